@@ -1,7 +1,5 @@
-﻿using BestHTTP.WebSocket;
-using Newtonsoft.Json;
-using Newtonsoft.Json.Converters;
-using Newtonsoft.Json.Linq;
+﻿using System;
+using BestHTTP.WebSocket;
 using UnityEngine;
 
 public class CloudClient : MonoBehaviour
@@ -23,13 +21,13 @@ public class CloudClient : MonoBehaviour
             return;
         }
 
-        var payload = new ControlConfigWrapper
+        var message = new Message
         {
-            @event = Event.UPDATE_CONFIG,
-            payload = config,
+            @event = AppEvent.UPDATE_CONFIG,
+            controlConfig = config,
         };
 
-        _ws.Send(JsonConvert.SerializeObject(payload));
+        _ws.Send(ProtocolJson.Encode(message));
     }
 
     void Awake()
@@ -46,27 +44,29 @@ public class CloudClient : MonoBehaviour
             Debug.Log($"Disconnected from WebSocet server with code {code}, message: {message}.");
         };
 
-        _ws.OnMessage += (_, message) =>
+        _ws.OnMessage += (_, text) =>
         {
-            var root = JToken.Parse(message);
-            var @event = root["event"];
+            Message message;
 
-            if (@event != null)
+            try
             {
-                switch (@event.ToObject<Event>())
-                {
-                    case Event.UPDATE_CONFIG:
-                        solarPanelController.UpdateControlConfig(root["payload"].ToObject<ControlConfig>());
-                        break;
-
-                    case Event.UPDATE_STATE:
-                        solarPanelController.AddSystemState(root["payload"].ToObject<SystemState>());
-                        break;
-                }
+                message = ProtocolJson.Decode(text);
             }
-            else
+            catch (Exception e)
             {
-                Debug.LogWarning("Cannot parse WebSocket message, ignored,");
+                Debug.LogWarning($"Cannot parse WebSocket message, ignored: {e.Message}");
+                return;
+            }
+
+            switch (message.@event)
+            {
+                case AppEvent.UPDATE_CONFIG:
+                    solarPanelController.UpdateControlConfig(message.controlConfig);
+                    break;
+
+                case AppEvent.UPDATE_STATE:
+                    solarPanelController.AddSystemState(message.systemState);
+                    break;
             }
         };
 
@@ -77,29 +77,4 @@ public class CloudClient : MonoBehaviour
     {
         if (_ws.IsOpen) _ws.Close();
     }
-
-    enum Event
-    {
-        UPDATE_CONFIG,
-        UPDATE_STATE,
-    }
-
-    struct EventWrapper
-    {
-        public string @event;
-    }
-
-    struct ControlConfigWrapper
-    {
-        [JsonConverter(typeof(StringEnumConverter))]
-        public Event @event;
-        public ControlConfig payload;
-    }
-
-    struct SystemStateWrapper
-    {
-        [JsonConverter(typeof(StringEnumConverter))]
-        public Event @event;
-        public SystemState payload;
-    }
 }
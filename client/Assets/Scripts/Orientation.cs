@@ -1,6 +0,0 @@
-﻿[System.Serializable]
-public struct Orientation
-{
-    public float azimuth;
-    public float inclination;
-}
@@ -0,0 +1,1018 @@
+﻿// Generated by tools/protocol_gen.py from protocol/schema.json, do not edit.
+using System;
+using System.Globalization;
+using System.IO;
+using System.Linq;
+using Newtonsoft.Json;
+using Newtonsoft.Json.Linq;
+
+public enum AppEvent
+{
+    UPDATE_CONFIG,
+    UPDATE_STATE,
+    UPDATE_VIEWERS,
+    UPDATE_DELTA,
+    ACK_KEYFRAME,
+}
+
+public enum ControlMode
+{
+    AUTOMATIC,
+    MANUAL,
+}
+
+public enum AhrsEngine
+{
+    Mahony,
+    Madgwick,
+    EKF,
+}
+
+// Degrees
+[Serializable]
+public struct Orientation
+{
+    public float azimuth;
+    public float inclination;
+}
+
+// Measured pulse width (us) per angle (degree), sorted by angle
+[Serializable]
+public struct ServoCalibrationPoint
+{
+    public float angle;
+    public float pulseWidth;
+}
+
+[Serializable]
+public struct ServoCalibration
+{
+    public bool hasAzimuth;
+    public ServoCalibrationPoint[] azimuth;
+    public bool hasInclination;
+    public ServoCalibrationPoint[] inclination;
+}
+
+[Serializable]
+public struct ControlConfig
+{
+    public ControlMode controlMode;
+    public Orientation manualOrientation;
+    public bool hasAhrsEngine;
+    public AhrsEngine ahrsEngine;
+    public bool hasServoCalibration;
+    public ServoCalibration servoCalibration;
+    // Gain a tracking move needs, relative to the energy it costs
+    public bool hasTrackingThreshold;
+    public float trackingThreshold;
+}
+
+// Energies in Wh, time in seconds
+[Serializable]
+public struct TrackingPolicy
+{
+    public uint moves;
+    public uint skipped;
+    public float motorOnTime;
+    public float motorEnergy;
+    public float yield;
+}
+
+// Effective uploads per second, and upload counters since boot
+[Serializable]
+public struct TelemetryRate
+{
+    public float rate;
+    public uint sent;
+    public uint failed;
+    public uint deferred;
+    public uint backoffs;
+}
+
+[Serializable]
+public struct SystemState
+{
+    public UnityEngine.Quaternion platformRotation;
+    public Orientation panelOrientation;
+    public Orientation motorsRotation;
+    // Seconds each servo has been energized since boot
+    public Orientation motorsEnergized;
+    // Milliseconds since the Unix epoch
+    public long timestamp;
+    // Read from the servo potentiometers, when the firmware has them
+    public bool hasMotorsMeasured;
+    public Orientation motorsMeasured;
+    public bool hasTrackingPolicy;
+    public TrackingPolicy trackingPolicy;
+    public bool hasTelemetry;
+    public TelemetryRate telemetry;
+    // Number the tracker gave this state when it uploads deltas against it
+    public bool hasKeyframe;
+    public uint keyframe;
+}
+
+[Serializable]
+public struct Viewers
+{
+    public uint viewers;
+}
+
+// Index in the delta fields of the firmware and value in quantization steps
+[Serializable]
+public struct DeltaChange
+{
+    public uint index;
+    public int steps;
+}
+
+// Fields that changed since the keyframe `base`
+[Serializable]
+public struct SystemDelta
+{
+    public uint @base;
+    public long timestamp;
+    public DeltaChange[] changes;
+}
+
+[Serializable]
+public struct KeyframeAck
+{
+    public uint keyframe;
+}
+
+// The payload of the event, the other ones are left empty
+public struct Message
+{
+    public AppEvent @event;
+    public ControlConfig controlConfig;
+    public SystemState systemState;
+    public Viewers viewers;
+    public SystemDelta systemDelta;
+    public KeyframeAck keyframeAck;
+}
+
+public static class ProtocolJson
+{
+    static readonly string[] AppEventNames = { "UPDATE_CONFIG", "UPDATE_STATE", "UPDATE_VIEWERS", "UPDATE_DELTA", "ACK_KEYFRAME" };
+    static readonly string[] ControlModeNames = { "AUTOMATIC", "MANUAL" };
+    static readonly string[] AhrsEngineNames = { "Mahony", "Madgwick", "EKF" };
+
+    public static string Encode(Message message)
+    {
+        var text = new StringWriter(CultureInfo.InvariantCulture);
+
+        using (var writer = new JsonTextWriter(text))
+        {
+            writer.WriteStartObject();
+            writer.WritePropertyName("event");
+            writer.WriteValue(AppEventNames[(int)message.@event]);
+            writer.WritePropertyName("payload");
+            switch (message.@event)
+            {
+                case AppEvent.UPDATE_CONFIG:
+                    Write(writer, message.controlConfig);
+                    break;
+                case AppEvent.UPDATE_STATE:
+                    Write(writer, message.systemState);
+                    break;
+                case AppEvent.UPDATE_VIEWERS:
+                    Write(writer, message.viewers);
+                    break;
+                case AppEvent.UPDATE_DELTA:
+                    Write(writer, message.systemDelta);
+                    break;
+                case AppEvent.ACK_KEYFRAME:
+                    Write(writer, message.keyframeAck);
+                    break;
+            }
+            writer.WriteEndObject();
+        }
+
+        return text.ToString();
+    }
+
+    // Throws a FormatException when the message is not valid
+    public static Message Decode(string json)
+    {
+        var root = ReadObject(JToken.Parse(json));
+        var message = new Message { @event = (AppEvent)ReadEnum(Required(root, "event"), AppEventNames) };
+        var payload = Required(root, "payload");
+
+        switch (message.@event)
+        {
+            case AppEvent.UPDATE_CONFIG:
+                message.controlConfig = ReadControlConfig(payload);
+                break;
+            case AppEvent.UPDATE_STATE:
+                message.systemState = ReadSystemState(payload);
+                break;
+            case AppEvent.UPDATE_VIEWERS:
+                message.viewers = ReadViewers(payload);
+                break;
+            case AppEvent.UPDATE_DELTA:
+                message.systemDelta = ReadSystemDelta(payload);
+                break;
+            case AppEvent.ACK_KEYFRAME:
+                message.keyframeAck = ReadKeyframeAck(payload);
+                break;
+        }
+
+        return message;
+    }
+
+    static void Write(JsonWriter writer, UnityEngine.Quaternion value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("w");
+        WriteFloat(writer, value.w, 6);
+        writer.WritePropertyName("x");
+        WriteFloat(writer, value.x, 6);
+        writer.WritePropertyName("y");
+        WriteFloat(writer, value.y, 6);
+        writer.WritePropertyName("z");
+        WriteFloat(writer, value.z, 6);
+        writer.WriteEndObject();
+    }
+
+    static UnityEngine.Quaternion ReadQuaternion(JToken token)
+    {
+        var value = new UnityEngine.Quaternion();
+
+        ReadObject(token);
+        value.w = ReadFloat(Required(token, "w"));
+        value.x = ReadFloat(Required(token, "x"));
+        value.y = ReadFloat(Required(token, "y"));
+        value.z = ReadFloat(Required(token, "z"));
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, Orientation value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("azimuth");
+        WriteFloat(writer, value.azimuth, 6);
+        writer.WritePropertyName("inclination");
+        WriteFloat(writer, value.inclination, 6);
+        writer.WriteEndObject();
+    }
+
+    static Orientation ReadOrientation(JToken token)
+    {
+        var value = new Orientation();
+
+        ReadObject(token);
+        value.azimuth = ReadFloat(Required(token, "azimuth"));
+        value.inclination = ReadFloat(Required(token, "inclination"));
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, ServoCalibrationPoint value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("angle");
+        WriteFloat(writer, value.angle, 3);
+        writer.WritePropertyName("pulseWidth");
+        WriteFloat(writer, value.pulseWidth, 1);
+        writer.WriteEndObject();
+    }
+
+    static ServoCalibrationPoint ReadServoCalibrationPoint(JToken token)
+    {
+        var value = new ServoCalibrationPoint();
+
+        ReadObject(token);
+        value.angle = ReadFloat(Required(token, "angle"));
+        value.pulseWidth = ReadFloat(Required(token, "pulseWidth"));
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, ServoCalibration value)
+    {
+        writer.WriteStartObject();
+        if (value.hasAzimuth)
+        {
+            writer.WritePropertyName("azimuth");
+            writer.WriteStartArray();
+            foreach (var item in value.azimuth) Write(writer, item);
+            writer.WriteEndArray();
+        }
+        if (value.hasInclination)
+        {
+            writer.WritePropertyName("inclination");
+            writer.WriteStartArray();
+            foreach (var item in value.inclination) Write(writer, item);
+            writer.WriteEndArray();
+        }
+        writer.WriteEndObject();
+    }
+
+    static ServoCalibration ReadServoCalibration(JToken token)
+    {
+        var value = new ServoCalibration();
+
+        ReadObject(token);
+        value.hasAzimuth = Optional(token, "azimuth", out var azimuthToken);
+        if (value.hasAzimuth) value.azimuth = ReadArray(azimuthToken, 16).Select(item => ReadServoCalibrationPoint(item)).ToArray();
+        value.hasInclination = Optional(token, "inclination", out var inclinationToken);
+        if (value.hasInclination) value.inclination = ReadArray(inclinationToken, 16).Select(item => ReadServoCalibrationPoint(item)).ToArray();
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, ControlConfig value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("controlMode");
+        writer.WriteValue(ControlModeNames[(int)value.controlMode]);
+        writer.WritePropertyName("manualOrientation");
+        Write(writer, value.manualOrientation);
+        if (value.hasAhrsEngine)
+        {
+            writer.WritePropertyName("ahrsEngine");
+            writer.WriteValue(AhrsEngineNames[(int)value.ahrsEngine]);
+        }
+        if (value.hasServoCalibration)
+        {
+            writer.WritePropertyName("servoCalibration");
+            Write(writer, value.servoCalibration);
+        }
+        if (value.hasTrackingThreshold)
+        {
+            writer.WritePropertyName("trackingThreshold");
+            WriteFloat(writer, value.trackingThreshold, 3);
+        }
+        writer.WriteEndObject();
+    }
+
+    static ControlConfig ReadControlConfig(JToken token)
+    {
+        var value = new ControlConfig();
+
+        ReadObject(token);
+        value.controlMode = (ControlMode)ReadEnum(Required(token, "controlMode"), ControlModeNames);
+        value.manualOrientation = ReadOrientation(Required(token, "manualOrientation"));
+        value.hasAhrsEngine = Optional(token, "ahrsEngine", out var ahrsEngineToken);
+        if (value.hasAhrsEngine) value.ahrsEngine = (AhrsEngine)ReadEnum(ahrsEngineToken, AhrsEngineNames);
+        value.hasServoCalibration = Optional(token, "servoCalibration", out var servoCalibrationToken);
+        if (value.hasServoCalibration) value.servoCalibration = ReadServoCalibration(servoCalibrationToken);
+        value.hasTrackingThreshold = Optional(token, "trackingThreshold", out var trackingThresholdToken);
+        if (value.hasTrackingThreshold) value.trackingThreshold = ReadFloat(trackingThresholdToken);
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, TrackingPolicy value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("moves");
+        writer.WriteValue(value.moves);
+        writer.WritePropertyName("skipped");
+        writer.WriteValue(value.skipped);
+        writer.WritePropertyName("motorOnTime");
+        WriteFloat(writer, value.motorOnTime, 1);
+        writer.WritePropertyName("motorEnergy");
+        WriteFloat(writer, value.motorEnergy, 4);
+        writer.WritePropertyName("yield");
+        WriteFloat(writer, value.yield, 4);
+        writer.WriteEndObject();
+    }
+
+    static TrackingPolicy ReadTrackingPolicy(JToken token)
+    {
+        var value = new TrackingPolicy();
+
+        ReadObject(token);
+        value.moves = ReadInteger<uint>(Required(token, "moves"));
+        value.skipped = ReadInteger<uint>(Required(token, "skipped"));
+        value.motorOnTime = ReadFloat(Required(token, "motorOnTime"));
+        value.motorEnergy = ReadFloat(Required(token, "motorEnergy"));
+        value.yield = ReadFloat(Required(token, "yield"));
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, TelemetryRate value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("rate");
+        WriteFloat(writer, value.rate, 3);
+        writer.WritePropertyName("sent");
+        writer.WriteValue(value.sent);
+        writer.WritePropertyName("failed");
+        writer.WriteValue(value.failed);
+        writer.WritePropertyName("deferred");
+        writer.WriteValue(value.deferred);
+        writer.WritePropertyName("backoffs");
+        writer.WriteValue(value.backoffs);
+        writer.WriteEndObject();
+    }
+
+    static TelemetryRate ReadTelemetryRate(JToken token)
+    {
+        var value = new TelemetryRate();
+
+        ReadObject(token);
+        value.rate = ReadFloat(Required(token, "rate"));
+        value.sent = ReadInteger<uint>(Required(token, "sent"));
+        value.failed = ReadInteger<uint>(Required(token, "failed"));
+        value.deferred = ReadInteger<uint>(Required(token, "deferred"));
+        value.backoffs = ReadInteger<uint>(Required(token, "backoffs"));
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, SystemState value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("platformRotation");
+        Write(writer, value.platformRotation);
+        writer.WritePropertyName("panelOrientation");
+        Write(writer, value.panelOrientation);
+        writer.WritePropertyName("motorsRotation");
+        Write(writer, value.motorsRotation);
+        writer.WritePropertyName("motorsEnergized");
+        Write(writer, value.motorsEnergized);
+        writer.WritePropertyName("timestamp");
+        writer.WriteValue(value.timestamp);
+        if (value.hasMotorsMeasured)
+        {
+            writer.WritePropertyName("motorsMeasured");
+            Write(writer, value.motorsMeasured);
+        }
+        if (value.hasTrackingPolicy)
+        {
+            writer.WritePropertyName("trackingPolicy");
+            Write(writer, value.trackingPolicy);
+        }
+        if (value.hasTelemetry)
+        {
+            writer.WritePropertyName("telemetry");
+            Write(writer, value.telemetry);
+        }
+        if (value.hasKeyframe)
+        {
+            writer.WritePropertyName("keyframe");
+            writer.WriteValue(value.keyframe);
+        }
+        writer.WriteEndObject();
+    }
+
+    static SystemState ReadSystemState(JToken token)
+    {
+        var value = new SystemState();
+
+        ReadObject(token);
+        value.platformRotation = ReadQuaternion(Required(token, "platformRotation"));
+        value.panelOrientation = ReadOrientation(Required(token, "panelOrientation"));
+        value.motorsRotation = ReadOrientation(Required(token, "motorsRotation"));
+        value.motorsEnergized = ReadOrientation(Required(token, "motorsEnergized"));
+        value.timestamp = ReadInteger<long>(Required(token, "timestamp"));
+        value.hasMotorsMeasured = Optional(token, "motorsMeasured", out var motorsMeasuredToken);
+        if (value.hasMotorsMeasured) value.motorsMeasured = ReadOrientation(motorsMeasuredToken);
+        value.hasTrackingPolicy = Optional(token, "trackingPolicy", out var trackingPolicyToken);
+        if (value.hasTrackingPolicy) value.trackingPolicy = ReadTrackingPolicy(trackingPolicyToken);
+        value.hasTelemetry = Optional(token, "telemetry", out var telemetryToken);
+        if (value.hasTelemetry) value.telemetry = ReadTelemetryRate(telemetryToken);
+        value.hasKeyframe = Optional(token, "keyframe", out var keyframeToken);
+        if (value.hasKeyframe) value.keyframe = ReadInteger<uint>(keyframeToken);
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, Viewers value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("viewers");
+        writer.WriteValue(value.viewers);
+        writer.WriteEndObject();
+    }
+
+    static Viewers ReadViewers(JToken token)
+    {
+        var value = new Viewers();
+
+        ReadObject(token);
+        value.viewers = ReadInteger<uint>(Required(token, "viewers"));
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, DeltaChange value)
+    {
+        writer.WriteStartArray();
+        writer.WriteValue(value.index);
+        writer.WriteValue(value.steps);
+        writer.WriteEndArray();
+    }
+
+    static DeltaChange ReadDeltaChange(JToken token)
+    {
+        var items = ReadArray(token, 2);
+        if (items.Count != 2) throw new FormatException($"{token.Path} does not have 2 items.");
+
+        return new DeltaChange
+        {
+            index = ReadInteger<uint>(items[0]),
+            steps = ReadInteger<int>(items[1]),
+        };
+    }
+
+    static void Write(JsonWriter writer, SystemDelta value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("base");
+        writer.WriteValue(value.@base);
+        writer.WritePropertyName("timestamp");
+        writer.WriteValue(value.timestamp);
+        writer.WritePropertyName("changes");
+        writer.WriteStartArray();
+        foreach (var item in value.changes) Write(writer, item);
+        writer.WriteEndArray();
+        writer.WriteEndObject();
+    }
+
+    static SystemDelta ReadSystemDelta(JToken token)
+    {
+        var value = new SystemDelta();
+
+        ReadObject(token);
+        value.@base = ReadInteger<uint>(Required(token, "base"));
+        value.timestamp = ReadInteger<long>(Required(token, "timestamp"));
+        value.changes = ReadArray(Required(token, "changes"), 10).Select(item => ReadDeltaChange(item)).ToArray();
+
+        return value;
+    }
+
+    static void Write(JsonWriter writer, KeyframeAck value)
+    {
+        writer.WriteStartObject();
+        writer.WritePropertyName("keyframe");
+        writer.WriteValue(value.keyframe);
+        writer.WriteEndObject();
+    }
+
+    static KeyframeAck ReadKeyframeAck(JToken token)
+    {
+        var value = new KeyframeAck();
+
+        ReadObject(token);
+        value.keyframe = ReadInteger<uint>(Required(token, "keyframe"));
+
+        return value;
+    }
+
+    // Rounded to the decimals the firmware writes
+    static void WriteFloat(JsonWriter writer, float value, int precision)
+    {
+        if (float.IsNaN(value) || float.IsInfinity(value)) writer.WriteNull();
+        else writer.WriteValue(Math.Round((double)value, precision, MidpointRounding.AwayFromZero));
+    }
+
+    static JToken Required(JToken token, string name)
+    {
+        return token[name] ?? throw new FormatException($"{name} is missing.");
+    }
+
+    static bool Optional(JToken token, string name, out JToken value)
+    {
+        value = token[name];
+        return value != null;
+    }
+
+    static float ReadFloat(JToken token)
+    {
+        if (token.Type == JTokenType.Null) return float.NaN;
+        if (token.Type != JTokenType.Float && token.Type != JTokenType.Integer) throw new FormatException($"{token.Path} is not a number.");
+
+        return token.Value<float>();
+    }
+
+    static T ReadInteger<T>(JToken token)
+    {
+        if (token.Type != JTokenType.Integer) throw new FormatException($"{token.Path} is not an integer.");
+
+        try
+        {
+            return token.Value<T>();
+        }
+        catch (Exception e) when (e is OverflowException || e is InvalidCastException)
+        {
+            throw new FormatException($"{token.Path} is out of range.");
+        }
+    }
+
+    static int ReadEnum(JToken token, string[] names)
+    {
+        var index = token.Type == JTokenType.String ? Array.IndexOf(names, token.Value<string>()) : -1;
+        if (index < 0) throw new FormatException($"{token.Path} is not one of {string.Join(", ", names)}.");
+
+        return index;
+    }
+
+    static JArray ReadArray(JToken token, int max)
+    {
+        if (!(token is JArray array) || array.Count > max) throw new FormatException($"{token.Path} is not an array of at most {max} items.");
+
+        return array;
+    }
+
+    static JObject ReadObject(JToken token)
+    {
+        return token as JObject ?? throw new FormatException($"{token.Path} is not an object.");
+    }
+}
+
+// Little endian, as BinaryWriter writes
+public static class ProtocolBinary
+{
+    public static byte[] Encode(Message message)
+    {
+        using (var stream = new MemoryStream())
+        using (var writer = new BinaryWriter(stream))
+        {
+            writer.Write((byte)message.@event);
+            switch (message.@event)
+            {
+                case AppEvent.UPDATE_CONFIG:
+                    Write(writer, message.controlConfig);
+                    break;
+                case AppEvent.UPDATE_STATE:
+                    Write(writer, message.systemState);
+                    break;
+                case AppEvent.UPDATE_VIEWERS:
+                    Write(writer, message.viewers);
+                    break;
+                case AppEvent.UPDATE_DELTA:
+                    Write(writer, message.systemDelta);
+                    break;
+                case AppEvent.ACK_KEYFRAME:
+                    Write(writer, message.keyframeAck);
+                    break;
+            }
+
+            return stream.ToArray();
+        }
+    }
+
+    // Throws a FormatException when the message is not valid, an
+    // EndOfStreamException when it is truncated
+    public static Message Decode(byte[] data)
+    {
+        using (var reader = new BinaryReader(new MemoryStream(data)))
+        {
+            var message = new Message { @event = (AppEvent)ReadEnum(reader, 5) };
+
+            switch (message.@event)
+            {
+                case AppEvent.UPDATE_CONFIG:
+                    message.controlConfig = ReadControlConfig(reader);
+                    break;
+                case AppEvent.UPDATE_STATE:
+                    message.systemState = ReadSystemState(reader);
+                    break;
+                case AppEvent.UPDATE_VIEWERS:
+                    message.viewers = ReadViewers(reader);
+                    break;
+                case AppEvent.UPDATE_DELTA:
+                    message.systemDelta = ReadSystemDelta(reader);
+                    break;
+                case AppEvent.ACK_KEYFRAME:
+                    message.keyframeAck = ReadKeyframeAck(reader);
+                    break;
+            }
+            if (reader.BaseStream.Position != data.Length) throw new FormatException("Binary message is too long.");
+
+            return message;
+        }
+    }
+
+    static void Write(BinaryWriter writer, UnityEngine.Quaternion value)
+    {
+        WriteFloat(writer, value.w);
+        WriteFloat(writer, value.x);
+        WriteFloat(writer, value.y);
+        WriteFloat(writer, value.z);
+    }
+
+    static UnityEngine.Quaternion ReadQuaternion(BinaryReader reader)
+    {
+        var value = new UnityEngine.Quaternion();
+
+        value.w = reader.ReadSingle();
+        value.x = reader.ReadSingle();
+        value.y = reader.ReadSingle();
+        value.z = reader.ReadSingle();
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, Orientation value)
+    {
+        WriteFloat(writer, value.azimuth);
+        WriteFloat(writer, value.inclination);
+    }
+
+    static Orientation ReadOrientation(BinaryReader reader)
+    {
+        var value = new Orientation();
+
+        value.azimuth = reader.ReadSingle();
+        value.inclination = reader.ReadSingle();
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, ServoCalibrationPoint value)
+    {
+        WriteFloat(writer, value.angle);
+        WriteFloat(writer, value.pulseWidth);
+    }
+
+    static ServoCalibrationPoint ReadServoCalibrationPoint(BinaryReader reader)
+    {
+        var value = new ServoCalibrationPoint();
+
+        value.angle = reader.ReadSingle();
+        value.pulseWidth = reader.ReadSingle();
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, ServoCalibration value)
+    {
+        writer.Write((byte)((value.hasAzimuth ? 1 : 0) | (value.hasInclination ? 2 : 0)));
+        if (value.hasAzimuth)
+        {
+            writer.Write((byte)value.azimuth.Length);
+            foreach (var item in value.azimuth) Write(writer, item);
+        }
+        if (value.hasInclination)
+        {
+            writer.Write((byte)value.inclination.Length);
+            foreach (var item in value.inclination) Write(writer, item);
+        }
+    }
+
+    static ServoCalibration ReadServoCalibration(BinaryReader reader)
+    {
+        var value = new ServoCalibration();
+        var present = reader.ReadByte();
+
+        if (present >> 2 != 0) throw new FormatException("Unknown optional fields.");
+        value.hasAzimuth = (present & 1) != 0;
+        value.hasInclination = (present & 2) != 0;
+        if (value.hasAzimuth)
+        {
+            value.azimuth = new ServoCalibrationPoint[ReadCount(reader, 16)];
+            for (var i = 0; i < value.azimuth.Length; i++) value.azimuth[i] = ReadServoCalibrationPoint(reader);
+        }
+        if (value.hasInclination)
+        {
+            value.inclination = new ServoCalibrationPoint[ReadCount(reader, 16)];
+            for (var i = 0; i < value.inclination.Length; i++) value.inclination[i] = ReadServoCalibrationPoint(reader);
+        }
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, ControlConfig value)
+    {
+        writer.Write((byte)((value.hasAhrsEngine ? 1 : 0) | (value.hasServoCalibration ? 2 : 0) | (value.hasTrackingThreshold ? 4 : 0)));
+        writer.Write((byte)value.controlMode);
+        Write(writer, value.manualOrientation);
+        if (value.hasAhrsEngine)
+        {
+            writer.Write((byte)value.ahrsEngine);
+        }
+        if (value.hasServoCalibration)
+        {
+            Write(writer, value.servoCalibration);
+        }
+        if (value.hasTrackingThreshold)
+        {
+            WriteFloat(writer, value.trackingThreshold);
+        }
+    }
+
+    static ControlConfig ReadControlConfig(BinaryReader reader)
+    {
+        var value = new ControlConfig();
+        var present = reader.ReadByte();
+
+        if (present >> 3 != 0) throw new FormatException("Unknown optional fields.");
+        value.hasAhrsEngine = (present & 1) != 0;
+        value.hasServoCalibration = (present & 2) != 0;
+        value.hasTrackingThreshold = (present & 4) != 0;
+        value.controlMode = (ControlMode)ReadEnum(reader, 2);
+        value.manualOrientation = ReadOrientation(reader);
+        if (value.hasAhrsEngine)
+        {
+            value.ahrsEngine = (AhrsEngine)ReadEnum(reader, 3);
+        }
+        if (value.hasServoCalibration)
+        {
+            value.servoCalibration = ReadServoCalibration(reader);
+        }
+        if (value.hasTrackingThreshold)
+        {
+            value.trackingThreshold = reader.ReadSingle();
+        }
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, TrackingPolicy value)
+    {
+        writer.Write(value.moves);
+        writer.Write(value.skipped);
+        WriteFloat(writer, value.motorOnTime);
+        WriteFloat(writer, value.motorEnergy);
+        WriteFloat(writer, value.yield);
+    }
+
+    static TrackingPolicy ReadTrackingPolicy(BinaryReader reader)
+    {
+        var value = new TrackingPolicy();
+
+        value.moves = reader.ReadUInt32();
+        value.skipped = reader.ReadUInt32();
+        value.motorOnTime = reader.ReadSingle();
+        value.motorEnergy = reader.ReadSingle();
+        value.yield = reader.ReadSingle();
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, TelemetryRate value)
+    {
+        WriteFloat(writer, value.rate);
+        writer.Write(value.sent);
+        writer.Write(value.failed);
+        writer.Write(value.deferred);
+        writer.Write(value.backoffs);
+    }
+
+    static TelemetryRate ReadTelemetryRate(BinaryReader reader)
+    {
+        var value = new TelemetryRate();
+
+        value.rate = reader.ReadSingle();
+        value.sent = reader.ReadUInt32();
+        value.failed = reader.ReadUInt32();
+        value.deferred = reader.ReadUInt32();
+        value.backoffs = reader.ReadUInt32();
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, SystemState value)
+    {
+        writer.Write((byte)((value.hasMotorsMeasured ? 1 : 0) | (value.hasTrackingPolicy ? 2 : 0) | (value.hasTelemetry ? 4 : 0) | (value.hasKeyframe ? 8 : 0)));
+        Write(writer, value.platformRotation);
+        Write(writer, value.panelOrientation);
+        Write(writer, value.motorsRotation);
+        Write(writer, value.motorsEnergized);
+        writer.Write(value.timestamp);
+        if (value.hasMotorsMeasured)
+        {
+            Write(writer, value.motorsMeasured);
+        }
+        if (value.hasTrackingPolicy)
+        {
+            Write(writer, value.trackingPolicy);
+        }
+        if (value.hasTelemetry)
+        {
+            Write(writer, value.telemetry);
+        }
+        if (value.hasKeyframe)
+        {
+            writer.Write(value.keyframe);
+        }
+    }
+
+    static SystemState ReadSystemState(BinaryReader reader)
+    {
+        var value = new SystemState();
+        var present = reader.ReadByte();
+
+        if (present >> 4 != 0) throw new FormatException("Unknown optional fields.");
+        value.hasMotorsMeasured = (present & 1) != 0;
+        value.hasTrackingPolicy = (present & 2) != 0;
+        value.hasTelemetry = (present & 4) != 0;
+        value.hasKeyframe = (present & 8) != 0;
+        value.platformRotation = ReadQuaternion(reader);
+        value.panelOrientation = ReadOrientation(reader);
+        value.motorsRotation = ReadOrientation(reader);
+        value.motorsEnergized = ReadOrientation(reader);
+        value.timestamp = reader.ReadInt64();
+        if (value.hasMotorsMeasured)
+        {
+            value.motorsMeasured = ReadOrientation(reader);
+        }
+        if (value.hasTrackingPolicy)
+        {
+            value.trackingPolicy = ReadTrackingPolicy(reader);
+        }
+        if (value.hasTelemetry)
+        {
+            value.telemetry = ReadTelemetryRate(reader);
+        }
+        if (value.hasKeyframe)
+        {
+            value.keyframe = reader.ReadUInt32();
+        }
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, Viewers value)
+    {
+        writer.Write(value.viewers);
+    }
+
+    static Viewers ReadViewers(BinaryReader reader)
+    {
+        var value = new Viewers();
+
+        value.viewers = reader.ReadUInt32();
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, DeltaChange value)
+    {
+        writer.Write(value.index);
+        writer.Write(value.steps);
+    }
+
+    static DeltaChange ReadDeltaChange(BinaryReader reader)
+    {
+        var value = new DeltaChange();
+
+        value.index = reader.ReadUInt32();
+        value.steps = reader.ReadInt32();
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, SystemDelta value)
+    {
+        writer.Write(value.@base);
+        writer.Write(value.timestamp);
+        writer.Write((byte)value.changes.Length);
+        foreach (var item in value.changes) Write(writer, item);
+    }
+
+    static SystemDelta ReadSystemDelta(BinaryReader reader)
+    {
+        var value = new SystemDelta();
+
+        value.@base = reader.ReadUInt32();
+        value.timestamp = reader.ReadInt64();
+        value.changes = new DeltaChange[ReadCount(reader, 10)];
+        for (var i = 0; i < value.changes.Length; i++) value.changes[i] = ReadDeltaChange(reader);
+
+        return value;
+    }
+
+    static void Write(BinaryWriter writer, KeyframeAck value)
+    {
+        writer.Write(value.keyframe);
+    }
+
+    static KeyframeAck ReadKeyframeAck(BinaryReader reader)
+    {
+        var value = new KeyframeAck();
+
+        value.keyframe = reader.ReadUInt32();
+
+        return value;
+    }
+
+    // The NaN of the firmware and the server, float.NaN has its sign bit set
+    static void WriteFloat(BinaryWriter writer, float value)
+    {
+        if (float.IsNaN(value)) writer.Write(0x7fc00000u);
+        else writer.Write(value);
+    }
+
+    static int ReadEnum(BinaryReader reader, int count)
+    {
+        var index = reader.ReadByte();
+        if (index >= count) throw new FormatException($"Enum index {index} out of range.");
+
+        return index;
+    }
+
+    static int ReadCount(BinaryReader reader, int max)
+    {
+        var count = reader.ReadByte();
+        if (count > max) throw new FormatException($"{count} items, at most {max}.");
+
+        return count;
+    }
+}
@@ -64,7 +64,7 @@ public class SolarPanelController : MonoBehaviour
     {
         modeDropdown.onValueChanged.AddListener(value =>
         {
-            controlConfig.controlMode = (ControlConfigMode)value;
+            controlConfig.controlMode = (ControlMode)value;
             cloudClient.UpdateConfig(controlConfig);
             UpdateUI();
         });
@@ -109,7 +109,7 @@ public class SolarPanelController : MonoBehaviour
         _lastOrientation.azimuth = Mod(_lastOrientation.azimuth, 360f);
         _lastOrientation.inclination = Mod(_lastOrientation.inclination, 360f);
 
-        if (controlConfig.controlMode == ControlConfigMode.AUTOMATIC)
+        if (controlConfig.controlMode == ControlMode.AUTOMATIC)
         {
             azimuthSlider.SetValue(_lastOrientation.azimuth, false);
             inclinationSlider.SetValue(_lastOrientation.inclination, false);
@@ -118,7 +118,7 @@ public class SolarPanelController : MonoBehaviour
 
     void UpdateUI()
     {
-        var isManual = controlConfig.controlMode == ControlConfigMode.MANUAL;
+        var isManual = controlConfig.controlMode == ControlMode.MANUAL;
 
         azimuthInputField.interactable = isManual;
         inclinationInputField.interactable = isManual;
@@ -0,0 +1,148 @@
+using System;
+using System.IO;
+using System.Linq;
+using Newtonsoft.Json;
+using Newtonsoft.Json.Linq;
+using NUnit.Framework;
+using UnityEngine;
+
+// The generated codecs on the messages the firmware codec encoded, written to
+// protocol/vectors.txt by test/test_protocol.c
+public class ProtocolTests
+{
+    // Mutated copies of each vector fed to the decoders
+    const int Mutations = 20;
+    // Passes over the vectors when timing the codecs
+    const int BenchmarkPasses = 50;
+
+    struct Vector
+    {
+        public string json;
+        public byte[] binary;
+    }
+
+    Vector[] _vectors;
+
+    [OneTimeSetUp]
+    public void ReadVectors()
+    {
+        var path = Path.Combine(Application.dataPath, "..", "..", "protocol", "vectors.txt");
+
+        // One per line, the binary form in hex, a space, then the JSON text
+        _vectors = File.ReadAllLines(path)
+            .Where(line => line.Length > 0)
+            .Select(line =>
+            {
+                var space = line.IndexOf(' ');
+                var hex = line.Substring(0, space);
+
+                return new Vector
+                {
+                    json = line.Substring(space + 1),
+                    binary = Enumerable.Range(0, hex.Length / 2).Select(i => Convert.ToByte(hex.Substring(i * 2, 2), 16)).ToArray(),
+                };
+            })
+            .ToArray();
+        Assert.IsNotEmpty(_vectors, "No protocol vectors");
+    }
+
+    // Both forms have to decode to the same message, encode back to the same
+    // bytes, and survive a round trip through JSON
+    [Test]
+    public void VectorsRoundTrip()
+    {
+        for (int i = 0; i < _vectors.Length; i++)
+        {
+            var vector = _vectors[i];
+            var message = ProtocolJson.Decode(vector.json);
+            var fromBinary = ProtocolBinary.Decode(vector.binary);
+            var json = ProtocolJson.Encode(message);
+
+            Assert.IsTrue(JToken.DeepEquals(JToken.Parse(json), JToken.Parse(vector.json)), $"Vector {i} changes through JSON: {json}");
+            Assert.IsTrue(JToken.DeepEquals(JToken.Parse(ProtocolJson.Encode(fromBinary)), JToken.Parse(vector.json)), $"Vector {i} decodes differently from binary");
+            Assert.AreEqual(vector.binary, ProtocolBinary.Encode(message), $"Vector {i} encodes to other bytes");
+            Assert.AreEqual(json, ProtocolJson.Encode(ProtocolJson.Decode(json)), $"Vector {i} is not stable through JSON");
+        }
+    }
+
+    // Mutated and truncated copies must not crash the decoders, most have to
+    // be rejected
+    [Test]
+    public void MutationsAreRejected()
+    {
+        var random = new System.Random(7);
+        int mutations = 0, accepted = 0;
+
+        foreach (var vector in _vectors)
+        {
+            for (int j = 0; j < Mutations; j++)
+            {
+                bool text = j % 2 == 0;
+                var chars = vector.json.ToCharArray();
+                var bytes = (byte[])vector.binary.Clone();
+                int length = text ? chars.Length : bytes.Length;
+                int at = random.Next(length);
+
+                // Alternately a byte replaced and the message cut short
+                if (j % 4 >= 2)
+                    length = at;
+                else if (text)
+                    chars[at] = "{}[],:\"-.0e9 nul"[random.Next(16)];
+                else
+                    bytes[at] = (byte)random.Next(256);
+
+                bool decoded = text
+                    ? Decodes(() => ProtocolJson.Decode(new string(chars, 0, length)))
+                    : Decodes(() => ProtocolBinary.Decode(bytes.Take(length).ToArray()));
+
+                mutations++;
+                if (decoded)
+                    accepted++;
+            }
+        }
+
+        Debug.Log($"{accepted} of {mutations} mutations accepted");
+        Assert.Less(accepted, mutations / 2, $"{accepted} of {mutations} mutations accepted");
+    }
+
+    // Encoding and decoding time of both forms, per message
+    [Test]
+    public void Benchmark()
+    {
+        var messages = _vectors.Select(vector => ProtocolJson.Decode(vector.json)).ToArray();
+
+        Time("Encoding JSON", i => ProtocolJson.Encode(messages[i]));
+        Time("Decoding JSON", i => ProtocolJson.Decode(_vectors[i].json));
+        Time("Encoding binary", i => ProtocolBinary.Encode(messages[i]));
+        Time("Decoding binary", i => ProtocolBinary.Decode(_vectors[i].binary));
+    }
+
+    // The decoders reject with these, anything else is a crash
+    static bool Decodes(Func<Message> decode)
+    {
+        try
+        {
+            ProtocolJson.Encode(decode());
+            return true;
+        }
+        catch (Exception e) when (e is FormatException || e is EndOfStreamException || e is JsonException)
+        {
+            return false;
+        }
+    }
+
+    // After a warm-up pass
+    void Time(string name, Action<int> run)
+    {
+        for (int i = 0; i < _vectors.Length; i++)
+            run(i);
+
+        var stopwatch = System.Diagnostics.Stopwatch.StartNew();
+        for (int pass = 0; pass < BenchmarkPasses; pass++)
+            for (int i = 0; i < _vectors.Length; i++)
+                run(i);
+
+        double nanoseconds = stopwatch.Elapsed.TotalMilliseconds * 1e6 / (_vectors.Length * BenchmarkPasses);
+        Debug.Log($"Protocol / {name}: {nanoseconds:F0} ns/message");
+    }
+}
@@ -17,33 +17,58 @@
 
 #include "MadgwickAHRS.h"
 #include <math.h>
+#include <stdint.h>
 
 //---------------------------------------------------------------------------------------------------
 // Variable definitions
 
-volatile float sampleFreq = 50;                            // 2 * proportional gain (Kp)
-volatile float beta = 0.8;                                 // 2 * proportional gain (Kp)
-volatile float q0 = 1.0f, q1 = 0.0f, q2 = 0.0f, q3 = 0.0f; // quaternion of sensor frame relative to auxiliary frame
+// Filter behind the single-instance API
+static float sampleFreq = 50;
+static MadgwickFilter filter = {.beta = 0.8f, .q0 = 1.0f, .q1 = 0.0f, .q2 = 0.0f, .q3 = 0.0f};
 
 //---------------------------------------------------------------------------------------------------
 // Function declarations
 
-float invSqrt(float x);
+static inline float invSqrt(float x);
 
 //====================================================================================================
 // Functions
 
+void MadgwickFilterInit(MadgwickFilter *f, float beta)
+{
+  f->beta = beta;
+  f->q0 = 1.0f;
+  f->q1 = 0.0f;
+  f->q2 = 0.0f;
+  f->q3 = 0.0f;
+}
+
 void MadgwickAHRSinit(float sampleFreqDef, float betaDef)
 {
   sampleFreq = sampleFreqDef;
-  beta = betaDef;
+  filter.beta = betaDef;
+}
+
+void MadgwickAHRSupdate(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz)
+{
+  MadgwickFilterUpdate(&filter, gx, gy, gz, ax, ay, az, mx, my, mz, 1.0f / sampleFreq);
+}
+
+void MadgwickAHRSupdateIMU(float gx, float gy, float gz, float ax, float ay, float az)
+{
+  MadgwickFilterUpdateIMU(&filter, gx, gy, gz, ax, ay, az, 1.0f / sampleFreq);
 }
 
 //---------------------------------------------------------------------------------------------------
 // AHRS algorithm update
+//
+// The state is copied into locals so the compiler keeps it in registers for
+// the whole kernel, and stored back once at the end.
 
-void MadgwickAHRSupdate(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz)
+void MadgwickFilterUpdate(MadgwickFilter *f, float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz, float dt)
 {
+  float q0 = f->q0, q1 = f->q1, q2 = f->q2, q3 = f->q3;
+  const float beta = f->beta;
   float recipNorm;
   float s0, s1, s2, s3;
   float qDot1, qDot2, qDot3, qDot4;
@@ -53,7 +78,7 @@ void MadgwickAHRSupdate(float gx, float gy, float gz, float ax, float ay, float
   // Use IMU algorithm if magnetometer measurement invalid (avoids NaN in magnetometer normalisation)
   if ((mx == 0.0f) && (my == 0.0f) && (mz == 0.0f))
   {
-    MadgwickAHRSupdateIMU(gx, gy, gz, ax, ay, az);
+    MadgwickFilterUpdateIMU(f, gx, gy, gz, ax, ay, az, dt);
     return;
   }
 
@@ -128,24 +153,26 @@ void MadgwickAHRSupdate(float gx, float gy, float gz, float ax, float ay, float
   }
 
   // Integrate rate of change of quaternion to yield quaternion
-  q0 += qDot1 * (1.0f / sampleFreq);
-  q1 += qDot2 * (1.0f / sampleFreq);
-  q2 += qDot3 * (1.0f / sampleFreq);
-  q3 += qDot4 * (1.0f / sampleFreq);
+  q0 += qDot1 * dt;
+  q1 += qDot2 * dt;
+  q2 += qDot3 * dt;
+  q3 += qDot4 * dt;
 
   // Normalise quaternion
   recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
-  q0 *= recipNorm;
-  q1 *= recipNorm;
-  q2 *= recipNorm;
-  q3 *= recipNorm;
+  f->q0 = q0 * recipNorm;
+  f->q1 = q1 * recipNorm;
+  f->q2 = q2 * recipNorm;
+  f->q3 = q3 * recipNorm;
 }
 
 //---------------------------------------------------------------------------------------------------
 // IMU algorithm update
 
-void MadgwickAHRSupdateIMU(float gx, float gy, float gz, float ax, float ay, float az)
+void MadgwickFilterUpdateIMU(MadgwickFilter *f, float gx, float gy, float gz, float ax, float ay, float az, float dt)
 {
+  float q0 = f->q0, q1 = f->q1, q2 = f->q2, q3 = f->q3;
+  const float beta = f->beta;
   float recipNorm;
   float s0, s1, s2, s3;
   float qDot1, qDot2, qDot3, qDot4;
@@ -201,32 +228,33 @@ void MadgwickAHRSupdateIMU(float gx, float gy, float gz, float ax, float ay, flo
   }
 
   // Integrate rate of change of quaternion to yield quaternion
-  q0 += qDot1 * (1.0f / sampleFreq);
-  q1 += qDot2 * (1.0f / sampleFreq);
-  q2 += qDot3 * (1.0f / sampleFreq);
-  q3 += qDot4 * (1.0f / sampleFreq);
+  q0 += qDot1 * dt;
+  q1 += qDot2 * dt;
+  q2 += qDot3 * dt;
+  q3 += qDot4 * dt;
 
   // Normalise quaternion
   recipNorm = invSqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
-  q0 *= recipNorm;
-  q1 *= recipNorm;
-  q2 *= recipNorm;
-  q3 *= recipNorm;
+  f->q0 = q0 * recipNorm;
+  f->q1 = q1 * recipNorm;
+  f->q2 = q2 * recipNorm;
+  f->q3 = q3 * recipNorm;
 }
 
 //---------------------------------------------------------------------------------------------------
 // Fast inverse square-root
 // See: http://en.wikipedia.org/wiki/Fast_inverse_square_root
 
-float invSqrt(float x)
+static inline float invSqrt(float x)
 {
+  union
+  {
+    float f;
+    int32_t i;
+  } y = {.f = x};
   float halfx = 0.5f * x;
-  float y = x;
-  long i = *(long *)&y;
-  i = 0x5f3759df - (i >> 1);
-  y = *(float *)&i;
-  y = y * (1.5f - (halfx * y * y));
-  return y;
+  y.i = 0x5f3759df - (y.i >> 1);
+  return y.f * (1.5f - (halfx * y.f * y.f));
 }
 
 /**
@@ -236,6 +264,7 @@ float invSqrt(float x)
  */
 void MadgwickGetVector(float *angle, float *x, float *y, float *z)
 {
+  float q0 = filter.q0, q1 = filter.q1, q2 = filter.q2, q3 = filter.q3;
   float ang = 2.0 * acos(q0);
   float sin_angle = sin(ang / 2.0);
   *angle = ang;
@@ -268,6 +297,7 @@ float norm_angle_0_2pi(float a)
  */
 void MadgwickGetEulerAngles(float *heading, float *pitch, float *roll)
 {
+  float q0 = filter.q0, q1 = filter.q1, q2 = filter.q2, q3 = filter.q3;
   float ww = q0 * q0;
   float xx = q1 * q1;
   float yy = q2 * q2;
@@ -13,9 +13,24 @@
 #ifndef MadgwickAHRS_h
 #define MadgwickAHRS_h
 
+//---------------------------------------------------------------------------------------------------
+// Filter state
+
+typedef struct MadgwickFilter
+{
+  float beta;           // 2 * proportional gain (Kp)
+  float q0, q1, q2, q3; // quaternion of sensor frame relative to auxiliary frame
+} MadgwickFilter;
+
 //---------------------------------------------------------------------------------------------------
 // Function declarations
 
+// Reentrant API: any number of filters, gyro in rad/s, dt in seconds
+void MadgwickFilterInit(MadgwickFilter *f, float beta);
+void MadgwickFilterUpdate(MadgwickFilter *f, float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz, float dt);
+void MadgwickFilterUpdateIMU(MadgwickFilter *f, float gx, float gy, float gz, float ax, float ay, float az, float dt);
+
+// Single filter API, kept for existing callers
 void MadgwickAHRSinit(float sampleFreqDef, float betaDef);
 void MadgwickAHRSupdate(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz);
 void MadgwickAHRSupdateIMU(float gx, float gy, float gz, float ax, float ay, float az);
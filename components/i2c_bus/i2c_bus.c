@@ -0,0 +1,207 @@
+#include <string.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "i2c_bus.h"
+
+// Start and stop conditions, plus the repeated start of a read, each take
+// roughly one SCL period on the wire.
+#define I2C_BUS_CONDITION_BITS 1
+#define I2C_BUS_BITS_PER_BYTE 9
+
+static i2c_bus_t *buses[I2C_BUS_MAX_PORTS];
+
+static void i2c_bus_account(i2c_bus_t *bus, esp_err_t result, size_t reg_size, size_t data_size, bool is_read);
+
+esp_err_t i2c_bus_attach(i2c_bus_t *bus)
+{
+    if (!bus || !bus->ops || bus->port < 0 || bus->port >= I2C_BUS_MAX_PORTS)
+        return ESP_ERR_INVALID_ARG;
+
+    if (!bus->lock)
+    {
+        bus->lock = xSemaphoreCreateMutex();
+
+        if (!bus->lock)
+            return ESP_ERR_NO_MEM;
+    }
+
+    buses[bus->port] = bus;
+    return ESP_OK;
+}
+
+esp_err_t i2c_bus_detach(int port)
+{
+    if (port < 0 || port >= I2C_BUS_MAX_PORTS)
+        return ESP_ERR_INVALID_ARG;
+
+    buses[port] = NULL;
+    return ESP_OK;
+}
+
+i2c_bus_t *i2c_bus_get(int port)
+{
+    if (port < 0 || port >= I2C_BUS_MAX_PORTS)
+        return NULL;
+
+    return buses[port];
+}
+
+esp_err_t i2c_bus_lock(i2c_bus_t *bus, i2c_bus_priority_t priority)
+{
+    if (!bus || !bus->lock)
+        return ESP_ERR_INVALID_STATE;
+
+    TickType_t timeout = pdMS_TO_TICKS(CONFIG_I2C_BUS_LOCK_TIMEOUT);
+
+    if (priority == I2C_BUS_PRIORITY_HIGH)
+    {
+        __atomic_add_fetch(&bus->high_priority_waiters, 1, __ATOMIC_SEQ_CST);
+        BaseType_t taken = xSemaphoreTake(bus->lock, timeout);
+        __atomic_sub_fetch(&bus->high_priority_waiters, 1, __ATOMIC_SEQ_CST);
+
+        return taken ? ESP_OK : ESP_ERR_TIMEOUT;
+    }
+
+    TickType_t start = xTaskGetTickCount();
+
+    for (;;)
+    {
+        TickType_t elapsed = xTaskGetTickCount() - start;
+
+        if (elapsed >= timeout || !xSemaphoreTake(bus->lock, timeout - elapsed))
+            return ESP_ERR_TIMEOUT;
+
+        if (!__atomic_load_n(&bus->high_priority_waiters, __ATOMIC_SEQ_CST))
+            return ESP_OK;
+
+        // Hand the bus over; the waiter only owns the mutex once it runs
+        xSemaphoreGive(bus->lock);
+        vTaskDelay(1);
+    }
+}
+
+void i2c_bus_unlock(i2c_bus_t *bus)
+{
+    xSemaphoreGive(bus->lock);
+}
+
+esp_err_t i2c_bus_write_locked(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, const uint8_t *data, size_t data_size)
+{
+    esp_err_t result = bus->ops->write(bus, address, reg, reg_size, data, data_size);
+    i2c_bus_account(bus, result, reg_size, data_size, false);
+    return result;
+}
+
+esp_err_t i2c_bus_read_locked(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, uint8_t *data, size_t data_size)
+{
+    esp_err_t result = bus->ops->read(bus, address, reg, reg_size, data, data_size);
+    i2c_bus_account(bus, result, reg_size, data_size, true);
+    return result;
+}
+
+esp_err_t i2c_bus_write(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, const uint8_t *data, size_t data_size)
+{
+    esp_err_t result = i2c_bus_lock(bus, I2C_BUS_PRIORITY_NORMAL);
+
+    if (result != ESP_OK)
+        return result;
+
+    result = i2c_bus_write_locked(bus, address, reg, reg_size, data, data_size);
+    i2c_bus_unlock(bus);
+    return result;
+}
+
+esp_err_t i2c_bus_read(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, uint8_t *data, size_t data_size)
+{
+    esp_err_t result = i2c_bus_lock(bus, I2C_BUS_PRIORITY_NORMAL);
+
+    if (result != ESP_OK)
+        return result;
+
+    result = i2c_bus_read_locked(bus, address, reg, reg_size, data, data_size);
+    i2c_bus_unlock(bus);
+    return result;
+}
+
+esp_err_t i2c_bus_execute(i2c_bus_t *bus, i2c_bus_transaction_t *transactions, size_t count, i2c_bus_priority_t priority)
+{
+    esp_err_t result = i2c_bus_lock(bus, priority);
+
+    if (result != ESP_OK)
+        return result;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        i2c_bus_transaction_t *transaction = &transactions[i];
+
+        // Between transactions, a NORMAL batch lets a waiting HIGH request through
+        if (i > 0 && priority != I2C_BUS_PRIORITY_HIGH && __atomic_load_n(&bus->high_priority_waiters, __ATOMIC_SEQ_CST))
+        {
+            i2c_bus_unlock(bus);
+            esp_err_t locked = i2c_bus_lock(bus, priority);
+
+            if (locked != ESP_OK)
+            {
+                for (size_t j = i; j < count; j++)
+                    transactions[j].result = locked;
+
+                return result == ESP_OK ? locked : result;
+            }
+        }
+
+        transaction->result = transaction->is_read
+                                  ? i2c_bus_read_locked(bus, transaction->address, &transaction->reg, 1, transaction->data, transaction->size)
+                                  : i2c_bus_write_locked(bus, transaction->address, &transaction->reg, 1, transaction->data, transaction->size);
+
+        if (result == ESP_OK)
+            result = transaction->result;
+    }
+
+    i2c_bus_unlock(bus);
+    return result;
+}
+
+esp_err_t i2c_bus_write_reg(i2c_bus_t *bus, uint8_t address, uint8_t reg, const uint8_t *data, size_t data_size)
+{
+    return i2c_bus_write(bus, address, &reg, 1, data, data_size);
+}
+
+esp_err_t i2c_bus_read_reg(i2c_bus_t *bus, uint8_t address, uint8_t reg, uint8_t *data, size_t data_size)
+{
+    return i2c_bus_read(bus, address, &reg, 1, data, data_size);
+}
+
+uint32_t i2c_bus_transfer_time_ns(uint32_t clk_speed, size_t reg_size, size_t data_size, bool is_read)
+{
+    if (clk_speed == 0)
+        return 0;
+
+    // START + address + register + data + STOP
+    uint32_t bits = 2 * I2C_BUS_CONDITION_BITS + (1 + reg_size + data_size) * I2C_BUS_BITS_PER_BYTE;
+
+    // Reads with a register pointer need a repeated START and a second address byte
+    if (is_read && reg_size > 0)
+        bits += I2C_BUS_CONDITION_BITS + I2C_BUS_BITS_PER_BYTE;
+
+    return (uint32_t)((uint64_t)bits * 1000000000ULL / clk_speed);
+}
+
+void i2c_bus_reset_stats(i2c_bus_t *bus)
+{
+    memset(&bus->stats, 0, sizeof(bus->stats));
+}
+
+static void i2c_bus_account(i2c_bus_t *bus, esp_err_t result, size_t reg_size, size_t data_size, bool is_read)
+{
+    bus->stats.transactions++;
+    bus->stats.bus_time_ns += i2c_bus_transfer_time_ns(bus->clk_speed, reg_size, data_size, is_read);
+
+    if (result != ESP_OK)
+    {
+        bus->stats.errors++;
+        return;
+    }
+
+    bus->stats.bytes_written += reg_size + (is_read ? 0 : data_size);
+    bus->stats.bytes_read += is_read ? data_size : 0;
+}
@@ -0,0 +1,202 @@
+#include <esp_log.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "i2c_bus_esp.h"
+
+static const char *TAG = "i2c_bus";
+
+typedef struct i2c_bus_esp_context_t
+{
+    TickType_t timeout;
+    i2c_config_t config;
+    bool installed;
+} i2c_bus_esp_context_t;
+
+static esp_err_t i2c_bus_esp_write(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, const uint8_t *data, size_t data_size);
+static esp_err_t i2c_bus_esp_read(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, uint8_t *data, size_t data_size);
+static bool config_equal(const i2c_config_t *a, const i2c_config_t *b);
+
+static const i2c_bus_ops_t i2c_bus_esp_ops = {
+    .write = i2c_bus_esp_write,
+    .read = i2c_bus_esp_read,
+};
+
+static i2c_bus_t buses[I2C_NUM_MAX];
+static i2c_bus_esp_context_t contexts[I2C_NUM_MAX];
+static portMUX_TYPE open_lock = portMUX_INITIALIZER_UNLOCKED;
+
+esp_err_t i2c_bus_esp_init(i2c_bus_t *bus, i2c_port_t port, uint32_t clk_speed, TickType_t timeout)
+{
+    if (!bus || port >= I2C_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+
+    contexts[port].timeout = timeout;
+
+    // Keep the lock of a bus being reinitialized
+    SemaphoreHandle_t lock = bus->lock;
+
+    *bus = (i2c_bus_t){
+        .ops = &i2c_bus_esp_ops,
+        .port = port,
+        .clk_speed = clk_speed,
+        .hardware = true,
+        .context = &contexts[port],
+        .lock = lock,
+    };
+
+    return ESP_OK;
+}
+
+i2c_bus_t *i2c_bus_esp_open(i2c_port_t port, const i2c_config_t *config, TickType_t timeout)
+{
+    if (port >= I2C_NUM_MAX || !config)
+        return NULL;
+
+    i2c_bus_t *bus = i2c_bus_get(port);
+    i2c_bus_esp_context_t *context = &contexts[port];
+
+    if (bus && !bus->hardware)
+        return bus;
+
+    if (bus && context->installed)
+    {
+        if (!config_equal(config, &context->config))
+            ESP_LOGW(TAG, "Port %d is already configured differently, sharing the installed driver", port);
+
+        return bus;
+    }
+
+    // Two drivers may race to open the same port during startup
+    portENTER_CRITICAL(&open_lock);
+    bool claimed = !context->installed;
+    context->installed = true;
+    portEXIT_CRITICAL(&open_lock);
+
+    if (!claimed)
+    {
+        TickType_t start = xTaskGetTickCount();
+
+        // Until the claiming opener attaches the bus, gives up or times out
+        while (!i2c_bus_get(port))
+        {
+            portENTER_CRITICAL(&open_lock);
+            bool installing = context->installed;
+            portEXIT_CRITICAL(&open_lock);
+
+            if (!installing || xTaskGetTickCount() - start >= pdMS_TO_TICKS(CONFIG_I2C_BUS_LOCK_TIMEOUT))
+            {
+                ESP_LOGE(TAG, "Port %d was not opened by the concurrent opener", port);
+                return NULL;
+            }
+            vTaskDelay(1);
+        }
+
+        return i2c_bus_get(port);
+    }
+
+    i2c_config_t temp = *config;
+    temp.mode = I2C_MODE_MASTER;
+
+    // The ISR stays in IRAM so transfers keep completing while flash writes disable the cache
+    if (i2c_param_config(port, &temp) != ESP_OK ||
+        i2c_driver_install(port, temp.mode, 0, 0, ESP_INTR_FLAG_IRAM) != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Could not install I2C driver on port %d", port);
+        context->installed = false;
+        return NULL;
+    }
+
+    context->config = temp;
+    i2c_bus_esp_init(&buses[port], port, temp.master.clk_speed, timeout);
+
+    if (i2c_bus_attach(&buses[port]) != ESP_OK)
+    {
+        i2c_driver_delete(port);
+        context->installed = false;
+        return NULL;
+    }
+
+    ESP_LOGD(TAG, "I2C driver installed on port %d", port);
+    return &buses[port];
+}
+
+esp_err_t i2c_bus_esp_close(i2c_port_t port)
+{
+    if (port >= I2C_NUM_MAX)
+        return ESP_ERR_INVALID_ARG;
+
+    if (!contexts[port].installed)
+        return ESP_OK;
+
+    i2c_bus_t *bus = &buses[port];
+    esp_err_t result = i2c_bus_lock(bus, I2C_BUS_PRIORITY_HIGH);
+
+    if (result != ESP_OK)
+        return result;
+
+    i2c_bus_detach(port);
+    i2c_driver_delete(port);
+    contexts[port].installed = false;
+    i2c_bus_unlock(bus);
+
+    return ESP_OK;
+}
+
+static esp_err_t i2c_bus_esp_write(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, const uint8_t *data, size_t data_size)
+{
+    i2c_bus_esp_context_t *context = bus->context;
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, address << 1 | I2C_MASTER_WRITE, true);
+    if (reg && reg_size)
+        i2c_master_write(cmd, (uint8_t *)reg, reg_size, true);
+    if (data && data_size)
+        i2c_master_write(cmd, (uint8_t *)data, data_size, true);
+    i2c_master_stop(cmd);
+
+    esp_err_t result = i2c_master_cmd_begin(bus->port, cmd, context->timeout);
+    i2c_cmd_link_delete(cmd);
+
+    if (result != ESP_OK)
+        ESP_LOGE(TAG, "Could not write to device [0x%02x at %d]: %d", address, bus->port, result);
+
+    return result;
+}
+
+static esp_err_t i2c_bus_esp_read(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, uint8_t *data, size_t data_size)
+{
+    if (!data || !data_size)
+        return ESP_ERR_INVALID_ARG;
+
+    i2c_bus_esp_context_t *context = bus->context;
+    i2c_cmd_handle_t cmd = i2c_cmd_link_create();
+
+    if (reg && reg_size)
+    {
+        i2c_master_start(cmd);
+        i2c_master_write_byte(cmd, address << 1 | I2C_MASTER_WRITE, true);
+        i2c_master_write(cmd, (uint8_t *)reg, reg_size, true);
+    }
+    i2c_master_start(cmd);
+    i2c_master_write_byte(cmd, address << 1 | I2C_MASTER_READ, true);
+    i2c_master_read(cmd, data, data_size, I2C_MASTER_LAST_NACK);
+    i2c_master_stop(cmd);
+
+    esp_err_t result = i2c_master_cmd_begin(bus->port, cmd, context->timeout);
+    i2c_cmd_link_delete(cmd);
+
+    if (result != ESP_OK)
+        ESP_LOGE(TAG, "Could not read from device [0x%02x at %d]: %d", address, bus->port, result);
+
+    return result;
+}
+
+static bool config_equal(const i2c_config_t *a, const i2c_config_t *b)
+{
+    return a->scl_io_num == b->scl_io_num &&
+           a->sda_io_num == b->sda_io_num &&
+           a->master.clk_speed == b->master.clk_speed &&
+           a->scl_pullup_en == b->scl_pullup_en &&
+           a->sda_pullup_en == b->sda_pullup_en;
+}
@@ -0,0 +1,350 @@
+#include <stdint.h>
+#include <string.h>
+#include "i2c_bus_sim.h"
+
+// Register addresses mirror components/mpu9250 and components/ds3231. They
+// are repeated here so the simulator does not depend on the drivers.
+#define MPU9250_WHO_AM_I 0x75
+#define MPU9250_WHO_AM_I_RESPONSE 0x71
+#define MPU9250_ACCEL_XOUT_H 0x3b
+#define MPU9250_TEMP_OUT_H 0x41
+#define MPU9250_GYRO_XOUT_H 0x43
+#define MPU9250_EXT_SENS_DATA_00 0x49
+#define MPU9250_RA_INT_PIN_CFG 0x37
+#define MPU9250_RA_PWR_MGMT_1 0x6b
+#define MPU9250_INTCFG_BYPASS_EN_BIT 1
+#define MPU9250_PWR1_DEVICE_RESET_BIT 7
+#define MPU9250_PWR1_SLEEP_BIT 6
+
+#define AK8963_ADDRESS 0x0c
+#define AK8963_WHO_AM_I 0x00
+#define AK8963_WHO_AM_I_RESPONSE 0x48
+#define AK8963_ST1 0x02
+#define AK8963_XOUT_L 0x03
+#define AK8963_ST2 0x09
+#define AK8963_ASAX 0x10
+#define AK8963_ST1_DRDY_BIT 0
+
+#define DS3231_ADDR_TIME 0x00
+#define DS3231_ADDR_STATUS 0x0f
+#define DS3231_STAT_OSCILLATOR 0x80
+
+#define PCA9685_MODE1 0x00
+#define PCA9685_MODE2 0x01
+#define PCA9685_LED0_ON_L 0x06
+#define PCA9685_ALL_LED_ON_L 0xfa
+#define PCA9685_PRE_SCALE 0xfe
+#define PCA9685_MODE1_RESTART_BIT 7
+#define PCA9685_MODE1_SLEEP_BIT 4
+#define PCA9685_FULL_BIT 4
+#define PCA9685_CHANNELS 16
+#define PCA9685_OSCILLATOR 25000000.f
+
+static esp_err_t i2c_bus_sim_write(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, const uint8_t *data, size_t data_size);
+static esp_err_t i2c_bus_sim_read(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, uint8_t *data, size_t data_size);
+static i2c_sim_device_t *i2c_bus_sim_select(i2c_bus_sim_t *sim, uint8_t address);
+static void mpu9250_reset(i2c_sim_device_t *device);
+static void mpu9250_on_write(i2c_sim_device_t *device, uint8_t reg, uint8_t value);
+static bool ak8963_is_present(const i2c_sim_device_t *device);
+static void ak8963_on_read(i2c_sim_device_t *device, uint8_t reg);
+static void pca9685_on_write(i2c_sim_device_t *device, uint8_t reg, uint8_t value);
+static uint8_t dec2bcd(uint8_t val);
+
+static const i2c_bus_ops_t i2c_bus_sim_ops = {
+    .write = i2c_bus_sim_write,
+    .read = i2c_bus_sim_read,
+};
+
+esp_err_t i2c_bus_sim_init(i2c_bus_t *bus, i2c_bus_sim_t *sim, int port, uint32_t clk_speed)
+{
+    if (!bus || !sim)
+        return ESP_ERR_INVALID_ARG;
+
+    memset(sim, 0, sizeof(*sim));
+
+    *bus = (i2c_bus_t){
+        .ops = &i2c_bus_sim_ops,
+        .port = port,
+        .clk_speed = clk_speed,
+        .hardware = false,
+        .context = sim,
+    };
+
+    return ESP_OK;
+}
+
+i2c_sim_device_t *i2c_bus_sim_add_device(i2c_bus_sim_t *sim, uint8_t address)
+{
+    if (sim->device_count >= I2C_BUS_SIM_MAX_DEVICES || i2c_bus_sim_find_device(sim, address))
+        return NULL;
+
+    i2c_sim_device_t *device = &sim->devices[sim->device_count++];
+    memset(device, 0, sizeof(*device));
+    device->address = address;
+    return device;
+}
+
+i2c_sim_device_t *i2c_bus_sim_find_device(i2c_bus_sim_t *sim, uint8_t address)
+{
+    for (size_t i = 0; i < sim->device_count; i++)
+    {
+        if (sim->devices[i].address == address)
+            return &sim->devices[i];
+    }
+
+    return NULL;
+}
+
+i2c_sim_device_t *i2c_bus_sim_add_mpu9250(i2c_bus_sim_t *sim, uint8_t address, i2c_sim_device_t **magnetometer)
+{
+    i2c_sim_device_t *device = i2c_bus_sim_add_device(sim, address);
+
+    if (!device)
+        return NULL;
+
+    device->on_write = mpu9250_on_write;
+    mpu9250_reset(device);
+
+    if (magnetometer)
+    {
+        i2c_sim_device_t *ak8963 = i2c_bus_sim_add_device(sim, AK8963_ADDRESS);
+
+        if (ak8963)
+        {
+            ak8963->registers[AK8963_WHO_AM_I] = AK8963_WHO_AM_I_RESPONSE;
+            // Sensitivity adjustment of 128 maps to a factor of exactly 1
+            memset(&ak8963->registers[AK8963_ASAX], 128, 3);
+            ak8963->is_present = ak8963_is_present;
+            ak8963->on_read = ak8963_on_read;
+            ak8963->context = device;
+        }
+
+        *magnetometer = ak8963;
+    }
+
+    return device;
+}
+
+i2c_sim_device_t *i2c_bus_sim_add_ds3231(i2c_bus_sim_t *sim, uint8_t address)
+{
+    i2c_sim_device_t *device = i2c_bus_sim_add_device(sim, address);
+
+    if (device)
+        device->registers[DS3231_ADDR_STATUS] = DS3231_STAT_OSCILLATOR;
+
+    return device;
+}
+
+i2c_sim_device_t *i2c_bus_sim_add_pca9685(i2c_bus_sim_t *sim, uint8_t address)
+{
+    i2c_sim_device_t *device = i2c_bus_sim_add_device(sim, address);
+
+    if (!device)
+        return NULL;
+
+    // Asleep, answering the all call address, every output fully off at 200 Hz
+    device->registers[PCA9685_MODE1] = 0x11;
+    device->registers[PCA9685_MODE2] = 0x04;
+    for (int channel = 0; channel < PCA9685_CHANNELS; channel++)
+        device->registers[PCA9685_LED0_ON_L + 4 * channel + 3] = 1 << PCA9685_FULL_BIT;
+    device->registers[PCA9685_PRE_SCALE] = 0x1e;
+    device->on_write = pca9685_on_write;
+    // Keeps the prescaler last accepted, to undo writes while awake
+    device->context = (void *)(uintptr_t)device->registers[PCA9685_PRE_SCALE];
+
+    return device;
+}
+
+void i2c_bus_sim_set_mpu9250_sample(i2c_sim_device_t *device, const int16_t accel[3], const int16_t gyro[3], int16_t temperature)
+{
+    for (int i = 0; i < 3; i++)
+    {
+        device->registers[MPU9250_ACCEL_XOUT_H + 2 * i] = (uint16_t)accel[i] >> 8;
+        device->registers[MPU9250_ACCEL_XOUT_H + 2 * i + 1] = (uint16_t)accel[i] & 0xff;
+        device->registers[MPU9250_GYRO_XOUT_H + 2 * i] = (uint16_t)gyro[i] >> 8;
+        device->registers[MPU9250_GYRO_XOUT_H + 2 * i + 1] = (uint16_t)gyro[i] & 0xff;
+    }
+
+    device->registers[MPU9250_TEMP_OUT_H] = (uint16_t)temperature >> 8;
+    device->registers[MPU9250_TEMP_OUT_H + 1] = (uint16_t)temperature & 0xff;
+}
+
+void i2c_bus_sim_set_ak8963_sample(i2c_sim_device_t *device, const int16_t magnet[3])
+{
+    // AK8963 output registers are little endian
+    for (int i = 0; i < 3; i++)
+    {
+        device->registers[AK8963_XOUT_L + 2 * i] = (uint16_t)magnet[i] & 0xff;
+        device->registers[AK8963_XOUT_L + 2 * i + 1] = (uint16_t)magnet[i] >> 8;
+    }
+
+    device->registers[AK8963_ST1] |= 1 << AK8963_ST1_DRDY_BIT;
+}
+
+void i2c_bus_sim_set_mpu9250_external_magnet(i2c_sim_device_t *device, const int16_t magnet[3])
+{
+    uint8_t *registers = &device->registers[MPU9250_EXT_SENS_DATA_00];
+
+    for (int i = 0; i < 3; i++)
+    {
+        registers[2 * i] = (uint16_t)magnet[i] & 0xff;
+        registers[2 * i + 1] = (uint16_t)magnet[i] >> 8;
+    }
+
+    // ST2, no overflow
+    registers[AK8963_ST2 - AK8963_XOUT_L] = 0;
+}
+
+void i2c_bus_sim_set_ds3231_time(i2c_sim_device_t *device, const struct tm *time)
+{
+    uint8_t *registers = &device->registers[DS3231_ADDR_TIME];
+
+    registers[0] = dec2bcd(time->tm_sec);
+    registers[1] = dec2bcd(time->tm_min);
+    registers[2] = dec2bcd(time->tm_hour);
+    registers[3] = dec2bcd(time->tm_wday + 1);
+    registers[4] = dec2bcd(time->tm_mday);
+    registers[5] = dec2bcd(time->tm_mon + 1);
+    registers[6] = dec2bcd(time->tm_year - 100);
+}
+
+float i2c_bus_sim_get_pca9685_pulse_width(const i2c_sim_device_t *device, int channel)
+{
+    const uint8_t *led = &device->registers[PCA9685_LED0_ON_L + 4 * channel];
+
+    if ((device->registers[PCA9685_MODE1] & (1 << PCA9685_MODE1_SLEEP_BIT)) || (led[3] & (1 << PCA9685_FULL_BIT)))
+        return 0.f;
+
+    float period = 1e6f * 4096 * (device->registers[PCA9685_PRE_SCALE] + 1) / PCA9685_OSCILLATOR;
+
+    if (led[1] & (1 << PCA9685_FULL_BIT))
+        return period;
+
+    uint16_t on = led[0] | (led[1] & 0x0f) << 8;
+    uint16_t off = led[2] | (led[3] & 0x0f) << 8;
+
+    return period * ((off - on) & 0xfff) / 4096;
+}
+
+static esp_err_t i2c_bus_sim_write(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, const uint8_t *data, size_t data_size)
+{
+    i2c_sim_device_t *device = i2c_bus_sim_select(bus->context, address);
+
+    // No ACK on the address byte
+    if (!device)
+        return ESP_FAIL;
+
+    const uint8_t *bytes[] = {reg, data};
+    size_t sizes[] = {reg_size, data_size};
+    bool has_pointer = false;
+
+    for (int part = 0; part < 2; part++)
+    {
+        for (size_t i = 0; bytes[part] && i < sizes[part]; i++)
+        {
+            // The first byte of a write sets the register pointer
+            if (!has_pointer)
+            {
+                device->pointer = bytes[part][i];
+                has_pointer = true;
+                continue;
+            }
+
+            uint8_t target = device->pointer++;
+            device->registers[target] = bytes[part][i];
+
+            if (device->on_write)
+                device->on_write(device, target, bytes[part][i]);
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t i2c_bus_sim_read(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, uint8_t *data, size_t data_size)
+{
+    if (!data || !data_size)
+        return ESP_ERR_INVALID_ARG;
+
+    i2c_sim_device_t *device = i2c_bus_sim_select(bus->context, address);
+
+    if (!device)
+        return ESP_FAIL;
+
+    if (reg && reg_size)
+        device->pointer = reg[0];
+
+    for (size_t i = 0; i < data_size; i++)
+    {
+        uint8_t source = device->pointer++;
+        data[i] = device->registers[source];
+
+        if (device->on_read)
+            device->on_read(device, source);
+    }
+
+    return ESP_OK;
+}
+
+static i2c_sim_device_t *i2c_bus_sim_select(i2c_bus_sim_t *sim, uint8_t address)
+{
+    i2c_sim_device_t *device = i2c_bus_sim_find_device(sim, address);
+
+    if (device && device->is_present && !device->is_present(device))
+        return NULL;
+
+    return device;
+}
+
+static void mpu9250_reset(i2c_sim_device_t *device)
+{
+    memset(device->registers, 0, sizeof(device->registers));
+    device->registers[MPU9250_WHO_AM_I] = MPU9250_WHO_AM_I_RESPONSE;
+    device->registers[MPU9250_RA_PWR_MGMT_1] = 1 << MPU9250_PWR1_SLEEP_BIT;
+}
+
+static void mpu9250_on_write(i2c_sim_device_t *device, uint8_t reg, uint8_t value)
+{
+    // DEVICE_RESET restores the power-on values and clears itself
+    if (reg == MPU9250_RA_PWR_MGMT_1 && (value & (1 << MPU9250_PWR1_DEVICE_RESET_BIT)))
+        mpu9250_reset(device);
+}
+
+static bool ak8963_is_present(const i2c_sim_device_t *device)
+{
+    const i2c_sim_device_t *mpu9250 = device->context;
+    return mpu9250->registers[MPU9250_RA_INT_PIN_CFG] & (1 << MPU9250_INTCFG_BYPASS_EN_BIT);
+}
+
+static void ak8963_on_read(i2c_sim_device_t *device, uint8_t reg)
+{
+    // Reading ST2 ends the measurement read cycle
+    if (reg == AK8963_ST2)
+        device->registers[AK8963_ST1] &= ~(1 << AK8963_ST1_DRDY_BIT);
+}
+
+static void pca9685_on_write(i2c_sim_device_t *device, uint8_t reg, uint8_t value)
+{
+    if (reg == PCA9685_PRE_SCALE)
+    {
+        if (device->registers[PCA9685_MODE1] & (1 << PCA9685_MODE1_SLEEP_BIT))
+            device->context = (void *)(uintptr_t)value;
+        else
+            device->registers[PCA9685_PRE_SCALE] = (uintptr_t)device->context;
+    }
+    // RESTART clears itself
+    else if (reg == PCA9685_MODE1)
+    {
+        device->registers[PCA9685_MODE1] &= ~(1 << PCA9685_MODE1_RESTART_BIT);
+    }
+    else if (reg >= PCA9685_ALL_LED_ON_L && reg < PCA9685_ALL_LED_ON_L + 4)
+    {
+        for (int channel = 0; channel < PCA9685_CHANNELS; channel++)
+            device->registers[PCA9685_LED0_ON_L + 4 * channel + reg - PCA9685_ALL_LED_ON_L] = value;
+    }
+}
+
+static uint8_t dec2bcd(uint8_t val)
+{
+    return ((val / 10) << 4) + (val % 10);
+}
@@ -0,0 +1,130 @@
+#ifndef __I2C_BUS_H__
+#define __I2C_BUS_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#define I2C_BUS_MAX_PORTS 2
+
+typedef struct i2c_bus_t i2c_bus_t;
+
+/**
+ * Backend operations. Both calls address a 7-bit (unshifted) peripheral.
+ *
+ * `write` sends `reg` followed by `data` in a single transaction.
+ * `read` sends `reg` (if any), issues a repeated start and reads `data_size` bytes.
+ */
+typedef struct i2c_bus_ops_t
+{
+    esp_err_t (*write)(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, const uint8_t *data, size_t data_size);
+    esp_err_t (*read)(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, uint8_t *data, size_t data_size);
+} i2c_bus_ops_t;
+
+/**
+ * Traffic counters, updated by every backend. `bus_time_ns` is the time the
+ * transfers occupy the wire at `clk_speed`, excluding driver overhead.
+ */
+typedef struct i2c_bus_stats_t
+{
+    uint32_t transactions;
+    uint32_t errors;
+    uint32_t bytes_written;
+    uint32_t bytes_read;
+    uint64_t bus_time_ns;
+} i2c_bus_stats_t;
+
+/**
+ * Lock priorities. A NORMAL holder yields the bus between its transactions
+ * whenever a HIGH request (the IMU sampling path) is waiting for it.
+ */
+typedef enum i2c_bus_priority_t
+{
+    I2C_BUS_PRIORITY_NORMAL,
+    I2C_BUS_PRIORITY_HIGH,
+} i2c_bus_priority_t;
+
+/**
+ * One register transaction of a batch. `result` is filled in by
+ * ::i2c_bus_execute().
+ */
+typedef struct i2c_bus_transaction_t
+{
+    uint8_t address;
+    uint8_t reg;
+    bool is_read;
+    uint8_t *data;
+    size_t size;
+    esp_err_t result;
+} i2c_bus_transaction_t;
+
+struct i2c_bus_t
+{
+    const i2c_bus_ops_t *ops;
+    int port;
+    uint32_t clk_speed;
+    bool hardware; //!< Drives a real I2C peripheral, the driver is owned by the backend
+    void *context;
+    i2c_bus_stats_t stats;
+    SemaphoreHandle_t lock;
+    volatile uint32_t high_priority_waiters;
+};
+
+/**
+ * @brief Make `bus` the bus used by all drivers talking to `bus->port`
+ *
+ * Attaching a simulated bus before the sensors are initialized runs the
+ * drivers against the simulated register maps instead of the hardware.
+ */
+esp_err_t i2c_bus_attach(i2c_bus_t *bus);
+esp_err_t i2c_bus_detach(int port);
+
+/**
+ * @return The bus attached to `port`, or NULL
+ */
+i2c_bus_t *i2c_bus_get(int port);
+
+/**
+ * @brief Take exclusive ownership of the bus
+ *
+ * Every transfer function takes the lock itself; holding it explicitly is
+ * only needed to keep several transfers (or a device reconfiguration and a
+ * transfer) together, using the `_locked` variants.
+ *
+ * @return ESP_ERR_TIMEOUT if the bus could not be taken in CONFIG_I2C_BUS_LOCK_TIMEOUT ms
+ */
+esp_err_t i2c_bus_lock(i2c_bus_t *bus, i2c_bus_priority_t priority);
+void i2c_bus_unlock(i2c_bus_t *bus);
+
+esp_err_t i2c_bus_write_locked(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, const uint8_t *data, size_t data_size);
+esp_err_t i2c_bus_read_locked(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, uint8_t *data, size_t data_size);
+
+esp_err_t i2c_bus_write(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, const uint8_t *data, size_t data_size);
+esp_err_t i2c_bus_read(i2c_bus_t *bus, uint8_t address, const uint8_t *reg, size_t reg_size, uint8_t *data, size_t data_size);
+
+/**
+ * @brief Run `count` register transactions back-to-back under one lock acquisition
+ *
+ * A NORMAL batch releases the bus between two transactions while a HIGH
+ * request waits, then takes it back. Each transaction records its own result;
+ * the ones left when the bus cannot be taken back record the lock error.
+ *
+ * @return ESP_OK if every transaction succeeded, otherwise the first error
+ */
+esp_err_t i2c_bus_execute(i2c_bus_t *bus, i2c_bus_transaction_t *transactions, size_t count, i2c_bus_priority_t priority);
+
+esp_err_t i2c_bus_write_reg(i2c_bus_t *bus, uint8_t address, uint8_t reg, const uint8_t *data, size_t data_size);
+esp_err_t i2c_bus_read_reg(i2c_bus_t *bus, uint8_t address, uint8_t reg, uint8_t *data, size_t data_size);
+
+/**
+ * @return Wire time of a transfer in nanoseconds, including start, address,
+ * repeated start and stop conditions.
+ */
+uint32_t i2c_bus_transfer_time_ns(uint32_t clk_speed, size_t reg_size, size_t data_size, bool is_read);
+
+void i2c_bus_reset_stats(i2c_bus_t *bus);
+
+#endif // __I2C_BUS_H__
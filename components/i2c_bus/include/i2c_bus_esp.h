@@ -0,0 +1,35 @@
+#ifndef __I2C_BUS_ESP_H__
+#define __I2C_BUS_ESP_H__
+
+#include <driver/i2c.h>
+#include <freertos/FreeRTOS.h>
+#include "i2c_bus.h"
+
+/**
+ * @brief Initialize a bus backed by the ESP-IDF I2C master driver
+ *
+ * The driver for `port` must be installed separately. Most callers want
+ * ::i2c_bus_esp_open() instead.
+ *
+ * @param timeout Command timeout passed to `i2c_master_cmd_begin`
+ */
+esp_err_t i2c_bus_esp_init(i2c_bus_t *bus, i2c_port_t port, uint32_t clk_speed, TickType_t timeout);
+
+/**
+ * @brief Get the bus owning `port`, installing the I2C driver on first use
+ *
+ * The first caller's configuration wins: later callers with a different
+ * configuration share the installed driver instead of reinstalling it, so
+ * drivers on the same port never thrash each other. If a simulated bus is
+ * attached to `port`, it is returned and the hardware is left untouched.
+ *
+ * @return NULL if the driver could not be installed
+ */
+i2c_bus_t *i2c_bus_esp_open(i2c_port_t port, const i2c_config_t *config, TickType_t timeout);
+
+/**
+ * @brief Uninstall the driver of a bus opened with ::i2c_bus_esp_open()
+ */
+esp_err_t i2c_bus_esp_close(i2c_port_t port);
+
+#endif // __I2C_BUS_ESP_H__
@@ -0,0 +1,77 @@
+#ifndef __I2C_BUS_SIM_H__
+#define __I2C_BUS_SIM_H__
+
+#include <time.h>
+#include "i2c_bus.h"
+
+#define I2C_BUS_SIM_MAX_DEVICES 8
+
+typedef struct i2c_sim_device_t i2c_sim_device_t;
+
+/**
+ * A simulated peripheral exposing a flat 8-bit register map with an
+ * auto-incrementing register pointer, the way the MPU9250, AK8963 and DS3231
+ * behave. The hooks model the registers with side effects.
+ */
+struct i2c_sim_device_t
+{
+    uint8_t address;
+    uint8_t registers[256];
+    uint8_t pointer;
+    bool (*is_present)(const i2c_sim_device_t *device);
+    void (*on_write)(i2c_sim_device_t *device, uint8_t reg, uint8_t value);
+    void (*on_read)(i2c_sim_device_t *device, uint8_t reg);
+    void *context;
+};
+
+typedef struct i2c_bus_sim_t
+{
+    i2c_sim_device_t devices[I2C_BUS_SIM_MAX_DEVICES];
+    size_t device_count;
+} i2c_bus_sim_t;
+
+/**
+ * @brief Initialize a bus whose transfers are served by `sim`
+ *
+ * Transfers are accounted in `bus->stats` exactly like on the hardware, so
+ * transaction counts and wire time per sample can be measured off-target.
+ */
+esp_err_t i2c_bus_sim_init(i2c_bus_t *bus, i2c_bus_sim_t *sim, int port, uint32_t clk_speed);
+
+i2c_sim_device_t *i2c_bus_sim_add_device(i2c_bus_sim_t *sim, uint8_t address);
+i2c_sim_device_t *i2c_bus_sim_find_device(i2c_bus_sim_t *sim, uint8_t address);
+
+/**
+ * @brief Add an MPU9250 with its power-on register values
+ *
+ * The returned device also hosts the auxiliary AK8963 when `magnetometer` is
+ * not NULL: the magnetometer only answers while the MPU9250 is in bypass mode.
+ */
+i2c_sim_device_t *i2c_bus_sim_add_mpu9250(i2c_bus_sim_t *sim, uint8_t address, i2c_sim_device_t **magnetometer);
+i2c_sim_device_t *i2c_bus_sim_add_ds3231(i2c_bus_sim_t *sim, uint8_t address);
+/**
+ * @brief Add a PCA9685 PWM expander with its power-on register values
+ *
+ * Writes to the ALL_LED registers reach every channel, the prescaler only
+ * takes while the oscillator sleeps.
+ */
+i2c_sim_device_t *i2c_bus_sim_add_pca9685(i2c_bus_sim_t *sim, uint8_t address);
+
+/**
+ * @brief Load raw sensor output registers, in device LSBs
+ */
+void i2c_bus_sim_set_mpu9250_sample(i2c_sim_device_t *device, const int16_t accel[3], const int16_t gyro[3], int16_t temperature);
+void i2c_bus_sim_set_ak8963_sample(i2c_sim_device_t *device, const int16_t magnet[3]);
+/**
+ * @brief Load the EXT_SENS_DATA registers of an MPU9250 as its auxiliary I2C
+ * master copies them from an AK8963 behind it, XOUT_L through ST2
+ */
+void i2c_bus_sim_set_mpu9250_external_magnet(i2c_sim_device_t *device, const int16_t magnet[3]);
+void i2c_bus_sim_set_ds3231_time(i2c_sim_device_t *device, const struct tm *time);
+/**
+ * @brief Pulse width (us) a PCA9685 channel outputs, 0 while it is off or the
+ * oscillator sleeps
+ */
+float i2c_bus_sim_get_pca9685_pulse_width(const i2c_sim_device_t *device, int channel);
+
+#endif // __I2C_BUS_SIM_H__
@@ -128,16 +128,26 @@ esp_err_t ak8963_get_mag(vector_t *v)
     return ret;
   }
 
+  ak8963_align_mag(bytes, v);
+  // ESP_LOGW(TAG, "mag     -> %0.4f %0.4f %0.4f", v->x, v->y, v->z);
+
+  return ESP_OK;
+}
+
+void ak8963_align_mag(const uint8_t bytes[6], vector_t *v)
+{
+  ak8963_align_mag_calibrated(bytes, &asa, cal, v);
+}
+
+void ak8963_align_mag_calibrated(const uint8_t bytes[6], const vector_t *asa, const calibration_t *c, vector_t *v)
+{
   float xi = (float)BYTE_2_INT_LE(bytes, 0);
   float yi = (float)BYTE_2_INT_LE(bytes, 2);
   float zi = (float)BYTE_2_INT_LE(bytes, 4);
 
-  v->x = (xi * asa.x - cal->mag_offset.x) * cal->mag_scale.x;
-  v->y = (yi * asa.y - cal->mag_offset.y) * cal->mag_scale.y;
-  v->z = (zi * asa.z - cal->mag_offset.z) * cal->mag_scale.z;
-  // ESP_LOGW(TAG, "mag     -> %0.4f %0.4f %0.4f", v->x, v->y, v->z);
-
-  return ESP_OK;
+  v->x = (xi * asa->x - c->mag_offset.x) * c->mag_scale.x;
+  v->y = (yi * asa->y - c->mag_offset.y) * c->mag_scale.y;
+  v->z = (zi * asa->z - c->mag_offset.z) * c->mag_scale.z;
 }
 
 esp_err_t ak8963_get_mag_raw(uint8_t bytes[6])
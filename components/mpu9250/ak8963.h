@@ -78,6 +78,13 @@ esp_err_t ak8963_get_sensitivity_adjustment_values();
 esp_err_t ak8963_get_mag(vector_t *v);
 esp_err_t ak8963_get_mag_raw(uint8_t bytes[6]);
 
+/**
+ * Convert raw little endian magnetometer bytes (from AK8963_XOUT_L) into calibrated values
+ * @name ak8963_align_mag
+ */
+void ak8963_align_mag(const uint8_t bytes[6], vector_t *v);
+void ak8963_align_mag_calibrated(const uint8_t bytes[6], const vector_t *asa, const calibration_t *c, vector_t *v);
+
 /**
  * @name getCNTL
  */
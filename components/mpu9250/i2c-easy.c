@@ -28,26 +28,16 @@
 #include "esp_system.h"
 #include "esp_err.h"
 
+#include "i2c_bus_esp.h"
 #include "i2c-easy.h"
 
-#define WRITE_BIT I2C_MASTER_WRITE /*!< I2C master write */
-#define READ_BIT I2C_MASTER_READ   /*!< I2C master read */
-#define ACK_CHECK_EN 0x1           /*!< I2C master will check ack from slave*/
-#define ACK_CHECK_DIS 0x0          /*!< I2C master will not check ack from slave */
-#define ACK_VAL 0x0                /*!< I2C ack value */
-#define NACK_VAL 0x1               /*!< I2C nack value */
-#define LAST_NACK_VAL 0x2          /*!< I2C last_nack value */
-
 #define I2C_FREQ_HZ 400000 /* I2C master clock frequency */
-#define I2C_TX_BUF_DISABLE 0 /* I2C master do not need buffer */
-#define I2C_RX_BUF_DISABLE 0
 
 /**
  * @brief i2c master initialization
  */
 esp_err_t i2c_master_init(uint8_t i2c_num, uint8_t gpio_sda, uint8_t gpio_scl)
 {
-  int i2c_master_port = i2c_num;
   i2c_config_t conf;
   conf.mode = I2C_MODE_MASTER;
   conf.sda_io_num = gpio_sda;
@@ -55,24 +45,19 @@ esp_err_t i2c_master_init(uint8_t i2c_num, uint8_t gpio_sda, uint8_t gpio_scl)
   conf.scl_io_num = gpio_scl;
   conf.scl_pullup_en = 0;
   conf.master.clk_speed = I2C_FREQ_HZ;
-  ESP_ERROR_CHECK(i2c_param_config(i2c_master_port, &conf));
-  ESP_ERROR_CHECK(i2c_driver_install(i2c_master_port, conf.mode, I2C_RX_BUF_DISABLE, I2C_TX_BUF_DISABLE,ESP_INTR_FLAG_IRAM));
+
+  // The port may already be owned by another driver (e.g. the DS3231), or by
+  // a simulated bus attached beforehand
+  if (!i2c_bus_esp_open(i2c_num, &conf, 1000 / portTICK_RATE_MS))
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
   return ESP_OK;
 }
 
 esp_err_t i2c_write_bytes(i2c_port_t i2c_num, uint8_t periph_address, uint8_t reg_address, uint8_t *data, size_t data_len)
 {
-  int ret;
-  i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-  i2c_master_start(cmd);
-  i2c_master_write_byte(cmd, periph_address << 1 | WRITE_BIT, ACK_CHECK_EN);
-  i2c_master_write_byte(cmd, reg_address, ACK_CHECK_EN);
-  i2c_master_write(cmd, data, data_len, ACK_CHECK_EN);
-  i2c_master_stop(cmd);
-  ret = i2c_master_cmd_begin(i2c_num, cmd, 1000 / portTICK_RATE_MS);
-  i2c_cmd_link_delete(cmd);
-
-  return ret;
+  return i2c_bus_write_reg(i2c_bus_get(i2c_num), periph_address, reg_address, data, data_len);
 }
 
 esp_err_t i2c_write_byte(i2c_port_t i2c_num, uint8_t periph_address, uint8_t reg_address, uint8_t data)
@@ -82,29 +67,7 @@ esp_err_t i2c_write_byte(i2c_port_t i2c_num, uint8_t periph_address, uint8_t reg
 
 esp_err_t i2c_read_bytes(i2c_port_t i2c_num, uint8_t periph_address, uint8_t reg_address, uint8_t *data, size_t data_len)
 {
-  int ret;
-  i2c_cmd_handle_t cmd = i2c_cmd_link_create();
-  i2c_master_start(cmd);
-  i2c_master_write_byte(cmd, periph_address << 1 | WRITE_BIT, ACK_CHECK_EN);
-  i2c_master_write_byte(cmd, reg_address, ACK_CHECK_EN);
-  i2c_master_stop(cmd);
-  ret = i2c_master_cmd_begin(i2c_num, cmd, 1000 / portTICK_RATE_MS);
-  i2c_cmd_link_delete(cmd);
-
-  if (ret != ESP_OK)
-  {
-    return ret;
-  }
-
-  cmd = i2c_cmd_link_create();
-  i2c_master_start(cmd);
-  i2c_master_write_byte(cmd, periph_address << 1 | READ_BIT, ACK_CHECK_EN);
-  i2c_master_read(cmd, data, data_len, LAST_NACK_VAL);
-  i2c_master_stop(cmd);
-  ret = i2c_master_cmd_begin(i2c_num, cmd, 1000 / portTICK_RATE_MS);
-  i2c_cmd_link_delete(cmd);
-
-  return ret;
+  return i2c_bus_read_reg(i2c_bus_get(i2c_num), periph_address, reg_address, data, data_len);
 }
 
 esp_err_t i2c_read_byte(i2c_port_t i2c_num, uint8_t periph_address, uint8_t reg_address, uint8_t *data)
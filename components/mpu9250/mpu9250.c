@@ -19,6 +19,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include "i2c_bus.h"
 #include "i2c-easy.h"
 #include "mpu9250.h"
 #include "ak8963.h"
@@ -33,11 +34,17 @@ static const char *TAG = "mpu9250";
 
 static bool initialised = false;
 calibration_t *cal;
+static bool secondary_initialised = false;
+static calibration_t *secondary_cal;
+static vector_t secondary_asa;
 
 static float gyro_inv_scale = 1.0;
 static float accel_inv_scale = 1.0;
 
 static esp_err_t enable_magnetometer(void);
+static esp_err_t secondary_enable_magnetometer(void);
+static esp_err_t secondary_slave_write(uint8_t reg, uint8_t value);
+static esp_err_t secondary_slave_read(uint8_t reg, uint8_t length);
 
 void choose_SCL_SDA_GPIO(gpio_num_t SCL,gpio_num_t SDA){
   I2C_MASTER_SCL_IO = SCL;
@@ -90,6 +97,79 @@ esp_err_t i2c_mpu9250_init(calibration_t *c)
   return ESP_OK;
 }
 
+esp_err_t i2c_mpu9250_init_secondary(calibration_t *c)
+{
+  ESP_LOGI(TAG, "Initializating secondary MPU9250");
+
+  if (!initialised)
+  {
+    ESP_LOGE(TAG, "i2c_mpu9250_init must be called before i2c_mpu9250_init_secondary");
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if (secondary_initialised)
+  {
+    ESP_LOGE(TAG, "i2c_mpu9250_init_secondary has already been called");
+    return ESP_ERR_INVALID_STATE;
+  }
+  secondary_cal = c;
+
+  uint8_t device_id;
+  esp_err_t ret = i2c_read_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_WHO_AM_I, &device_id);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "No secondary MPU9250 at 0x%02x", MPU9250_I2C_ADDR_SECONDARY);
+    return ret;
+  }
+
+  ret = i2c_write_bit(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_PWR_MGMT_1, MPU9250_PWR1_DEVICE_RESET_BIT, 1);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  vTaskDelay(10 / portTICK_RATE_MS);
+
+  // Same settings as the primary IMU, so both share the scale factors
+  ret = i2c_write_bits(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_PWR_MGMT_1, MPU9250_PWR1_CLKSEL_BIT, MPU9250_PWR1_CLKSEL_LENGTH, MPU9250_CLOCK_PLL_XGYRO);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  vTaskDelay(10 / portTICK_RATE_MS);
+
+  ret = i2c_write_bits(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_GYRO_CONFIG, MPU9250_GCONFIG_FS_SEL_BIT, MPU9250_GCONFIG_FS_SEL_LENGTH, MPU9250_GYRO_FS_250);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  vTaskDelay(10 / portTICK_RATE_MS);
+
+  ret = i2c_write_bits(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_ACCEL_CONFIG_1, MPU9250_ACONFIG_FS_SEL_BIT, MPU9250_ACONFIG_FS_SEL_LENGTH, MPU9250_ACCEL_FS_4);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  vTaskDelay(10 / portTICK_RATE_MS);
+
+  ret = i2c_write_bit(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_PWR_MGMT_1, MPU9250_PWR1_SLEEP_BIT, 0);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  vTaskDelay(10 / portTICK_RATE_MS);
+
+  ret = secondary_enable_magnetometer();
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  secondary_initialised = true;
+  ESP_LOGI(TAG, "Secondary MPU9250 initialized, device ID 0x%02x", device_id);
+
+  return ESP_OK;
+}
+
 esp_err_t set_clock_source(uint8_t adrs)
 {
   return i2c_write_bits(I2C_MASTER_NUM, MPU9250_I2C_ADDR, MPU9250_RA_PWR_MGMT_1, MPU9250_PWR1_CLKSEL_BIT, MPU9250_PWR1_CLKSEL_LENGTH, adrs);
@@ -196,15 +276,20 @@ float scale_accel(float value, float offset, float scale_lo, float scale_hi)
   }
 }
 
-void align_accel(uint8_t bytes[6], vector_t *v)
+void align_accel_calibrated(const uint8_t bytes[6], const calibration_t *c, vector_t *v)
 {
   int16_t xi = BYTE_2_INT_BE(bytes, 0);
   int16_t yi = BYTE_2_INT_BE(bytes, 2);
   int16_t zi = BYTE_2_INT_BE(bytes, 4);
 
-  v->x = scale_accel((float)xi, cal->accel_offset.x, cal->accel_scale_lo.x, cal->accel_scale_hi.x);
-  v->y = scale_accel((float)yi, cal->accel_offset.y, cal->accel_scale_lo.y, cal->accel_scale_hi.y);
-  v->z = scale_accel((float)zi, cal->accel_offset.z, cal->accel_scale_lo.z, cal->accel_scale_hi.z);
+  v->x = scale_accel((float)xi, c->accel_offset.x, c->accel_scale_lo.x, c->accel_scale_hi.x);
+  v->y = scale_accel((float)yi, c->accel_offset.y, c->accel_scale_lo.y, c->accel_scale_hi.y);
+  v->z = scale_accel((float)zi, c->accel_offset.z, c->accel_scale_lo.z, c->accel_scale_hi.z);
+}
+
+void align_accel(uint8_t bytes[6], vector_t *v)
+{
+  align_accel_calibrated(bytes, cal, v);
 }
 
 esp_err_t get_accel(vector_t *v)
@@ -224,15 +309,20 @@ esp_err_t get_accel(vector_t *v)
   return ESP_OK;
 }
 
-void align_gryo(uint8_t bytes[6], vector_t *v)
+void align_gryo_calibrated(const uint8_t bytes[6], const calibration_t *c, vector_t *v)
 {
   int16_t xi = BYTE_2_INT_BE(bytes, 0);
   int16_t yi = BYTE_2_INT_BE(bytes, 2);
   int16_t zi = BYTE_2_INT_BE(bytes, 4);
 
-  v->x = (float)xi * gyro_inv_scale + cal->gyro_bias_offset.x;
-  v->y = (float)yi * gyro_inv_scale + cal->gyro_bias_offset.y;
-  v->z = (float)zi * gyro_inv_scale + cal->gyro_bias_offset.z;
+  v->x = (float)xi * gyro_inv_scale + c->gyro_bias_offset.x;
+  v->y = (float)yi * gyro_inv_scale + c->gyro_bias_offset.y;
+  v->z = (float)zi * gyro_inv_scale + c->gyro_bias_offset.z;
+}
+
+void align_gryo(uint8_t bytes[6], vector_t *v)
+{
+  align_gryo_calibrated(bytes, cal, v);
 }
 
 esp_err_t get_gyro(vector_t *v)
@@ -273,14 +363,72 @@ esp_err_t get_accel_gyro(vector_t *va, vector_t *vg)
 
 esp_err_t get_accel_gyro_mag(vector_t *va, vector_t *vg, vector_t *vm)
 {
-  esp_err_t ret;
-  ret = get_accel_gyro(va, vg);
+  uint8_t accel_gyro[14];
+  // Reading through ST2 ends the magnetometer read cycle, so the next
+  // measurement can be latched.
+  uint8_t mag[AK8963_ST2 - AK8963_XOUT_L + 1];
+
+  // One lock acquisition for both devices, ahead of lower priority traffic
+  i2c_bus_transaction_t transactions[] = {
+      {.address = MPU9250_I2C_ADDR, .reg = MPU9250_ACCEL_XOUT_H, .is_read = true, .data = accel_gyro, .size = sizeof(accel_gyro)},
+      {.address = AK8963_ADDRESS, .reg = AK8963_XOUT_L, .is_read = true, .data = mag, .size = sizeof(mag)},
+  };
+
+  esp_err_t ret = i2c_bus_execute(i2c_bus_get(I2C_MASTER_NUM), transactions, 2, I2C_BUS_PRIORITY_HIGH);
   if (ret != ESP_OK)
   {
     return ret;
   }
 
-  return ak8963_get_mag(vm);
+  align_accel(accel_gyro, va);
+  align_gryo(&accel_gyro[8], vg);
+  ak8963_align_mag(mag, vm);
+
+  return ESP_OK;
+}
+
+esp_err_t get_accel_gyro_mag_dual(vector_t va[2], vector_t vg[2], vector_t vm[2], esp_err_t results[2])
+{
+  uint8_t accel_gyro[14];
+  uint8_t mag[AK8963_ST2 - AK8963_XOUT_L + 1];
+  // Accel, temperature and gyro, followed by the magnetometer bytes the
+  // auxiliary master copied into EXT_SENS_DATA
+  uint8_t secondary[14 + sizeof(mag)];
+
+  if (!secondary_initialised)
+  {
+    results[1] = ESP_ERR_INVALID_STATE;
+    return results[0] = get_accel_gyro_mag(&va[0], &vg[0], &vm[0]);
+  }
+
+  // Both IMUs in the same bus window, so their samples are taken together and
+  // a dead IMU only costs its NACK. Results stay failed if the bus is not acquired.
+  i2c_bus_transaction_t transactions[] = {
+      {.address = MPU9250_I2C_ADDR, .reg = MPU9250_ACCEL_XOUT_H, .is_read = true, .data = accel_gyro, .size = sizeof(accel_gyro), .result = ESP_FAIL},
+      {.address = AK8963_ADDRESS, .reg = AK8963_XOUT_L, .is_read = true, .data = mag, .size = sizeof(mag), .result = ESP_FAIL},
+      {.address = MPU9250_I2C_ADDR_SECONDARY, .reg = MPU9250_ACCEL_XOUT_H, .is_read = true, .data = secondary, .size = sizeof(secondary), .result = ESP_FAIL},
+  };
+
+  esp_err_t ret = i2c_bus_execute(i2c_bus_get(I2C_MASTER_NUM), transactions, 3, I2C_BUS_PRIORITY_HIGH);
+
+  results[0] = transactions[0].result != ESP_OK ? transactions[0].result : transactions[1].result;
+  results[1] = transactions[2].result;
+
+  if (results[0] == ESP_OK)
+  {
+    align_accel(accel_gyro, &va[0]);
+    align_gryo(&accel_gyro[8], &vg[0]);
+    ak8963_align_mag(mag, &vm[0]);
+  }
+
+  if (results[1] == ESP_OK)
+  {
+    align_accel_calibrated(secondary, secondary_cal, &va[1]);
+    align_gryo_calibrated(&secondary[8], secondary_cal, &vg[1]);
+    ak8963_align_mag_calibrated(&secondary[14], &secondary_asa, secondary_cal, &vm[1]);
+  }
+
+  return ret;
 }
 
 esp_err_t get_mag(vector_t *v)
@@ -348,6 +496,114 @@ static esp_err_t enable_magnetometer(void)
   }
 }
 
+// The secondary AK8963 is driven through SLV0 of the auxiliary I2C master.
+// SLV0 repeats its transaction every sample, so it ends up reading the
+// measurement registers continuously into EXT_SENS_DATA.
+static esp_err_t secondary_enable_magnetometer(void)
+{
+  ESP_LOGI(TAG, "Enabling secondary magnetometer");
+
+  esp_err_t ret = i2c_write_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_I2C_MST_CTRL, MPU9250_I2C_MST_CLK_400);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  ret = i2c_write_bit(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_USER_CTRL, MPU9250_USERCTRL_I2C_MST_EN_BIT, 1);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  vTaskDelay(100 / portTICK_RATE_MS);
+
+  uint8_t id;
+  ret = secondary_slave_read(AK8963_WHO_AM_I, 1);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  ret = i2c_read_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_EXT_SENS_DATA_00, &id);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  if (id != AK8963_WHO_AM_I_RESPONSE)
+  {
+    ESP_LOGE(TAG, "Secondary AK8963: Device ID is not equal to 0x%02x, device value is 0x%02x", AK8963_WHO_AM_I_RESPONSE, id);
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  // Sensitivity adjustment values from the fuse ROM
+  uint8_t bytes[3];
+  ret = secondary_slave_write(AK8963_CNTL, AK8963_CNTL_MODE_FUSE_ROM_ACCESS);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  ret = secondary_slave_read(AK8963_ASAX, 3);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  ret = i2c_read_bytes(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_EXT_SENS_DATA_00, bytes, 3);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  secondary_asa.x = (((float)bytes[0] - 128.0) * 0.5) / 128.0 + 1.0;
+  secondary_asa.y = (((float)bytes[1] - 128.0) * 0.5) / 128.0 + 1.0;
+  secondary_asa.z = (((float)bytes[2] - 128.0) * 0.5) / 128.0 + 1.0;
+
+  // The mode can only be changed from power-down
+  ret = secondary_slave_write(AK8963_CNTL, AK8963_CNTL_MODE_OFF);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  ret = secondary_slave_write(AK8963_CNTL, AK8963_CNTL_MODE_CONTINUE_MEASURE_2);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  // Reading through ST2 ends each measurement cycle, as with the primary AK8963
+  ret = secondary_slave_read(AK8963_XOUT_L, AK8963_ST2 - AK8963_XOUT_L + 1);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  ESP_LOGI(TAG, "Secondary magnetometer enabled");
+  return ESP_OK;
+}
+
+static esp_err_t secondary_slave_write(uint8_t reg, uint8_t value)
+{
+  esp_err_t ret = i2c_write_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_I2C_SLV0_ADDR, AK8963_ADDRESS);
+  if (ret == ESP_OK)
+    ret = i2c_write_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_I2C_SLV0_REG, reg);
+  if (ret == ESP_OK)
+    ret = i2c_write_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_I2C_SLV0_DO, value);
+  if (ret == ESP_OK)
+    ret = i2c_write_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_I2C_SLV0_CTRL, MPU9250_I2C_SLV_EN | 1);
+
+  // Let the auxiliary master run the transaction
+  vTaskDelay(20 / portTICK_RATE_MS);
+  return ret;
+}
+
+static esp_err_t secondary_slave_read(uint8_t reg, uint8_t length)
+{
+  esp_err_t ret = i2c_write_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_I2C_SLV0_ADDR, MPU9250_I2C_SLV_READ | AK8963_ADDRESS);
+  if (ret == ESP_OK)
+    ret = i2c_write_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_I2C_SLV0_REG, reg);
+  if (ret == ESP_OK)
+    ret = i2c_write_byte(I2C_MASTER_NUM, MPU9250_I2C_ADDR_SECONDARY, MPU9250_RA_I2C_SLV0_CTRL, MPU9250_I2C_SLV_EN | length);
+
+  vTaskDelay(20 / portTICK_RATE_MS);
+  return ret;
+}
+
 esp_err_t get_bypass_enabled(bool *state)
 {
   uint8_t bit;
@@ -33,6 +33,8 @@
 #define MPU9250_I2C_ADDRESS_AD0_LOW (0x68)
 #define MPU9250_I2C_ADDRESS_AD0_HIGH (0x69)
 #define MPU9250_I2C_ADDR MPU9250_I2C_ADDRESS_AD0_HIGH
+// Optional redundant IMU sharing the bus, with AD0 tied low
+#define MPU9250_I2C_ADDR_SECONDARY MPU9250_I2C_ADDRESS_AD0_LOW
 #define MPU9250_WHO_AM_I (0x75)
 
 #define MPU9250_RA_CONFIG (0x1A)
@@ -40,6 +42,15 @@
 #define MPU9250_RA_ACCEL_CONFIG_1 (0x1C)
 #define MPU9250_RA_ACCEL_CONFIG_2 (0x1D)
 
+#define MPU9250_RA_I2C_MST_CTRL (0x24)
+#define MPU9250_RA_I2C_SLV0_ADDR (0x25)
+#define MPU9250_RA_I2C_SLV0_REG (0x26)
+#define MPU9250_RA_I2C_SLV0_CTRL (0x27)
+
+#define MPU9250_I2C_MST_CLK_400 (0x0D)
+#define MPU9250_I2C_SLV_READ (0x80)
+#define MPU9250_I2C_SLV_EN (0x80)
+
 #define MPU9250_RA_INT_PIN_CFG (0x37)
 
 #define MPU9250_INTCFG_ACTL_BIT (7)
@@ -65,6 +76,7 @@
 #define MPU9250_GYRO_YOUT_L (0x46)
 #define MPU9250_GYRO_ZOUT_H (0x47)
 #define MPU9250_GYRO_ZOUT_L (0x48)
+#define MPU9250_EXT_SENS_DATA_00 (0x49)
 
 #define MPU9250_RA_USER_CTRL (0x6A)
 #define MPU9250_RA_PWR_MGMT_1 (0x6B)
@@ -144,6 +156,12 @@ typedef struct
 } calibration_t;
 
 esp_err_t i2c_mpu9250_init(calibration_t *cal);
+/**
+ * Initialize the redundant MPU9250 at MPU9250_I2C_ADDR_SECONDARY, after i2c_mpu9250_init.
+ * Its AK8963 has the same address as the primary one, so it stays behind the
+ * MPU9250 auxiliary I2C master, which copies every measurement into EXT_SENS_DATA.
+ */
+esp_err_t i2c_mpu9250_init_secondary(calibration_t *cal);
 esp_err_t set_clock_source(uint8_t adrs);
 esp_err_t set_full_scale_gyro_range(uint8_t adrs);
 esp_err_t set_full_scale_accel_range(uint8_t adrs);
@@ -163,6 +181,11 @@ esp_err_t get_mag(vector_t *v);
 esp_err_t get_accel_gyro(vector_t *va, vector_t *vg);
 esp_err_t get_accel_gyro_mag(vector_t *va, vector_t *vg, vector_t *vm);
 esp_err_t get_mag_raw(uint8_t bytes[6]);
+/**
+ * Read both IMUs in one bus transaction. Index 0 is the primary IMU, index 1 the
+ * secondary one; results[i] tells whether the values of IMU i were updated.
+ */
+esp_err_t get_accel_gyro_mag_dual(vector_t va[2], vector_t vg[2], vector_t vm[2], esp_err_t results[2]);
 
 void print_settings(void);
 void choose_SCL_SDA_GPIO(gpio_num_t SCL,gpio_num_t SDA);
@@ -0,0 +1,65 @@
+#ifndef __PCA9685_H__
+#define __PCA9685_H__
+
+#include <stdint.h>
+#include <esp_err.h>
+#include "i2c_bus.h"
+
+// Address with A0 to A5 tied low
+#define PCA9685_ADDRESS 0x40
+#define PCA9685_CHANNELS 16
+// Internal oscillator (Hz)
+#define PCA9685_OSCILLATOR 25000000
+
+#define PCA9685_MODE1 0x00
+#define PCA9685_MODE2 0x01
+#define PCA9685_LED0_ON_L 0x06
+#define PCA9685_ALL_LED_ON_L 0xfa
+#define PCA9685_ALL_LED_OFF_H 0xfd
+#define PCA9685_PRE_SCALE 0xfe
+
+#define PCA9685_MODE1_RESTART_BIT 7
+#define PCA9685_MODE1_AI_BIT 5
+#define PCA9685_MODE1_SLEEP_BIT 4
+#define PCA9685_MODE1_ALLCALL_BIT 0
+#define PCA9685_MODE2_OUTDRV_BIT 2
+// In LEDn_ON_H and LEDn_OFF_H
+#define PCA9685_FULL_BIT 4
+
+typedef struct pca9685_t
+{
+    i2c_bus_t *bus;
+    uint8_t address;
+    uint8_t pre_scale;
+    // PWM frequency (Hz) the prescaler actually gives
+    float frequency;
+    // LEDn_ON_L to LEDn_OFF_H of every channel, as last prepared
+    uint8_t registers[PCA9685_CHANNELS * 4];
+} pca9685_t;
+
+/**
+ * @brief Set the PWM frequency and enable the register auto-increment, with
+ * every output fully off
+ */
+esp_err_t pca9685_init(pca9685_t *pca9685, i2c_bus_t *bus, uint8_t address, float frequency);
+
+/**
+ * @brief LEDn_ON_L to LEDn_OFF_H of a pulse width (us), fully off when it is
+ * 0 or less
+ */
+void pca9685_encode(const pca9685_t *pca9685, float pulse_width, uint8_t registers[4]);
+
+/**
+ * @brief Prepare the write of `count` consecutive channels from `first` as
+ * one auto-incremented transaction
+ *
+ * A NAN pulse width rewrites what the channel was last prepared with. The
+ * transaction points into `pca9685->registers`, so that the writes of several
+ * expanders can run back-to-back with ::i2c_bus_execute().
+ */
+void pca9685_prepare(pca9685_t *pca9685, int first, int count, const float *pulse_widths, i2c_bus_transaction_t *transaction);
+
+esp_err_t pca9685_set_pulse_widths(pca9685_t *pca9685, int first, int count, const float *pulse_widths);
+esp_err_t pca9685_set_pulse_width(pca9685_t *pca9685, int channel, float pulse_width);
+
+#endif // __PCA9685_H__
@@ -0,0 +1,104 @@
+#include <math.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "pca9685.h"
+
+#define PCA9685_STEPS 4096
+// Prescaler limits of the datasheet, 1526 Hz to 24 Hz
+#define PCA9685_MIN_PRE_SCALE 3
+#define PCA9685_MAX_PRE_SCALE 255
+
+esp_err_t pca9685_init(pca9685_t *pca9685, i2c_bus_t *bus, uint8_t address, float frequency)
+{
+    if (!pca9685 || !bus || frequency <= 0.f)
+        return ESP_ERR_INVALID_ARG;
+
+    long pre_scale = lroundf(PCA9685_OSCILLATOR / (PCA9685_STEPS * frequency)) - 1;
+
+    if (pre_scale < PCA9685_MIN_PRE_SCALE)
+        pre_scale = PCA9685_MIN_PRE_SCALE;
+    if (pre_scale > PCA9685_MAX_PRE_SCALE)
+        pre_scale = PCA9685_MAX_PRE_SCALE;
+
+    *pca9685 = (pca9685_t){
+        .bus = bus,
+        .address = address,
+        .pre_scale = pre_scale,
+        .frequency = (float)PCA9685_OSCILLATOR / (PCA9685_STEPS * (pre_scale + 1)),
+    };
+
+    for (int channel = 0; channel < PCA9685_CHANNELS; channel++)
+        pca9685_encode(pca9685, 0.f, &pca9685->registers[4 * channel]);
+
+    // The prescaler can only be written while the oscillator sleeps
+    uint8_t sleep = 1 << PCA9685_MODE1_SLEEP_BIT | 1 << PCA9685_MODE1_ALLCALL_BIT;
+    uint8_t wake = 1 << PCA9685_MODE1_AI_BIT | 1 << PCA9685_MODE1_ALLCALL_BIT;
+    uint8_t totem_pole = 1 << PCA9685_MODE2_OUTDRV_BIT;
+    uint8_t full_off = 1 << PCA9685_FULL_BIT;
+    esp_err_t result;
+
+    if ((result = i2c_bus_write_reg(bus, address, PCA9685_MODE1, &sleep, 1)) != ESP_OK ||
+        (result = i2c_bus_write_reg(bus, address, PCA9685_PRE_SCALE, &pca9685->pre_scale, 1)) != ESP_OK ||
+        (result = i2c_bus_write_reg(bus, address, PCA9685_MODE2, &totem_pole, 1)) != ESP_OK ||
+        (result = i2c_bus_write_reg(bus, address, PCA9685_ALL_LED_OFF_H, &full_off, 1)) != ESP_OK ||
+        (result = i2c_bus_write_reg(bus, address, PCA9685_MODE1, &wake, 1)) != ESP_OK)
+        return result;
+
+    // The oscillator needs 500 us to start, a tick at least
+    vTaskDelay(1);
+    return ESP_OK;
+}
+
+void pca9685_encode(const pca9685_t *pca9685, float pulse_width, uint8_t registers[4])
+{
+    if (pulse_width <= 0.f)
+    {
+        registers[0] = registers[1] = registers[2] = 0;
+        registers[3] = 1 << PCA9685_FULL_BIT;
+        return;
+    }
+
+    long off = lroundf(pulse_width * 1e-6f * pca9685->frequency * PCA9685_STEPS);
+
+    if (off > PCA9685_STEPS - 1)
+        off = PCA9685_STEPS - 1;
+
+    // Pulses all start at count 0
+    registers[0] = 0;
+    registers[1] = 0;
+    registers[2] = off & 0xff;
+    registers[3] = off >> 8;
+}
+
+void pca9685_prepare(pca9685_t *pca9685, int first, int count, const float *pulse_widths, i2c_bus_transaction_t *transaction)
+{
+    for (int i = 0; i < count; i++)
+    {
+        if (!isnan(pulse_widths[i]))
+            pca9685_encode(pca9685, pulse_widths[i], &pca9685->registers[4 * (first + i)]);
+    }
+
+    *transaction = (i2c_bus_transaction_t){
+        .address = pca9685->address,
+        .reg = PCA9685_LED0_ON_L + 4 * first,
+        .is_read = false,
+        .data = &pca9685->registers[4 * first],
+        .size = 4 * count,
+    };
+}
+
+esp_err_t pca9685_set_pulse_widths(pca9685_t *pca9685, int first, int count, const float *pulse_widths)
+{
+    i2c_bus_transaction_t transaction;
+
+    if (first < 0 || count < 1 || first + count > PCA9685_CHANNELS)
+        return ESP_ERR_INVALID_ARG;
+
+    pca9685_prepare(pca9685, first, count, pulse_widths, &transaction);
+    return i2c_bus_write_reg(pca9685->bus, transaction.address, transaction.reg, transaction.data, transaction.size);
+}
+
+esp_err_t pca9685_set_pulse_width(pca9685_t *pca9685, int channel, float pulse_width)
+{
+    return pca9685_set_pulse_widths(pca9685, channel, 1, &pulse_width);
+}
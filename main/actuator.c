@@ -0,0 +1,197 @@
+#include <esp_timer.h>
+#include <math.h>
+#include "actuator.h"
+
+// Angle changes (degree) too small to be written
+#define ANGLE_EPSILON .01f
+
+static float limit_angle(actuator_t *actuator, actuator_channel_t *channel, float angle, float duration);
+
+esp_err_t actuator_init(actuator_t *actuator, const actuator_ops_t *ops, const actuator_config_t *config, void *context)
+{
+    *actuator = (actuator_t){
+        .ops = ops,
+        .config = *config,
+        .context = context,
+    };
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        actuator->channels[axis].calibration = config->calibrations[axis];
+        actuator->channels[axis].angle = NAN;
+    }
+
+    return ops->init(actuator);
+}
+
+void actuator_set_calibration(actuator_t *actuator, motor_axis_t axis, const servo_calibration_t *calibration)
+{
+    actuator->channels[axis].calibration = *calibration;
+    actuator->channels[axis].angle = NAN;
+}
+
+void actuator_set_velocity_limit(actuator_t *actuator, motor_axis_t axis, float velocity_limit)
+{
+    actuator->channels[axis].velocity_limit = velocity_limit;
+}
+
+esp_err_t actuator_set_position(actuator_t *actuator, motor_axis_t axis, float angle)
+{
+    actuator_channel_t *channel = &actuator->channels[axis];
+    int64_t now = esp_timer_get_time();
+
+    if (fabsf(angle - channel->angle) <= ANGLE_EPSILON)
+    {
+        channel->commanded_at = now;
+        return ESP_OK;
+    }
+
+    // Still at the previous pulse until the pre-pulse ends
+    if (!channel->powered && actuator->config.settle_time > 0.f)
+        actuator_energize(actuator, axis);
+    if (now < channel->ready_at)
+        return ESP_OK;
+
+    angle = limit_angle(actuator, channel, angle, (now - channel->commanded_at) * 1e-6f);
+    channel->commanded_at = now;
+
+    esp_err_t result = actuator->ops->set_pulse_width(actuator, axis, servo_calibration_pulse_width(&channel->calibration, angle));
+    if (result == ESP_OK)
+    {
+        channel->angle = angle;
+        channel->moved_at = now;
+        actuator->stats.commands++;
+    }
+
+    return result;
+}
+
+esp_err_t actuator_set_power(actuator_t *actuator, motor_axis_t axis, bool on)
+{
+    actuator_channel_t *channel = &actuator->channels[axis];
+    int64_t now = esp_timer_get_time();
+    esp_err_t result = actuator->ops->set_power(actuator, axis, on);
+
+    if (result != ESP_OK)
+        return result;
+
+    if (on && !channel->powered)
+    {
+        channel->energized_at = now;
+        channel->ready_at = now + actuator->config.pre_pulse_ms * 1000;
+    }
+    else if (!on && channel->powered)
+    {
+        channel->energized_time += now - channel->energized_at;
+    }
+
+    channel->powered = on;
+    channel->moved_at = now;
+    return ESP_OK;
+}
+
+void actuator_set_power_gating(actuator_t *actuator, float settle_time, uint32_t pre_pulse_ms)
+{
+    actuator->config.settle_time = settle_time;
+    actuator->config.pre_pulse_ms = pre_pulse_ms;
+}
+
+int64_t actuator_energize(actuator_t *actuator, motor_axis_t axis)
+{
+    actuator_channel_t *channel = &actuator->channels[axis];
+
+    if (!channel->powered)
+        actuator_set_power(actuator, axis, true);
+
+    return channel->ready_at;
+}
+
+void actuator_update_power(actuator_t *actuator)
+{
+    int64_t now = esp_timer_get_time();
+
+    if (actuator->config.settle_time <= 0.f)
+        return;
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        actuator_channel_t *channel = &actuator->channels[axis];
+
+        // A fade holds the axis busy until it ends
+        if (channel->powered && channel->commanded_at <= now &&
+            now - channel->moved_at > actuator->config.settle_time * 1e6f)
+            actuator_set_power(actuator, axis, false);
+    }
+}
+
+float actuator_energized_seconds(const actuator_t *actuator, motor_axis_t axis)
+{
+    const actuator_channel_t *channel = &actuator->channels[axis];
+    int64_t energized = channel->energized_time;
+
+    if (channel->powered)
+        energized += esp_timer_get_time() - channel->energized_at;
+
+    return energized * 1e-6f;
+}
+
+esp_err_t actuator_fade_init(actuator_t *actuator, TaskHandle_t task)
+{
+    if (actuator->ops->fade_init == NULL)
+        return ESP_ERR_NOT_SUPPORTED;
+
+    actuator->fade_task = task;
+    return actuator->ops->fade_init(actuator);
+}
+
+bool actuator_fade(actuator_t *actuator, motor_axis_t axis, float angle, uint32_t duration_ms)
+{
+    actuator_channel_t *channel = &actuator->channels[axis];
+
+    if (actuator->ops->fade == NULL || duration_ms == 0 || isnan(channel->angle))
+    {
+        actuator_set_position(actuator, axis, angle);
+        return false;
+    }
+
+    // Still at the previous pulse until the pre-pulse ends, the caller retries
+    if (!channel->powered && actuator->config.settle_time > 0.f)
+        actuator_energize(actuator, axis);
+    if (esp_timer_get_time() < channel->ready_at)
+        return false;
+
+    // Slower rather than shorter: the fade still ends on the angle
+    if (channel->velocity_limit > 0.f && fabsf(angle - channel->angle) > channel->velocity_limit * duration_ms * 1e-3f)
+    {
+        duration_ms = ceilf(fabsf(angle - channel->angle) / channel->velocity_limit * 1e3f);
+        actuator->stats.limited++;
+    }
+
+    esp_err_t result = actuator->ops->fade(actuator, axis, servo_calibration_pulse_width(&channel->calibration, angle), duration_ms);
+    if (result != ESP_OK && result != ESP_ERR_INVALID_STATE)
+        return false;
+
+    // Reached at the end of the fade, where the velocity limit and the
+    // settle time count from
+    channel->angle = angle;
+    channel->commanded_at = esp_timer_get_time() + duration_ms * 1000;
+    channel->moved_at = channel->commanded_at;
+    if (result != ESP_OK)
+        return false;
+
+    actuator->stats.commands++;
+    return true;
+}
+
+static float limit_angle(actuator_t *actuator, actuator_channel_t *channel, float angle, float duration)
+{
+    if (isnan(channel->angle) || channel->velocity_limit <= 0.f)
+        return angle;
+
+    float step = channel->velocity_limit * fmaxf(duration, 0.f);
+    if (fabsf(angle - channel->angle) <= step)
+        return angle;
+
+    actuator->stats.limited++;
+    return channel->angle + copysignf(step, angle - channel->angle);
+}
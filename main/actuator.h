@@ -0,0 +1,146 @@
+#ifndef __ACTUATOR_H__
+#define __ACTUATOR_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <driver/gpio.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <sdkconfig.h>
+#include "servo_calibration.h"
+
+#define MOTORS_AXES 2
+
+// Notification bits of the axes whose hardware fade ended
+#define MOTORS_FADE_AZIMUTH BIT0
+#define MOTORS_FADE_INCLINATION BIT1
+
+// Backend driving the servos, chosen at build time
+#if defined(CONFIG_ACTUATOR_BACKEND_MCPWM)
+#define ACTUATOR_BACKEND actuator_mcpwm_ops
+#elif defined(CONFIG_ACTUATOR_BACKEND_SIM)
+#define ACTUATOR_BACKEND actuator_sim_ops
+#else
+#define ACTUATOR_BACKEND actuator_ledc_ops
+#endif
+
+typedef enum motor_axis_t
+{
+    MOTOR_AZIMUTH,
+    MOTOR_INCLINATION,
+} motor_axis_t;
+
+typedef struct actuator_t actuator_t;
+
+/**
+ * Backend operations. Pulse widths are in microseconds.
+ *
+ * `fade` ramps linearly to a pulse width without the CPU and notifies
+ * `fade_task` with the axis bit when it ends. It returns
+ * ESP_ERR_INVALID_STATE when the output is already there, in which case
+ * nothing notifies. Backends without a fade engine leave `fade_init` and
+ * `fade` NULL.
+ */
+typedef struct actuator_ops_t
+{
+    const char *name;
+    esp_err_t (*init)(actuator_t *actuator);
+    esp_err_t (*set_pulse_width)(actuator_t *actuator, motor_axis_t axis, float pulse_width);
+    esp_err_t (*set_power)(actuator_t *actuator, motor_axis_t axis, bool on);
+    esp_err_t (*fade_init)(actuator_t *actuator);
+    esp_err_t (*fade)(actuator_t *actuator, motor_axis_t axis, float pulse_width, uint32_t duration_ms);
+} actuator_ops_t;
+
+typedef struct actuator_config_t
+{
+    gpio_num_t enable_gpio[MOTORS_AXES];
+    gpio_num_t pwm_gpio[MOTORS_AXES];
+    // Servo pulse frequency (Hz)
+    int frequency;
+    servo_calibration_t calibrations[MOTORS_AXES];
+    // Seconds an axis holds still before it is de-energized, 0 keeps it energized
+    float settle_time;
+    // Time (ms) a re-energized axis gets the pulse it was left at before moving
+    uint32_t pre_pulse_ms;
+} actuator_config_t;
+
+typedef struct actuator_channel_t
+{
+    servo_calibration_t calibration;
+    // Degree per second, 0 for none
+    float velocity_limit;
+    // Last commanded angle (degree), NAN until the first command
+    float angle;
+    int64_t commanded_at;
+    bool powered;
+    // Last written move, and when the pre-pulse after energizing ends
+    int64_t moved_at;
+    int64_t ready_at;
+    // Energized time (us) up to the last power on
+    int64_t energized_time;
+    int64_t energized_at;
+} actuator_channel_t;
+
+typedef struct actuator_stats_t
+{
+    // Pulse width writes and fades handed to the backend
+    uint32_t commands;
+    // Commands shortened or stretched by the velocity limit
+    uint32_t limited;
+} actuator_stats_t;
+
+struct actuator_t
+{
+    const actuator_ops_t *ops;
+    actuator_config_t config;
+    actuator_channel_t channels[MOTORS_AXES];
+    TaskHandle_t fade_task;
+    void *context;
+    actuator_stats_t stats;
+};
+
+// State of the host simulation backend, NULL context uses a shared one
+typedef struct actuator_sim_t
+{
+    float pulse_width[MOTORS_AXES];
+    bool powered[MOTORS_AXES];
+    uint32_t writes;
+} actuator_sim_t;
+
+extern const actuator_ops_t actuator_ledc_ops;
+extern const actuator_ops_t actuator_mcpwm_ops;
+extern const actuator_ops_t actuator_sim_ops;
+
+// Both axes start unpowered, without power gating
+esp_err_t actuator_init(actuator_t *actuator, const actuator_ops_t *ops, const actuator_config_t *config, void *context);
+// The next position command is written whatever the previous one was
+void actuator_set_calibration(actuator_t *actuator, motor_axis_t axis, const servo_calibration_t *calibration);
+void actuator_set_velocity_limit(actuator_t *actuator, motor_axis_t axis, float velocity_limit);
+/**
+ * Commands an angle (degree). A command further than the velocity limit
+ * allows since the previous one is shortened, changes below 0.01 degree are
+ * not written.
+ */
+esp_err_t actuator_set_position(actuator_t *actuator, motor_axis_t axis, float angle);
+esp_err_t actuator_set_power(actuator_t *actuator, motor_axis_t axis, bool on);
+void actuator_set_power_gating(actuator_t *actuator, float settle_time, uint32_t pre_pulse_ms);
+/**
+ * Powers a gated axis back on. Returns when (esp_timer_get_time()) the
+ * pre-pulse ends and the axis can move, position commands are held until
+ * then. A move commanded to an unpowered axis energizes it the same way.
+ */
+int64_t actuator_energize(actuator_t *actuator, motor_axis_t axis);
+// De-energizes the axes that held still for the settle time
+void actuator_update_power(actuator_t *actuator);
+float actuator_energized_seconds(const actuator_t *actuator, motor_axis_t axis);
+esp_err_t actuator_fade_init(actuator_t *actuator, TaskHandle_t task);
+/**
+ * Ramps to an angle in `duration_ms`, stretched to respect the velocity
+ * limit. Returns true when a fade started and will notify, otherwise the
+ * angle was written directly, already commanded, or the fade is held until
+ * the pre-pulse ends or failed and has to be retried.
+ */
+bool actuator_fade(actuator_t *actuator, motor_axis_t axis, float angle, uint32_t duration_ms);
+
+#endif // __ACTUATOR_H__
@@ -0,0 +1,117 @@
+#include <driver/ledc.h>
+#include <esp_attr.h>
+#include <math.h>
+#include "actuator.h"
+
+// The highest resolution the 50 Hz period allows is 20 bits, 16 bits already
+// step the servos by about 0.03 degree
+#define PWM_RESOLUTION 16
+#define PWM_MODE LEDC_HIGH_SPEED_MODE
+#define PWM_TIMER LEDC_TIMER_0
+
+static uint32_t duty(const actuator_t *actuator, float pulse_width);
+static bool IRAM_ATTR notify_fade_end(const ledc_cb_param_t *param, void *arg);
+
+static esp_err_t actuator_ledc_init(actuator_t *actuator)
+{
+    const actuator_config_t *config = &actuator->config;
+    gpio_config_t enable_gpio_config = {
+        .pin_bit_mask = BIT64(config->enable_gpio[MOTOR_AZIMUTH]) | BIT64(config->enable_gpio[MOTOR_INCLINATION]),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    ledc_timer_config_t timer_config = {
+        .speed_mode = PWM_MODE,
+        .duty_resolution = PWM_RESOLUTION,
+        .timer_num = PWM_TIMER,
+        .freq_hz = config->frequency,
+    };
+    esp_err_t result;
+
+    if ((result = gpio_config(&enable_gpio_config)) != ESP_OK ||
+        (result = ledc_timer_config(&timer_config)) != ESP_OK)
+        return result;
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        ledc_channel_config_t channel_config = {
+            .gpio_num = config->pwm_gpio[axis],
+            .speed_mode = PWM_MODE,
+            .channel = LEDC_CHANNEL_0 + axis,
+            .intr_type = LEDC_INTR_DISABLE,
+            .timer_sel = PWM_TIMER,
+            .hpoint = 0,
+        };
+
+        if ((result = gpio_set_level(config->enable_gpio[axis], 0)) != ESP_OK ||
+            (result = ledc_channel_config(&channel_config)) != ESP_OK)
+            return result;
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t actuator_ledc_set_pulse_width(actuator_t *actuator, motor_axis_t axis, float pulse_width)
+{
+    esp_err_t result = ledc_set_duty(PWM_MODE, LEDC_CHANNEL_0 + axis, duty(actuator, pulse_width));
+
+    return result == ESP_OK ? ledc_update_duty(PWM_MODE, LEDC_CHANNEL_0 + axis) : result;
+}
+
+static esp_err_t actuator_ledc_set_power(actuator_t *actuator, motor_axis_t axis, bool on)
+{
+    return gpio_set_level(actuator->config.enable_gpio[axis], on);
+}
+
+static esp_err_t actuator_ledc_fade_init(actuator_t *actuator)
+{
+    ledc_cbs_t callbacks = {
+        .fade_cb = notify_fade_end,
+    };
+    esp_err_t result = ledc_fade_func_install(0);
+
+    for (int axis = 0; result == ESP_OK && axis < MOTORS_AXES; axis++)
+        result = ledc_cb_register(PWM_MODE, LEDC_CHANNEL_0 + axis, &callbacks, actuator);
+
+    return result;
+}
+
+// A fade in progress is replaced by the new one
+static esp_err_t actuator_ledc_fade(actuator_t *actuator, motor_axis_t axis, float pulse_width, uint32_t duration_ms)
+{
+    uint32_t target = duty(actuator, pulse_width);
+    esp_err_t result;
+
+    if (ledc_get_duty(PWM_MODE, LEDC_CHANNEL_0 + axis) == target)
+        return ESP_ERR_INVALID_STATE;
+
+    result = ledc_set_fade_with_time(PWM_MODE, LEDC_CHANNEL_0 + axis, target, duration_ms);
+    return result == ESP_OK ? ledc_fade_start(PWM_MODE, LEDC_CHANNEL_0 + axis, LEDC_FADE_NO_WAIT) : result;
+}
+
+static uint32_t duty(const actuator_t *actuator, float pulse_width)
+{
+    return lroundf(pulse_width * 1e-6f * actuator->config.frequency * (float)(1u << PWM_RESOLUTION));
+}
+
+static bool IRAM_ATTR notify_fade_end(const ledc_cb_param_t *param, void *arg)
+{
+    actuator_t *actuator = arg;
+    BaseType_t woken = pdFALSE;
+
+    if (param->event == LEDC_FADE_END_EVT && actuator->fade_task != NULL)
+        xTaskNotifyFromISR(actuator->fade_task, BIT(param->channel - LEDC_CHANNEL_0), eSetBits, &woken);
+
+    return woken == pdTRUE;
+}
+
+const actuator_ops_t actuator_ledc_ops = {
+    .name = "LEDC",
+    .init = actuator_ledc_init,
+    .set_pulse_width = actuator_ledc_set_pulse_width,
+    .set_power = actuator_ledc_set_power,
+    .fade_init = actuator_ledc_fade_init,
+    .fade = actuator_ledc_fade,
+};
@@ -0,0 +1,57 @@
+#include <driver/mcpwm.h>
+#include <math.h>
+#include "actuator.h"
+
+// One operator of the same timer per axis
+static const mcpwm_io_signals_t signals[MOTORS_AXES] = {MCPWM0A, MCPWM0B};
+static const mcpwm_generator_t generators[MOTORS_AXES] = {MCPWM_GEN_A, MCPWM_GEN_B};
+
+static esp_err_t actuator_mcpwm_init(actuator_t *actuator)
+{
+    const actuator_config_t *config = &actuator->config;
+    gpio_config_t enable_gpio_config = {
+        .pin_bit_mask = BIT64(config->enable_gpio[MOTOR_AZIMUTH]) | BIT64(config->enable_gpio[MOTOR_INCLINATION]),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    mcpwm_config_t pwm_config = {
+        .frequency = config->frequency,
+        .cmpr_a = 0.f,
+        .cmpr_b = 0.f,
+        .counter_mode = MCPWM_UP_COUNTER,
+        .duty_mode = MCPWM_DUTY_MODE_0,
+    };
+    esp_err_t result;
+
+    if ((result = gpio_config(&enable_gpio_config)) != ESP_OK)
+        return result;
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        if ((result = gpio_set_level(config->enable_gpio[axis], 0)) != ESP_OK ||
+            (result = mcpwm_gpio_init(MCPWM_UNIT_0, signals[axis], config->pwm_gpio[axis])) != ESP_OK)
+            return result;
+    }
+
+    return mcpwm_init(MCPWM_UNIT_0, MCPWM_TIMER_0, &pwm_config);
+}
+
+// Whole microseconds, about 0.09 degree on a 2 ms range servo
+static esp_err_t actuator_mcpwm_set_pulse_width(actuator_t *actuator, motor_axis_t axis, float pulse_width)
+{
+    return mcpwm_set_duty_in_us(MCPWM_UNIT_0, MCPWM_TIMER_0, generators[axis], lroundf(pulse_width));
+}
+
+static esp_err_t actuator_mcpwm_set_power(actuator_t *actuator, motor_axis_t axis, bool on)
+{
+    return gpio_set_level(actuator->config.enable_gpio[axis], on);
+}
+
+const actuator_ops_t actuator_mcpwm_ops = {
+    .name = "MCPWM",
+    .init = actuator_mcpwm_init,
+    .set_pulse_width = actuator_mcpwm_set_pulse_width,
+    .set_power = actuator_mcpwm_set_power,
+};
@@ -0,0 +1,37 @@
+#include <string.h>
+#include "actuator.h"
+
+static actuator_sim_t shared_simulation;
+
+static esp_err_t actuator_sim_init(actuator_t *actuator)
+{
+    if (actuator->context == NULL)
+        actuator->context = &shared_simulation;
+
+    memset(actuator->context, 0, sizeof(actuator_sim_t));
+    return ESP_OK;
+}
+
+static esp_err_t actuator_sim_set_pulse_width(actuator_t *actuator, motor_axis_t axis, float pulse_width)
+{
+    actuator_sim_t *simulation = actuator->context;
+
+    simulation->pulse_width[axis] = pulse_width;
+    simulation->writes++;
+    return ESP_OK;
+}
+
+static esp_err_t actuator_sim_set_power(actuator_t *actuator, motor_axis_t axis, bool on)
+{
+    actuator_sim_t *simulation = actuator->context;
+
+    simulation->powered[axis] = on;
+    return ESP_OK;
+}
+
+const actuator_ops_t actuator_sim_ops = {
+    .name = "simulation",
+    .init = actuator_sim_init,
+    .set_pulse_width = actuator_sim_set_pulse_width,
+    .set_power = actuator_sim_set_power,
+};
@@ -0,0 +1,143 @@
+#include <stddef.h>
+#include <string.h>
+#include <strings.h>
+#include "ahrs.h"
+
+ahrs_config_t ahrs_default_config(ahrs_engine_t engine)
+{
+    return (ahrs_config_t){
+        .engine = engine,
+        .kp = 2.5f,
+        .ki = 0.f,
+        .beta = .8f,
+        .gyro_noise = .01f,
+        .gyro_bias_noise = .0005f,
+        .accel_noise = .05f,
+        .magnet_noise = .1f,
+        // 99th percentile of chi-square with 3 degrees of freedom
+        .accel_gate = 11.34f,
+        .magnet_gate = 11.34f,
+        .correction_period = .15f,
+    };
+}
+
+const char *ahrs_engine_name(ahrs_engine_t engine)
+{
+    switch (engine)
+    {
+    case AHRS_MADGWICK:
+        return ahrs_madgwick_ops.name;
+    case AHRS_EKF:
+        return ahrs_ekf_ops.name;
+    default:
+        return ahrs_mahony_ops.name;
+    }
+}
+
+bool ahrs_engine_from_name(const char *name, ahrs_engine_t *engine)
+{
+    const ahrs_engine_t engines[] = {AHRS_MAHONY, AHRS_MADGWICK, AHRS_EKF};
+
+    for (size_t i = 0; name != NULL && i < sizeof(engines) / sizeof(engines[0]); i++)
+    {
+        if (strcasecmp(name, ahrs_engine_name(engines[i])) == 0)
+        {
+            *engine = engines[i];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ahrs_init(ahrs_t *ahrs, const ahrs_config_t *config)
+{
+    ahrs->rotation = QUATERNION_IDENTITY;
+    memset(&ahrs->batch, 0, sizeof(ahrs->batch));
+    ahrs_set_config(ahrs, config);
+}
+
+void ahrs_set_config(ahrs_t *ahrs, const ahrs_config_t *config)
+{
+    switch (config->engine)
+    {
+    case AHRS_MADGWICK:
+        ahrs->ops = &ahrs_madgwick_ops;
+        break;
+    case AHRS_EKF:
+        ahrs->ops = &ahrs_ekf_ops;
+        break;
+    default:
+        ahrs->ops = &ahrs_mahony_ops;
+        break;
+    }
+
+    ahrs->config = *config;
+    ahrs->ops->reset(ahrs);
+}
+
+void ahrs_reset(ahrs_t *ahrs, quaternion_t rotation)
+{
+    ahrs->rotation = rotation;
+    ahrs->ops->reset(ahrs);
+}
+
+void ahrs_update(ahrs_t *ahrs, vector3_t accel, vector3_t gyro, vector3_t magnet, float dt)
+{
+    ahrs->ops->update(ahrs, accel, gyro, magnet, dt);
+}
+
+void ahrs_update_batch(ahrs_t *ahrs, const ahrs_sample_t *samples, int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        const ahrs_sample_t *sample = &samples[i];
+
+        if (ahrs->batch.started)
+        {
+            float dt = (sample->timestamp - ahrs->batch.timestamp) * 1e-6f;
+
+            if (dt > 0.f)
+            {
+                // Trapezoidal rate plus the coning term, exact to second
+                // order for a rate varying linearly over the step
+                vector3_t w0 = ahrs->batch.gyro, w1 = sample->gyro;
+                vector3_t coning = vector3_cross(w0, w1);
+                vector3_t angle = {
+                    .5f * (w0.x + w1.x) * dt + coning.x * dt * dt / 12.f,
+                    .5f * (w0.y + w1.y) * dt + coning.y * dt * dt / 12.f,
+                    .5f * (w0.z + w1.z) * dt + coning.z * dt * dt / 12.f,
+                };
+
+                ahrs->ops->predict(ahrs, angle, dt);
+                ahrs->batch.elapsed += dt;
+            }
+        }
+
+        ahrs->batch.started = true;
+        ahrs->batch.timestamp = sample->timestamp;
+        ahrs->batch.gyro = sample->gyro;
+        ahrs->batch.accel_sum.x += sample->accel.x;
+        ahrs->batch.accel_sum.y += sample->accel.y;
+        ahrs->batch.accel_sum.z += sample->accel.z;
+        ahrs->batch.magnet_sum.x += sample->magnet.x;
+        ahrs->batch.magnet_sum.y += sample->magnet.y;
+        ahrs->batch.magnet_sum.z += sample->magnet.z;
+
+        if (ahrs->batch.elapsed >= ahrs->config.correction_period)
+        {
+            // The corrections only use directions, so sums work as averages
+            ahrs->ops->correct(ahrs, ahrs->batch.accel_sum, ahrs->batch.magnet_sum, ahrs->batch.elapsed);
+            ahrs->batch.accel_sum = (vector3_t){0.f, 0.f, 0.f};
+            ahrs->batch.magnet_sum = (vector3_t){0.f, 0.f, 0.f};
+            ahrs->batch.elapsed = 0.f;
+        }
+    }
+
+    ahrs->rotation = quaternion_normalize(ahrs->rotation);
+}
+
+void ahrs_pause(ahrs_t *ahrs)
+{
+    ahrs->batch.started = false;
+}
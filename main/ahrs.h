@@ -0,0 +1,116 @@
+#ifndef __AHRS_H__
+#define __AHRS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+typedef enum ahrs_engine_t
+{
+    AHRS_MAHONY,
+    AHRS_MADGWICK,
+    AHRS_EKF,
+} ahrs_engine_t;
+
+typedef struct ahrs_config_t
+{
+    ahrs_engine_t engine;
+    // Mahony proportional and integral feedback gains
+    float kp;
+    float ki;
+    // Madgwick gradient descent step
+    float beta;
+    // EKF noise densities: gyro in rad/s, gyro bias random walk in rad/s^2,
+    // accel and magnet on normalized vectors
+    float gyro_noise;
+    float gyro_bias_noise;
+    float accel_noise;
+    float magnet_noise;
+    // EKF chi-square thresholds (3 degrees of freedom) above which an
+    // accel or magnet update is rejected
+    float accel_gate;
+    float magnet_gate;
+    // Seconds between accel and magnet corrections in batch updates
+    float correction_period;
+} ahrs_config_t;
+
+typedef struct ahrs_sample_t
+{
+    vector3_t accel;
+    vector3_t gyro;
+    vector3_t magnet;
+    // Microseconds, from esp_timer_get_time()
+    int64_t timestamp;
+} ahrs_sample_t;
+
+typedef struct ahrs_t ahrs_t;
+
+typedef struct ahrs_ops_t
+{
+    const char *name;
+    void (*reset)(ahrs_t *ahrs);
+    void (*update)(ahrs_t *ahrs, vector3_t accel, vector3_t gyro, vector3_t magnet, float dt);
+    // Batch steps: rotate by a gyro rotation vector without normalizing, and
+    // correct with accel and magnet averaged over dt
+    void (*predict)(ahrs_t *ahrs, vector3_t angle, float dt);
+    void (*correct)(ahrs_t *ahrs, vector3_t accel, vector3_t magnet, float dt);
+} ahrs_ops_t;
+
+#define AHRS_EKF_STATES 6
+
+typedef struct ahrs_ekf_state_t
+{
+    // Upper triangle of the covariance of [attitude error, gyro bias error],
+    // both in the sensor frame
+    float p[AHRS_EKF_STATES * (AHRS_EKF_STATES + 1) / 2];
+    vector3_t gyro_bias;
+    // Direction of the magnetic field in the world frame, x pointing north
+    vector3_t magnet_reference;
+    uint32_t accel_rejected;
+    uint32_t magnet_rejected;
+} ahrs_ekf_state_t;
+
+struct ahrs_t
+{
+    const ahrs_ops_t *ops;
+    ahrs_config_t config;
+    // Rotation from the sensor frame to the world frame
+    quaternion_t rotation;
+    union
+    {
+        vector3_t mahony_error;
+        ahrs_ekf_state_t ekf;
+    } state;
+    // Batch update progress, kept across calls
+    struct
+    {
+        bool started;
+        int64_t timestamp;
+        vector3_t gyro;
+        vector3_t accel_sum;
+        vector3_t magnet_sum;
+        float elapsed;
+    } batch;
+};
+
+extern const ahrs_ops_t ahrs_mahony_ops;
+extern const ahrs_ops_t ahrs_madgwick_ops;
+extern const ahrs_ops_t ahrs_ekf_ops;
+
+ahrs_config_t ahrs_default_config(ahrs_engine_t engine);
+const char *ahrs_engine_name(ahrs_engine_t engine);
+bool ahrs_engine_from_name(const char *name, ahrs_engine_t *engine);
+
+void ahrs_init(ahrs_t *ahrs, const ahrs_config_t *config);
+// Switches engine or gains at runtime, continuing from the current rotation.
+void ahrs_set_config(ahrs_t *ahrs, const ahrs_config_t *config);
+void ahrs_reset(ahrs_t *ahrs, quaternion_t rotation);
+void ahrs_update(ahrs_t *ahrs, vector3_t accel, vector3_t gyro, vector3_t magnet, float dt);
+// Integrates every gyro sample at its own timestamp and corrects once per
+// correction period, normalizing once per call.
+void ahrs_update_batch(ahrs_t *ahrs, const ahrs_sample_t *samples, int count);
+// Call after skipping samples: the next batch sample starts a new
+// integration interval instead of spanning the gap.
+void ahrs_pause(ahrs_t *ahrs);
+
+#endif // __AHRS_H__
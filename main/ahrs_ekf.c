@@ -0,0 +1,253 @@
+#include <math.h>
+#include <string.h>
+#include "ahrs.h"
+
+// Error-state EKF: the nominal attitude lives in ahrs->rotation and the
+// nominal gyro bias in the state; the filter estimates a small rotation
+// error and a bias error, both in the sensor frame. Gravity and the
+// magnetic field are observed as direction vectors, and each observation is
+// rejected when its innovation fails a chi-square test.
+//
+// The covariance is symmetric, so only its upper triangle is stored and
+// updated. Everything is single precision and on the stack.
+
+#define N AHRS_EKF_STATES
+#define P(i, j) p[p_index[i][j]]
+
+// Blend rate of the magnetic field reference, per accepted update
+#define MAGNET_REFERENCE_RATE .01f
+
+static const uint8_t p_index[N][N] = {
+    {0, 1, 2, 3, 4, 5},
+    {1, 6, 7, 8, 9, 10},
+    {2, 7, 11, 12, 13, 14},
+    {3, 8, 12, 15, 16, 17},
+    {4, 9, 13, 16, 18, 19},
+    {5, 10, 14, 17, 19, 20},
+};
+
+static void ahrs_ekf_reset(ahrs_t *ahrs);
+static void ahrs_ekf_update(ahrs_t *ahrs, vector3_t accel, vector3_t gyro, vector3_t magnet, float dt);
+static void ahrs_ekf_predict(ahrs_t *ahrs, vector3_t angle, float dt);
+static void ahrs_ekf_correct(ahrs_t *ahrs, vector3_t accel, vector3_t magnet, float dt);
+static bool ahrs_ekf_observe(ahrs_t *ahrs, vector3_t measured, vector3_t predicted, float noise, float gate);
+static vector3_t magnet_reference(quaternion_t rotation, vector3_t measured);
+static void apply_error(quaternion_t *q, vector3_t e);
+static bool invert_symmetric3(const float m[3][3], float out[3][3]);
+
+const ahrs_ops_t ahrs_ekf_ops = {
+    .name = "EKF",
+    .reset = ahrs_ekf_reset,
+    .update = ahrs_ekf_update,
+    .predict = ahrs_ekf_predict,
+    .correct = ahrs_ekf_correct,
+};
+
+static void ahrs_ekf_reset(ahrs_t *ahrs)
+{
+    ahrs_ekf_state_t *ekf = &ahrs->state.ekf;
+    float *p = ekf->p;
+
+    memset(ekf, 0, sizeof(*ekf));
+
+    // Start unsure of the attitude, about 30 degrees on every axis, and of
+    // the gyro bias, about 1 degree/s
+    for (int i = 0; i < 3; i++)
+    {
+        P(i, i) = .25f;
+        P(i + 3, i + 3) = 3e-4f;
+    }
+}
+
+static void ahrs_ekf_update(ahrs_t *ahrs, vector3_t accel, vector3_t gyro, vector3_t magnet, float dt)
+{
+    ahrs_ekf_predict(ahrs, (vector3_t){gyro.x * dt, gyro.y * dt, gyro.z * dt}, dt);
+    ahrs_ekf_correct(ahrs, accel, magnet, dt);
+    ahrs->rotation = quaternion_normalize(ahrs->rotation);
+}
+
+static void ahrs_ekf_correct(ahrs_t *ahrs, vector3_t accel, vector3_t magnet, float dt)
+{
+    ahrs_ekf_state_t *ekf = &ahrs->state.ekf;
+
+    float accel_norm = vector3_magnitude(accel);
+    if (accel_norm > 0.f)
+    {
+        vector3_t measured = {accel.x / accel_norm, accel.y / accel_norm, accel.z / accel_norm};
+        vector3_t predicted = quaternion_rotate(quaternion_inverse(ahrs->rotation), VECTOR3_UP);
+
+        if (!ahrs_ekf_observe(ahrs, measured, predicted, ahrs->config.accel_noise, ahrs->config.accel_gate))
+            ekf->accel_rejected++;
+    }
+
+    float magnet_norm = vector3_magnitude(magnet);
+    if (magnet_norm > 0.f)
+    {
+        vector3_t measured = {magnet.x / magnet_norm, magnet.y / magnet_norm, magnet.z / magnet_norm};
+
+        // The first reading only defines the reference field
+        if (ekf->magnet_reference.x == 0.f && ekf->magnet_reference.z == 0.f)
+        {
+            ekf->magnet_reference = magnet_reference(ahrs->rotation, measured);
+            return;
+        }
+
+        vector3_t predicted = quaternion_rotate(quaternion_inverse(ahrs->rotation), ekf->magnet_reference);
+
+        if (ahrs_ekf_observe(ahrs, measured, predicted, ahrs->config.magnet_noise, ahrs->config.magnet_gate))
+        {
+            // Track slow changes of the inclination of the field
+            vector3_t b = magnet_reference(ahrs->rotation, measured);
+            vector3_t *reference = &ekf->magnet_reference;
+            reference->x += MAGNET_REFERENCE_RATE * (b.x - reference->x);
+            reference->z += MAGNET_REFERENCE_RATE * (b.z - reference->z);
+            *reference = vector3_normalize(*reference);
+        }
+        else
+        {
+            ekf->magnet_rejected++;
+        }
+    }
+}
+
+static void ahrs_ekf_predict(ahrs_t *ahrs, vector3_t angle, float dt)
+{
+    ahrs_ekf_state_t *ekf = &ahrs->state.ekf;
+    float *p = ekf->p;
+    float w[3] = {
+        angle.x - ekf->gyro_bias.x * dt,
+        angle.y - ekf->gyro_bias.y * dt,
+        angle.z - ekf->gyro_bias.z * dt,
+    };
+
+    // Propagate the nominal attitude with the unbiased gyro
+    ahrs->rotation = quaternion_multiply(ahrs->rotation, quaternion_exp((vector3_t){w[0], w[1], w[2]}));
+
+    // P = F P F^T + Q with F = [A, -I dt; 0, I] and A = I - [w x], computed
+    // per 3x3 block: attitude-attitude, attitude-bias and bias-bias
+    float a[3][3] = {
+        {1.f, w[2], -w[1]},
+        {-w[2], 1.f, w[0]},
+        {w[1], -w[0], 1.f},
+    };
+    float ap[3][3], t[3][3];
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = 0; j < 3; j++)
+        {
+            ap[i][j] = a[i][0] * P(0, j) + a[i][1] * P(1, j) + a[i][2] * P(2, j);
+            t[i][j] = a[i][0] * P(0, j + 3) + a[i][1] * P(1, j + 3) + a[i][2] * P(2, j + 3);
+        }
+    }
+
+    float q_attitude = ahrs->config.gyro_noise * ahrs->config.gyro_noise * dt;
+    float q_bias = ahrs->config.gyro_bias_noise * ahrs->config.gyro_bias_noise * dt;
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = i; j < 3; j++)
+        {
+            P(i, j) = ap[i][0] * a[j][0] + ap[i][1] * a[j][1] + ap[i][2] * a[j][2] -
+                      dt * (t[i][j] + t[j][i]) + dt * dt * P(i + 3, j + 3) +
+                      (i == j ? q_attitude : 0.f);
+        }
+    }
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 3; j++)
+            P(i, j + 3) = t[i][j] - dt * P(i + 3, j + 3);
+    for (int i = 3; i < N; i++)
+        P(i, i) += q_bias;
+}
+
+// Observes `predicted` = R^T v, whose Jacobian w.r.t. the attitude error is
+// [predicted x] and zero w.r.t. the bias. Returns false when gated out.
+static bool ahrs_ekf_observe(ahrs_t *ahrs, vector3_t measured, vector3_t predicted, float noise, float gate)
+{
+    ahrs_ekf_state_t *ekf = &ahrs->state.ekf;
+    float *p = ekf->p;
+    float h[3][3] = {
+        {0.f, -predicted.z, predicted.y},
+        {predicted.z, 0.f, -predicted.x},
+        {-predicted.y, predicted.x, 0.f},
+    };
+    float y[3] = {measured.x - predicted.x, measured.y - predicted.y, measured.z - predicted.z};
+
+    // P H^T only involves the attitude columns of P
+    float pht[N][3];
+    for (int i = 0; i < N; i++)
+        for (int m = 0; m < 3; m++)
+            pht[i][m] = P(i, 0) * h[m][0] + P(i, 1) * h[m][1] + P(i, 2) * h[m][2];
+
+    // S = H P H^T + R
+    float s[3][3], s_inv[3][3];
+    for (int m = 0; m < 3; m++)
+        for (int n = m; n < 3; n++)
+            s[m][n] = s[n][m] = h[m][0] * pht[0][n] + h[m][1] * pht[1][n] + h[m][2] * pht[2][n] + (m == n ? noise * noise : 0.f);
+
+    if (!invert_symmetric3(s, s_inv))
+        return false;
+
+    // Chi-square test on the normalized innovation
+    float s_inv_y[3];
+    for (int m = 0; m < 3; m++)
+        s_inv_y[m] = s_inv[m][0] * y[0] + s_inv[m][1] * y[1] + s_inv[m][2] * y[2];
+    if (y[0] * s_inv_y[0] + y[1] * s_inv_y[1] + y[2] * s_inv_y[2] > gate)
+        return false;
+
+    // K = P H^T S^-1, dx = K y = P H^T S^-1 y
+    float k[N][3], dx[N];
+    for (int i = 0; i < N; i++)
+    {
+        for (int m = 0; m < 3; m++)
+            k[i][m] = pht[i][0] * s_inv[0][m] + pht[i][1] * s_inv[1][m] + pht[i][2] * s_inv[2][m];
+        dx[i] = pht[i][0] * s_inv_y[0] + pht[i][1] * s_inv_y[1] + pht[i][2] * s_inv_y[2];
+    }
+
+    // P = P - K H P, where H P = (P H^T)^T
+    for (int i = 0; i < N; i++)
+        for (int j = i; j < N; j++)
+            P(i, j) -= k[i][0] * pht[j][0] + k[i][1] * pht[j][1] + k[i][2] * pht[j][2];
+
+    apply_error(&ahrs->rotation, (vector3_t){dx[0], dx[1], dx[2]});
+    ekf->gyro_bias.x += dx[3];
+    ekf->gyro_bias.y += dx[4];
+    ekf->gyro_bias.z += dx[5];
+    return true;
+}
+
+// The measured field in the world frame, with its horizontal component
+// rotated onto the x axis
+static vector3_t magnet_reference(quaternion_t rotation, vector3_t measured)
+{
+    vector3_t h = quaternion_rotate(rotation, measured);
+    return (vector3_t){sqrtf(h.x * h.x + h.y * h.y), 0.f, h.z};
+}
+
+// q = q * [1, e / 2], normalized
+static void apply_error(quaternion_t *q, vector3_t e)
+{
+    quaternion_t dq = {1.f, .5f * e.x, .5f * e.y, .5f * e.z};
+    quaternion_t r = quaternion_multiply(*q, dq);
+    float norm = 1.f / sqrtf(r.w * r.w + r.x * r.x + r.y * r.y + r.z * r.z);
+
+    *q = (quaternion_t){r.w * norm, r.x * norm, r.y * norm, r.z * norm};
+}
+
+static bool invert_symmetric3(const float m[3][3], float out[3][3])
+{
+    float c00 = m[1][1] * m[2][2] - m[1][2] * m[1][2];
+    float c01 = m[1][2] * m[0][2] - m[0][1] * m[2][2];
+    float c02 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+    float det = m[0][0] * c00 + m[0][1] * c01 + m[0][2] * c02;
+
+    if (fabsf(det) < 1e-12f)
+        return false;
+
+    float inv = 1.f / det;
+    out[0][0] = c00 * inv;
+    out[0][1] = out[1][0] = c01 * inv;
+    out[0][2] = out[2][0] = c02 * inv;
+    out[1][1] = (m[0][0] * m[2][2] - m[0][2] * m[0][2]) * inv;
+    out[1][2] = out[2][1] = (m[0][2] * m[0][1] - m[0][0] * m[1][2]) * inv;
+    out[2][2] = (m[0][0] * m[1][1] - m[0][1] * m[0][1]) * inv;
+    return true;
+}
@@ -0,0 +1,40 @@
+#include <MadgwickAHRS.h>
+#include "ahrs.h"
+
+static void ahrs_madgwick_reset(ahrs_t *ahrs)
+{
+}
+
+static void ahrs_madgwick_update(ahrs_t *ahrs, vector3_t accel, vector3_t gyro, vector3_t magnet, float dt)
+{
+    MadgwickFilter filter = {
+        .beta = ahrs->config.beta,
+        .q0 = ahrs->rotation.w,
+        .q1 = ahrs->rotation.x,
+        .q2 = ahrs->rotation.y,
+        .q3 = ahrs->rotation.z,
+    };
+
+    MadgwickFilterUpdate(&filter, gyro.x, gyro.y, gyro.z, accel.x, accel.y, accel.z, magnet.x, magnet.y, magnet.z, dt);
+
+    ahrs->rotation = (quaternion_t){filter.q0, filter.q1, filter.q2, filter.q3};
+}
+
+static void ahrs_madgwick_predict(ahrs_t *ahrs, vector3_t angle, float dt)
+{
+    ahrs->rotation = quaternion_multiply(ahrs->rotation, quaternion_exp(angle));
+}
+
+// Gradient descent step only: the gyro was already integrated by the predict steps
+static void ahrs_madgwick_correct(ahrs_t *ahrs, vector3_t accel, vector3_t magnet, float dt)
+{
+    ahrs_madgwick_update(ahrs, accel, (vector3_t){0.f, 0.f, 0.f}, magnet, dt);
+}
+
+const ahrs_ops_t ahrs_madgwick_ops = {
+    .name = "Madgwick",
+    .reset = ahrs_madgwick_reset,
+    .update = ahrs_madgwick_update,
+    .predict = ahrs_madgwick_predict,
+    .correct = ahrs_madgwick_correct,
+};
@@ -0,0 +1,33 @@
+#include "ahrs.h"
+
+static void ahrs_mahony_reset(ahrs_t *ahrs)
+{
+    ahrs->state.mahony_error = (vector3_t){0.f, 0.f, 0.f};
+}
+
+static void ahrs_mahony_update(ahrs_t *ahrs, vector3_t accel, vector3_t gyro, vector3_t magnet, float dt)
+{
+    quaternion_mahony_update_gains(
+        &ahrs->rotation, &ahrs->state.mahony_error,
+        accel, gyro, magnet,
+        ahrs->config.kp, ahrs->config.ki, dt);
+}
+
+static void ahrs_mahony_predict(ahrs_t *ahrs, vector3_t angle, float dt)
+{
+    ahrs->rotation = quaternion_multiply(ahrs->rotation, quaternion_exp(angle));
+}
+
+// Feedback only: the gyro was already integrated by the predict steps
+static void ahrs_mahony_correct(ahrs_t *ahrs, vector3_t accel, vector3_t magnet, float dt)
+{
+    ahrs_mahony_update(ahrs, accel, (vector3_t){0.f, 0.f, 0.f}, magnet, dt);
+}
+
+const ahrs_ops_t ahrs_mahony_ops = {
+    .name = "Mahony",
+    .reset = ahrs_mahony_reset,
+    .update = ahrs_mahony_update,
+    .predict = ahrs_mahony_predict,
+    .correct = ahrs_mahony_correct,
+};
@@ -0,0 +1,104 @@
+#include <math.h>
+#include <stddef.h>
+#include "backtracking.h"
+#include "compensation.h"
+
+#define PI 3.14159265358979323846
+#define rad (PI / 180.f)
+
+static inline float evaluate(const backtracking_t *backtracking, float sun_x, float sun_y, float sun_z, float *incidence);
+
+backtracking_config_t backtracking_default_config()
+{
+    return (backtracking_config_t){
+        .row_pitch = 2.f,
+        .panel_width = 1.f,
+        .slope = 0.f,
+        // North-south rows, the sun azimuth counting from the south
+        .row_azimuth = 0.f,
+    };
+}
+
+void backtracking_init(backtracking_t *backtracking, const backtracking_config_t *config)
+{
+    *backtracking = (backtracking_t){
+        .config = *config,
+        .across = compensation_direction((orientation_t){.azimuth = config->row_azimuth + 90.f, .inclination = 90.f}),
+        .along = compensation_direction((orientation_t){.azimuth = config->row_azimuth, .inclination = 90.f}),
+        .slope = config->slope * rad,
+        .axes_distance = config->row_pitch / (config->panel_width * cosf(config->slope * rad)),
+    };
+}
+
+// In the plane across the rows, a panel at rotation r throws a shadow as
+// wide as width * |cos(r - s)| toward a sun at rotation s, and the next axis
+// lies pitch * |cos(s + slope)| / cos(slope) away in that direction. The
+// closest shade free rotation turns back toward flat by acos of their ratio.
+float backtracking_rotation(const backtracking_t *backtracking, float sun_rotation)
+{
+    float rotation = sun_rotation * rad;
+    float ratio = fabsf(cosf(rotation + backtracking->slope)) * backtracking->axes_distance;
+
+    return (rotation - copysignf(acosf(fminf(ratio, 1.f)), rotation)) / rad;
+}
+
+orientation_t backtracking_orientation(const backtracking_t *backtracking, orientation_t sun)
+{
+    vector3_t direction = compensation_direction(sun);
+
+    if (direction.z <= 0.f)
+        return sun;
+
+    float across = vector3_dot(direction, backtracking->across);
+    float along = vector3_dot(direction, backtracking->along);
+    float projection = sqrtf(across * across + direction.z * direction.z);
+    float rotation = backtracking_rotation(backtracking, atan2f(across, direction.z) / rad) * rad;
+    vector3_t normal = {
+        backtracking->across.x * projection * sinf(rotation) + backtracking->along.x * along,
+        backtracking->across.y * projection * sinf(rotation) + backtracking->along.y * along,
+        projection * cosf(rotation),
+    };
+    orientation_t orientation = {
+        .azimuth = sun.azimuth,
+        .inclination = acosf(fminf(normal.z, 1.f)) / rad,
+    };
+
+    compensation_orientation(normal, &orientation);
+    return orientation;
+}
+
+void backtracking_evaluate(const backtracking_t *backtracking, const float *sun_x, const float *sun_y, const float *sun_z, int count,
+                           float *rotations, float *incidences)
+{
+    float incidence;
+
+    // Which outputs are wanted is settled once, not per element
+    if (rotations != NULL && incidences != NULL)
+    {
+        for (int i = 0; i < count; i++)
+            rotations[i] = evaluate(backtracking, sun_x[i], sun_y[i], sun_z[i], &incidences[i]);
+    }
+    else if (rotations != NULL)
+    {
+        for (int i = 0; i < count; i++)
+            rotations[i] = evaluate(backtracking, sun_x[i], sun_y[i], sun_z[i], &incidence);
+    }
+    else if (incidences != NULL)
+    {
+        for (int i = 0; i < count; i++)
+            evaluate(backtracking, sun_x[i], sun_y[i], sun_z[i], &incidences[i]);
+    }
+}
+
+// Backtracked rotation (radian) of one sun direction, and the incidence cosine it keeps
+static inline float evaluate(const backtracking_t *backtracking, float sun_x, float sun_y, float sun_z, float *incidence)
+{
+    float across = sun_x * backtracking->across.x + sun_y * backtracking->across.y;
+    float along = sun_x * backtracking->along.x + sun_y * backtracking->along.y;
+    float rotation = atan2f(across, sun_z);
+    // Cosine of the correction, 1 while nothing needs backtracking
+    float ratio = fminf(fabsf(cosf(rotation + backtracking->slope)) * backtracking->axes_distance, 1.f);
+
+    *incidence = (across * across + sun_z * sun_z) * ratio + along * along;
+    return rotation - copysignf(acosf(ratio), rotation);
+}
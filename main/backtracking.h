@@ -0,0 +1,55 @@
+#ifndef __BACKTRACKING_H__
+#define __BACKTRACKING_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+typedef struct backtracking_config_t
+{
+    // Distance between the rotation axes of two rows, and panel width across
+    // the rows, in the same unit
+    float row_pitch;
+    float panel_width;
+    // Terrain slope across the rows (degree), positive when the ground rises
+    // toward the next row, at azimuth `row_azimuth` + 90
+    float slope;
+    // Azimuth (degree) the rows run along
+    float row_azimuth;
+} backtracking_config_t;
+
+typedef struct backtracking_t
+{
+    backtracking_config_t config;
+    // Horizontal unit vectors across and along the rows
+    vector3_t across;
+    vector3_t along;
+    float slope;
+    // Pitch over the panel width, projected on the horizontal
+    float axes_distance;
+} backtracking_t;
+
+backtracking_config_t backtracking_default_config();
+void backtracking_init(backtracking_t *backtracking, const backtracking_config_t *config);
+/**
+ * Rotation across the rows (degree from the vertical, toward `across`) that
+ * is closest to `sun_rotation`, the rotation facing the sun, without shading
+ * the next row. Rotations are the panel normal projected across the rows.
+ */
+float backtracking_rotation(const backtracking_t *backtracking, float sun_rotation);
+/**
+ * Orientation closest to facing the sun whose panel does not shade the next
+ * row: the rotation across the rows is backtracked, the part of the sun
+ * direction along the rows is kept.
+ */
+orientation_t backtracking_orientation(const backtracking_t *backtracking, orientation_t sun);
+/**
+ * The same for `count` sun directions given as separate x, y and z arrays,
+ * batched without per element branches. Writes the backtracked rotations
+ * (radian) and the incidence cosine they keep on the sun, any of them may be
+ * NULL.
+ */
+void backtracking_evaluate(const backtracking_t *backtracking, const float *sun_x, const float *sun_y, const float *sun_z, int count,
+                           float *rotations, float *incidences);
+
+#endif // __BACKTRACKING_H__
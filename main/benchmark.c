@@ -0,0 +1,1463 @@
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <i2c_bus_sim.h>
+#include <MadgwickAHRS.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "actuator.h"
+#include "ahrs.h"
+#include "backtracking.h"
+#include "benchmark.h"
+#include "compensation.h"
+#include "motion_profile.h"
+#include "motion_queue.h"
+#include "multi_head.h"
+#include "path_planner.h"
+#include "protocol.h"
+#include "redundant_imu.h"
+#include "servo_calibration.h"
+#include "servo_feedback.h"
+#include "sun_calculator.h"
+#include "telemetry_delta.h"
+#include "trace.h"
+
+#define PI 3.14159265358979323846
+#define rad (PI / 180.f)
+
+// Samples fed to a filter between two timer reads
+#define BENCHMARK_CHUNK 50
+// Samples per batch update, like a FIFO read
+#define BENCHMARK_BATCH 10
+// Errors are only accumulated once the filters had time to converge
+#define BENCHMARK_SETTLE_TIME 10.f
+// Orientations and passes of the compensation benchmark
+#define COMPENSATION_INPUTS 64
+#define COMPENSATION_PASSES 500
+// Sampling step of the motion profiles, and plans timed per case
+#define MOTION_PROFILE_STEP 1e-3f
+#define MOTION_PROFILE_PLANS 200
+// Servo PWM: 16 bit timer at 50 Hz
+#define SERVO_FREQUENCY 50
+#define SERVO_RESOLUTION 16
+// Motion queue: executor period (us), then how long (ms) the executor is
+// timed idle and under logging load, against a tskIDLE_PRIORITY task
+#define MOTION_QUEUE_PERIOD 20000
+#define MOTION_QUEUE_TIMING_MS 2000
+// Commands timed per actuator backend, and the velocity limit check
+#define ACTUATOR_COMMANDS 2000
+#define ACTUATOR_VELOCITY_LIMIT 90.f
+#define ACTUATOR_VELOCITY_WAIT 20000
+// Power gating check: settle time (s) and pre-pulse (ms)
+#define ACTUATOR_SETTLE_TIME .01f
+#define ACTUATOR_PRE_PULSE_MS 5
+// Calibration points of the simulated servo, and duties timed
+#define SERVO_CALIBRATION_POINTS 9
+#define SERVO_CHECKS 3601
+// Servo feedback filter updates timed
+#define SERVO_FEEDBACK_UPDATES 1000
+// Sun path simulation: a year from 2023-01-01 UTC, tracking every 2 minutes,
+// at the tracker location
+#define SUN_PATH_START 1672531200
+#define SUN_PATH_DAYS 365
+#define SUN_PATH_STEP 120
+#define SUN_PATH_LATITUDE 10.75f
+#define SUN_PATH_LONGITUDE 106.75f
+// Longest sun lookahead (s)
+#define SUN_LOOKAHEAD_MAX 600.f
+// Backtracking: sun directions of the sun path year every 5 minutes, in
+// chunks of daylight ones
+#define BACKTRACKING_STEP 300
+#define BACKTRACKING_CHUNK 256
+// Multi-head: the simulated expanders sit on the port the IMU does not use,
+// at 400 kHz, planned once a minute from local noon (2023-03-20, UTC+7) and
+// stepped every 50 Hz PWM frame
+#define MULTI_HEAD_PORT 1
+#define MULTI_HEAD_CLOCK 400000
+#define MULTI_HEAD_NOON 1679288400
+#define MULTI_HEAD_PLANS 60
+#define MULTI_HEAD_FRAMES 500
+#define MULTI_HEAD_FRAME_TIME .02f
+// Trace events recorded, drained every batch, against log lines printed
+#define TRACE_BENCHMARK_EVENTS 10000
+#define TRACE_BENCHMARK_BATCH 100
+#define TRACE_BENCHMARK_LOGS 10
+// Random messages the protocol benchmark encodes and decodes
+#define PROTOCOL_BENCHMARK_MESSAGES 1000
+// Time at which the redundant IMU benchmark injects its fault
+#define REDUNDANT_IMU_FAULT_TIME 40.f
+
+typedef struct synthetic_trajectory_t
+{
+    float rate;
+    float duration;
+    float time;
+    uint32_t seed;
+    quaternion_t truth;
+    vector3_t gyro_bias;
+    // Field added to the magnetometer in a time window, like a passing motor
+    vector3_t magnet_disturbance;
+    float disturbance_start;
+    float disturbance_end;
+} synthetic_trajectory_t;
+
+typedef enum imu_fault_t
+{
+    IMU_FAULT_NONE,
+    IMU_FAULT_SILENT,
+    IMU_FAULT_STUCK,
+    IMU_FAULT_TILTED,
+} imu_fault_t;
+
+// State of the legacy Madgwick kernel, in volatile globals as it was
+static volatile float legacy_sample_freq = 50;
+static volatile float legacy_beta = 0.8;
+static volatile float legacy_q0 = 1.0f, legacy_q1 = 0.0f, legacy_q2 = 0.0f, legacy_q3 = 0.0f;
+
+static void synthetic_rewind(void *context);
+static bool synthetic_next(void *context, benchmark_sample_t *sample);
+static quaternion_t synthetic_truth(float t);
+static void recorded_rewind(void *context);
+static bool recorded_next(void *context, benchmark_sample_t *sample);
+static void benchmark_mahony_baseline(const benchmark_trajectory_t *trajectory);
+static orientation_t compensate_quaternion_chain(quaternion_t platform_rotation, orientation_t orientation, float fallback_azimuth);
+static void legacy_madgwick_update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz);
+static float legacy_inv_sqrt(float x);
+static float noise(uint32_t *seed, float sigma);
+static float orientation_error(quaternion_t a, quaternion_t b);
+static float servo_pulse_width(float angle);
+static void count_motion_queue_output(const float angles[MOTORS_AXES], uint32_t energize, void *context);
+static void time_idle_priority_task(void *params);
+static void random_message(uint32_t *seed, protocol_message_t *message);
+static uint32_t random_below(uint32_t *seed, uint32_t count);
+
+void benchmark_run()
+{
+    static synthetic_trajectory_t sway = {
+        .rate = 12.5f,
+        .duration = 120.f,
+        .gyro_bias = {.002f, -.003f, .001f},
+    };
+    static synthetic_trajectory_t fifo = {
+        .rate = 100.f,
+        .duration = 120.f,
+        .gyro_bias = {.002f, -.003f, .001f},
+    };
+    static synthetic_trajectory_t disturbed = {
+        .rate = 12.5f,
+        .duration = 120.f,
+        .gyro_bias = {.002f, -.003f, .001f},
+        .magnet_disturbance = {-.4f, .6f, .3f},
+        .disturbance_start = 60.f,
+        .disturbance_end = 75.f,
+    };
+    benchmark_trajectory_t trajectories[] = {
+        {
+            .name = "Synthetic sway",
+            .context = &sway,
+            .rewind = synthetic_rewind,
+            .next = synthetic_next,
+        },
+        {
+            .name = "Synthetic sway, 100 Hz",
+            .context = &fifo,
+            .rewind = synthetic_rewind,
+            .next = synthetic_next,
+        },
+        {
+            .name = "Synthetic sway, disturbed magnet",
+            .context = &disturbed,
+            .rewind = synthetic_rewind,
+            .next = synthetic_next,
+        },
+    };
+
+    for (int i = 0; i < sizeof(trajectories) / sizeof(trajectories[0]); i++)
+    {
+        benchmark_mahony_baseline(&trajectories[i]);
+        benchmark_ahrs(&trajectories[i]);
+        benchmark_madgwick_gains(&trajectories[i]);
+    }
+
+    benchmark_redundant_imu(&trajectories[0]);
+
+    benchmark_compensation();
+    benchmark_motion_profile();
+    benchmark_motion_queue();
+    benchmark_path_planner();
+    benchmark_backtracking();
+    benchmark_multi_head();
+    benchmark_trace();
+    benchmark_protocol();
+    benchmark_servo_calibration();
+    benchmark_actuator();
+    benchmark_servo_feedback();
+}
+
+// Per stage cost of the platform compensation, against the quaternion chain it replaced
+void benchmark_compensation()
+{
+    static orientation_t inputs[COMPENSATION_INPUTS];
+    static vector3_t directions[COMPENSATION_INPUTS];
+    static vector3_t local[COMPENSATION_INPUTS];
+    static orientation_t outputs[COMPENSATION_INPUTS];
+    const quaternion_t platform_rotation = quaternion_normalize((quaternion_t){.98f, .08f, -.12f, .1f});
+    const int calls = COMPENSATION_INPUTS * COMPENSATION_PASSES;
+    compensation_t compensation;
+    int64_t start, elapsed;
+
+    for (int i = 0; i < COMPENSATION_INPUTS; i++)
+        inputs[i] = (orientation_t){.azimuth = i * 360.f / COMPENSATION_INPUTS, .inclination = (i % 9) * 10.f};
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < COMPENSATION_PASSES; pass++)
+        for (int i = 0; i < COMPENSATION_INPUTS; i++)
+            outputs[i] = compensate_quaternion_chain(platform_rotation, inputs[i], 0.f);
+    elapsed = esp_timer_get_time() - start;
+    ESP_LOGI("Benchmark", "Compensation / quaternion chain: %lld ns/call", (long long)(elapsed * 1000 / calls));
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < calls; pass++)
+    {
+        compensation_init(&compensation, 0.f);
+        compensation_set_platform_rotation(&compensation, platform_rotation);
+    }
+    elapsed = esp_timer_get_time() - start;
+    ESP_LOGI("Benchmark", "Compensation / matrix rebuild: %lld ns/call", (long long)(elapsed * 1000 / calls));
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < calls; pass++)
+        compensation_set_platform_rotation(&compensation, platform_rotation);
+    elapsed = esp_timer_get_time() - start;
+    ESP_LOGI("Benchmark", "Compensation / unchanged rotation check: %lld ns/call", (long long)(elapsed * 1000 / calls));
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < COMPENSATION_PASSES; pass++)
+        for (int i = 0; i < COMPENSATION_INPUTS; i++)
+            directions[i] = compensation_direction(inputs[i]);
+    elapsed = esp_timer_get_time() - start;
+    ESP_LOGI("Benchmark", "Compensation / direction from azimuth and inclination: %lld ns/call", (long long)(elapsed * 1000 / calls));
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < COMPENSATION_PASSES; pass++)
+        for (int i = 0; i < COMPENSATION_INPUTS; i++)
+            local[i] = compensation_to_platform(&compensation, directions[i]);
+    elapsed = esp_timer_get_time() - start;
+    ESP_LOGI("Benchmark", "Compensation / matrix-vector product: %lld ns/call", (long long)(elapsed * 1000 / calls));
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < COMPENSATION_PASSES; pass++)
+        for (int i = 0; i < COMPENSATION_INPUTS; i++)
+            compensation_orientation(local[i], &outputs[i]);
+    elapsed = esp_timer_get_time() - start;
+    ESP_LOGI("Benchmark", "Compensation / direction to orientation: %lld ns/call", (long long)(elapsed * 1000 / calls));
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < COMPENSATION_PASSES; pass++)
+        for (int i = 0; i < COMPENSATION_INPUTS; i++)
+            outputs[i] = compensation_apply(&compensation, inputs[i], 0.f);
+    elapsed = esp_timer_get_time() - start;
+    ESP_LOGI("Benchmark", "Compensation / cached matrix, total: %lld ns/call", (long long)(elapsed * 1000 / calls));
+
+    float error_max = 0.f;
+    for (int i = 0; i < COMPENSATION_INPUTS; i++)
+    {
+        orientation_t expected = compensate_quaternion_chain(platform_rotation, inputs[i], 0.f);
+        float azimuth_error = fabsf(remainderf(outputs[i].azimuth - expected.azimuth, 360.f));
+        error_max = fmaxf(error_max, fmaxf(azimuth_error, fabsf(outputs[i].inclination - expected.inclination)));
+    }
+    ESP_LOGI("Benchmark", "Compensation / largest difference with the quaternion chain: %.5f deg", error_max);
+}
+
+void benchmark_ahrs(const benchmark_trajectory_t *trajectory)
+{
+    static benchmark_sample_t samples[BENCHMARK_CHUNK];
+    static ahrs_sample_t batch[BENCHMARK_CHUNK];
+    static quaternion_t estimates[BENCHMARK_CHUNK];
+    const ahrs_engine_t engines[] = {AHRS_MAHONY, AHRS_MADGWICK, AHRS_EKF};
+
+    for (int run = 0; run < 2 * sizeof(engines) / sizeof(engines[0]); run++)
+    {
+        // Every engine runs once per sample, then in batches
+        ahrs_engine_t engine = engines[run / 2];
+        bool batched = run % 2 == 1;
+
+        ahrs_t ahrs;
+        ahrs_config_t config = ahrs_default_config(engine);
+        ahrs_init(&ahrs, &config);
+        trajectory->rewind(trajectory->context);
+
+        int64_t elapsed = 0, timestamp = 0;
+        int updates = 0, measured = 0;
+        float time = 0.f, error_sum = 0.f, error_max = 0.f;
+        bool has_more = true;
+
+        while (has_more)
+        {
+            int count = 0;
+            while (count < BENCHMARK_CHUNK && (has_more = trajectory->next(trajectory->context, &samples[count])))
+            {
+                timestamp += (int64_t)(samples[count].dt * 1e6f);
+                batch[count] = (ahrs_sample_t){
+                    .accel = samples[count].accel,
+                    .gyro = samples[count].gyro,
+                    .magnet = samples[count].magnet,
+                    .timestamp = timestamp,
+                };
+                count++;
+            }
+
+            int64_t start = esp_timer_get_time();
+            if (batched)
+            {
+                for (int i = 0; i < count; i += BENCHMARK_BATCH)
+                {
+                    int size = count - i < BENCHMARK_BATCH ? count - i : BENCHMARK_BATCH;
+                    ahrs_update_batch(&ahrs, &batch[i], size);
+                    estimates[i + size - 1] = ahrs.rotation;
+                }
+            }
+            else
+            {
+                for (int i = 0; i < count; i++)
+                {
+                    ahrs_update(&ahrs, samples[i].accel, samples[i].gyro, samples[i].magnet, samples[i].dt);
+                    estimates[i] = ahrs.rotation;
+                }
+            }
+            elapsed += esp_timer_get_time() - start;
+            updates += count;
+
+            for (int i = 0; i < count; i++)
+            {
+                time += samples[i].dt;
+
+                // Batches only expose the rotation after their last sample
+                bool has_estimate = !batched || (i + 1) % BENCHMARK_BATCH == 0 || i == count - 1;
+                if (time < BENCHMARK_SETTLE_TIME || !has_estimate)
+                    continue;
+
+                float error = orientation_error(estimates[i], samples[i].truth);
+                error_sum += error;
+                error_max = fmaxf(error_max, error);
+                measured++;
+            }
+        }
+
+        ESP_LOGI("Benchmark", "%s / %s%s: %lld ns/sample, error mean %.3f deg, max %.3f deg over %d samples",
+                 trajectory->name, ahrs.ops->name, batched ? " batch" : "",
+                 updates > 0 ? elapsed * 1000 / updates : 0LL,
+                 measured > 0 ? error_sum / measured : 0.f, error_max, measured);
+
+        if (engine == AHRS_EKF)
+        {
+            ESP_LOGI("Benchmark", "%s / %s%s: rejected %u accel and %u magnet updates",
+                     trajectory->name, ahrs.ops->name, batched ? " batch" : "",
+                     (unsigned)ahrs.state.ekf.accel_rejected, (unsigned)ahrs.state.ekf.magnet_rejected);
+        }
+    }
+}
+
+// Plan and sample cost of both profile types, on moves from rest and retargets
+void benchmark_motion_profile()
+{
+    const motion_limits_t limits[MOTION_PROFILE_AXES] = {
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+        {.velocity = 120.f, .acceleration = 240.f, .jerk = 1500.f},
+    };
+    const struct
+    {
+        const char *name;
+        axis_state_t start[MOTION_PROFILE_AXES];
+        float target[MOTION_PROFILE_AXES];
+    } moves[] = {
+        {"long move", {{0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}}, {170.f, -60.f}},
+        {"short move", {{10.f, 0.f, 0.f}, {10.f, 0.f, 0.f}}, {12.f, 10.5f}},
+        {"retarget ahead", {{50.f, 100.f, -100.f}, {20.f, -30.f, 50.f}}, {120.f, -10.f}},
+        {"retarget behind", {{50.f, 150.f, 200.f}, {0.f, 60.f, 0.f}}, {20.f, 5.f}},
+    };
+    const motion_profile_type_t types[] = {MOTION_PROFILE_TRAPEZOIDAL, MOTION_PROFILE_S_CURVE};
+
+    for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++)
+    {
+        for (int m = 0; m < sizeof(moves) / sizeof(moves[0]); m++)
+        {
+            static motion_profile_t profile;
+            axis_state_t states[MOTION_PROFILE_AXES];
+            int samples = 0;
+
+            int64_t start = esp_timer_get_time();
+            for (int i = 0; i < MOTION_PROFILE_PLANS; i++)
+                motion_profile_plan(&profile, types[t], limits, moves[m].start, moves[m].target);
+            int64_t plan_time = esp_timer_get_time() - start;
+
+            start = esp_timer_get_time();
+            for (float time = MOTION_PROFILE_STEP; time < profile.duration + MOTION_PROFILE_STEP; time += MOTION_PROFILE_STEP)
+            {
+                motion_profile_sample(&profile, time, states);
+                samples++;
+            }
+            int64_t sample_time = esp_timer_get_time() - start;
+
+            ESP_LOGI("Benchmark", "Motion profile / %s, %s: %.3f s, plan %lld ns, sample %lld ns",
+                     motion_profile_type_name(types[t]), moves[m].name, profile.duration,
+                     plan_time * 1000 / MOTION_PROFILE_PLANS, samples > 0 ? sample_time * 1000 / samples : 0LL);
+        }
+    }
+}
+
+// Cost of a duty computation through the linear mapping and through a
+// calibration table measured on a nonlinear servo
+void benchmark_servo_calibration()
+{
+    servo_calibration_t linear = servo_calibration_linear(-90.f, 400.f, 90.f, 2400.f);
+    servo_calibration_t measured = {.count = SERVO_CALIBRATION_POINTS};
+
+    for (int i = 0; i < SERVO_CALIBRATION_POINTS; i++)
+    {
+        float angle = -90.f + 180.f * i / (SERVO_CALIBRATION_POINTS - 1);
+        measured.points[i] = (servo_calibration_point_t){.angle = angle, .pulse_width = servo_pulse_width(angle)};
+    }
+
+    const struct
+    {
+        const char *name;
+        const servo_calibration_t *calibration;
+    } mappings[] = {
+        {"linear", &linear},
+        {"calibrated", &measured},
+    };
+
+    for (int m = 0; m < sizeof(mappings) / sizeof(mappings[0]); m++)
+    {
+        volatile uint32_t sink = 0;
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < SERVO_CHECKS; i++)
+            sink += servo_calibration_duty(mappings[m].calibration, -90.f + 180.f * i / (SERVO_CHECKS - 1), SERVO_RESOLUTION, SERVO_FREQUENCY);
+        int64_t elapsed = esp_timer_get_time() - start;
+
+        ESP_LOGI("Benchmark", "Servo calibration / %s, 16 bit: %lld ns per duty", mappings[m].name, elapsed * 1000 / SERVO_CHECKS);
+    }
+}
+
+// Command latency of the backend built in, and of the simulation one, with
+// the servos left unpowered
+void benchmark_actuator()
+{
+    const actuator_ops_t *backends[] = {&ACTUATOR_BACKEND, &actuator_sim_ops};
+    actuator_config_t config = {
+        .enable_gpio = {GPIO_NUM_13, GPIO_NUM_4},
+        .pwm_gpio = {GPIO_NUM_16, GPIO_NUM_17},
+        .frequency = 50,
+        .calibrations = {
+            servo_calibration_linear(0.f, 2400.f, 180.f, 400.f),
+            servo_calibration_linear(-90.f, 400.f, 90.f, 2400.f),
+        },
+    };
+
+    for (int b = 0; b < sizeof(backends) / sizeof(backends[0]); b++)
+    {
+        static actuator_t actuator;
+        static actuator_sim_t simulation;
+
+        if (b > 0 && backends[b] == backends[0])
+            continue;
+
+        if (actuator_init(&actuator, backends[b], &config, backends[b] == &actuator_sim_ops ? &simulation : NULL) != ESP_OK)
+        {
+            ESP_LOGW("Benchmark", "Actuator / %s: initialization failed", backends[b]->name);
+            continue;
+        }
+
+        // Alternating positions, so that every command is written
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < ACTUATOR_COMMANDS; i++)
+            actuator_set_position(&actuator, i % MOTORS_AXES, 45.f + (i / MOTORS_AXES % 2));
+        int64_t position_time = esp_timer_get_time() - start;
+
+        start = esp_timer_get_time();
+        for (int i = 0; i < ACTUATOR_COMMANDS; i++)
+            actuator_set_power(&actuator, i % MOTORS_AXES, false);
+        int64_t power_time = esp_timer_get_time() - start;
+
+        // From rest, a far command moves no more than the limit allows
+        actuator_set_position(&actuator, MOTOR_AZIMUTH, 0.f);
+        actuator_set_velocity_limit(&actuator, MOTOR_AZIMUTH, ACTUATOR_VELOCITY_LIMIT);
+        start = esp_timer_get_time();
+        while (esp_timer_get_time() - start < ACTUATOR_VELOCITY_WAIT)
+            ;
+        actuator_set_position(&actuator, MOTOR_AZIMUTH, 180.f);
+        float allowed = ACTUATOR_VELOCITY_LIMIT * (esp_timer_get_time() - start) * 1e-6f;
+        float moved = actuator.channels[MOTOR_AZIMUTH].angle;
+        actuator_set_velocity_limit(&actuator, MOTOR_AZIMUTH, 0.f);
+
+        // The settled axis is de-energized, then a move waits for the pre-pulse
+        actuator_set_power(&actuator, MOTOR_AZIMUTH, true);
+        actuator_set_power_gating(&actuator, ACTUATOR_SETTLE_TIME, ACTUATOR_PRE_PULSE_MS);
+        start = esp_timer_get_time();
+        while (esp_timer_get_time() - start < 2 * ACTUATOR_SETTLE_TIME * 1e6f)
+            actuator_update_power(&actuator);
+        bool gated = !actuator.channels[MOTOR_AZIMUTH].powered;
+
+        start = esp_timer_get_time();
+        while (actuator.channels[MOTOR_AZIMUTH].angle != 90.f && esp_timer_get_time() - start < 100 * ACTUATOR_PRE_PULSE_MS * 1000)
+            actuator_set_position(&actuator, MOTOR_AZIMUTH, 90.f);
+        int64_t held = esp_timer_get_time() - start;
+        float energized = actuator_energized_seconds(&actuator, MOTOR_AZIMUTH);
+        actuator_set_power_gating(&actuator, 0.f, 0);
+
+        ESP_LOGI("Benchmark", "Actuator / %s: position %lld ns, power gate %lld ns per command, velocity limit moved %.2f of %.2f degree allowed, %s, "
+                              "%s after settling, move held %.1f ms by the pre-pulse, energized %.3f s",
+                 backends[b]->name, position_time * 1000 / ACTUATOR_COMMANDS, power_time * 1000 / ACTUATOR_COMMANDS,
+                 moved, allowed, moved <= allowed + .01f ? "within limit" : "LIMIT EXCEEDED",
+                 gated ? "de-energized" : "STILL ENERGIZED", held * 1e-3f, energized);
+    }
+}
+
+// One 50 Hz frame of conversions at the default sample rate, through the
+// spike rejection and filter, on the stand-in ADC
+void benchmark_servo_feedback()
+{
+    static servo_feedback_t feedback;
+    static servo_feedback_sim_t simulation;
+    servo_feedback_config_t config = servo_feedback_default_config();
+    bool valid[MOTORS_AXES];
+
+    simulation = (servo_feedback_sim_t){.angles = {30.f, 0.f}, .noise = 4.f, .spike_rate = .01f, .batch = SERVO_FEEDBACK_MAX_BATCH, .seed = 1};
+    servo_feedback_init(&feedback, &servo_feedback_sim_ops, &config, &simulation);
+
+    int64_t begin = esp_timer_get_time();
+    for (int i = 0; i < SERVO_FEEDBACK_UPDATES; i++)
+        servo_feedback_update(&feedback, valid);
+    int64_t elapsed = esp_timer_get_time() - begin;
+
+    ESP_LOGI("Benchmark", "Servo feedback / filter: %lld ns per update of %d conversions per axis, simulated source included",
+             elapsed * 1000 / SERVO_FEEDBACK_UPDATES, SERVO_FEEDBACK_MAX_BATCH);
+}
+
+// The executor period timed idle and while the CPU is busy logging, next to
+// the tskIDLE_PRIORITY loop it replaces
+void benchmark_motion_queue()
+{
+    static motion_queue_t queue;
+    float position[MOTORS_AXES] = {30.f, 0.f};
+
+    for (int loaded = 0; loaded < 2; loaded++)
+    {
+        static motion_queue_stats_t baseline;
+        TaskHandle_t baseline_task;
+
+        motion_queue_init(&queue, position, MOTION_QUEUE_PERIOD, count_motion_queue_output, NULL);
+        if (motion_queue_start(&queue, portNUM_PROCESSORS - 1) != ESP_OK)
+        {
+            ESP_LOGW("Benchmark", "Motion queue: no hardware timer, executor timing skipped");
+            return;
+        }
+        baseline = (motion_queue_stats_t){0};
+        xTaskCreate(time_idle_priority_task, "Idle priority", 2048, &baseline, tskIDLE_PRIORITY, &baseline_task);
+
+        int64_t begin = esp_timer_get_time();
+        while (esp_timer_get_time() - begin < MOTION_QUEUE_TIMING_MS * 1000)
+        {
+            if (loaded)
+                ESP_LOGI("Benchmark", "Motion queue: logging load at %lld us", (long long)esp_timer_get_time());
+            else
+                vTaskDelay(1);
+        }
+
+        vTaskDelete(baseline_task);
+        motion_queue_stop(&queue);
+
+        ESP_LOGI("Benchmark", "Motion queue / %s: executor jitter mean %.1f max %lld us, latency mean %.1f max %lld us; "
+                              "tskIDLE_PRIORITY loop jitter mean %.1f max %lld us, %u of %u periods run",
+                 loaded ? "logging" : "idle",
+                 queue.stats.ticks > 1 ? (float)queue.stats.jitter_sum / (queue.stats.ticks - 1) : 0.f, (long long)queue.stats.jitter_max,
+                 queue.stats.ticks > 0 ? (float)queue.stats.latency_sum / queue.stats.ticks : 0.f, (long long)queue.stats.latency_max,
+                 baseline.ticks > 1 ? (float)baseline.jitter_sum / (baseline.ticks - 1) : 0.f, (long long)baseline.jitter_max,
+                 baseline.ticks, MOTION_QUEUE_TIMING_MS * 1000 / MOTION_QUEUE_PERIOD);
+    }
+}
+
+// Time the batched schedule takes for a year of sun directions, per row layout
+void benchmark_backtracking()
+{
+    const struct
+    {
+        float row_pitch;
+        float slope;
+    } layouts[] = {
+        {3.33f, 0.f},
+        {2.5f, 0.f},
+        {2.f, 0.f},
+        {2.5f, 5.f},
+        {2.5f, 10.f},
+    };
+    const int layout_count = sizeof(layouts) / sizeof(layouts[0]);
+    static float sun_x[BACKTRACKING_CHUNK], sun_y[BACKTRACKING_CHUNK], sun_z[BACKTRACKING_CHUNK];
+    static float rotations[BACKTRACKING_CHUNK], incidences[BACKTRACKING_CHUNK];
+    backtracking_t backtracking[layout_count];
+    int64_t elapsed[layout_count];
+    int samples = 0;
+
+    for (int l = 0; l < layout_count; l++)
+    {
+        backtracking_config_t config = backtracking_default_config();
+        config.row_pitch = layouts[l].row_pitch;
+        config.slope = layouts[l].slope;
+        backtracking_init(&backtracking[l], &config);
+        elapsed[l] = 0;
+    }
+
+    time_t t = SUN_PATH_START;
+    while (t < SUN_PATH_START + SUN_PATH_DAYS * 86400)
+    {
+        int count = 0;
+
+        for (; count < BACKTRACKING_CHUNK && t < SUN_PATH_START + SUN_PATH_DAYS * 86400; t += BACKTRACKING_STEP)
+        {
+            orientation_t sun = get_sun_orientation(t, SUN_PATH_LATITUDE, SUN_PATH_LONGITUDE);
+            vector3_t direction = compensation_direction(sun);
+
+            // Daylight only
+            if (sun.inclination >= 90.f)
+                continue;
+
+            sun_x[count] = direction.x;
+            sun_y[count] = direction.y;
+            sun_z[count] = direction.z;
+            count++;
+        }
+        samples += count;
+
+        for (int l = 0; l < layout_count; l++)
+        {
+            int64_t begin = esp_timer_get_time();
+            backtracking_evaluate(&backtracking[l], sun_x, sun_y, sun_z, count, rotations, incidences);
+            elapsed[l] += esp_timer_get_time() - begin;
+        }
+    }
+
+    for (int l = 0; l < layout_count; l++)
+    {
+        ESP_LOGI("Benchmark", "Backtracking / pitch %.2f, slope %.0f degree: %.3f ms per year of %d samples",
+                 layouts[l].row_pitch, layouts[l].slope, elapsed[l] * 1e-3f, samples);
+    }
+}
+
+// Heads on simulated PCA9685 expanders: the shared sun position, the plan of
+// each head toward it through its own mounting, then the CPU and wire time
+// of a PWM frame, one write per expander against one write per channel
+void benchmark_multi_head()
+{
+    const motion_limits_t limits[MOTION_PROFILE_AXES] = {
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+    };
+    const int head_counts[] = {1, 2, 4, 8, 16};
+    static i2c_bus_t bus;
+    static i2c_bus_sim_t sim;
+    static multi_head_t multi_head;
+
+    i2c_bus_sim_init(&bus, &sim, MULTI_HEAD_PORT, MULTI_HEAD_CLOCK);
+    for (int expander = 0; expander < MULTI_HEAD_MAX_EXPANDERS; expander++)
+        i2c_bus_sim_add_pca9685(&sim, PCA9685_ADDRESS + expander);
+    ESP_ERROR_CHECK(i2c_bus_attach(&bus));
+
+    for (int c = 0; c < sizeof(head_counts) / sizeof(head_counts[0]); c++)
+    {
+        multi_head_config_t config = multi_head_default_config(head_counts[c], MOTION_PROFILE_S_CURVE, limits);
+        int64_t ephemeris_time = 0, batched_time, channel_time;
+        uint32_t batched_transactions, channel_transactions;
+        uint64_t batched_bus_time, channel_bus_time;
+        float output_error = 0.f;
+
+        // Heads tilted a few degrees every which way
+        for (int head = 0; head < config.head_count; head++)
+            config.heads[head].mounting = quaternion_from_orientation((orientation_t){head * 45.f, 2.f + head % 3});
+        ESP_ERROR_CHECK(multi_head_init(&multi_head, &bus, &config));
+
+        for (int i = 0; i < MULTI_HEAD_PLANS; i++)
+        {
+            int64_t begin = esp_timer_get_time();
+            orientation_t sun = get_sun_orientation(MULTI_HEAD_NOON + i * 60, SUN_PATH_LATITUDE, SUN_PATH_LONGITUDE);
+            ephemeris_time += esp_timer_get_time() - begin;
+
+            multi_head_set_sun(&multi_head, sun);
+        }
+
+        i2c_bus_reset_stats(&bus);
+        batched_time = esp_timer_get_time();
+        for (int frame = 0; frame < MULTI_HEAD_FRAMES; frame++)
+            multi_head_update(&multi_head, MULTI_HEAD_FRAME_TIME);
+        batched_time = esp_timer_get_time() - batched_time;
+        batched_transactions = bus.stats.transactions;
+        batched_bus_time = bus.stats.bus_time_ns;
+
+        for (int head = 0; head < config.head_count; head++)
+        {
+            const multi_head_head_config_t *head_config = &config.heads[head];
+            float angles[MOTORS_AXES] = {multi_head.heads[head].motors.azimuth, multi_head.heads[head].motors.inclination};
+
+            for (int axis = 0; axis < MOTORS_AXES; axis++)
+            {
+                i2c_sim_device_t *device = i2c_bus_sim_find_device(&sim, config.addresses[head_config->expander]);
+                float error = i2c_bus_sim_get_pca9685_pulse_width(device, head_config->channels[axis]) -
+                              servo_calibration_pulse_width(&head_config->calibrations[axis], angles[axis]);
+
+                output_error = fmaxf(output_error, fabsf(error));
+            }
+        }
+
+        i2c_bus_reset_stats(&bus);
+        channel_time = esp_timer_get_time();
+        for (int frame = 0; frame < MULTI_HEAD_FRAMES; frame++)
+        {
+            for (int head = 0; head < config.head_count; head++)
+            {
+                const multi_head_head_config_t *head_config = &config.heads[head];
+                float angles[MOTORS_AXES] = {multi_head.heads[head].motors.azimuth, multi_head.heads[head].motors.inclination};
+
+                for (int axis = 0; axis < MOTORS_AXES; axis++)
+                    pca9685_set_pulse_width(&multi_head.expanders[head_config->expander], head_config->channels[axis],
+                                            servo_calibration_pulse_width(&head_config->calibrations[axis], angles[axis]));
+            }
+        }
+        channel_time = esp_timer_get_time() - channel_time;
+        channel_transactions = bus.stats.transactions;
+        channel_bus_time = bus.stats.bus_time_ns;
+
+        float batched_frame = (batched_time + batched_bus_time / 1000) / (float)MULTI_HEAD_FRAMES;
+        float channel_frame = (channel_time + channel_bus_time / 1000) / (float)MULTI_HEAD_FRAMES;
+
+        ESP_LOGI("Benchmark", "Multi-head / %d heads on %d PCA9685: sun %.1f us shared, plan %.1f us per head, output error %.2f us",
+                 config.head_count, config.expander_count, (float)ephemeris_time / MULTI_HEAD_PLANS,
+                 (float)multi_head.stats.plan_time / (MULTI_HEAD_PLANS * config.head_count), output_error);
+        ESP_LOGI("Benchmark", "Multi-head / %d heads, one write per expander: %.1f transactions, wire %.1f us, CPU %.1f us per frame, up to %.0f Hz",
+                 config.head_count, (float)batched_transactions / MULTI_HEAD_FRAMES, batched_bus_time / 1e3f / MULTI_HEAD_FRAMES,
+                 (float)batched_time / MULTI_HEAD_FRAMES, 1e6f / batched_frame);
+        ESP_LOGI("Benchmark", "Multi-head / %d heads, one write per channel: %.1f transactions, wire %.1f us, CPU %.1f us per frame, up to %.0f Hz",
+                 config.head_count, (float)channel_transactions / MULTI_HEAD_FRAMES, channel_bus_time / 1e3f / MULTI_HEAD_FRAMES,
+                 (float)channel_time / MULTI_HEAD_FRAMES, 1e6f / channel_frame);
+    }
+
+    i2c_bus_detach(MULTI_HEAD_PORT);
+}
+
+// Cost of a trace event against the log line it replaces, the events drained
+// between batches so that none is dropped
+void benchmark_trace()
+{
+    static trace_record_t records[TRACE_BENCHMARK_BATCH];
+    int64_t trace_time = 0, log_time;
+    int mismatches = 0;
+
+    while (trace_read(records, TRACE_BENCHMARK_BATCH) > 0)
+        ;
+
+    for (int i = 0; i < TRACE_BENCHMARK_EVENTS; i += TRACE_BENCHMARK_BATCH)
+    {
+        int64_t begin = esp_timer_get_time();
+        for (int j = 0; j < TRACE_BENCHMARK_BATCH; j++)
+            TRACE(TRACE_MOTORS_MOVE, 90.f + j, -j * .5f, .001f * (i + j));
+        trace_time += esp_timer_get_time() - begin;
+
+        size_t count = trace_read(records, TRACE_BENCHMARK_BATCH);
+        for (size_t j = 0; j < count; j++)
+        {
+            float azimuth;
+            memcpy(&azimuth, &records[j].args[0], sizeof(azimuth));
+            if (records[j].format != TRACE_MOTORS_MOVE || records[j].argc != 3 || azimuth != 90.f + j)
+                mismatches++;
+        }
+        mismatches += TRACE_BENCHMARK_BATCH - count;
+    }
+
+    log_time = esp_timer_get_time();
+    for (int i = 0; i < TRACE_BENCHMARK_LOGS; i++)
+        ESP_LOGI("Motors", "Move to azimuth %.2f inclination %.2f in %.3f s", 90.f + i, -i * .5f, .001f * i);
+    log_time = esp_timer_get_time() - log_time;
+
+    ESP_LOGI("Benchmark", "Trace / %d events: %lld ns per event, %d lost or garbled, %u dropped since boot; log line %lld ns",
+             TRACE_BENCHMARK_EVENTS, (long long)(trace_time * 1000 / TRACE_BENCHMARK_EVENTS), mismatches, trace_dropped(),
+             (long long)(log_time * 1000 / TRACE_BENCHMARK_LOGS));
+}
+
+// The generated codecs on random messages of every event: system states
+// encoded by the former sprintf chain against the JSON and binary forms, then
+// decoding times of both forms
+void benchmark_protocol()
+{
+    static const char legacy_format[] =
+        "{\"event\":\"UPDATE_STATE\",\"payload\":{"
+        "\"platformRotation\":{\"w\":%.6f,\"x\":%.6f,\"y\":%.6f,\"z\":%.6f},"
+        "\"panelOrientation\":{\"azimuth\":%.6f,\"inclination\":%.6f},"
+        "\"motorsRotation\":{\"azimuth\":%.6f,\"inclination\":%.6f},"
+        "\"motorsEnergized\":{\"azimuth\":%.1f,\"inclination\":%.1f},"
+        "\"timestamp\":%lld}}";
+    static protocol_message_t message, decoded;
+    static char json[2048];
+    static uint8_t binary[512];
+    int64_t legacy_time = 0, json_time = 0, binary_time = 0, json_decode_time = 0, binary_decode_time = 0;
+    uint64_t legacy_bytes = 0, json_bytes = 0, binary_bytes = 0;
+    int states = 0;
+    uint32_t seed = 7;
+
+    for (int i = 0; i < PROTOCOL_BENCHMARK_MESSAGES; i++)
+    {
+        random_message(&seed, &message);
+
+        if (message.event == PROTOCOL_APP_EVENT_UPDATE_STATE)
+        {
+            const protocol_system_state_t *state = &message.system_state;
+            int64_t begin = esp_timer_get_time();
+            legacy_bytes += snprintf(json, sizeof(json), legacy_format, state->platform_rotation.w, state->platform_rotation.x,
+                                     state->platform_rotation.y, state->platform_rotation.z, state->panel_orientation.azimuth,
+                                     state->panel_orientation.inclination, state->motors_rotation.azimuth, state->motors_rotation.inclination,
+                                     state->motors_energized.azimuth, state->motors_energized.inclination, (long long)state->timestamp);
+            legacy_time += esp_timer_get_time() - begin;
+
+            // The same fields as the sprintf chain
+            protocol_system_state_t *plain = &decoded.system_state;
+            decoded.event = PROTOCOL_APP_EVENT_UPDATE_STATE;
+            *plain = (protocol_system_state_t){
+                .platform_rotation = state->platform_rotation,
+                .panel_orientation = state->panel_orientation,
+                .motors_rotation = state->motors_rotation,
+                .motors_energized = state->motors_energized,
+                .timestamp = state->timestamp,
+            };
+            begin = esp_timer_get_time();
+            json_bytes += protocol_encode_json(&decoded, json, sizeof(json));
+            json_time += esp_timer_get_time() - begin;
+            begin = esp_timer_get_time();
+            binary_bytes += protocol_encode_binary(&decoded, binary, sizeof(binary));
+            binary_time += esp_timer_get_time() - begin;
+            states++;
+        }
+
+        int length = protocol_encode_json(&message, json, sizeof(json));
+        int64_t begin = esp_timer_get_time();
+        protocol_decode_json(json, length, &decoded);
+        json_decode_time += esp_timer_get_time() - begin;
+
+        int size = protocol_encode_binary(&message, binary, sizeof(binary));
+        begin = esp_timer_get_time();
+        protocol_decode_binary(binary, size, &decoded);
+        binary_decode_time += esp_timer_get_time() - begin;
+    }
+
+    ESP_LOGI("Benchmark", "Protocol / %d states: sprintf %lld ns %.0f bytes, JSON %lld ns %.0f bytes, binary %lld ns %.0f bytes",
+             states, (long long)(legacy_time * 1000 / states), (float)legacy_bytes / states, (long long)(json_time * 1000 / states),
+             (float)json_bytes / states, (long long)(binary_time * 1000 / states), (float)binary_bytes / states);
+    ESP_LOGI("Benchmark", "Protocol / %d messages: decoding JSON %lld ns, binary %lld ns",
+             PROTOCOL_BENCHMARK_MESSAGES, (long long)(json_decode_time * 1000 / PROTOCOL_BENCHMARK_MESSAGES),
+             (long long)(binary_decode_time * 1000 / PROTOCOL_BENCHMARK_MESSAGES));
+}
+
+// Cost of a path planner decision over a year of sun paths, and of the sun
+// lookahead the motors task aims with
+void benchmark_path_planner()
+{
+    const motion_limits_t limits[MOTION_PROFILE_AXES] = {
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+    };
+    static path_planner_t planner;
+    path_planner_config_t config = path_planner_default_config(MOTION_PROFILE_S_CURVE, limits);
+    orientation_t motors = {0.f, 0.f};
+    int64_t plan_time = 0, lookahead_time = 0;
+    int steps = 0;
+
+    path_planner_init(&planner, &config);
+
+    for (time_t t = SUN_PATH_START; t < SUN_PATH_START + SUN_PATH_DAYS * 86400; t += SUN_PATH_STEP)
+    {
+        orientation_t sun = get_sun_orientation(t, SUN_PATH_LATITUDE, SUN_PATH_LONGITUDE);
+        axis_state_t current[MOTION_PROFILE_AXES] = {{.position = motors.azimuth}, {.position = motors.inclination}};
+        orientation_t desired;
+
+        // Daylight only
+        if (sun.inclination >= 90.f)
+            continue;
+
+        int64_t start = esp_timer_get_time();
+        if (path_planner_plan(&planner, sun, current, &desired))
+            motors = desired;
+        plan_time += esp_timer_get_time() - start;
+
+        start = esp_timer_get_time();
+        get_sun_lookahead(t, SUN_PATH_LATITUDE, SUN_PATH_LONGITUDE, config.dead_band, SUN_LOOKAHEAD_MAX);
+        lookahead_time += esp_timer_get_time() - start;
+        steps++;
+    }
+
+    ESP_LOGI("Benchmark", "Sun path / %d decisions, %u timing both solutions: path planner %lld ns, sun lookahead %lld ns",
+             steps, planner.evaluations, steps > 0 ? plan_time * 1000 / steps : 0LL, steps > 0 ? lookahead_time * 1000 / steps : 0LL);
+}
+
+// Two IMUs on the same trajectory, the second one failing halfway in
+// different ways. Reports how fast the fault is detected and what it costs
+// the blended rotation.
+void benchmark_redundant_imu(const benchmark_trajectory_t *trajectory)
+{
+    const imu_fault_t faults[] = {IMU_FAULT_NONE, IMU_FAULT_SILENT, IMU_FAULT_STUCK, IMU_FAULT_TILTED};
+    const char *fault_names[] = {"no fault", "silent", "stuck", "tilted 8 deg"};
+    ahrs_config_t ahrs_config = ahrs_default_config(AHRS_MAHONY);
+    redundant_imu_config_t config = redundant_imu_default_config();
+
+    for (int f = 0; f < sizeof(faults) / sizeof(faults[0]); f++)
+    {
+        static redundant_imu_t imu;
+        redundant_imu_init(&imu, &config, &ahrs_config, 2);
+        trajectory->rewind(trajectory->context);
+
+        benchmark_sample_t sample;
+        ahrs_sample_t samples[2];
+        bool valid[2] = {true, true};
+        uint32_t seed = 54321;
+        int64_t timestamp = 0, elapsed = 0;
+        int updates = 0, measured = 0;
+        float time = 0.f, error_sum = 0.f, error_max = 0.f, detected = -1.f;
+        // The tilt error of a mounting that moved on the platform
+        quaternion_t tilt = {cosf(4.f * rad), sinf(4.f * rad), 0.f, 0.f};
+
+        while (trajectory->next(trajectory->context, &sample))
+        {
+            time += sample.dt;
+            timestamp += (int64_t)(sample.dt * 1e6f);
+            samples[0] = (ahrs_sample_t){sample.accel, sample.gyro, sample.magnet, timestamp};
+
+            bool faulty = time >= REDUNDANT_IMU_FAULT_TIME;
+            valid[1] = !(faulty && faults[f] == IMU_FAULT_SILENT);
+
+            if (!(faulty && faults[f] == IMU_FAULT_STUCK))
+            {
+                // Independent noise on the second IMU
+                samples[1] = (ahrs_sample_t){
+                    .accel = {sample.accel.x + noise(&seed, .02f), sample.accel.y + noise(&seed, .02f), sample.accel.z + noise(&seed, .02f)},
+                    .gyro = {sample.gyro.x + noise(&seed, .005f), sample.gyro.y + noise(&seed, .005f), sample.gyro.z + noise(&seed, .005f)},
+                    .magnet = {sample.magnet.x + noise(&seed, .05f), sample.magnet.y + noise(&seed, .05f), sample.magnet.z + noise(&seed, .05f)},
+                };
+
+                if (faulty && faults[f] == IMU_FAULT_TILTED)
+                {
+                    samples[1].accel = quaternion_rotate(tilt, samples[1].accel);
+                    samples[1].magnet = quaternion_rotate(tilt, samples[1].magnet);
+                }
+            }
+            samples[1].timestamp = timestamp;
+
+            int64_t start = esp_timer_get_time();
+            redundant_imu_update(&imu, samples, valid);
+            elapsed += esp_timer_get_time() - start;
+            updates++;
+
+            if (detected < 0.f && imu.channels[1].state != IMU_CHANNEL_HEALTHY)
+                detected = time - REDUNDANT_IMU_FAULT_TIME;
+
+            if (time < BENCHMARK_SETTLE_TIME)
+                continue;
+
+            float error = orientation_error(imu.rotation, sample.truth);
+            error_sum += error;
+            error_max = fmaxf(error_max, error);
+            measured++;
+        }
+
+        ESP_LOGI("Benchmark", "%s / redundant IMU, %s: %lld ns/update, error mean %.3f deg, max %.3f deg, "
+                              "second IMU %s after %.2f s, %u drops",
+                 trajectory->name, fault_names[f],
+                 updates > 0 ? elapsed * 1000 / updates : 0LL,
+                 measured > 0 ? error_sum / measured : 0.f, error_max,
+                 imu_channel_state_name(imu.channels[1].state), detected, (unsigned)imu.dropped);
+    }
+}
+
+// Several Madgwick filters side by side on the same samples, one per gain,
+// and the cost of the volatile global kernel they replaced
+void benchmark_madgwick_gains(const benchmark_trajectory_t *trajectory)
+{
+    static benchmark_sample_t samples[BENCHMARK_CHUNK];
+    const float gains[] = {.05f, .2f, .8f};
+    const int filter_count = sizeof(gains) / sizeof(gains[0]);
+    static quaternion_t estimates[BENCHMARK_CHUNK][sizeof(gains) / sizeof(gains[0])];
+    static quaternion_t legacy_estimates[BENCHMARK_CHUNK];
+    MadgwickFilter filters[sizeof(gains) / sizeof(gains[0])];
+    float error_sum[sizeof(gains) / sizeof(gains[0])] = {0};
+    float legacy_error_sum = 0.f;
+    int64_t elapsed = 0, legacy_elapsed = 0;
+    int updates = 0, legacy_updates = 0, measured = 0;
+    float time = 0.f;
+    bool has_more = true;
+
+    for (int i = 0; i < filter_count; i++)
+        MadgwickFilterInit(&filters[i], gains[i]);
+
+    // The legacy kernel runs with the largest gain, its default
+    legacy_beta = gains[filter_count - 1];
+    legacy_q0 = 1.f;
+    legacy_q1 = legacy_q2 = legacy_q3 = 0.f;
+
+    trajectory->rewind(trajectory->context);
+    while (has_more)
+    {
+        int count = 0;
+        while (count < BENCHMARK_CHUNK && (has_more = trajectory->next(trajectory->context, &samples[count])))
+            count++;
+
+        if (count == 0)
+            break;
+
+        // It only knows a fixed rate, the one of the trajectory
+        legacy_sample_freq = 1.f / samples[0].dt;
+
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < count; i++)
+        {
+            const benchmark_sample_t *sample = &samples[i];
+            legacy_madgwick_update(sample->gyro.x, sample->gyro.y, sample->gyro.z,
+                                   sample->accel.x, sample->accel.y, sample->accel.z,
+                                   sample->magnet.x, sample->magnet.y, sample->magnet.z);
+            legacy_estimates[i] = (quaternion_t){legacy_q0, legacy_q1, legacy_q2, legacy_q3};
+        }
+        legacy_elapsed += esp_timer_get_time() - start;
+        legacy_updates += count;
+
+        start = esp_timer_get_time();
+        for (int i = 0; i < count; i++)
+        {
+            const benchmark_sample_t *sample = &samples[i];
+
+            for (int f = 0; f < filter_count; f++)
+            {
+                MadgwickFilterUpdate(&filters[f],
+                                     sample->gyro.x, sample->gyro.y, sample->gyro.z,
+                                     sample->accel.x, sample->accel.y, sample->accel.z,
+                                     sample->magnet.x, sample->magnet.y, sample->magnet.z,
+                                     sample->dt);
+                estimates[i][f] = (quaternion_t){filters[f].q0, filters[f].q1, filters[f].q2, filters[f].q3};
+            }
+        }
+        elapsed += esp_timer_get_time() - start;
+        updates += count * filter_count;
+
+        for (int i = 0; i < count; i++)
+        {
+            time += samples[i].dt;
+            if (time < BENCHMARK_SETTLE_TIME)
+                continue;
+
+            for (int f = 0; f < filter_count; f++)
+                error_sum[f] += orientation_error(estimates[i][f], samples[i].truth);
+            legacy_error_sum += orientation_error(legacy_estimates[i], samples[i].truth);
+            measured++;
+        }
+    }
+
+    for (int i = 0; i < filter_count; i++)
+    {
+        ESP_LOGI("Benchmark", "%s / MadgwickFilter beta %.2f: error mean %.3f deg",
+                 trajectory->name, gains[i], measured > 0 ? error_sum[i] / measured : 0.f);
+    }
+    ESP_LOGI("Benchmark", "%s / MadgwickFilter: %lld ns/update",
+             trajectory->name, updates > 0 ? elapsed * 1000 / updates : 0LL);
+    ESP_LOGI("Benchmark", "%s / legacy volatile Madgwick beta %.2f: %lld ns/update, error mean %.3f deg",
+             trajectory->name, legacy_beta, legacy_updates > 0 ? legacy_elapsed * 1000 / legacy_updates : 0LL,
+             measured > 0 ? legacy_error_sum / measured : 0.f);
+}
+
+// Cost of the original fixed-gain filter, called directly
+static void benchmark_mahony_baseline(const benchmark_trajectory_t *trajectory)
+{
+    static benchmark_sample_t samples[BENCHMARK_CHUNK];
+    quaternion_t rotation = QUATERNION_IDENTITY;
+    vector3_t error = {0.f, 0.f, 0.f};
+    int64_t elapsed = 0;
+    int updates = 0;
+    bool has_more = true;
+
+    trajectory->rewind(trajectory->context);
+    while (has_more)
+    {
+        int count = 0;
+        while (count < BENCHMARK_CHUNK && (has_more = trajectory->next(trajectory->context, &samples[count])))
+            count++;
+
+        int64_t start = esp_timer_get_time();
+        for (int i = 0; i < count; i++)
+            quaternion_mahony_update(&rotation, &error, samples[i].accel, samples[i].gyro, samples[i].magnet, samples[i].dt);
+        elapsed += esp_timer_get_time() - start;
+        updates += count;
+    }
+
+    ESP_LOGI("Benchmark", "%s / quaternion_mahony_update: %lld ns/update",
+             trajectory->name, updates > 0 ? elapsed * 1000 / updates : 0LL);
+}
+
+benchmark_trajectory_t benchmark_recorded_trajectory(const char *name, benchmark_recording_t *recording)
+{
+    return (benchmark_trajectory_t){
+        .name = name,
+        .context = recording,
+        .rewind = recorded_rewind,
+        .next = recorded_next,
+    };
+}
+
+static void synthetic_rewind(void *context)
+{
+    synthetic_trajectory_t *trajectory = context;
+
+    trajectory->time = 0.f;
+    trajectory->seed = 12345;
+    trajectory->truth = synthetic_truth(0.f);
+}
+
+static bool synthetic_next(void *context, benchmark_sample_t *sample)
+{
+    synthetic_trajectory_t *trajectory = context;
+    float dt = 1.f / trajectory->rate;
+
+    if (trajectory->time >= trajectory->duration)
+        return false;
+
+    trajectory->time += dt;
+    quaternion_t previous = trajectory->truth;
+    quaternion_t current = synthetic_truth(trajectory->time);
+    trajectory->truth = current;
+
+    // Body rate turning the previous rotation into the current one
+    quaternion_t delta = quaternion_multiply(quaternion_inverse(previous), current);
+    float sign = delta.w < 0.f ? -1.f : 1.f;
+    vector3_t gyro = {2.f * sign * delta.x / dt, 2.f * sign * delta.y / dt, 2.f * sign * delta.z / dt};
+
+    quaternion_t inverse = quaternion_inverse(current);
+    vector3_t accel = quaternion_rotate(inverse, VECTOR3_UP);
+    vector3_t magnet = quaternion_rotate(inverse, vector3_normalize((vector3_t){.95f, 0.f, -.3f}));
+    if (trajectory->disturbance_start <= trajectory->time && trajectory->time < trajectory->disturbance_end)
+    {
+        magnet.x += trajectory->magnet_disturbance.x;
+        magnet.y += trajectory->magnet_disturbance.y;
+        magnet.z += trajectory->magnet_disturbance.z;
+    }
+    uint32_t *seed = &trajectory->seed;
+
+    sample->accel = (vector3_t){accel.x + noise(seed, .02f), accel.y + noise(seed, .02f), accel.z + noise(seed, .02f)};
+    sample->gyro = (vector3_t){
+        gyro.x + trajectory->gyro_bias.x + noise(seed, .005f),
+        gyro.y + trajectory->gyro_bias.y + noise(seed, .005f),
+        gyro.z + trajectory->gyro_bias.z + noise(seed, .005f),
+    };
+    sample->magnet = (vector3_t){magnet.x + noise(seed, .05f), magnet.y + noise(seed, .05f), magnet.z + noise(seed, .05f)};
+    sample->dt = dt;
+    sample->truth = current;
+    return true;
+}
+
+// A platform slowly turning while swaying, like a tracker on a moving base
+static quaternion_t synthetic_truth(float t)
+{
+    float yaw = 30.f * rad * sinf(.05f * t) + 40.f * rad;
+    float pitch = 8.f * rad * sinf(.4f * t);
+    float roll = 5.f * rad * sinf(.27f * t + 1.f);
+
+    quaternion_t qz = {cosf(yaw * .5f), 0.f, 0.f, sinf(yaw * .5f)};
+    quaternion_t qy = {cosf(pitch * .5f), 0.f, sinf(pitch * .5f), 0.f};
+    quaternion_t qx = {cosf(roll * .5f), sinf(roll * .5f), 0.f, 0.f};
+
+    return quaternion_multiply(quaternion_multiply(qz, qy), qx);
+}
+
+static void recorded_rewind(void *context)
+{
+    ((benchmark_recording_t *)context)->position = 0;
+}
+
+static bool recorded_next(void *context, benchmark_sample_t *sample)
+{
+    benchmark_recording_t *recording = context;
+
+    if (recording->position >= recording->count)
+        return false;
+
+    *sample = recording->samples[recording->position++];
+    return true;
+}
+
+// The compensation as it was done before the cached matrix
+static orientation_t compensate_quaternion_chain(quaternion_t platform_rotation, orientation_t orientation, float fallback_azimuth)
+{
+    vector3_t world_direction = quaternion_rotate(
+        quaternion_from_orientation(orientation),
+        VECTOR3_UP);
+    vector3_t local_direction = quaternion_rotate(
+        quaternion_inverse(platform_rotation),
+        world_direction);
+
+    local_direction = vector3_normalize(local_direction);
+
+    if (fabs(local_direction.x) < .1f && fabs(local_direction.y) < .1f)
+        return (orientation_t){.azimuth = fallback_azimuth, .inclination = 0.f};
+
+    return (orientation_t){
+        .azimuth = -atan2(local_direction.y, local_direction.x) / rad + (local_direction.y >= 0.f ? 360.f : 0.f),
+        .inclination = acos(local_direction.z) / rad,
+    };
+}
+
+// MadgwickAHRSupdate as it was before the reentrant filter, on volatile
+// globals and a fixed sample rate. The samples always carry a magnetometer
+// reading, so its IMU-only fallback is left out.
+static void legacy_madgwick_update(float gx, float gy, float gz, float ax, float ay, float az, float mx, float my, float mz)
+{
+    float recipNorm;
+    float s0, s1, s2, s3;
+    float qDot1, qDot2, qDot3, qDot4;
+    float hx, hy;
+    float _2q0mx, _2q0my, _2q0mz, _2q1mx, _2bx, _2bz, _4bx, _4bz, _2q0, _2q1, _2q2, _2q3, _2q0q2, _2q2q3, q0q0, q0q1, q0q2, q0q3, q1q1, q1q2, q1q3, q2q2, q2q3, q3q3;
+
+    // Rate of change of quaternion from gyroscope
+    qDot1 = 0.5f * (-legacy_q1 * gx - legacy_q2 * gy - legacy_q3 * gz);
+    qDot2 = 0.5f * (legacy_q0 * gx + legacy_q2 * gz - legacy_q3 * gy);
+    qDot3 = 0.5f * (legacy_q0 * gy - legacy_q1 * gz + legacy_q3 * gx);
+    qDot4 = 0.5f * (legacy_q0 * gz + legacy_q1 * gy - legacy_q2 * gx);
+
+    // Compute feedback only if accelerometer measurement valid (avoids NaN in accelerometer normalisation)
+    if (!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f)))
+    {
+
+        // Normalise accelerometer measurement
+        recipNorm = legacy_inv_sqrt(ax * ax + ay * ay + az * az);
+        ax *= recipNorm;
+        ay *= recipNorm;
+        az *= recipNorm;
+
+        // Normalise magnetometer measurement
+        recipNorm = legacy_inv_sqrt(mx * mx + my * my + mz * mz);
+        mx *= recipNorm;
+        my *= recipNorm;
+        mz *= recipNorm;
+
+        // Auxiliary variables to avoid repeated arithmetic
+        _2q0mx = 2.0f * legacy_q0 * mx;
+        _2q0my = 2.0f * legacy_q0 * my;
+        _2q0mz = 2.0f * legacy_q0 * mz;
+        _2q1mx = 2.0f * legacy_q1 * mx;
+        _2q0 = 2.0f * legacy_q0;
+        _2q1 = 2.0f * legacy_q1;
+        _2q2 = 2.0f * legacy_q2;
+        _2q3 = 2.0f * legacy_q3;
+        _2q0q2 = 2.0f * legacy_q0 * legacy_q2;
+        _2q2q3 = 2.0f * legacy_q2 * legacy_q3;
+        q0q0 = legacy_q0 * legacy_q0;
+        q0q1 = legacy_q0 * legacy_q1;
+        q0q2 = legacy_q0 * legacy_q2;
+        q0q3 = legacy_q0 * legacy_q3;
+        q1q1 = legacy_q1 * legacy_q1;
+        q1q2 = legacy_q1 * legacy_q2;
+        q1q3 = legacy_q1 * legacy_q3;
+        q2q2 = legacy_q2 * legacy_q2;
+        q2q3 = legacy_q2 * legacy_q3;
+        q3q3 = legacy_q3 * legacy_q3;
+
+        // Reference direction of Earth's magnetic field
+        hx = mx * q0q0 - _2q0my * legacy_q3 + _2q0mz * legacy_q2 + mx * q1q1 + _2q1 * my * legacy_q2 + _2q1 * mz * legacy_q3 - mx * q2q2 - mx * q3q3;
+        hy = _2q0mx * legacy_q3 + my * q0q0 - _2q0mz * legacy_q1 + _2q1mx * legacy_q2 - my * q1q1 + my * q2q2 + _2q2 * mz * legacy_q3 - my * q3q3;
+        _2bx = sqrt(hx * hx + hy * hy);
+        _2bz = -_2q0mx * legacy_q2 + _2q0my * legacy_q1 + mz * q0q0 + _2q1mx * legacy_q3 - mz * q1q1 + _2q2 * my * legacy_q3 - mz * q2q2 + mz * q3q3;
+        _4bx = 2.0f * _2bx;
+        _4bz = 2.0f * _2bz;
+
+        // Gradient decent algorithm corrective step
+        s0 = -_2q2 * (2.0f * q1q3 - _2q0q2 - ax) + _2q1 * (2.0f * q0q1 + _2q2q3 - ay) - _2bz * legacy_q2 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (-_2bx * legacy_q3 + _2bz * legacy_q1) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + _2bx * legacy_q2 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        s1 = _2q3 * (2.0f * q1q3 - _2q0q2 - ax) + _2q0 * (2.0f * q0q1 + _2q2q3 - ay) - 4.0f * legacy_q1 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - az) + _2bz * legacy_q3 * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (_2bx * legacy_q2 + _2bz * legacy_q0) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + (_2bx * legacy_q3 - _4bz * legacy_q1) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        s2 = -_2q0 * (2.0f * q1q3 - _2q0q2 - ax) + _2q3 * (2.0f * q0q1 + _2q2q3 - ay) - 4.0f * legacy_q2 * (1 - 2.0f * q1q1 - 2.0f * q2q2 - az) + (-_4bx * legacy_q2 - _2bz * legacy_q0) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (_2bx * legacy_q1 + _2bz * legacy_q3) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + (_2bx * legacy_q0 - _4bz * legacy_q2) * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        s3 = _2q1 * (2.0f * q1q3 - _2q0q2 - ax) + _2q2 * (2.0f * q0q1 + _2q2q3 - ay) + (-_4bx * legacy_q3 + _2bz * legacy_q1) * (_2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx) + (-_2bx * legacy_q0 + _2bz * legacy_q2) * (_2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my) + _2bx * legacy_q1 * (_2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz);
+        recipNorm = legacy_inv_sqrt(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3); // normalise step magnitude
+        s0 *= recipNorm;
+        s1 *= recipNorm;
+        s2 *= recipNorm;
+        s3 *= recipNorm;
+
+        // Apply feedback step
+        qDot1 -= legacy_beta * s0;
+        qDot2 -= legacy_beta * s1;
+        qDot3 -= legacy_beta * s2;
+        qDot4 -= legacy_beta * s3;
+    }
+
+    // Integrate rate of change of quaternion to yield quaternion
+    legacy_q0 += qDot1 * (1.0f / legacy_sample_freq);
+    legacy_q1 += qDot2 * (1.0f / legacy_sample_freq);
+    legacy_q2 += qDot3 * (1.0f / legacy_sample_freq);
+    legacy_q3 += qDot4 * (1.0f / legacy_sample_freq);
+
+    // Normalise quaternion
+    recipNorm = legacy_inv_sqrt(legacy_q0 * legacy_q0 + legacy_q1 * legacy_q1 + legacy_q2 * legacy_q2 + legacy_q3 * legacy_q3);
+    legacy_q0 *= recipNorm;
+    legacy_q1 *= recipNorm;
+    legacy_q2 *= recipNorm;
+    legacy_q3 *= recipNorm;
+}
+
+// long is 32 bits on the ESP32, int32_t keeps the bit trick valid on a host
+static float legacy_inv_sqrt(float x)
+{
+    float halfx = 0.5f * x;
+    float y = x;
+    int32_t i = *(int32_t *)&y;
+    i = 0x5f3759df - (i >> 1);
+    y = *(float *)&i;
+    y = y * (1.5f - (halfx * y * y));
+    return y;
+}
+
+// Deterministic gaussian noise, so every engine sees the same samples
+static float noise(uint32_t *seed, float sigma)
+{
+    float sum = 0.f;
+
+    // Sum of uniforms, close enough to a normal distribution
+    for (int i = 0; i < 4; i++)
+    {
+        *seed = *seed * 1664525u + 1013904223u;
+        sum += (*seed >> 8) * (1.f / 16777216.f);
+    }
+
+    return (sum - 2.f) * sqrtf(3.f) * sigma;
+}
+
+static float orientation_error(quaternion_t a, quaternion_t b)
+{
+    float dot = fabsf(a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z);
+    return 2.f * acosf(fminf(dot, 1.f)) / rad;
+}
+
+// A servo with a 30 us dead zone offset and a bowed response, as measured on
+// cheap analog servos
+static float servo_pulse_width(float angle)
+{
+    float t = (angle + 90.f) / 180.f;
+
+    return 430.f + 2000.f * t - 90.f * sinf(PI * t);
+}
+
+static void count_motion_queue_output(const float angles[MOTORS_AXES], uint32_t energize, void *context)
+{
+}
+
+// The motors task loop the executor replaces, timed the same way
+static void time_idle_priority_task(void *params)
+{
+    motion_queue_stats_t *stats = params;
+    TickType_t last_wake = xTaskGetTickCount();
+    int64_t previous = 0;
+
+    for (;;)
+    {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(MOTION_QUEUE_PERIOD / 1000));
+        int64_t now = esp_timer_get_time();
+
+        if (stats->ticks > 0)
+        {
+            int64_t jitter = llabs(now - previous - MOTION_QUEUE_PERIOD);
+            stats->jitter_sum += jitter;
+            if (jitter > stats->jitter_max)
+                stats->jitter_max = jitter;
+        }
+        stats->ticks++;
+        previous = now;
+    }
+}
+
+// Every optional field and array length, with values over the full range of their type
+static void random_message(uint32_t *seed, protocol_message_t *message)
+{
+    memset(message, 0, sizeof(*message));
+    message->event = random_below(seed, PROTOCOL_APP_EVENT_COUNT);
+
+    switch (message->event)
+    {
+    case PROTOCOL_APP_EVENT_UPDATE_CONFIG:
+    {
+        protocol_control_config_t *config = &message->control_config;
+        protocol_servo_calibration_t *calibration = &config->servo_calibration;
+
+        config->control_mode = random_below(seed, PROTOCOL_CONTROL_MODE_COUNT);
+        config->manual_orientation = (orientation_t){noise(seed, 180.f), noise(seed, 45.f)};
+        config->has_ahrs_engine = random_below(seed, 2);
+        config->ahrs_engine = random_below(seed, PROTOCOL_AHRS_ENGINE_COUNT);
+        config->has_servo_calibration = random_below(seed, 2);
+        calibration->has_azimuth = random_below(seed, 2);
+        calibration->azimuth_count = random_below(seed, SERVO_CALIBRATION_MAX_POINTS + 1);
+        calibration->has_inclination = random_below(seed, 2);
+        calibration->inclination_count = random_below(seed, SERVO_CALIBRATION_MAX_POINTS + 1);
+        for (int i = 0; i < SERVO_CALIBRATION_MAX_POINTS; i++)
+        {
+            calibration->azimuth[i] = (servo_calibration_point_t){i * 12.f + noise(seed, 1.f), 500.f + i * 130.f + noise(seed, 5.f)};
+            calibration->inclination[i] = (servo_calibration_point_t){i * 6.f + noise(seed, 1.f), 500.f + i * 130.f + noise(seed, 5.f)};
+        }
+        config->has_tracking_threshold = random_below(seed, 2);
+        config->tracking_threshold = fabsf(noise(seed, 2.f));
+        break;
+    }
+    case PROTOCOL_APP_EVENT_UPDATE_STATE:
+    {
+        protocol_system_state_t *state = &message->system_state;
+
+        state->platform_rotation = quaternion_normalize((quaternion_t){1.f, noise(seed, .1f), noise(seed, .1f), noise(seed, .1f)});
+        state->panel_orientation = (orientation_t){noise(seed, 180.f), noise(seed, 45.f)};
+        state->motors_rotation = (orientation_t){noise(seed, 90.f), noise(seed, 45.f)};
+        state->motors_energized = (orientation_t){fabsf(noise(seed, 1e4f)), fabsf(noise(seed, 1e4f))};
+        state->timestamp = 1700000000000LL + random_below(seed, UINT32_MAX);
+        state->has_motors_measured = random_below(seed, 2);
+        state->motors_measured = (orientation_t){noise(seed, 90.f), noise(seed, 45.f)};
+        state->has_tracking_policy = random_below(seed, 2);
+        state->tracking_policy = (protocol_tracking_policy_t){
+            .moves = random_below(seed, UINT32_MAX),
+            .skipped = random_below(seed, 100000),
+            .motor_on_time = fabsf(noise(seed, 1e3f)),
+            .motor_energy = fabsf(noise(seed, 10.f)),
+            .yield = fabsf(noise(seed, 1e3f)),
+        };
+        state->has_telemetry = random_below(seed, 2);
+        state->telemetry = (protocol_telemetry_rate_t){
+            .rate = fabsf(noise(seed, 2.f)),
+            .sent = random_below(seed, UINT32_MAX),
+            .failed = random_below(seed, 1000),
+            .deferred = random_below(seed, 1000),
+            .backoffs = random_below(seed, 100),
+        };
+        state->has_keyframe = random_below(seed, 2);
+        state->keyframe = random_below(seed, UINT32_MAX);
+        break;
+    }
+    case PROTOCOL_APP_EVENT_UPDATE_VIEWERS:
+        message->viewers.viewers = random_below(seed, 100);
+        break;
+    case PROTOCOL_APP_EVENT_UPDATE_DELTA:
+        message->system_delta.base = random_below(seed, UINT32_MAX);
+        message->system_delta.timestamp = 1700000000000LL + random_below(seed, UINT32_MAX);
+        message->system_delta.changes_count = random_below(seed, TELEMETRY_DELTA_FIELDS + 1);
+        for (int i = 0; i < message->system_delta.changes_count; i++)
+            message->system_delta.changes[i] = (protocol_delta_change_t){
+                .index = i,
+                .steps = (int32_t)(random_below(seed, UINT32_MAX) - INT32_MAX),
+            };
+        break;
+    case PROTOCOL_APP_EVENT_ACK_KEYFRAME:
+        message->keyframe_ack.keyframe = random_below(seed, UINT32_MAX);
+        break;
+    default:
+        break;
+    }
+}
+
+static uint32_t random_below(uint32_t *seed, uint32_t count)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return ((uint64_t)*seed * count) >> 32;
+}
@@ -0,0 +1,51 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <stdbool.h>
+#include "types.h"
+
+typedef struct benchmark_sample_t
+{
+    vector3_t accel;
+    vector3_t gyro;
+    vector3_t magnet;
+    float dt;
+    // Reference rotation after the sample, from the sensor frame to the world frame
+    quaternion_t truth;
+} benchmark_sample_t;
+
+// A source of sensor samples: synthetic or recorded
+typedef struct benchmark_trajectory_t
+{
+    const char *name;
+    void *context;
+    void (*rewind)(void *context);
+    bool (*next)(void *context, benchmark_sample_t *sample);
+} benchmark_trajectory_t;
+
+typedef struct benchmark_recording_t
+{
+    const benchmark_sample_t *samples;
+    int count;
+    int position;
+} benchmark_recording_t;
+
+benchmark_trajectory_t benchmark_recorded_trajectory(const char *name, benchmark_recording_t *recording);
+
+void benchmark_ahrs(const benchmark_trajectory_t *trajectory);
+void benchmark_madgwick_gains(const benchmark_trajectory_t *trajectory);
+void benchmark_compensation();
+void benchmark_motion_profile();
+void benchmark_motion_queue();
+void benchmark_path_planner();
+void benchmark_backtracking();
+void benchmark_multi_head();
+void benchmark_trace();
+void benchmark_protocol();
+void benchmark_servo_calibration();
+void benchmark_actuator();
+void benchmark_servo_feedback();
+void benchmark_redundant_imu(const benchmark_trajectory_t *trajectory);
+void benchmark_run();
+
+#endif // __BENCHMARK_H__
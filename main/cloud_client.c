@@ -1,6 +1,7 @@
 #include <esp_log.h>
 #include <esp_system.h>
 #include "cloud_client.h"
+#include "trace.h"
 
 const esp_websocket_client_config_t config = {
     // .uri = "wss://hcmut-es2021-solar-tracker.herokuapp.com/ws",
@@ -25,24 +26,11 @@ static void cloud_client_data_handler_internal(void *event_handler_arg, esp_even
 {
     esp_websocket_event_data_t *websocket_event_data = (esp_websocket_event_data_t *)event_data;
 
-    switch (websocket_event_data->op_code)
-    {
-    case 1:
-        ESP_LOGI(
-            "Cloud Client", "Server response:\n\tOpcode: %d\n\tText data: %.*s",
-            websocket_event_data->op_code,
-            websocket_event_data->data_len,
-            websocket_event_data->data_ptr);
-        external_data_handler(websocket_event_data->data_ptr, websocket_event_data->data_len);
-        break;
-
-    case 10:
-        ESP_LOGI("Cloud Client", "Server response:\n\tOpcode: %d\n\tPong frame", websocket_event_data->op_code);
-        break;
+    // Traced rather than logged, every message would block on the UART
+    TRACE(TRACE_CLOUD_MESSAGE, websocket_event_data->op_code, websocket_event_data->data_len);
 
-    default:
-        ESP_LOGI("Cloud Client", "Server response:\n\tOpcode: %d", websocket_event_data->op_code);
-    }
+    if (websocket_event_data->op_code == 1)
+        external_data_handler(websocket_event_data->data_ptr, websocket_event_data->data_len);
 }
 
 void cloud_client_init(cloud_client_data_handler_t data_handler)
@@ -63,9 +51,9 @@ void cloud_client_init(cloud_client_data_handler_t data_handler)
     }
 }
 
-void cloud_client_send(const char *data, int length, TickType_t timeout)
+int cloud_client_send(const char *data, int length, TickType_t timeout)
 {
-    if (!connected) return;
+    if (!connected) return -1;
 
     // ESP_LOGI("Cloud Client", "Sending:\n\t%.*s", length, data);
 
@@ -79,4 +67,6 @@ void cloud_client_send(const char *data, int length, TickType_t timeout)
     {
         ESP_LOGE("Cloud Client", "Error sending text data!");
     }
+
+    return length;
 }
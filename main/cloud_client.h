@@ -7,6 +7,7 @@
 typedef void (*cloud_client_data_handler_t)(const char *data, int length);
 
 void cloud_client_init(cloud_client_data_handler_t data_handler);
-void cloud_client_send(const char *data, int length, TickType_t timeout);
+// Returns the length sent, -1 when disconnected or the send timed out
+int cloud_client_send(const char *data, int length, TickType_t timeout);
 
 #endif // CLOUD_CLIENT_H
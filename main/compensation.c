@@ -0,0 +1,97 @@
+#include <math.h>
+#include "compensation.h"
+
+#define PI 3.14159265358979323846
+#define rad (PI / 180.f)
+
+void compensation_init(compensation_t *compensation, float epsilon)
+{
+    *compensation = (compensation_t){
+        .epsilon = epsilon,
+    };
+}
+
+bool compensation_set_platform_rotation(compensation_t *compensation, quaternion_t rotation)
+{
+    quaternion_t cached = compensation->platform_rotation;
+    float epsilon = compensation->epsilon;
+
+    if (compensation->valid &&
+        fabsf(rotation.w - cached.w) <= epsilon &&
+        fabsf(rotation.x - cached.x) <= epsilon &&
+        fabsf(rotation.y - cached.y) <= epsilon &&
+        fabsf(rotation.z - cached.z) <= epsilon)
+    {
+        return false;
+    }
+
+    float w = rotation.w, x = rotation.x, y = rotation.y, z = rotation.z;
+    float (*m)[3] = compensation->world_to_platform;
+
+    // Transpose of the rotation matrix of the quaternion
+    m[0][0] = 1.f - 2.f * (y * y + z * z);
+    m[0][1] = 2.f * (x * y + w * z);
+    m[0][2] = 2.f * (x * z - w * y);
+    m[1][0] = 2.f * (x * y - w * z);
+    m[1][1] = 1.f - 2.f * (x * x + z * z);
+    m[1][2] = 2.f * (y * z + w * x);
+    m[2][0] = 2.f * (x * z + w * y);
+    m[2][1] = 2.f * (y * z - w * x);
+    m[2][2] = 1.f - 2.f * (x * x + y * y);
+
+    compensation->platform_rotation = rotation;
+    compensation->valid = true;
+    compensation->rebuilds++;
+    return true;
+}
+
+// Same as rotating VECTOR3_UP by quaternion_from_orientation(orientation),
+// which is a rotation of -azimuth around z after one of inclination around y
+vector3_t compensation_direction(orientation_t orientation)
+{
+    float azimuth = orientation.azimuth * rad;
+    float inclination = orientation.inclination * rad;
+    float sin_inclination = sinf(inclination);
+
+    return (vector3_t){
+        cosf(azimuth) * sin_inclination,
+        -sinf(azimuth) * sin_inclination,
+        cosf(inclination),
+    };
+}
+
+vector3_t compensation_to_platform(const compensation_t *compensation, vector3_t v)
+{
+    const float (*m)[3] = compensation->world_to_platform;
+
+    return (vector3_t){
+        m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+        m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+        m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z,
+    };
+}
+
+bool compensation_orientation(vector3_t direction, orientation_t *orientation)
+{
+    if (fabsf(direction.x) < .1f && fabsf(direction.y) < .1f)
+        return false;
+
+    *orientation = (orientation_t){
+        .azimuth = -atan2f(direction.y, direction.x) / rad + (direction.y >= 0.f ? 360.f : 0.f),
+        .inclination = acosf(fminf(fmaxf(direction.z, -1.f), 1.f)) / rad,
+    };
+    return true;
+}
+
+orientation_t compensation_apply(const compensation_t *compensation, orientation_t orientation, float fallback_azimuth)
+{
+    orientation_t compensated = {
+        .azimuth = fallback_azimuth,
+        .inclination = 0.f,
+    };
+
+    compensation_orientation(
+        compensation_to_platform(compensation, compensation_direction(orientation)),
+        &compensated);
+    return compensated;
+}
@@ -0,0 +1,34 @@
+#ifndef __COMPENSATION_H__
+#define __COMPENSATION_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+typedef struct compensation_t
+{
+    // Largest quaternion component change that keeps the cached matrix
+    float epsilon;
+    bool valid;
+    quaternion_t platform_rotation;
+    // Inverse platform rotation: from the world frame to the platform frame
+    float world_to_platform[3][3];
+    uint32_t rebuilds;
+} compensation_t;
+
+void compensation_init(compensation_t *compensation, float epsilon);
+// Rebuilds the matrix if the rotation moved beyond epsilon. Returns true when rebuilt.
+bool compensation_set_platform_rotation(compensation_t *compensation, quaternion_t rotation);
+
+// Unit vector pointing along an orientation, in the world frame
+vector3_t compensation_direction(orientation_t orientation);
+vector3_t compensation_to_platform(const compensation_t *compensation, vector3_t direction);
+// Orientation of a unit direction in the platform frame. Returns false when
+// it nearly aligns with the platform normal, where the azimuth is undefined.
+bool compensation_orientation(vector3_t direction, orientation_t *orientation);
+
+// Orientation in the platform frame pointing along `orientation` in the world
+// frame, keeping `fallback_azimuth` near the platform normal.
+orientation_t compensation_apply(const compensation_t *compensation, orientation_t orientation, float fallback_azimuth);
+
+#endif // __COMPENSATION_H__
@@ -1,24 +1,96 @@
-#include <cJSON.h>
 #include <driver/gpio.h>
+#include <driver/i2c.h>
 #include <esp_log.h>
 #include <esp_sntp.h>
 #include <esp_system.h>
+#include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <freertos/timers.h>
 #include <math.h>
 #include <nvs_flash.h>
+#include <stdatomic.h>
+#include <string.h>
 #include <sys/time.h>
+#include "ahrs.h"
+#include "backtracking.h"
+#include "benchmark.h"
 #include "cloud_client.h"
+#include "compensation.h"
+#include "i2c_bus.h"
+#include "motion_detector.h"
+#include "motion_profile.h"
+#include "motion_queue.h"
 #include "motors_controller.h"
+#include "multi_head.h"
+#include "path_planner.h"
+#include "position_loop.h"
+#include "protocol.h"
+#include "redundant_imu.h"
 #include "sensor.h"
+#include "servo_feedback.h"
 #include "sun_calculator.h"
+#include "telemetry_delta.h"
+#include "telemetry_rate.h"
+#include "trace.h"
+#include "tracking_policy.h"
 #include "types.h"
 #include "wifi_connector.h"
 
 #define PI 3.14159265358979323846
 #define rad (PI / 180.f)
 
+#if defined(CONFIG_AHRS_ENGINE_MADGWICK)
+#define AHRS_ENGINE AHRS_MADGWICK
+#elif defined(CONFIG_AHRS_ENGINE_EKF)
+#define AHRS_ENGINE AHRS_EKF
+#else
+#define AHRS_ENGINE AHRS_MAHONY
+#endif
+
+#if defined(CONFIG_MOTION_PROFILE_TRAPEZOIDAL)
+#define MOTION_PROFILE MOTION_PROFILE_TRAPEZOIDAL
+#else
+#define MOTION_PROFILE MOTION_PROFILE_S_CURVE
+#endif
+
+#define PLATFORM_ROTATION_PERIOD_MS 80
+// One servo PWM frame
+#define MOTORS_TICK_MS 20
+// Velocity limit of the actuator, relative to the motion profile one
+#define MOTORS_VELOCITY_MARGIN 1.25f
+// Setpoint polling period while the LEDC fade engine drives the motors
+#define MOTORS_FADE_PLAN_PERIOD_MS 100
+// Deviation (degree) of a fade ramp from the motion profile
+#define MOTORS_FADE_TOLERANCE .25f
+// Motion queued ahead of the executor (s), at most this far (degree) from
+// the motion profile
+#define MOTION_QUEUE_HORIZON .3f
+#define MOTION_QUEUE_TOLERANCE .05f
+// Interval between motion queue timing reports
+#define MOTION_QUEUE_REPORT_PERIOD 60.f
+// Longest the sun is aimed ahead of its position (s)
+#define SUN_FEED_FORWARD_MAX_LOOKAHEAD 600.f
+// Interval (ms) between the steps of the heads on the PWM expanders, and
+// between their plans toward the setpoint
+#define MULTI_HEAD_PERIOD_MS 20
+#define MULTI_HEAD_PLAN_PERIOD_MS 1000
+// Interval (ms) between the telemetry rate decisions, how long (ms) an
+// upload may block on a backed up WebSocket, and the motors rotation change
+// (degree) between two decisions that counts as moving
+#define TELEMETRY_TICK_MS 100
+#define TELEMETRY_SEND_TIMEOUT_MS 100
+#define TELEMETRY_MOTION_THRESHOLD .01f
+// Change of the desired motors rotation (degree) that plans a new move
+#define MOTION_RETARGET_THRESHOLD .2f
+// Error (degree) of a de-energized axis, pulled away by the load, that
+// energizes it again
+#define SERVO_FEEDBACK_DRIFT 1.f
+// Quaternion component change that rebuilds the compensation matrix, about 0.01 degree
+#define COMPENSATION_EPSILON 1e-4f
+// Interval between platform rotation cost reports
+#define PLATFORM_ROTATION_REPORT_PERIOD 60.f
+
 typedef enum control_mode_t
 {
     AUTOMATIC,
@@ -31,15 +103,28 @@ typedef struct control_config_t
     orientation_t manual_orientation;
 } control_config_t;
 
+typedef struct platform_rotation_stats_t
+{
+    int64_t since;
+    uint32_t samples;
+    int64_t cpu_time;
+    i2c_bus_stats_t bus;
+} platform_rotation_stats_t;
+
 typedef struct system_state_t
 {
     quaternion_t platform_rotation;
     orientation_t panel_orientation;
     orientation_t motors_rotation;
+    // From the potentiometers, NAN without feedback
+    orientation_t motors_measured;
 } system_state_t;
 
-static const float azimuth_angular_speed = 180.f;
-static const float inclination_angular_speed = 180.f;
+// Degrees, per second, per second squared and per second cubed
+static const motion_limits_t motion_limits[MOTION_PROFILE_AXES] = {
+    [MOTION_PROFILE_AZIMUTH] = {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+    [MOTION_PROFILE_INCLINATION] = {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+};
 static const float latitude = 10.75f;
 static const float longitude = 106.75f;
 
@@ -48,18 +133,80 @@ static control_config_t control_config = {
 };
 static system_state_t system_state = {
     .platform_rotation = QUATERNION_IDENTITY,
+    .motors_measured = {NAN, NAN},
 };
 static bool time_updated;
+static redundant_imu_t platform_imu;
+// Written by the cloud client, applied by the platform rotation timer
+static ahrs_config_t pending_ahrs_config;
+static volatile bool ahrs_config_pending;
+// Written by the cloud client, applied by the motors task
+static servo_calibration_t pending_calibrations[MOTORS_AXES];
+static volatile bool calibration_pending[MOTORS_AXES];
+#ifdef CONFIG_MOTION_QUEUE
+// Handed by the motors task to the executor, which applies them between two
+// frames and then clears their bits (1 << axis)
+static servo_calibration_t executor_calibrations[MOTORS_AXES];
+static atomic_uint executor_calibrations_pending;
+#endif
+#ifdef CONFIG_TRACKING_POLICY
+static float pending_tracking_threshold;
+static volatile bool tracking_threshold_pending;
+#endif
+// Dashboards watching, as counted by the server
+static volatile int viewers;
+static telemetry_rate_t telemetry_rate;
+#ifdef CONFIG_TELEMETRY_DELTA
+static telemetry_delta_t telemetry_delta;
+// Written by the cloud client, applied by the upload timer
+static volatile uint32_t acked_keyframe;
+#endif
+static motion_detector_t motion_detector;
+static platform_rotation_stats_t platform_rotation_stats;
+static compensation_t compensation;
+static path_planner_t path_planner;
+#ifdef CONFIG_MOTION_QUEUE
+static motion_queue_t motion_queue;
+#endif
+#ifdef CONFIG_TRACKING_POLICY
+static tracking_policy_t tracking_policy;
+#endif
+#ifdef CONFIG_BACKTRACKING
+static backtracking_t backtracking;
+#endif
+#ifdef CONFIG_MULTI_HEAD
+static multi_head_t multi_head;
+#endif
+#ifdef CONFIG_SERVO_FEEDBACK
+static servo_feedback_t servo_feedback;
+static position_loop_t position_loop;
+#endif
 
 static void initialize_sntp();
 static void initialize_timezone();
 static void notify_sntp_sync(struct timeval *tv);
 static void cloud_client_data_handler(const char *data, int length);
+static void receive_servo_calibration(motor_axis_t axis, const servo_calibration_point_t *points, int count);
 static void rotate_motors(void *params);
+#ifdef CONFIG_MOTION_QUEUE
+static int64_t queue_move_start(const axis_state_t states[MOTION_PROFILE_AXES], const float target[MOTION_PROFILE_AXES], int64_t now);
+static void drive_motors(const float angles[MOTORS_AXES], uint32_t energize, void *context);
+static void report_motion_queue_stats();
+#endif
+#ifdef CONFIG_SERVO_FEEDBACK
+static void follow_servo_feedback(bool moving, bool replanned);
+#endif
+#ifdef CONFIG_TRACKING_POLICY
+static bool move_pays_off(const axis_state_t states[MOTION_PROFILE_AXES], orientation_t desired, orientation_t sun);
+#endif
+#ifdef CONFIG_MULTI_HEAD
+static void drive_heads(void *params);
+#endif
 static void update_platform_rotation(TimerHandle_t timer);
+static void report_platform_rotation_stats(int64_t now);
 static void upload_system_state(TimerHandle_t timer);
+static void system_state_message(protocol_message_t *message);
 static orientation_t compensate_platform_rotation(orientation_t orientation);
-static void rotate_step(orientation_t *current_orientation, const orientation_t desired_orientation, const float delta_time);
 static double gettimeofday_combined();
 
 void app_main(void)
@@ -67,15 +214,68 @@ void app_main(void)
     initialize_timezone();
 
     ESP_ERROR_CHECK(nvs_flash_init());
+    ESP_ERROR_CHECK(trace_start(CONFIG_TRACE_PRINT_PERIOD_MS));
+
+#ifdef CONFIG_BENCHMARK_MODE
+    benchmark_run();
+#endif
 
     bool is_connected = false;
     initialise_wifi(&is_connected);
 
     motors_init(GPIO_NUM_13, GPIO_NUM_4,
                 GPIO_NUM_16, GPIO_NUM_17);
+    // A safety net behind the motion profile, which already keeps to the limits
+    motors_set_velocity_limit(MOTOR_AZIMUTH, MOTORS_VELOCITY_MARGIN * motion_limits[MOTION_PROFILE_AZIMUTH].velocity);
+    motors_set_velocity_limit(MOTOR_INCLINATION, MOTORS_VELOCITY_MARGIN * motion_limits[MOTION_PROFILE_INCLINATION].velocity);
+#ifdef CONFIG_MOTORS_POWER_GATING
+    motors_set_power_gating(CONFIG_MOTORS_SETTLE_TIME_MS * 1e-3f, CONFIG_MOTORS_PRE_PULSE_MS);
+#endif
+#ifdef CONFIG_SERVO_FEEDBACK
+    servo_feedback_config_t servo_feedback_config = servo_feedback_default_config();
+    servo_feedback_config.channels[MOTOR_AZIMUTH] = CONFIG_SERVO_FEEDBACK_AZIMUTH_CHANNEL;
+    servo_feedback_config.channels[MOTOR_INCLINATION] = CONFIG_SERVO_FEEDBACK_INCLINATION_CHANNEL;
+    ESP_ERROR_CHECK(servo_feedback_init(&servo_feedback, &servo_feedback_adc_ops, &servo_feedback_config, NULL));
+
+    position_loop_config_t position_loop_config = position_loop_default_config();
+    position_loop_init(&position_loop, &position_loop_config);
+#endif
     sensor_init();
 
-    TimerHandle_t update_platform_rotation_handle = xTimerCreate("Update platform rotation", pdMS_TO_TICKS(80), pdTRUE, NULL, update_platform_rotation);
+    ahrs_config_t ahrs_config = ahrs_default_config(AHRS_ENGINE);
+    redundant_imu_config_t redundant_imu_config = redundant_imu_default_config();
+    redundant_imu_init(&platform_imu, &redundant_imu_config, &ahrs_config, sensor_count());
+    ESP_LOGI("Platform rotation", "Using %s filter on %d IMU(s).", platform_imu.channels[0].ahrs.ops->name, platform_imu.channel_count);
+
+    compensation_init(&compensation, COMPENSATION_EPSILON);
+
+    path_planner_config_t path_planner_config = path_planner_default_config(MOTION_PROFILE, motion_limits);
+#ifdef CONFIG_TRACKING_POLICY
+    // Whether a small move is worth it is up to the tracking policy
+    path_planner_config.dead_band = 0.f;
+
+    tracking_policy_config_t tracking_policy_config = tracking_policy_default_config();
+#ifdef CONFIG_MOTORS_POWER_GATING
+    tracking_policy_config.gating_time = (CONFIG_MOTORS_SETTLE_TIME_MS + CONFIG_MOTORS_PRE_PULSE_MS) * 1e-3f;
+#endif
+    tracking_policy_config.threshold = CONFIG_TRACKING_POLICY_THRESHOLD_PERCENT * 1e-2f;
+    tracking_policy_init(&tracking_policy, &tracking_policy_config);
+#endif
+    path_planner_init(&path_planner, &path_planner_config);
+#ifdef CONFIG_BACKTRACKING
+    backtracking_config_t backtracking_config = backtracking_default_config();
+    backtracking_config.row_pitch = CONFIG_BACKTRACKING_ROW_PITCH_MM * 1e-3f;
+    backtracking_config.panel_width = CONFIG_BACKTRACKING_PANEL_WIDTH_MM * 1e-3f;
+    backtracking_config.slope = CONFIG_BACKTRACKING_SLOPE_DECIDEGREES * .1f;
+    backtracking_config.row_azimuth = CONFIG_BACKTRACKING_ROW_AZIMUTH;
+    backtracking_init(&backtracking, &backtracking_config);
+#endif
+
+    motion_detector_config_t motion_detector_config = motion_detector_default_config();
+    motion_detector_init(&motion_detector, &motion_detector_config);
+    platform_rotation_stats.since = esp_timer_get_time();
+
+    TimerHandle_t update_platform_rotation_handle = xTimerCreate("Update platform rotation", pdMS_TO_TICKS(PLATFORM_ROTATION_PERIOD_MS), pdTRUE, NULL, update_platform_rotation);
     xTimerStart(update_platform_rotation_handle, 0);
     ESP_LOGI("Platform rotation", "Timer started.");
 
@@ -92,7 +292,30 @@ void app_main(void)
     xTaskCreate(rotate_motors, "Motors", 8196, NULL, tskIDLE_PRIORITY, &motors_task);
     ESP_LOGI("Motors", "Task created.");
 
-    TimerHandle_t upload_system_state_handle = xTimerCreate("Upload system state", pdMS_TO_TICKS(200), pdTRUE, NULL, upload_system_state);
+#ifdef CONFIG_MULTI_HEAD
+    // The expanders share the bus of the IMU, opened by the sensor
+    multi_head_config_t multi_head_config = multi_head_default_config(CONFIG_MULTI_HEAD_COUNT, MOTION_PROFILE, motion_limits);
+    esp_err_t multi_head_result = multi_head_init(&multi_head, i2c_bus_get(I2C_NUM_0), &multi_head_config);
+    if (multi_head_result == ESP_OK)
+    {
+        xTaskCreate(drive_heads, "Heads", 4096, NULL, tskIDLE_PRIORITY + 1, NULL);
+        ESP_LOGI("Heads", "Driving %d heads on %d PCA9685.", multi_head_config.head_count, multi_head_config.expander_count);
+    }
+    else
+    {
+        ESP_LOGE("Heads", "PCA9685 initialization failed: %s.", esp_err_to_name(multi_head_result));
+    }
+#endif
+
+    telemetry_rate_config_t telemetry_rate_config = telemetry_rate_default_config();
+    telemetry_rate_init(&telemetry_rate, &telemetry_rate_config);
+#ifdef CONFIG_TELEMETRY_DELTA
+    telemetry_delta_config_t telemetry_delta_config = telemetry_delta_default_config();
+    telemetry_delta_config.keyframe_period = CONFIG_TELEMETRY_KEYFRAME_PERIOD;
+    telemetry_delta_init(&telemetry_delta, &telemetry_delta_config);
+#endif
+
+    TimerHandle_t upload_system_state_handle = xTimerCreate("Upload system state", pdMS_TO_TICKS(TELEMETRY_TICK_MS), pdTRUE, NULL, upload_system_state);
     xTimerStart(upload_system_state_handle, pdMS_TO_TICKS(1000));
     ESP_LOGI("System state", "Will be uploaded in 1 second.");
 
@@ -118,50 +341,150 @@ static void initialize_timezone()
 static void notify_sntp_sync(struct timeval *tv)
 {
     time_updated = true;
-    ESP_LOGI("SNTP", "Received time from server: %ld", tv->tv_sec);
+    TRACE(TRACE_SNTP_SYNC, tv->tv_sec);
 }
 
 static void cloud_client_data_handler(const char *data, int length)
 {
-    cJSON *root = cJSON_Parse(data);
-    cJSON *event = cJSON_GetObjectItem(root, "event");
+    // Too large for the stack of the WebSocket task, which is the only caller
+    static protocol_message_t message;
+
+    if (!protocol_decode_json(data, length, &message))
+    {
+        ESP_LOGW("Cloud client", "Cannot parse message: %.*s", length, data);
+        return;
+    }
 
-    if (strcmp(event->valuestring, "UPDATE_CONFIG") == 0)
+    switch (message.event)
     {
-        cJSON *payload = cJSON_GetObjectItem(root, "payload");
+    case PROTOCOL_APP_EVENT_UPDATE_CONFIG:
+    {
+        const protocol_control_config_t *config = &message.control_config;
+        ahrs_engine_t engine;
+
+        control_config.control_mode = config->control_mode == PROTOCOL_CONTROL_MODE_MANUAL ? MANUAL : AUTOMATIC;
+        control_config.manual_orientation = config->manual_orientation;
+
+        if (config->has_ahrs_engine && ahrs_engine_from_name(protocol_ahrs_engine_names[config->ahrs_engine], &engine) &&
+            engine != platform_imu.channels[0].ahrs.config.engine)
+        {
+            pending_ahrs_config = ahrs_default_config(engine);
+            ahrs_config_pending = true;
+        }
 
-        cJSON *control_mode = cJSON_GetObjectItem(payload, "controlMode");
-        control_config.control_mode = strcmp(control_mode->valuestring, "MANUAL") == 0 ? MANUAL : AUTOMATIC;
+        const protocol_servo_calibration_t *calibration = &config->servo_calibration;
+        if (config->has_servo_calibration && calibration->has_azimuth)
+            receive_servo_calibration(MOTOR_AZIMUTH, calibration->azimuth, calibration->azimuth_count);
+        if (config->has_servo_calibration && calibration->has_inclination)
+            receive_servo_calibration(MOTOR_INCLINATION, calibration->inclination, calibration->inclination_count);
 
-        cJSON *manual_orientation = cJSON_GetObjectItem(payload, "manualOrientation");
-        control_config.manual_orientation.azimuth = cJSON_GetObjectItem(manual_orientation, "azimuth")->valuedouble;
-        control_config.manual_orientation.inclination = cJSON_GetObjectItem(manual_orientation, "inclination")->valuedouble;
+#ifdef CONFIG_TRACKING_POLICY
+        if (config->has_tracking_threshold && config->tracking_threshold >= 0.f)
+        {
+            pending_tracking_threshold = config->tracking_threshold;
+            tracking_threshold_pending = true;
+        }
+#endif
+        break;
     }
-    else
-    {
-        ESP_LOGW("Cloud client", "Event not supported: %s", event->valuestring);
+    case PROTOCOL_APP_EVENT_UPDATE_VIEWERS:
+        viewers = message.viewers.viewers;
+        break;
+#ifdef CONFIG_TELEMETRY_DELTA
+    case PROTOCOL_APP_EVENT_ACK_KEYFRAME:
+        acked_keyframe = message.keyframe_ack.keyframe;
+        break;
+#endif
+    default:
+        ESP_LOGW("Cloud client", "Event not supported: %s", protocol_app_event_names[message.event]);
+        break;
     }
-
-    cJSON_Delete(root);
 }
 
-bool is_in_dead_zone(orientation_t orientation)
+// Hands a calibration to the motors task, unless its points do not make a
+// valid table or it is the one in use
+static void receive_servo_calibration(motor_axis_t axis, const servo_calibration_point_t *points, int count)
 {
-    return (-5.f < orientation.azimuth && orientation.azimuth < 5.f) ||
-           (175.f < orientation.azimuth && orientation.azimuth < 185.f) ||
-           (355.f < orientation.azimuth && orientation.azimuth < 365.f);
+    servo_calibration_t calibration = {
+        .count = count,
+    };
+
+    memcpy(calibration.points, points, count * sizeof(*points));
+    if (servo_calibration_is_valid(&calibration) && memcmp(&calibration, motors_calibration(axis), sizeof(calibration)) != 0)
+    {
+        pending_calibrations[axis] = calibration;
+        calibration_pending[axis] = true;
+    }
 }
 
 static void rotate_motors(void *params)
 {
     ESP_LOGI("Motors", "Started.");
 
+    static motion_profile_t profile;
+    bool planned = false;
+    int64_t planned_at = 0;
+#if defined(CONFIG_MOTORS_HARDWARE_FADE)
+    uint32_t fading = 0;
+    TickType_t wait = pdMS_TO_TICKS(MOTORS_FADE_PLAN_PERIOD_MS);
+
+    motors_fade_init(xTaskGetCurrentTaskHandle());
+#elif defined(CONFIG_MOTION_QUEUE)
+    // Profile time queued up to
+    float queued_until = 0.f;
+    float position[MOTORS_AXES] = {system_state.motors_rotation.azimuth, system_state.motors_rotation.inclination};
+    TickType_t last_wake = xTaskGetTickCount();
+
+    motion_queue_init(&motion_queue, position, MOTORS_TICK_MS * 1000, drive_motors, NULL);
+    ESP_ERROR_CHECK(motion_queue_start(&motion_queue, portNUM_PROCESSORS - 1));
+#else
+    TickType_t last_wake = xTaskGetTickCount();
+#endif
+
     for (;;)
     {
-        static double last_time = 0.f;
-        double current_time = gettimeofday_combined();
-        float delta_time = current_time - last_time;
-        last_time = current_time;
+#ifdef CONFIG_MOTORS_HARDWARE_FADE
+        // Woken as each ramp ends, and periodically to follow the setpoint
+        uint32_t ended = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &ended, wait);
+        fading &= ~ended;
+#elif defined(CONFIG_MOTION_QUEUE)
+        // The executor drives the motors, this only keeps it fed
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(MOTORS_FADE_PLAN_PERIOD_MS));
+        report_motion_queue_stats();
+#else
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(MOTORS_TICK_MS));
+#endif
+
+        for (int axis = 0; axis < MOTORS_AXES; axis++)
+        {
+            if (!calibration_pending[axis])
+                continue;
+#ifdef CONFIG_MOTION_QUEUE
+            // The executor did not take the previous table yet
+            if (atomic_load(&executor_calibrations_pending) & (1u << axis))
+                continue;
+#endif
+
+            servo_calibration_t calibration = pending_calibrations[axis];
+            calibration_pending[axis] = false;
+#ifdef CONFIG_MOTION_QUEUE
+            executor_calibrations[axis] = calibration;
+            atomic_fetch_or(&executor_calibrations_pending, 1u << axis);
+#else
+            motors_set_calibration(axis, &calibration);
+#endif
+            // The flash write stalls this task, never the executor
+            motors_store_calibration(axis, &calibration);
+        }
+
+#ifdef CONFIG_TRACKING_POLICY
+        if (tracking_threshold_pending)
+        {
+            tracking_threshold_pending = false;
+            tracking_policy.config.threshold = pending_tracking_threshold;
+        }
+#endif
 
         if (!time_updated)
             continue;
@@ -170,117 +493,495 @@ static void rotate_motors(void *params)
         {
             time_t t;
             time(&t);
+#ifdef CONFIG_SUN_FEED_FORWARD
+            // Aim where the sun will be halfway through the hold that follows the move
+            t += lroundf(get_sun_lookahead(t, latitude, longitude, path_planner.config.dead_band, SUN_FEED_FORWARD_MAX_LOOKAHEAD));
+#endif
             system_state.panel_orientation = get_sun_orientation(t, latitude, longitude);
+#ifdef CONFIG_BACKTRACKING
+            // Turned back from the sun while facing it would shade the next row
+            system_state.panel_orientation = backtracking_orientation(&backtracking, system_state.panel_orientation);
+#endif
         }
         else
         {
             system_state.panel_orientation = control_config.manual_orientation;
         }
 
-        orientation_t desired_motors_rotation = compensate_platform_rotation(system_state.panel_orientation);
-        // orientation_t desired_motors_rotation = system_state.panel_orientation;
+        orientation_t platform_orientation = compensate_platform_rotation(system_state.panel_orientation);
+
+        int64_t now = esp_timer_get_time();
+        axis_state_t states[MOTION_PROFILE_AXES];
 
-        if (desired_motors_rotation.azimuth > 180.f)
+        if (planned)
         {
-            desired_motors_rotation.azimuth -= 180.f;
-            desired_motors_rotation.inclination = -desired_motors_rotation.inclination;
+            // The move may wait for the pre-pulse of a re-energized axis
+            motion_profile_sample(&profile, fmaxf((now - planned_at) * 1e-6f, 0.f), states);
+        }
+        else
+        {
+            states[MOTION_PROFILE_AZIMUTH] = (axis_state_t){.position = system_state.motors_rotation.azimuth};
+            states[MOTION_PROFILE_INCLINATION] = (axis_state_t){.position = system_state.motors_rotation.inclination};
         }
 
-        desired_motors_rotation.inclination = fmin(fmax(desired_motors_rotation.inclination, -90.f), 90.f);
+        // The planner picks between the two equivalent motors rotations and
+        // holds still while the panel already points close enough
+        orientation_t desired_motors_rotation;
+        bool move = path_planner_plan(&path_planner, platform_orientation, states, &desired_motors_rotation);
 
-        if (is_in_dead_zone(desired_motors_rotation) && is_in_dead_zone(system_state.motors_rotation))
-            continue;
+        // The move is planned once per setpoint, from where the motors are now
+        bool retarget = move &&
+                        (!planned ||
+                         fabsf(desired_motors_rotation.azimuth - profile.axes[MOTION_PROFILE_AZIMUTH].target) > MOTION_RETARGET_THRESHOLD ||
+                         fabsf(desired_motors_rotation.inclination - profile.axes[MOTION_PROFILE_INCLINATION].target) > MOTION_RETARGET_THRESHOLD);
 
-        rotate_step(&system_state.motors_rotation, desired_motors_rotation, delta_time);
+#ifdef CONFIG_TRACKING_POLICY
+        // Tracking the sun from rest has to pay off, moves underway and the
+        // manual setpoint are followed
+        if (control_config.control_mode == AUTOMATIC)
+        {
+            static int64_t accounted_at;
+            float power = tracking_policy_clear_sky_power(&tracking_policy.config, system_state.panel_orientation.inclination);
+
+            if (accounted_at != 0)
+                tracking_policy_account(&tracking_policy, system_state.motors_rotation, platform_orientation, power, (now - accounted_at) * 1e-6f);
+            accounted_at = now;
+
+            if (retarget && (!planned || (now - planned_at) * 1e-6f >= profile.duration))
+                retarget = move_pays_off(states, desired_motors_rotation, platform_orientation);
+        }
+#endif
+
+        bool replanned = false;
+        if (retarget)
+        {
+            float target[MOTION_PROFILE_AXES] = {
+                [MOTION_PROFILE_AZIMUTH] = desired_motors_rotation.azimuth,
+                [MOTION_PROFILE_INCLINATION] = desired_motors_rotation.inclination,
+            };
+
+            motion_profile_plan(&profile, MOTION_PROFILE, motion_limits, states, target);
+            planned = true;
+            TRACE(TRACE_MOTORS_MOVE, target[MOTION_PROFILE_AZIMUTH], target[MOTION_PROFILE_INCLINATION], profile.duration);
+#ifdef CONFIG_MOTION_QUEUE
+            planned_at = queue_move_start(states, target, now);
+            queued_until = 0.f;
+#else
+            planned_at = motors_prepare_move(desired_motors_rotation);
+#endif
+            replanned = true;
+        }
+
+        system_state.motors_rotation.azimuth = states[MOTION_PROFILE_AZIMUTH].position;
+        system_state.motors_rotation.inclination = states[MOTION_PROFILE_INCLINATION].position;
+
+#ifdef CONFIG_MOTORS_HARDWARE_FADE
+        // The next ramp starts when the last one ended, or right away on a new
+        // plan. A ramp starts from the duty the hardware is at, so a ramp cut
+        // short by a new plan leaves no jump.
+        float elapsed = (now - planned_at) * 1e-6f;
+        wait = pdMS_TO_TICKS(MOTORS_FADE_PLAN_PERIOD_MS);
+
+        if (planned && elapsed < 0.f)
+        {
+            wait = pdMS_TO_TICKS(-elapsed * 1000.f) + 1;
+        }
+        else if (planned && (replanned || fading == 0) && elapsed < profile.duration)
+        {
+            float breakpoint = motion_profile_next_breakpoint(&profile, elapsed, MOTORS_TICK_MS * 1e-3f, MOTORS_FADE_TOLERANCE);
+            uint32_t duration_ms = (breakpoint - elapsed) * 1000.f;
+            axis_state_t targets[MOTION_PROFILE_AXES];
+
+            motion_profile_sample(&profile, breakpoint, targets);
+            fading = motors_fade(
+                (orientation_t){
+                    .azimuth = targets[MOTION_PROFILE_AZIMUTH].position,
+                    .inclination = targets[MOTION_PROFILE_INCLINATION].position,
+                },
+                duration_ms);
+
+            // Less than a duty step to go, nothing will notify
+            if (fading == 0)
+                wait = pdMS_TO_TICKS(duration_ms) + 1;
+        }
+#elif defined(CONFIG_MOTION_QUEUE)
+        if (planned)
+            queued_until = motion_queue_push_profile(&motion_queue, &profile, queued_until,
+                                                     (now - planned_at) * 1e-6f + MOTION_QUEUE_HORIZON, MOTION_QUEUE_TOLERANCE);
+#elif defined(CONFIG_SERVO_FEEDBACK)
+        follow_servo_feedback(planned && (now - planned_at) * 1e-6f < profile.duration, replanned);
+#else
         motors_rotate(system_state.motors_rotation);
+#endif
+
+#ifndef CONFIG_MOTION_QUEUE
+        motors_update_power();
+#endif
+    }
+}
+
+#ifdef CONFIG_MOTION_QUEUE
+// Drops what is queued for a new move. The axes that are de-energized and
+// have to move are energized first, and held for their pre-pulse. Returns
+// when the move starts.
+static int64_t queue_move_start(const axis_state_t states[MOTION_PROFILE_AXES], const float target[MOTION_PROFILE_AXES], int64_t now)
+{
+    motion_queue_segment_t hold = {
+        .end = {states[MOTION_PROFILE_AZIMUTH].position, states[MOTION_PROFILE_INCLINATION].position},
+    };
+
+    motion_queue_flush(&motion_queue);
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        if (target[axis] != states[axis].position && !motors_is_energized(axis))
+            hold.energize |= 1u << axis;
+    }
+
+#ifdef CONFIG_MOTORS_POWER_GATING
+    if (hold.energize != 0)
+    {
+        hold.ticks = (CONFIG_MOTORS_PRE_PULSE_MS + MOTORS_TICK_MS - 1) / MOTORS_TICK_MS;
+        motion_queue_push(&motion_queue, &hold);
+    }
+#endif
+
+    return now + hold.ticks * MOTORS_TICK_MS * 1000;
+}
+
+// Runs in the executor, every servo PWM frame
+static void drive_motors(const float angles[MOTORS_AXES], uint32_t energize, void *context)
+{
+    uint32_t calibrations = atomic_load(&executor_calibrations_pending);
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        if (calibrations & (1u << axis))
+            motors_set_calibration(axis, &executor_calibrations[axis]);
+    }
+    atomic_fetch_and(&executor_calibrations_pending, ~calibrations);
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        if (energize & (1u << axis))
+            motors_set_power(axis, true);
+    }
+
+    motors_rotate((orientation_t){.azimuth = angles[MOTOR_AZIMUTH], .inclination = angles[MOTOR_INCLINATION]});
+    motors_update_power();
+}
+
+static void report_motion_queue_stats()
+{
+    static int64_t reported_at;
+    int64_t now = esp_timer_get_time();
+    motion_queue_stats_t stats = motion_queue.stats;
+
+    if (now - reported_at < MOTION_QUEUE_REPORT_PERIOD * 1e6f || stats.ticks < 2)
+        return;
+
+    ESP_LOGI("Motion queue", "%u ticks, jitter mean %.1f max %lld us, latency mean %.1f max %lld us, %u underruns.",
+             stats.ticks, (float)stats.jitter_sum / (stats.ticks - 1), (long long)stats.jitter_max,
+             (float)stats.latency_sum / stats.ticks, (long long)stats.latency_max, stats.underruns);
+    reported_at = now;
+}
+#endif
+
+#ifdef CONFIG_TRACKING_POLICY
+// Times the move from rest to `desired`, and lets the policy weigh it
+static bool move_pays_off(const axis_state_t states[MOTION_PROFILE_AXES], orientation_t desired, orientation_t sun)
+{
+    static motion_profile_t candidate;
+    float target[MOTION_PROFILE_AXES] = {
+        [MOTION_PROFILE_AZIMUTH] = desired.azimuth,
+        [MOTION_PROFILE_INCLINATION] = desired.inclination,
+    };
+    orientation_t current = {
+        .azimuth = states[MOTION_PROFILE_AZIMUTH].position,
+        .inclination = states[MOTION_PROFILE_INCLINATION].position,
+    };
+    float power = tracking_policy_clear_sky_power(&tracking_policy.config, system_state.panel_orientation.inclination);
+
+    motion_profile_plan(&candidate, MOTION_PROFILE, motion_limits, states, target);
+    return tracking_policy_should_move(&tracking_policy, current, desired, sun, power, candidate.duration);
+}
+#endif
+
+#ifdef CONFIG_SERVO_FEEDBACK
+// Commands the motors rotation, corrected by the outer loop on the measured one
+static void follow_servo_feedback(bool moving, bool replanned)
+{
+    float targets[MOTORS_AXES] = {system_state.motors_rotation.azimuth, system_state.motors_rotation.inclination};
+    float commands[MOTORS_AXES];
+    bool valid[MOTORS_AXES], settled[MOTORS_AXES];
+
+    servo_feedback_update(&servo_feedback, valid);
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        if (replanned)
+            position_loop_clear_stall(&position_loop, axis);
+
+        // A gated axis pulled away by the load is held again
+        if (valid[axis] && !motors_is_energized(axis) && !position_loop.axes[axis].stalled &&
+            fabsf(targets[axis] - servo_feedback.angles[axis]) > SERVO_FEEDBACK_DRIFT)
+            motors_set_power(axis, true);
+
+        settled[axis] = !moving && motors_is_energized(axis);
+    }
+
+    uint32_t stalled = position_loop_update(&position_loop, targets, servo_feedback.angles, valid, settled, MOTORS_TICK_MS * 1e-3f, commands);
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        if (stalled & (1u << axis))
+            TRACE(TRACE_MOTORS_STALL, axis, position_loop.axes[axis].error);
     }
+
+    system_state.motors_measured.azimuth = valid[MOTOR_AZIMUTH] ? servo_feedback.angles[MOTOR_AZIMUTH] : NAN;
+    system_state.motors_measured.inclination = valid[MOTOR_INCLINATION] ? servo_feedback.angles[MOTOR_INCLINATION] : NAN;
+    motors_rotate((orientation_t){.azimuth = commands[MOTOR_AZIMUTH], .inclination = commands[MOTOR_INCLINATION]});
 }
+#endif
+
+#ifdef CONFIG_MULTI_HEAD
+// The heads follow the setpoint of the motors task, so they share its
+// ephemeris, each through its own mounting compensation
+static void drive_heads(void *params)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    int64_t planned_at = 0;
+
+    for (;;)
+    {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(MULTI_HEAD_PERIOD_MS));
+
+        int64_t now = esp_timer_get_time();
+
+        if (time_updated && now - planned_at >= MULTI_HEAD_PLAN_PERIOD_MS * 1000)
+        {
+            multi_head_set_sun(&multi_head, system_state.panel_orientation);
+            planned_at = now;
+        }
+
+        multi_head_update(&multi_head, MULTI_HEAD_PERIOD_MS * 1e-3f);
+    }
+}
+#endif
 
 static void update_platform_rotation(TimerHandle_t timer)
 {
     if (!time_updated)
         return;
 
-    vector3_t accel = {0.f, 0.f, 1.f};
-    vector3_t gyro = {0.f, 0.f, 0.f};
-    vector3_t magnet = {1.f, 0.f, 0.f};
+    int64_t start = esp_timer_get_time();
+
+    vector3_t accel[REDUNDANT_IMU_MAX_CHANNELS], gyro[REDUNDANT_IMU_MAX_CHANNELS], magnet[REDUNDANT_IMU_MAX_CHANNELS];
+    bool valid[REDUNDANT_IMU_MAX_CHANNELS];
+
+    sensor_read_all(accel, gyro, magnet, valid);
+
+    int64_t timestamp = esp_timer_get_time();
+    ahrs_sample_t samples[REDUNDANT_IMU_MAX_CHANNELS];
+    // The motion detector follows the first IMU that answered
+    const ahrs_sample_t *sample = NULL;
 
-    sensor_read(&accel, &gyro, &magnet);
+    for (int i = 0; i < platform_imu.channel_count; i++)
+    {
+        samples[i] = (ahrs_sample_t){
+            .accel = accel[i],
+            .gyro = {gyro[i].x * rad, gyro[i].y * rad, gyro[i].z * rad},
+            .magnet = magnet[i],
+            .timestamp = timestamp,
+        };
 
-    gyro.x *= rad;
-    gyro.y *= rad;
-    gyro.z *= rad;
+        if (valid[i] && sample == NULL && platform_imu.channels[i].state == IMU_CHANNEL_HEALTHY)
+            sample = &samples[i];
+    }
 
-    static double last_time = 0.f;
-    double current_time = gettimeofday_combined();
-    float delta_time = last_time == 0.f ? 0.f : current_time - last_time;
-    last_time = current_time;
+    platform_rotation_stats.samples++;
 
-    static vector3_t error;
-    quaternion_mahony_update(&system_state.platform_rotation, &error, accel, gyro, magnet, delta_time / 4.f);
+#ifdef CONFIG_STATIONARY_MODE
+    motion_state_t previous_state = motion_detector.state;
+    motion_state_t state = sample != NULL ? motion_detector_update(&motion_detector, sample) : previous_state;
+
+    if (state == MOTION_STATIONARY)
+    {
+        // The filter has converged on a still platform: keep its rotation
+        if (previous_state != MOTION_STATIONARY)
+        {
+            xTimerChangePeriod(timer, pdMS_TO_TICKS(CONFIG_STATIONARY_WATCHDOG_PERIOD), 0);
+            ESP_LOGI("Platform rotation", "Stationary, polling every %d ms.", CONFIG_STATIONARY_WATCHDOG_PERIOD);
+        }
+
+        platform_rotation_stats.cpu_time += esp_timer_get_time() - start;
+        report_platform_rotation_stats(timestamp);
+        return;
+    }
+
+    if (previous_state == MOTION_STATIONARY)
+    {
+        xTimerChangePeriod(timer, pdMS_TO_TICKS(PLATFORM_ROTATION_PERIOD_MS), 0);
+        redundant_imu_pause(&platform_imu);
+        ESP_LOGI("Platform rotation", "Disturbed, back to full rate fusion.");
+    }
+#endif
+
+    if (ahrs_config_pending)
+    {
+        redundant_imu_set_ahrs_config(&platform_imu, &pending_ahrs_config);
+        ahrs_config_pending = false;
+        ESP_LOGI("Platform rotation", "Switched to %s filter.", platform_imu.channels[0].ahrs.ops->name);
+    }
+
+    // Without a healthy IMU the last rotation is kept, the loop keeps running
+    // and a recovered IMU is picked up on a later tick
+    if (redundant_imu_update(&platform_imu, samples, valid))
+        system_state.platform_rotation = platform_imu.rotation;
+
+    platform_rotation_stats.cpu_time += esp_timer_get_time() - start;
+    report_platform_rotation_stats(timestamp);
+}
+
+// Logs what the platform rotation cost since the last report, compared with
+// polling at full rate all the time. The I2C figures cover the whole bus.
+static void report_platform_rotation_stats(int64_t now)
+{
+    platform_rotation_stats_t *stats = &platform_rotation_stats;
+    float elapsed = (now - stats->since) * 1e-6f;
+
+    if (elapsed < PLATFORM_ROTATION_REPORT_PERIOD)
+        return;
+
+    i2c_bus_t *bus = i2c_bus_get(I2C_NUM_0);
+    i2c_bus_stats_t bus_stats = bus != NULL ? bus->stats : (i2c_bus_stats_t){0};
+    uint32_t full_rate_samples = elapsed * 1000.f / PLATFORM_ROTATION_PERIOD_MS;
+    uint32_t transactions = bus_stats.transactions - stats->bus.transactions;
+    uint32_t bytes = bus_stats.bytes_written + bus_stats.bytes_read - stats->bus.bytes_written - stats->bus.bytes_read;
+    uint64_t bus_time = bus_stats.bus_time_ns - stats->bus.bus_time_ns;
+
+    ESP_LOGI("Platform rotation",
+             "%s, %d/%d IMUs healthy: %u samples (%u at full rate, %.1f%% saved), "
+             "I2C %u transactions, %u bytes, busy %.3f%%, CPU busy %.3f%%",
+             motion_detector.state == MOTION_STATIONARY ? "Stationary" : "Moving",
+             redundant_imu_healthy_count(&platform_imu), platform_imu.channel_count,
+             stats->samples, full_rate_samples,
+             full_rate_samples > 0 ? 100.f * (1.f - (float)stats->samples / full_rate_samples) : 0.f,
+             transactions, bytes,
+             100.f * bus_time * 1e-9f / elapsed,
+             100.f * stats->cpu_time * 1e-6f / elapsed);
+
+    stats->since = now;
+    stats->samples = 0;
+    stats->cpu_time = 0;
+    stats->bus = bus_stats;
 }
 
+// Uploads at the rate the link and the audience call for
 static void upload_system_state(TimerHandle_t timer)
 {
-    char buffer[512];
-    int length = sprintf(
-        buffer,
-        "{"
-        "\"event\":\"UPDATE_STATE\","
-        "\"payload\":{"
-        "\"platformRotation\":{\"w\":%.6f,\"x\":%.6f,\"y\":%.6f,\"z\":%.6f},"
-        "\"panelOrientation\":{\"azimuth\":%.6f,\"inclination\":%.6f},"
-        "\"motorsRotation\":{\"azimuth\":%.6f,\"inclination\":%.6f},"
-        "\"timestamp\":%lld"
-        "}}",
+    static orientation_t motors_rotation;
+    bool moving = fabsf(system_state.motors_rotation.azimuth - motors_rotation.azimuth) > TELEMETRY_MOTION_THRESHOLD ||
+                  fabsf(system_state.motors_rotation.inclination - motors_rotation.inclination) > TELEMETRY_MOTION_THRESHOLD;
+
+    motors_rotation = system_state.motors_rotation;
+#ifdef CONFIG_TELEMETRY_DELTA
+    static float since_frame;
+    since_frame += TELEMETRY_TICK_MS * 1e-3f;
+#endif
+    if (!telemetry_rate_should_send(&telemetry_rate, moving, viewers, TELEMETRY_TICK_MS * 1e-3f))
+        return;
+
+    char buffer[768];
+    // Too large for the stack of the timer task
+    static protocol_message_t message;
+#ifdef CONFIG_TELEMETRY_DELTA
+    const float values[TELEMETRY_DELTA_FIELDS] = {
         system_state.platform_rotation.w, system_state.platform_rotation.x, system_state.platform_rotation.y, system_state.platform_rotation.z,
         system_state.panel_orientation.azimuth, system_state.panel_orientation.inclination,
         system_state.motors_rotation.azimuth, system_state.motors_rotation.inclination,
-        (long long)(gettimeofday_combined() * 1000.L));
+        motors_energized_seconds(MOTOR_AZIMUTH), motors_energized_seconds(MOTOR_INCLINATION),
+    };
+    uint32_t keyframe;
+
+    telemetry_delta_ack(&telemetry_delta, acked_keyframe);
+    telemetry_delta_frame_t frame = telemetry_delta_next(&telemetry_delta, values, since_frame, &keyframe);
+    since_frame = 0.f;
+    if (frame == TELEMETRY_DELTA_UNCHANGED)
+        return;
+
+    if (frame == TELEMETRY_DELTA_DELTA)
+    {
+        message.event = PROTOCOL_APP_EVENT_UPDATE_DELTA;
+        message.system_delta.base = keyframe;
+        message.system_delta.timestamp = gettimeofday_combined() * 1000.L;
+        message.system_delta.changes_count = telemetry_delta_changes(&telemetry_delta, message.system_delta.changes);
+    }
+    else
+    {
+        system_state_message(&message);
+        message.system_state.has_keyframe = true;
+        message.system_state.keyframe = keyframe;
+    }
+#else
+    system_state_message(&message);
+#endif
 
+    int length = protocol_encode_json(&message, buffer, sizeof(buffer));
     if (length <= 0)
     {
         ESP_LOGE("Solar tracker", "Cannot format system state data for upload.");
         return;
     }
 
-    cloud_client_send(buffer, length, portMAX_DELAY);
+    int64_t begin = esp_timer_get_time();
+    bool sent = cloud_client_send(buffer, length, pdMS_TO_TICKS(TELEMETRY_SEND_TIMEOUT_MS)) >= 0;
+    float send_time = (esp_timer_get_time() - begin) * 1e-6f;
+    wifi_ap_record_t access_point;
+    int rssi = esp_wifi_sta_get_ap_info(&access_point) == ESP_OK ? access_point.rssi : 0;
+
+    telemetry_rate_report(&telemetry_rate, sent, send_time, rssi);
 }
 
-static orientation_t compensate_platform_rotation(orientation_t orientation)
+static void system_state_message(protocol_message_t *message)
 {
-    vector3_t world_direction = quaternion_rotate(
-        quaternion_from_orientation(orientation),
-        VECTOR3_UP);
-    vector3_t local_direction = quaternion_rotate(
-        quaternion_inverse(system_state.platform_rotation),
-        world_direction);
-
-    local_direction = vector3_normalize(local_direction);
-
-    // Nearly align with the platform normal
-    if (fabs(local_direction.x) < .1f && fabs(local_direction.y) < .1f)
-    {
-        return (orientation_t){
-            .azimuth = system_state.motors_rotation.azimuth,
-            .inclination = 0.f,
-        };
-    }
-
-    return (orientation_t){
-        .azimuth = -atan2(local_direction.y, local_direction.x) / rad + (local_direction.y >= 0.f ? 360.f : 0.f),
-        .inclination = acos(local_direction.z) / rad,
+    message->event = PROTOCOL_APP_EVENT_UPDATE_STATE;
+    message->system_state = (protocol_system_state_t){
+        .platform_rotation = system_state.platform_rotation,
+        .panel_orientation = system_state.panel_orientation,
+        .motors_rotation = system_state.motors_rotation,
+        .motors_energized = {motors_energized_seconds(MOTOR_AZIMUTH), motors_energized_seconds(MOTOR_INCLINATION)},
+        .timestamp = gettimeofday_combined() * 1000.L,
+        // Only sent while the potentiometers are read
+        .has_motors_measured = !isnan(system_state.motors_measured.azimuth) && !isnan(system_state.motors_measured.inclination),
+        .motors_measured = system_state.motors_measured,
+        .has_telemetry = true,
+        .telemetry = {
+            .rate = telemetry_rate_effective(&telemetry_rate),
+            .sent = telemetry_rate.stats.sent,
+            .failed = telemetry_rate.stats.failed,
+            .deferred = telemetry_rate.stats.deferred,
+            .backoffs = telemetry_rate.stats.backoffs,
+        },
+    };
+#ifdef CONFIG_TRACKING_POLICY
+    message->system_state.has_tracking_policy = true;
+    message->system_state.tracking_policy = (protocol_tracking_policy_t){
+        .moves = tracking_policy.stats.moves,
+        .skipped = tracking_policy.stats.skipped,
+        .motor_on_time = tracking_policy.stats.motor_on_time,
+        .motor_energy = tracking_policy.stats.motor_energy / 3600.f,
+        .yield = tracking_policy.stats.yield / 3600.f,
     };
+#endif
 }
 
-static void rotate_step(orientation_t *current_orientation, const orientation_t desired_orientation, const float delta_time)
+static orientation_t compensate_platform_rotation(orientation_t orientation)
 {
-    float azimuth_offset = desired_orientation.azimuth - current_orientation->azimuth;
-    float inclination_offset = desired_orientation.inclination - current_orientation->inclination;
-    float delta_azimuth = fmin(fabs(azimuth_offset), azimuth_angular_speed * delta_time);
-    float delta_inclination = fmin(fabs(inclination_offset), inclination_angular_speed * delta_time);
-    current_orientation->azimuth += copysign(delta_azimuth, azimuth_offset);
-    current_orientation->inclination += copysign(delta_inclination, inclination_offset);
+    // The matrix is only rebuilt when the platform rotation actually moved
+    compensation_set_platform_rotation(&compensation, system_state.platform_rotation);
+
+    return compensation_apply(&compensation, orientation, system_state.motors_rotation.azimuth);
 }
 
 static double gettimeofday_combined()
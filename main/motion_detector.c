@@ -0,0 +1,89 @@
+#include <string.h>
+#include "motion_detector.h"
+
+// Weight of the newest sample in the accel mean and variance
+#define ACCEL_AVERAGE_RATE .1f
+
+static void restart(motion_detector_t *detector, const ahrs_sample_t *sample);
+static float distance(vector3_t a, vector3_t b);
+
+motion_detector_config_t motion_detector_default_config()
+{
+    return (motion_detector_config_t){
+        .gyro_threshold = .05f,
+        .accel_variance_threshold = 2e-4f,
+        .settle_time = 10.f,
+        .accel_deviation_threshold = .05f,
+        .magnet_deviation_threshold = .1f,
+    };
+}
+
+void motion_detector_init(motion_detector_t *detector, const motion_detector_config_t *config)
+{
+    memset(detector, 0, sizeof(*detector));
+    detector->config = *config;
+    detector->state = MOTION_MOVING;
+}
+
+motion_state_t motion_detector_update(motion_detector_t *detector, const ahrs_sample_t *sample)
+{
+    if (!detector->started)
+    {
+        restart(detector, sample);
+        return detector->state;
+    }
+
+    if (detector->state == MOTION_STATIONARY)
+    {
+        bool disturbed =
+            vector3_magnitude(sample->gyro) > detector->config.gyro_threshold ||
+            distance(sample->accel, detector->accel_reference) > detector->config.accel_deviation_threshold ||
+            distance(vector3_normalize(sample->magnet), detector->magnet_reference) > detector->config.magnet_deviation_threshold;
+
+        if (disturbed)
+            restart(detector, sample);
+
+        return detector->state;
+    }
+
+    // Exponentially weighted mean and variance of the accel vector
+    vector3_t offset = {
+        sample->accel.x - detector->accel_mean.x,
+        sample->accel.y - detector->accel_mean.y,
+        sample->accel.z - detector->accel_mean.z,
+    };
+    detector->accel_mean.x += ACCEL_AVERAGE_RATE * offset.x;
+    detector->accel_mean.y += ACCEL_AVERAGE_RATE * offset.y;
+    detector->accel_mean.z += ACCEL_AVERAGE_RATE * offset.z;
+    detector->accel_variance = (1.f - ACCEL_AVERAGE_RATE) * (detector->accel_variance + ACCEL_AVERAGE_RATE * vector3_dot(offset, offset));
+
+    bool quiet = vector3_magnitude(sample->gyro) < detector->config.gyro_threshold &&
+                 detector->accel_variance < detector->config.accel_variance_threshold;
+
+    if (!quiet)
+    {
+        detector->quiet_since = sample->timestamp;
+    }
+    else if ((sample->timestamp - detector->quiet_since) * 1e-6f >= detector->config.settle_time)
+    {
+        detector->state = MOTION_STATIONARY;
+        detector->accel_reference = detector->accel_mean;
+        detector->magnet_reference = vector3_normalize(sample->magnet);
+    }
+
+    return detector->state;
+}
+
+static void restart(motion_detector_t *detector, const ahrs_sample_t *sample)
+{
+    detector->started = true;
+    detector->state = MOTION_MOVING;
+    detector->quiet_since = sample->timestamp;
+    detector->accel_mean = sample->accel;
+    detector->accel_variance = 0.f;
+}
+
+static float distance(vector3_t a, vector3_t b)
+{
+    return vector3_magnitude((vector3_t){a.x - b.x, a.y - b.y, a.z - b.z});
+}
@@ -0,0 +1,43 @@
+#ifndef __MOTION_DETECTOR_H__
+#define __MOTION_DETECTOR_H__
+
+#include <stdint.h>
+#include "ahrs.h"
+
+typedef enum motion_state_t
+{
+    MOTION_MOVING,
+    MOTION_STATIONARY,
+} motion_state_t;
+
+typedef struct motion_detector_config_t
+{
+    // Quiet when the gyro norm (rad/s) and the accel variance (g^2) stay below these
+    float gyro_threshold;
+    float accel_variance_threshold;
+    // Seconds the platform must stay quiet before it is considered stationary
+    float settle_time;
+    // Once stationary, a single sample leaving the stationary accel (g) or
+    // normalized magnet reading by more than these is a disturbance
+    float accel_deviation_threshold;
+    float magnet_deviation_threshold;
+} motion_detector_config_t;
+
+typedef struct motion_detector_t
+{
+    motion_detector_config_t config;
+    motion_state_t state;
+    bool started;
+    int64_t quiet_since;
+    vector3_t accel_mean;
+    float accel_variance;
+    // Readings when the platform became stationary
+    vector3_t accel_reference;
+    vector3_t magnet_reference;
+} motion_detector_t;
+
+motion_detector_config_t motion_detector_default_config();
+void motion_detector_init(motion_detector_t *detector, const motion_detector_config_t *config);
+motion_state_t motion_detector_update(motion_detector_t *detector, const ahrs_sample_t *sample);
+
+#endif // __MOTION_DETECTOR_H__
@@ -0,0 +1,313 @@
+#include <math.h>
+#include <string.h>
+#include "motion_profile.h"
+
+// Distances, velocities and durations below these are treated as zero
+#define POSITION_EPSILON 1e-4f
+#define VELOCITY_EPSILON 1e-4f
+#define TIME_EPSILON 1e-4f
+// Halvings of the bisections below, plenty for float precision
+#define BISECTION_STEPS 24
+
+typedef struct axis_planner_t
+{
+    motion_axis_profile_t *axis;
+    motion_profile_type_t type;
+    motion_limits_t limits;
+    axis_state_t state;
+    float time;
+} axis_planner_t;
+
+static void plan_axis(motion_axis_profile_t *axis, motion_profile_type_t type, motion_limits_t limits, axis_state_t start, float target);
+static void add_segment(axis_planner_t *planner, float duration, float acceleration, float jerk);
+static void change_velocity(axis_planner_t *planner, float velocity);
+static float change_time(const axis_planner_t *planner, float delta);
+static float change_distance(const axis_planner_t *planner, float from, float to);
+static void evaluate(const motion_segment_t *segment, float time, axis_state_t *state);
+static float axis_acceleration(const motion_axis_profile_t *axis, float time);
+
+void motion_profile_plan(motion_profile_t *profile, motion_profile_type_t type, const motion_limits_t limits[MOTION_PROFILE_AXES],
+                         const axis_state_t start[MOTION_PROFILE_AXES], const float target[MOTION_PROFILE_AXES])
+{
+    profile->type = type;
+    profile->duration = 0.f;
+
+    for (int i = 0; i < MOTION_PROFILE_AXES; i++)
+    {
+        plan_axis(&profile->axes[i], type, limits[i], start[i], target[i]);
+        profile->duration = fmaxf(profile->duration, profile->axes[i].duration);
+    }
+
+    // Stretch the faster axes by lowering their cruise velocity. Time only
+    // grows as the limit shrinks, so a bisection finds it.
+    for (int i = 0; i < MOTION_PROFILE_AXES; i++)
+    {
+        if (profile->axes[i].duration >= profile->duration - TIME_EPSILON || profile->axes[i].count == 0)
+            continue;
+
+        motion_limits_t slower = limits[i];
+        float low = 0.f, high = limits[i].velocity;
+
+        for (int step = 0; step < BISECTION_STEPS; step++)
+        {
+            slower.velocity = .5f * (low + high);
+            plan_axis(&profile->axes[i], type, slower, start[i], target[i]);
+
+            if (profile->axes[i].duration > profile->duration)
+                low = slower.velocity;
+            else
+                high = slower.velocity;
+        }
+
+        slower.velocity = high;
+        plan_axis(&profile->axes[i], type, slower, start[i], target[i]);
+    }
+}
+
+void motion_profile_sample(motion_profile_t *profile, float time, axis_state_t states[MOTION_PROFILE_AXES])
+{
+    for (int i = 0; i < MOTION_PROFILE_AXES; i++)
+    {
+        motion_axis_profile_t *axis = &profile->axes[i];
+
+        if (axis->count == 0 || time >= axis->duration)
+        {
+            states[i] = (axis_state_t){.position = axis->target};
+            continue;
+        }
+
+        // Ticks move forward, so this is usually the same or the next segment
+        if (axis->segments[axis->cursor].start > time)
+            axis->cursor = 0;
+        while (axis->cursor + 1 < axis->count && axis->segments[axis->cursor + 1].start <= time)
+            axis->cursor++;
+
+        evaluate(&axis->segments[axis->cursor], time, &states[i]);
+    }
+}
+
+float motion_profile_next_breakpoint(const motion_profile_t *profile, float time, float spacing, float tolerance)
+{
+    float breakpoint = profile->duration;
+
+    for (int i = 0; i < MOTION_PROFILE_AXES; i++)
+    {
+        const motion_axis_profile_t *axis = &profile->axes[i];
+
+        for (int k = 1; k <= axis->count; k++)
+        {
+            float boundary = k < axis->count ? axis->segments[k].start : axis->duration;
+
+            if (boundary >= time + spacing)
+            {
+                breakpoint = fminf(breakpoint, boundary);
+                break;
+            }
+        }
+    }
+
+    // Within a segment the acceleration is linear, so it peaks at an end, and
+    // a chord over a duration strays at most peak * duration^2 / 8
+    for (int i = 0; i < MOTION_PROFILE_AXES; i++)
+    {
+        float peak = fmaxf(fabsf(axis_acceleration(&profile->axes[i], time)), fabsf(axis_acceleration(&profile->axes[i], breakpoint)));
+
+        if (peak > VELOCITY_EPSILON)
+            breakpoint = fminf(breakpoint, time + fmaxf(sqrtf(8.f * tolerance / peak), spacing));
+    }
+
+    return fmaxf(breakpoint, time);
+}
+
+const char *motion_profile_type_name(motion_profile_type_t type)
+{
+    return type == MOTION_PROFILE_S_CURVE ? "S-curve" : "trapezoidal";
+}
+
+static void plan_axis(motion_axis_profile_t *axis, motion_profile_type_t type, motion_limits_t limits, axis_state_t start, float target)
+{
+    axis_planner_t planner = {
+        .axis = axis,
+        .type = type,
+        .limits = limits,
+        .state = start,
+    };
+
+    axis->count = 0;
+    axis->cursor = 0;
+    axis->target = target;
+
+    // The velocity changes below start and end without acceleration
+    if (type == MOTION_PROFILE_S_CURVE && fabsf(start.acceleration) > VELOCITY_EPSILON)
+        add_segment(&planner, fabsf(start.acceleration) / limits.jerk, start.acceleration, -copysignf(limits.jerk, start.acceleration));
+    planner.state.acceleration = 0.f;
+
+    float velocity = planner.state.velocity;
+
+    if (fabsf(velocity) > VELOCITY_EPSILON)
+    {
+        float distance = target - planner.state.position;
+        float stop = change_distance(&planner, fabsf(velocity), 0.f);
+
+        if (distance * copysignf(1.f, velocity) >= stop)
+        {
+            // Keep going at the velocity limit, or as close to it as the
+            // target allows. Cruising slower than now is how a synchronized
+            // axis stretches its move.
+            float speed = fabsf(velocity);
+            float low = speed, high = limits.velocity;
+
+            if (change_distance(&planner, speed, high) + change_distance(&planner, high, 0.f) <= fabsf(distance))
+                low = high;
+
+            for (int step = 0; step < BISECTION_STEPS && low != high; step++)
+            {
+                float middle = .5f * (low + high);
+
+                if (change_distance(&planner, speed, middle) + change_distance(&planner, middle, 0.f) <= fabsf(distance))
+                    low = middle;
+                else
+                    high = middle;
+            }
+
+            float cruise = (fabsf(distance) - change_distance(&planner, speed, low) - change_distance(&planner, low, 0.f)) / low;
+
+            change_velocity(&planner, copysignf(low, velocity));
+            add_segment(&planner, cruise, 0.f, 0.f);
+            change_velocity(&planner, 0.f);
+            axis->duration = planner.time;
+            return;
+        }
+
+        // Too late to stop on the target, or it is behind: stop first
+        change_velocity(&planner, 0.f);
+    }
+
+    float distance = target - planner.state.position;
+
+    if (fabsf(distance) > POSITION_EPSILON)
+    {
+        // Rest to rest, peak velocity reduced on short moves
+        float low = 0.f, high = limits.velocity;
+
+        if (2.f * change_distance(&planner, 0.f, high) <= fabsf(distance))
+            low = high;
+
+        for (int step = 0; step < BISECTION_STEPS && low < high; step++)
+        {
+            float middle = .5f * (low + high);
+
+            if (2.f * change_distance(&planner, 0.f, middle) <= fabsf(distance))
+                low = middle;
+            else
+                high = middle;
+        }
+
+        float cruise = low > VELOCITY_EPSILON ? (fabsf(distance) - 2.f * change_distance(&planner, 0.f, low)) / low : 0.f;
+
+        change_velocity(&planner, copysignf(low, distance));
+        add_segment(&planner, cruise, 0.f, 0.f);
+        change_velocity(&planner, 0.f);
+    }
+
+    axis->duration = planner.time;
+}
+
+static void add_segment(axis_planner_t *planner, float duration, float acceleration, float jerk)
+{
+    motion_axis_profile_t *axis = planner->axis;
+
+    if (duration < TIME_EPSILON || axis->count >= MOTION_PROFILE_MAX_SEGMENTS)
+        return;
+
+    motion_segment_t *segment = &axis->segments[axis->count++];
+    segment->start = planner->time;
+    segment->state = planner->state;
+    segment->state.acceleration = acceleration;
+    segment->jerk = jerk;
+
+    planner->time += duration;
+    evaluate(segment, planner->time, &planner->state);
+}
+
+// From the current velocity to `velocity`, starting and ending without
+// acceleration. The acceleration peaks below its limit on small changes.
+static void change_velocity(axis_planner_t *planner, float velocity)
+{
+    float delta = velocity - planner->state.velocity;
+    float sign = delta < 0.f ? -1.f : 1.f;
+    float acceleration = planner->limits.acceleration;
+    float jerk = planner->limits.jerk;
+
+    if (fabsf(delta) < VELOCITY_EPSILON)
+        return;
+
+    if (planner->type == MOTION_PROFILE_TRAPEZOIDAL)
+    {
+        add_segment(planner, fabsf(delta) / acceleration, sign * acceleration, 0.f);
+    }
+    else if (fabsf(delta) >= acceleration * acceleration / jerk)
+    {
+        add_segment(planner, acceleration / jerk, 0.f, sign * jerk);
+        add_segment(planner, fabsf(delta) / acceleration - acceleration / jerk, sign * acceleration, 0.f);
+        add_segment(planner, acceleration / jerk, sign * acceleration, -sign * jerk);
+    }
+    else
+    {
+        float peak = sqrtf(fabsf(delta) * jerk);
+        add_segment(planner, peak / jerk, 0.f, sign * jerk);
+        add_segment(planner, peak / jerk, sign * peak, -sign * jerk);
+    }
+
+    // Land exactly on the velocity, whatever was rounded on the way
+    planner->state.velocity = velocity;
+    planner->state.acceleration = 0.f;
+}
+
+static float change_time(const axis_planner_t *planner, float delta)
+{
+    float acceleration = planner->limits.acceleration;
+    float jerk = planner->limits.jerk;
+
+    delta = fabsf(delta);
+
+    if (planner->type == MOTION_PROFILE_TRAPEZOIDAL)
+        return delta / acceleration;
+    if (delta >= acceleration * acceleration / jerk)
+        return delta / acceleration + acceleration / jerk;
+    return 2.f * sqrtf(delta / jerk);
+}
+
+// Both velocity changes are point symmetric in time, so the mean velocity
+// over one is the mean of its ends
+static float change_distance(const axis_planner_t *planner, float from, float to)
+{
+    return .5f * (from + to) * change_time(planner, to - from);
+}
+
+static void evaluate(const motion_segment_t *segment, float time, axis_state_t *state)
+{
+    float t = time - segment->start;
+    float jerk = segment->jerk;
+    const axis_state_t *start = &segment->state;
+
+    state->position = start->position + t * (start->velocity + t * (.5f * start->acceleration + t * jerk * (1.f / 6.f)));
+    state->velocity = start->velocity + t * (start->acceleration + .5f * t * jerk);
+    state->acceleration = start->acceleration + t * jerk;
+}
+
+// Just before `time`, so a boundary gives the acceleration of the segment it ends
+static float axis_acceleration(const motion_axis_profile_t *axis, float time)
+{
+    int k = 0;
+    axis_state_t state;
+
+    if (axis->count == 0 || time > axis->duration)
+        return 0.f;
+
+    while (k + 1 < axis->count && axis->segments[k + 1].start < time)
+        k++;
+
+    evaluate(&axis->segments[k], time, &state);
+    return state.acceleration;
+}
@@ -0,0 +1,78 @@
+#ifndef __MOTION_PROFILE_H__
+#define __MOTION_PROFILE_H__
+
+#include <stdbool.h>
+
+#define MOTION_PROFILE_AXES 2
+#define MOTION_PROFILE_AZIMUTH 0
+#define MOTION_PROFILE_INCLINATION 1
+// Acceleration ramp down, stop, then three velocity changes and a cruise
+#define MOTION_PROFILE_MAX_SEGMENTS 11
+
+typedef enum motion_profile_type_t
+{
+    // Acceleration limited, the acceleration steps between segments
+    MOTION_PROFILE_TRAPEZOIDAL,
+    // Jerk limited, the acceleration ramps between segments
+    MOTION_PROFILE_S_CURVE,
+} motion_profile_type_t;
+
+typedef struct motion_limits_t
+{
+    float velocity;
+    float acceleration;
+    float jerk;
+} motion_limits_t;
+
+typedef struct axis_state_t
+{
+    float position;
+    float velocity;
+    float acceleration;
+} axis_state_t;
+
+// Constant jerk from `start` (s after the plan) until the next segment
+typedef struct motion_segment_t
+{
+    float start;
+    axis_state_t state;
+    float jerk;
+} motion_segment_t;
+
+typedef struct motion_axis_profile_t
+{
+    motion_segment_t segments[MOTION_PROFILE_MAX_SEGMENTS];
+    int count;
+    float duration;
+    float target;
+    // Segment found by the last sample, the next one searches from there
+    int cursor;
+} motion_axis_profile_t;
+
+typedef struct motion_profile_t
+{
+    motion_profile_type_t type;
+    motion_axis_profile_t axes[MOTION_PROFILE_AXES];
+    // Both axes arrive together at the end of it
+    float duration;
+} motion_profile_t;
+
+/**
+ * Plans a move of every axis from `start` to rest at `target`. The axis that
+ * would arrive first is slowed down so that both arrive together. A moving
+ * axis keeps its direction when it can stop in time, otherwise it stops first.
+ */
+void motion_profile_plan(motion_profile_t *profile, motion_profile_type_t type, const motion_limits_t limits[MOTION_PROFILE_AXES],
+                         const axis_state_t start[MOTION_PROFILE_AXES], const float target[MOTION_PROFILE_AXES]);
+// State of every axis `time` seconds after the plan
+void motion_profile_sample(motion_profile_t *profile, float time, axis_state_t states[MOTION_PROFILE_AXES]);
+/**
+ * End of a linear ramp starting `time` seconds after the plan, at least
+ * `spacing` seconds long: the first segment boundary of any axis, or the end
+ * of the move, brought closer so that no axis strays more than `tolerance`
+ * from the line between the two samples.
+ */
+float motion_profile_next_breakpoint(const motion_profile_t *profile, float time, float spacing, float tolerance);
+const char *motion_profile_type_name(motion_profile_type_t type);
+
+#endif // __MOTION_PROFILE_H__
@@ -0,0 +1,221 @@
+#include <driver/timer.h>
+#include <esp_attr.h>
+#include <esp_timer.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "motion_queue.h"
+
+#define EXECUTOR_TIMER_GROUP TIMER_GROUP_0
+#define EXECUTOR_TIMER TIMER_0
+// 80 MHz APB clock down to 1 MHz, so that the alarm counts microseconds
+#define EXECUTOR_TIMER_DIVIDER 80
+
+static bool IRAM_ATTR notify_executor(void *arg);
+static void execute(void *params);
+
+void motion_queue_init(motion_queue_t *queue, const float position[MOTORS_AXES], uint32_t period_us, motion_queue_output_t output, void *context)
+{
+    memset(queue, 0, sizeof(*queue));
+    memcpy(queue->position, position, sizeof(queue->position));
+    memcpy(queue->from, position, sizeof(queue->from));
+    queue->idle = true;
+    queue->period_us = period_us;
+    queue->output = output;
+    queue->context = context;
+}
+
+bool motion_queue_push(motion_queue_t *queue, const motion_queue_segment_t *segment)
+{
+    uint32_t head = atomic_load(&queue->head);
+
+    if (head - atomic_load(&queue->tail) >= MOTION_QUEUE_CAPACITY)
+        return false;
+
+    queue->segments[head % MOTION_QUEUE_CAPACITY] = *segment;
+    atomic_store(&queue->head, head + 1);
+    return true;
+}
+
+uint32_t motion_queue_length(motion_queue_t *queue)
+{
+    uint32_t head = atomic_load(&queue->head);
+    uint32_t tail = atomic_load(&queue->tail);
+    uint32_t flush_to = atomic_load(&queue->flush_to);
+
+    // A flush the executor did not see yet already emptied the queue
+    if ((int32_t)(flush_to - tail) > 0)
+        tail = flush_to;
+
+    return head - tail;
+}
+
+float motion_queue_push_profile(motion_queue_t *queue, motion_profile_t *profile, float time, float until, float tolerance)
+{
+    float period = queue->period_us * 1e-6f;
+
+    while (time < profile->duration && time < until)
+    {
+        float breakpoint = motion_profile_next_breakpoint(profile, time, period, tolerance);
+        motion_queue_segment_t segment = {
+            .ticks = lroundf(fmaxf((breakpoint - time) / period, 1.f)),
+        };
+        axis_state_t states[MOTION_PROFILE_AXES];
+
+        motion_profile_sample(profile, time + segment.ticks * period, states);
+        segment.end[MOTOR_AZIMUTH] = states[MOTION_PROFILE_AZIMUTH].position;
+        segment.end[MOTOR_INCLINATION] = states[MOTION_PROFILE_INCLINATION].position;
+        segment.last = time + segment.ticks * period >= profile->duration;
+
+        if (!motion_queue_push(queue, &segment))
+            break;
+        time += segment.ticks * period;
+    }
+
+    return time;
+}
+
+void motion_queue_flush(motion_queue_t *queue)
+{
+    atomic_store(&queue->flush_to, atomic_load(&queue->head));
+    atomic_fetch_add(&queue->flushes, 1);
+}
+
+void motion_queue_tick(motion_queue_t *queue, int64_t fired_at)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t flushes = atomic_load(&queue->flushes);
+    uint32_t energize = 0;
+
+    if (flushes != queue->flushes_seen)
+    {
+        uint32_t flush_to = atomic_load(&queue->flush_to);
+
+        // The segment being executed may have been pushed after the flush
+        queue->flushes_seen = flushes;
+        if (queue->running && (int32_t)(queue->index - flush_to) < 0)
+        {
+            queue->running = false;
+            memcpy(queue->from, queue->position, sizeof(queue->from));
+        }
+        if ((int32_t)(flush_to - atomic_load(&queue->tail)) > 0)
+            atomic_store(&queue->tail, flush_to);
+        queue->idle = !queue->running;
+    }
+
+    if (!queue->running)
+    {
+        uint32_t tail = atomic_load(&queue->tail);
+
+        if (tail != atomic_load(&queue->head))
+        {
+            queue->current = queue->segments[tail % MOTION_QUEUE_CAPACITY];
+            queue->index = tail;
+            atomic_store(&queue->tail, tail + 1);
+            queue->running = true;
+            queue->idle = false;
+            queue->tick = 0;
+            energize = queue->current.energize;
+        }
+        else if (!queue->idle)
+        {
+            queue->stats.underruns++;
+        }
+    }
+
+    if (queue->running)
+    {
+        uint32_t ticks = queue->current.ticks > 0 ? queue->current.ticks : 1;
+        float progress = (float)++queue->tick / ticks;
+
+        for (int axis = 0; axis < MOTORS_AXES; axis++)
+            queue->position[axis] = queue->from[axis] + (queue->current.end[axis] - queue->from[axis]) * progress;
+
+        if (queue->tick >= ticks)
+        {
+            queue->running = false;
+            queue->idle = queue->current.last;
+            memcpy(queue->position, queue->current.end, sizeof(queue->position));
+            memcpy(queue->from, queue->current.end, sizeof(queue->from));
+        }
+    }
+
+    queue->output(queue->position, energize, queue->context);
+
+    if (queue->stats.ticks > 0)
+    {
+        int64_t jitter = llabs(now - queue->output_at - queue->period_us);
+        queue->stats.jitter_sum += jitter;
+        if (jitter > queue->stats.jitter_max)
+            queue->stats.jitter_max = jitter;
+    }
+    queue->stats.latency_sum += now - fired_at;
+    if (now - fired_at > queue->stats.latency_max)
+        queue->stats.latency_max = now - fired_at;
+    queue->stats.ticks++;
+    queue->output_at = now;
+}
+
+esp_err_t motion_queue_start(motion_queue_t *queue, BaseType_t core)
+{
+    timer_config_t timer_config = {
+        .alarm_en = TIMER_ALARM_EN,
+        .counter_en = TIMER_PAUSE,
+        .intr_type = TIMER_INTR_LEVEL,
+        .counter_dir = TIMER_COUNT_UP,
+        .auto_reload = TIMER_AUTORELOAD_EN,
+        .divider = EXECUTOR_TIMER_DIVIDER,
+    };
+    esp_err_t result;
+
+    // Above the Wi-Fi and esp_timer tasks, on the other core when there is one
+    if (xTaskCreatePinnedToCore(execute, "Motion queue", 4096, queue, configMAX_PRIORITIES - 1, &queue->task, core) != pdPASS)
+        return ESP_ERR_NO_MEM;
+
+    if ((result = timer_init(EXECUTOR_TIMER_GROUP, EXECUTOR_TIMER, &timer_config)) != ESP_OK ||
+        (result = timer_set_counter_value(EXECUTOR_TIMER_GROUP, EXECUTOR_TIMER, 0)) != ESP_OK ||
+        (result = timer_set_alarm_value(EXECUTOR_TIMER_GROUP, EXECUTOR_TIMER, queue->period_us)) != ESP_OK ||
+        (result = timer_isr_callback_add(EXECUTOR_TIMER_GROUP, EXECUTOR_TIMER, notify_executor, queue, ESP_INTR_FLAG_IRAM)) != ESP_OK ||
+        (result = timer_start(EXECUTOR_TIMER_GROUP, EXECUTOR_TIMER)) != ESP_OK)
+    {
+        vTaskDelete(queue->task);
+        queue->task = NULL;
+        return result;
+    }
+
+    return ESP_OK;
+}
+
+void motion_queue_stop(motion_queue_t *queue)
+{
+    if (queue->task == NULL)
+        return;
+
+    timer_pause(EXECUTOR_TIMER_GROUP, EXECUTOR_TIMER);
+    timer_isr_callback_remove(EXECUTOR_TIMER_GROUP, EXECUTOR_TIMER);
+    timer_deinit(EXECUTOR_TIMER_GROUP, EXECUTOR_TIMER);
+    vTaskDelete(queue->task);
+    queue->task = NULL;
+}
+
+static bool IRAM_ATTR notify_executor(void *arg)
+{
+    motion_queue_t *queue = arg;
+    BaseType_t woken = pdFALSE;
+
+    queue->fired_at = esp_timer_get_time();
+    vTaskNotifyGiveFromISR(queue->task, &woken);
+
+    return woken == pdTRUE;
+}
+
+static void execute(void *params)
+{
+    motion_queue_t *queue = params;
+
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        motion_queue_tick(queue, queue->fired_at);
+    }
+}
@@ -0,0 +1,106 @@
+#ifndef __MOTION_QUEUE_H__
+#define __MOTION_QUEUE_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include "actuator.h"
+#include "motion_profile.h"
+
+// Segments waiting at most, a power of two
+#define MOTION_QUEUE_CAPACITY 32
+
+typedef struct motion_queue_segment_t
+{
+    // Angles (degree) at the end of the segment, ramped linearly from where
+    // the previous one ended
+    float end[MOTORS_AXES];
+    // Duration, in executor periods
+    uint32_t ticks;
+    // Bits (1 << axis) of the axes energized as the segment starts
+    uint32_t energize;
+    // The move ends with this segment, running dry after it is no underrun
+    bool last;
+} motion_queue_segment_t;
+
+/**
+ * Called by the executor every period with the angles to command. `energize`
+ * is only set on the first period of a segment.
+ */
+typedef void (*motion_queue_output_t)(const float angles[MOTORS_AXES], uint32_t energize, void *context);
+
+typedef struct motion_queue_stats_t
+{
+    uint32_t ticks;
+    // Periods without a segment in the middle of a move
+    uint32_t underruns;
+    // Deviation (us) of the interval between two outputs from the period
+    int64_t jitter_max;
+    int64_t jitter_sum;
+    // Delay (us) from the timer interrupt to the output
+    int64_t latency_max;
+    int64_t latency_sum;
+} motion_queue_stats_t;
+
+/**
+ * Single producer, single consumer: the control task pushes and flushes,
+ * the executor pops. Indices run freely and wrap at the capacity.
+ */
+typedef struct motion_queue_t
+{
+    motion_queue_segment_t segments[MOTION_QUEUE_CAPACITY];
+    atomic_uint head;
+    atomic_uint tail;
+    // A flush drops the segments up to `flush_to`, the head when it was requested
+    atomic_uint flush_to;
+    atomic_uint flushes;
+    uint32_t flushes_seen;
+
+    // Executor state: the commanded angles, the segment being executed, a
+    // copy as its slot is reused once popped, where it started and how far
+    // into it
+    float position[MOTORS_AXES];
+    motion_queue_segment_t current;
+    uint32_t index;
+    bool running;
+    float from[MOTORS_AXES];
+    uint32_t tick;
+    bool idle;
+
+    uint32_t period_us;
+    motion_queue_output_t output;
+    void *context;
+    TaskHandle_t task;
+    volatile int64_t fired_at;
+    int64_t output_at;
+    motion_queue_stats_t stats;
+} motion_queue_t;
+
+void motion_queue_init(motion_queue_t *queue, const float position[MOTORS_AXES], uint32_t period_us, motion_queue_output_t output, void *context);
+// Returns false when the queue is full
+bool motion_queue_push(motion_queue_t *queue, const motion_queue_segment_t *segment);
+// Segments waiting, the one being executed excluded
+uint32_t motion_queue_length(motion_queue_t *queue);
+/**
+ * Queues the motion profile from `time` up to `until` (s into it) as linear
+ * segments straying at most `tolerance` (degree) from it, or as far as the
+ * queue has room. Returns the time queued up to, `time` plus whole periods.
+ */
+float motion_queue_push_profile(motion_queue_t *queue, motion_profile_t *profile, float time, float until, float tolerance);
+// Drops the waiting segments and the one being executed, which stops where it is
+void motion_queue_flush(motion_queue_t *queue);
+// One executor period, `fired_at` being when it was due (esp_timer_get_time())
+void motion_queue_tick(motion_queue_t *queue, int64_t fired_at);
+/**
+ * Starts the executor: a hardware timer interrupt every period wakes a task
+ * of the highest priority, pinned to `core`, that runs motion_queue_tick.
+ * The interrupt does no floating point work, which the ESP32 does not allow
+ * there.
+ */
+esp_err_t motion_queue_start(motion_queue_t *queue, BaseType_t core);
+void motion_queue_stop(motion_queue_t *queue);
+
+#endif // __MOTION_QUEUE_H__
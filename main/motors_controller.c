@@ -1,108 +1,182 @@
-#include <driver/ledc.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <math.h>
+#include <nvs.h>
 #include "motors_controller.h"
 
-static const float azimuth_0_degrees_duty_cycle = .02f;
-static const float azimuth_360_degrees_duty_cycle = .12f;
-static const float inclination_0_degrees_duty_cycle = .02f;
-static const float inclination_180_degrees_duty_cycle = .12f;
+#define PWM_FREQUENCY 50
+#define CALIBRATION_NAMESPACE "motors"
+// Target change (degree) that needs a gated axis energized
+#define MOTORS_ANGLE_EPSILON .01f
 
-static orientation_t current_orientation = {
-    .azimuth = 1000.f,
-    .inclination = 1000.f,
+static const char *calibration_keys[MOTORS_AXES] = {
+    [MOTOR_AZIMUTH] = "azimuth",
+    [MOTOR_INCLINATION] = "inclination",
 };
 
-static unsigned int target_duty_azimuth(float azimuth);
-static unsigned int target_duty_inclination(float inclination);
+static actuator_t actuator;
+
+static servo_calibration_t load_calibration(motor_axis_t axis, servo_calibration_t fallback);
 
 void motors_init(
     gpio_num_t azimuth_enable_gpio, gpio_num_t inclination_enable_gpio,
     gpio_num_t azimuth_pwm_gpio, gpio_num_t inclination_pwm_gpio)
 {
     ESP_LOGI("Motors", "Initializing...");
-    gpio_config_t enable_gpio_config = {
-        .pin_bit_mask = BIT(azimuth_enable_gpio) | BIT(inclination_enable_gpio),
-        .mode = GPIO_MODE_OUTPUT,
-        .pull_up_en = GPIO_PULLUP_DISABLE,
-        .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
-    };
-    ledc_timer_config_t timer_config = {
-        .speed_mode = LEDC_HIGH_SPEED_MODE,
-        .duty_resolution = LEDC_TIMER_10_BIT,
-        .timer_num = LEDC_TIMER_0,
-        .freq_hz = 50,
-    };
-    ledc_channel_config_t azimuth_channel_config = {
-        .gpio_num = azimuth_pwm_gpio,
-        .speed_mode = LEDC_HIGH_SPEED_MODE,
-        .channel = LEDC_CHANNEL_0,
-        .intr_type = LEDC_INTR_DISABLE,
-        .timer_sel = LEDC_TIMER_0,
-        .hpoint = 0,
-    };
-    ledc_channel_config_t inclination_channel_config = {
-        .gpio_num = inclination_pwm_gpio,
-        .speed_mode = LEDC_HIGH_SPEED_MODE,
-        .channel = LEDC_CHANNEL_1,
-        .intr_type = LEDC_INTR_DISABLE,
-        .timer_sel = LEDC_TIMER_0,
-        .hpoint = 0,
+    actuator_config_t config = {
+        .enable_gpio = {azimuth_enable_gpio, inclination_enable_gpio},
+        .pwm_gpio = {azimuth_pwm_gpio, inclination_pwm_gpio},
+        .frequency = PWM_FREQUENCY,
+        // Ideal servos over 0.4 to 2.4 ms until calibrated, the azimuth one reversed
+        .calibrations = {
+            load_calibration(MOTOR_AZIMUTH, servo_calibration_linear(0.f, 2400.f, 180.f, 400.f)),
+            load_calibration(MOTOR_INCLINATION, servo_calibration_linear(-90.f, 400.f, 90.f, 2400.f)),
+        },
     };
 
-    ESP_ERROR_CHECK(gpio_config(&enable_gpio_config));
-    ESP_ERROR_CHECK(gpio_set_level(azimuth_enable_gpio, 1));
-    ESP_ERROR_CHECK(gpio_set_level(inclination_enable_gpio, 1));
-    ESP_ERROR_CHECK(ledc_timer_config(&timer_config));
-    ESP_ERROR_CHECK(ledc_channel_config(&azimuth_channel_config));
-    ESP_ERROR_CHECK(ledc_channel_config(&inclination_channel_config));
-    ESP_LOGI("Motors", "Initialized.");
+    ESP_ERROR_CHECK(actuator_init(&actuator, &ACTUATOR_BACKEND, &config, NULL));
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+        ESP_ERROR_CHECK(actuator_set_power(&actuator, axis, true));
+    ESP_LOGI("Motors", "Initialized, %s backend.", actuator.ops->name);
 }
 
 void motors_rotate(orientation_t orientation)
 {
-    bool is_dirty = false;
+    actuator_set_position(&actuator, MOTOR_AZIMUTH, orientation.azimuth);
+    actuator_set_position(&actuator, MOTOR_INCLINATION, orientation.inclination);
+}
 
-    if (fabs(orientation.azimuth - current_orientation.azimuth) > .01f)
-    {
-        ledc_set_duty(
-            LEDC_HIGH_SPEED_MODE,
-            LEDC_CHANNEL_0,
-            target_duty_azimuth(orientation.azimuth));
-        ledc_update_duty(
-            LEDC_HIGH_SPEED_MODE,
-            LEDC_CHANNEL_0);
-
-        is_dirty = true;
-    }
+void motors_set_velocity_limit(motor_axis_t axis, float velocity_limit)
+{
+    actuator_set_velocity_limit(&actuator, axis, velocity_limit);
+}
+
+void motors_set_power_gating(float settle_time, uint32_t pre_pulse_ms)
+{
+    actuator_set_power_gating(&actuator, settle_time, pre_pulse_ms);
+}
+
+int64_t motors_prepare_move(orientation_t orientation)
+{
+    float targets[MOTORS_AXES] = {
+        [MOTOR_AZIMUTH] = orientation.azimuth,
+        [MOTOR_INCLINATION] = orientation.inclination,
+    };
+    int64_t ready_at = esp_timer_get_time();
 
-    if (fabs(orientation.inclination - current_orientation.inclination) > .01f)
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
     {
-        ledc_set_duty(
-            LEDC_HIGH_SPEED_MODE,
-            LEDC_CHANNEL_1,
-            target_duty_inclination(orientation.inclination));
-        ledc_update_duty(
-            LEDC_HIGH_SPEED_MODE,
-            LEDC_CHANNEL_1);
-
-        is_dirty = true;
+        if (!actuator.channels[axis].powered && !(fabsf(targets[axis] - actuator.channels[axis].angle) <= MOTORS_ANGLE_EPSILON))
+        {
+            int64_t axis_ready_at = actuator_energize(&actuator, axis);
+
+            if (axis_ready_at > ready_at)
+                ready_at = axis_ready_at;
+        }
     }
 
-    if (is_dirty)
+    return ready_at;
+}
+
+void motors_set_power(motor_axis_t axis, bool on)
+{
+    actuator_set_power(&actuator, axis, on);
+}
+
+bool motors_is_energized(motor_axis_t axis)
+{
+    return actuator.channels[axis].powered;
+}
+
+void motors_update_power()
+{
+    actuator_update_power(&actuator);
+}
+
+float motors_energized_seconds(motor_axis_t axis)
+{
+    return actuator_energized_seconds(&actuator, axis);
+}
+
+void motors_fade_init(TaskHandle_t task)
+{
+    ESP_ERROR_CHECK(actuator_fade_init(&actuator, task));
+    ESP_LOGI("Motors", "Hardware fade installed.");
+}
+
+uint32_t motors_fade(orientation_t orientation, uint32_t duration_ms)
+{
+    uint32_t fading = 0;
+
+    if (actuator_fade(&actuator, MOTOR_AZIMUTH, orientation.azimuth, duration_ms))
+        fading |= MOTORS_FADE_AZIMUTH;
+    if (actuator_fade(&actuator, MOTOR_INCLINATION, orientation.inclination, duration_ms))
+        fading |= MOTORS_FADE_INCLINATION;
+
+    return fading;
+}
+
+const servo_calibration_t *motors_calibration(motor_axis_t axis)
+{
+    return &actuator.channels[axis].calibration;
+}
+
+bool motors_set_calibration(motor_axis_t axis, const servo_calibration_t *calibration)
+{
+    if (!servo_calibration_is_valid(calibration))
     {
-        current_orientation = orientation;
-        // ESP_LOGI("Motors", "New orientation: (%6.3f, %6.3f)", orientation.azimuth, orientation.inclination);
+        ESP_LOGW("Motors", "Invalid %s calibration.", calibration_keys[axis]);
+        return false;
     }
+
+    actuator_set_calibration(&actuator, axis, calibration);
+    return true;
 }
 
-static unsigned int target_duty_azimuth(float azimuth)
+bool motors_store_calibration(motor_axis_t axis, const servo_calibration_t *calibration)
 {
-    return 1024.f * (azimuth_360_degrees_duty_cycle - (azimuth / 180.f) * (azimuth_360_degrees_duty_cycle - azimuth_0_degrees_duty_cycle));
+    nvs_handle_t handle;
+    esp_err_t result;
+
+    if (!servo_calibration_is_valid(calibration))
+        return false;
+
+    result = nvs_open(CALIBRATION_NAMESPACE, NVS_READWRITE, &handle);
+    if (result == ESP_OK)
+    {
+        result = nvs_set_blob(handle, calibration_keys[axis], calibration, sizeof(*calibration));
+        if (result == ESP_OK)
+            result = nvs_commit(handle);
+        nvs_close(handle);
+    }
+
+    if (result != ESP_OK)
+    {
+        ESP_LOGW("Motors", "Could not store the %s calibration: %s", calibration_keys[axis], esp_err_to_name(result));
+        return false;
+    }
+
+    ESP_LOGI("Motors", "Stored the %s calibration, %d points.", calibration_keys[axis], calibration->count);
+    return true;
 }
 
-static unsigned int target_duty_inclination(float inclination)
+static servo_calibration_t load_calibration(motor_axis_t axis, servo_calibration_t fallback)
 {
-    return 1024.f * (inclination_0_degrees_duty_cycle + (inclination / 180.f + .5f) * (inclination_180_degrees_duty_cycle - inclination_0_degrees_duty_cycle));
+    nvs_handle_t handle;
+    servo_calibration_t calibration;
+    size_t size = sizeof(calibration);
+    bool loaded = false;
+
+    if (nvs_open(CALIBRATION_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+        return fallback;
+
+    if (nvs_get_blob(handle, calibration_keys[axis], &calibration, &size) == ESP_OK &&
+        size == sizeof(calibration) && servo_calibration_is_valid(&calibration))
+    {
+        loaded = true;
+        ESP_LOGI("Motors", "Loaded the %s calibration, %d points.", calibration_keys[axis], calibration.count);
+    }
+
+    nvs_close(handle);
+    return loaded ? calibration : fallback;
 }
@@ -2,11 +2,44 @@
 #define __MOTORS_CONTROLLER_H__
 
 #include <driver/gpio.h>
+#include "actuator.h"
 #include "types.h"
 
 void motors_init(
     gpio_num_t azimuth_enable_gpio, gpio_num_t inclination_enable_gpio,
     gpio_num_t azimuth_pwm_gpio, gpio_num_t inclination_pwm_gpio);
 void motors_rotate(orientation_t orientation);
+// Degree per second a position command may move an axis, 0 for none
+void motors_set_velocity_limit(motor_axis_t axis, float velocity_limit);
+/**
+ * De-energizes an axis once it held still for `settle_time` seconds, and
+ * gives it `pre_pulse_ms` of its current pulse when energized again. 0 s
+ * keeps both axes energized.
+ */
+void motors_set_power_gating(float settle_time, uint32_t pre_pulse_ms);
+/**
+ * Energizes the axes that have to move to reach `orientation`. Returns when
+ * (esp_timer_get_time()) they can start moving.
+ */
+int64_t motors_prepare_move(orientation_t orientation);
+void motors_set_power(motor_axis_t axis, bool on);
+bool motors_is_energized(motor_axis_t axis);
+// Call periodically, de-energizes the settled axes
+void motors_update_power();
+float motors_energized_seconds(motor_axis_t axis);
+// Installs the hardware fade engine, `task` is notified as each fade ends
+void motors_fade_init(TaskHandle_t task);
+/**
+ * Hands a move to the hardware fade engine: both motors ramp linearly to
+ * `orientation` in `duration_ms`, without the CPU. Returns the notification
+ * bits of the axes that fade, 0 when neither has to move.
+ */
+uint32_t motors_fade(orientation_t orientation, uint32_t duration_ms);
+
+const servo_calibration_t *motors_calibration(motor_axis_t axis);
+// Applies a calibration table, false when it is not valid
+bool motors_set_calibration(motor_axis_t axis, const servo_calibration_t *calibration);
+// Stores a calibration table in NVS, where motors_init loads it from
+bool motors_store_calibration(motor_axis_t axis, const servo_calibration_t *calibration);
 
 #endif // __MOTORS_CONTROLLER_H__
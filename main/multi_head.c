@@ -0,0 +1,176 @@
+#include <esp_timer.h>
+#include <math.h>
+#include <string.h>
+#include "multi_head.h"
+
+#define MULTI_HEAD_REST_AZIMUTH 90.f
+#define MULTI_HEAD_REST_INCLINATION 0.f
+
+static float step_toward(float position, float target, float step);
+
+multi_head_config_t multi_head_default_config(int head_count, motion_profile_type_t type, const motion_limits_t limits[MOTION_PROFILE_AXES])
+{
+    multi_head_config_t config = {
+        .head_count = head_count,
+        .expander_count = (head_count * MOTORS_AXES + PCA9685_CHANNELS - 1) / PCA9685_CHANNELS,
+        .frequency = 50.f,
+        .velocity_limit = limits[MOTION_PROFILE_AZIMUTH].velocity,
+        .planner = path_planner_default_config(type, limits),
+    };
+
+    for (int expander = 0; expander < MULTI_HEAD_MAX_EXPANDERS; expander++)
+        config.addresses[expander] = PCA9685_ADDRESS + expander;
+
+    for (int head = 0; head < MULTI_HEAD_MAX_HEADS; head++)
+    {
+        int channel = head * MOTORS_AXES;
+
+        config.heads[head] = (multi_head_head_config_t){
+            .expander = channel / PCA9685_CHANNELS,
+            .channels = {channel % PCA9685_CHANNELS, channel % PCA9685_CHANNELS + 1},
+            .calibrations = {
+                servo_calibration_linear(0.f, 2400.f, 180.f, 400.f),
+                servo_calibration_linear(-90.f, 400.f, 90.f, 2400.f),
+            },
+            .mounting = QUATERNION_IDENTITY,
+        };
+    }
+
+    return config;
+}
+
+esp_err_t multi_head_init(multi_head_t *multi_head, i2c_bus_t *bus, const multi_head_config_t *config)
+{
+    if (!bus || config->head_count < 1 || config->head_count > MULTI_HEAD_MAX_HEADS ||
+        config->expander_count < 1 || config->expander_count > MULTI_HEAD_MAX_EXPANDERS)
+        return ESP_ERR_INVALID_ARG;
+
+    for (int head = 0; head < config->head_count; head++)
+    {
+        const multi_head_head_config_t *head_config = &config->heads[head];
+
+        if (head_config->expander >= config->expander_count ||
+            head_config->channels[MOTOR_AZIMUTH] >= PCA9685_CHANNELS || head_config->channels[MOTOR_INCLINATION] >= PCA9685_CHANNELS)
+            return ESP_ERR_INVALID_ARG;
+    }
+
+    memset(multi_head, 0, sizeof(*multi_head));
+    multi_head->config = *config;
+    multi_head->bus = bus;
+
+    for (int expander = 0; expander < config->expander_count; expander++)
+    {
+        esp_err_t result = pca9685_init(&multi_head->expanders[expander], bus, config->addresses[expander], config->frequency);
+
+        if (result != ESP_OK)
+            return result;
+    }
+
+    for (int head = 0; head < config->head_count; head++)
+    {
+        multi_head_head_t *state = &multi_head->heads[head];
+
+        compensation_init(&state->compensation, 0.f);
+        compensation_set_platform_rotation(&state->compensation, config->heads[head].mounting);
+        path_planner_init(&state->planner, &config->planner);
+        state->motors = (orientation_t){MULTI_HEAD_REST_AZIMUTH, MULTI_HEAD_REST_INCLINATION};
+        state->target = state->motors;
+    }
+
+    return ESP_OK;
+}
+
+void multi_head_set_mounting(multi_head_t *multi_head, int head, quaternion_t mounting)
+{
+    multi_head->config.heads[head].mounting = mounting;
+    compensation_set_platform_rotation(&multi_head->heads[head].compensation, mounting);
+}
+
+void multi_head_set_calibration(multi_head_t *multi_head, int head, motor_axis_t axis, const servo_calibration_t *calibration)
+{
+    multi_head->config.heads[head].calibrations[axis] = *calibration;
+}
+
+void multi_head_set_sun(multi_head_t *multi_head, orientation_t sun)
+{
+    int64_t begin = esp_timer_get_time();
+
+    for (int head = 0; head < multi_head->config.head_count; head++)
+    {
+        multi_head_head_t *state = &multi_head->heads[head];
+        orientation_t orientation = compensation_apply(&state->compensation, sun, state->motors.azimuth);
+        axis_state_t current[MOTION_PROFILE_AXES] = {
+            [MOTION_PROFILE_AZIMUTH] = {.position = state->motors.azimuth},
+            [MOTION_PROFILE_INCLINATION] = {.position = state->motors.inclination},
+        };
+        orientation_t desired;
+
+        if (path_planner_plan(&state->planner, orientation, current, &desired))
+            state->target = desired;
+    }
+
+    multi_head->stats.plan_time += esp_timer_get_time() - begin;
+}
+
+esp_err_t multi_head_update(multi_head_t *multi_head, float dt)
+{
+    const multi_head_config_t *config = &multi_head->config;
+    float step = config->velocity_limit > 0.f ? config->velocity_limit * dt : INFINITY;
+    float pulse_widths[MULTI_HEAD_MAX_EXPANDERS][PCA9685_CHANNELS];
+    int first[MULTI_HEAD_MAX_EXPANDERS], last[MULTI_HEAD_MAX_EXPANDERS];
+    i2c_bus_transaction_t transactions[MULTI_HEAD_MAX_EXPANDERS];
+    size_t count = 0;
+    int64_t begin = esp_timer_get_time();
+
+    for (int expander = 0; expander < config->expander_count; expander++)
+    {
+        first[expander] = PCA9685_CHANNELS;
+        last[expander] = -1;
+        for (int channel = 0; channel < PCA9685_CHANNELS; channel++)
+            pulse_widths[expander][channel] = NAN;
+    }
+
+    for (int head = 0; head < config->head_count; head++)
+    {
+        const multi_head_head_config_t *head_config = &config->heads[head];
+        multi_head_head_t *state = &multi_head->heads[head];
+        float angles[MOTORS_AXES];
+
+        state->motors.azimuth = step_toward(state->motors.azimuth, state->target.azimuth, step);
+        state->motors.inclination = step_toward(state->motors.inclination, state->target.inclination, step);
+        angles[MOTOR_AZIMUTH] = state->motors.azimuth;
+        angles[MOTOR_INCLINATION] = state->motors.inclination;
+
+        for (int axis = 0; axis < MOTORS_AXES; axis++)
+        {
+            int expander = head_config->expander, channel = head_config->channels[axis];
+
+            pulse_widths[expander][channel] = servo_calibration_pulse_width(&head_config->calibrations[axis], angles[axis]);
+            if (channel < first[expander])
+                first[expander] = channel;
+            if (channel > last[expander])
+                last[expander] = channel;
+        }
+    }
+
+    // Channels between two heads are left as they are
+    for (int expander = 0; expander < config->expander_count; expander++)
+    {
+        if (last[expander] >= 0)
+            pca9685_prepare(&multi_head->expanders[expander], first[expander], last[expander] - first[expander] + 1,
+                            &pulse_widths[expander][first[expander]], &transactions[count++]);
+    }
+
+    esp_err_t result = i2c_bus_execute(multi_head->bus, transactions, count, I2C_BUS_PRIORITY_NORMAL);
+
+    multi_head->stats.updates++;
+    if (result != ESP_OK)
+        multi_head->stats.errors++;
+    multi_head->stats.write_time += esp_timer_get_time() - begin;
+    return result;
+}
+
+static float step_toward(float position, float target, float step)
+{
+    return fabsf(target - position) <= step ? target : position + copysignf(step, target - position);
+}
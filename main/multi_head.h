@@ -0,0 +1,90 @@
+#ifndef __MULTI_HEAD_H__
+#define __MULTI_HEAD_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <pca9685.h>
+#include "actuator.h"
+#include "compensation.h"
+#include "path_planner.h"
+#include "servo_calibration.h"
+#include "types.h"
+
+#define MULTI_HEAD_MAX_HEADS 16
+#define MULTI_HEAD_MAX_EXPANDERS 4
+
+typedef struct multi_head_head_config_t
+{
+    // Expander, by index in the addresses, and its channel for each axis
+    uint8_t expander;
+    uint8_t channels[MOTORS_AXES];
+    servo_calibration_t calibrations[MOTORS_AXES];
+    // Rotation of the head base, from its frame to the world frame
+    quaternion_t mounting;
+} multi_head_head_config_t;
+
+typedef struct multi_head_config_t
+{
+    int head_count;
+    int expander_count;
+    uint8_t addresses[MULTI_HEAD_MAX_EXPANDERS];
+    // Servo pulse frequency (Hz)
+    float frequency;
+    // Degree per second each axis steps toward its target, 0 for none
+    float velocity_limit;
+    path_planner_config_t planner;
+    multi_head_head_config_t heads[MULTI_HEAD_MAX_HEADS];
+} multi_head_config_t;
+
+typedef struct multi_head_head_t
+{
+    compensation_t compensation;
+    path_planner_t planner;
+    // Motors rotation planned toward the sun, and the one commanded
+    orientation_t target;
+    orientation_t motors;
+} multi_head_head_t;
+
+typedef struct multi_head_stats_t
+{
+    uint32_t updates;
+    uint32_t errors;
+    // Time (us) spent compensating and planning every head, and writing the
+    // expanders
+    int64_t plan_time;
+    int64_t write_time;
+} multi_head_stats_t;
+
+typedef struct multi_head_t
+{
+    multi_head_config_t config;
+    i2c_bus_t *bus;
+    pca9685_t expanders[MULTI_HEAD_MAX_EXPANDERS];
+    multi_head_head_t heads[MULTI_HEAD_MAX_HEADS];
+    multi_head_stats_t stats;
+} multi_head_t;
+
+/**
+ * `head_count` heads of two consecutive channels each, the azimuth first,
+ * filling expanders from PCA9685_ADDRESS up, with the motors calibrations by
+ * default and level mountings.
+ */
+multi_head_config_t multi_head_default_config(int head_count, motion_profile_type_t type, const motion_limits_t limits[MOTION_PROFILE_AXES]);
+// Every head starts at azimuth 90 and inclination 0, its outputs off until the first update
+esp_err_t multi_head_init(multi_head_t *multi_head, i2c_bus_t *bus, const multi_head_config_t *config);
+void multi_head_set_mounting(multi_head_t *multi_head, int head, quaternion_t mounting);
+void multi_head_set_calibration(multi_head_t *multi_head, int head, motor_axis_t axis, const servo_calibration_t *calibration);
+/**
+ * Plans every head toward `sun`, computed once for all of them, through its
+ * own mounting compensation and path planner.
+ */
+void multi_head_set_sun(multi_head_t *multi_head, orientation_t sun);
+/**
+ * Steps every head toward its target, `dt` seconds after the previous update,
+ * then writes the channels of each expander in one transaction, all of them
+ * under a single bus lock.
+ */
+esp_err_t multi_head_update(multi_head_t *multi_head, float dt);
+
+#endif // __MULTI_HEAD_H__
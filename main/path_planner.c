@@ -0,0 +1,138 @@
+#include <math.h>
+#include "compensation.h"
+#include "path_planner.h"
+
+#define PI 3.14159265358979323846
+#define rad (PI / 180.f)
+
+typedef struct candidate_t
+{
+    orientation_t motors;
+    float error;
+    float time;
+} candidate_t;
+
+static candidate_t candidate(const path_planner_t *planner, orientation_t orientation, bool flipped);
+static void time_candidate(path_planner_t *planner, candidate_t *candidate, const axis_state_t current[MOTION_PROFILE_AXES]);
+static bool is_better(const path_planner_t *planner, const candidate_t *a, const candidate_t *b);
+
+path_planner_config_t path_planner_default_config(motion_profile_type_t type, const motion_limits_t limits[MOTION_PROFILE_AXES])
+{
+    return (path_planner_config_t){
+        .azimuth_min = 0.f,
+        .azimuth_max = 180.f,
+        .inclination_min = -90.f,
+        .inclination_max = 90.f,
+        .pointing_tolerance = 2.f,
+        .dead_band = .5f,
+        .hysteresis = .5f,
+        .retarget_threshold = .2f,
+        .type = type,
+        .limits = {limits[MOTION_PROFILE_AZIMUTH], limits[MOTION_PROFILE_INCLINATION]},
+    };
+}
+
+void path_planner_init(path_planner_t *planner, const path_planner_config_t *config)
+{
+    *planner = (path_planner_t){
+        .config = *config,
+    };
+}
+
+bool path_planner_plan(path_planner_t *planner, orientation_t orientation, const axis_state_t current[MOTION_PROFILE_AXES], orientation_t *motors)
+{
+    orientation_t position = {
+        .azimuth = current[MOTION_PROFILE_AZIMUTH].position,
+        .inclination = current[MOTION_PROFILE_INCLINATION].position,
+    };
+    bool moving = current[MOTION_PROFILE_AZIMUTH].velocity != 0.f || current[MOTION_PROFILE_INCLINATION].velocity != 0.f;
+
+    if (planner->started && !moving && path_planner_pointing_error(position, orientation) <= planner->config.dead_band)
+        return false;
+
+    candidate_t same = candidate(planner, orientation, planner->flipped);
+
+    // Planning both moves is the costly part, and the choice only changes
+    // once the setpoint moved or the current solution stopped fitting
+    if (!planner->started || same.error > planner->config.pointing_tolerance ||
+        path_planner_pointing_error(orientation, planner->setpoint) > planner->config.retarget_threshold)
+    {
+        candidate_t other = candidate(planner, orientation, !planner->flipped);
+
+        time_candidate(planner, &same, current);
+        time_candidate(planner, &other, current);
+        planner->setpoint = orientation;
+        planner->evaluations++;
+
+        // Stay on the current solution unless the other one is clearly better
+        if (is_better(planner, &other, &same))
+        {
+            if (planner->started)
+                planner->flips++;
+
+            planner->flipped = !planner->flipped;
+            same = other;
+        }
+    }
+
+    planner->started = true;
+    *motors = same.motors;
+    return true;
+}
+
+float path_planner_pointing_error(orientation_t a, orientation_t b)
+{
+    float dot = vector3_dot(compensation_direction(a), compensation_direction(b));
+
+    return acosf(fminf(fmaxf(dot, -1.f), 1.f)) / rad;
+}
+
+// The solution on one branch: the azimuth turn closest to the servo range,
+// clamped into it
+static candidate_t candidate(const path_planner_t *planner, orientation_t orientation, bool flipped)
+{
+    const path_planner_config_t *config = &planner->config;
+    float azimuth = orientation.azimuth + (flipped ? 180.f : 0.f);
+    float inclination = flipped ? -orientation.inclination : orientation.inclination;
+    float middle = .5f * (config->azimuth_min + config->azimuth_max);
+
+    azimuth -= 360.f * roundf((azimuth - middle) / 360.f);
+
+    candidate_t result = {
+        .motors = {
+            .azimuth = fminf(fmaxf(azimuth, config->azimuth_min), config->azimuth_max),
+            .inclination = fminf(fmaxf(inclination, config->inclination_min), config->inclination_max),
+        },
+    };
+    result.error = path_planner_pointing_error(result.motors, orientation);
+
+    return result;
+}
+
+// Only needed to choose between two accurate enough solutions
+static void time_candidate(path_planner_t *planner, candidate_t *candidate, const axis_state_t current[MOTION_PROFILE_AXES])
+{
+    if (candidate->error > planner->config.pointing_tolerance)
+        return;
+
+    float target[MOTION_PROFILE_AXES] = {
+        [MOTION_PROFILE_AZIMUTH] = candidate->motors.azimuth,
+        [MOTION_PROFILE_INCLINATION] = candidate->motors.inclination,
+    };
+    motion_profile_plan(&planner->profile, planner->config.type, planner->config.limits, current, target);
+    candidate->time = planner->profile.duration;
+}
+
+// Within the pointing tolerance the faster move wins, by more than the
+// hysteresis. Otherwise the more accurate one does.
+static bool is_better(const path_planner_t *planner, const candidate_t *a, const candidate_t *b)
+{
+    bool a_fits = a->error <= planner->config.pointing_tolerance;
+    bool b_fits = b->error <= planner->config.pointing_tolerance;
+
+    if (a_fits && b_fits)
+        return a->time + planner->config.hysteresis < b->time;
+    if (a_fits != b_fits)
+        return a_fits;
+    return a->error < b->error;
+}
@@ -0,0 +1,55 @@
+#ifndef __PATH_PLANNER_H__
+#define __PATH_PLANNER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "motion_profile.h"
+#include "types.h"
+
+typedef struct path_planner_config_t
+{
+    // Servo ranges, in degrees
+    float azimuth_min;
+    float azimuth_max;
+    float inclination_min;
+    float inclination_max;
+    // Pointing error (degree) accepted from clamping a solution into the
+    // servo ranges, which lets the inclination swing through the zenith
+    // instead of sweeping the azimuth across its range
+    float pointing_tolerance;
+    // No move while the motors already point this close (degree)
+    float dead_band;
+    // Move time (s) the other solution must save before switching to it
+    float hysteresis;
+    // Setpoint move (degree) that has the two solutions timed again, closer
+    // setpoints stay on the current one
+    float retarget_threshold;
+    motion_profile_type_t type;
+    motion_limits_t limits[MOTION_PROFILE_AXES];
+} path_planner_config_t;
+
+typedef struct path_planner_t
+{
+    path_planner_config_t config;
+    bool started;
+    // On the (azimuth - 180, -inclination) solution
+    bool flipped;
+    uint32_t flips;
+    // Setpoint the solutions were last timed for, and how often they were
+    orientation_t setpoint;
+    uint32_t evaluations;
+    // Scratch profile for timing the candidate moves
+    motion_profile_t profile;
+} path_planner_t;
+
+path_planner_config_t path_planner_default_config(motion_profile_type_t type, const motion_limits_t limits[MOTION_PROFILE_AXES]);
+void path_planner_init(path_planner_t *planner, const path_planner_config_t *config);
+/**
+ * Chooses the motors rotation pointing along `orientation`, from the motors
+ * state `current`. Returns false when the motors should hold still.
+ */
+bool path_planner_plan(path_planner_t *planner, orientation_t orientation, const axis_state_t current[MOTION_PROFILE_AXES], orientation_t *motors);
+// Angle (degree) between where two orientations point
+float path_planner_pointing_error(orientation_t a, orientation_t b);
+
+#endif // __PATH_PLANNER_H__
@@ -0,0 +1,72 @@
+#include <math.h>
+#include <string.h>
+#include "position_loop.h"
+
+position_loop_config_t position_loop_default_config()
+{
+    return (position_loop_config_t){
+        .ki = 1.f,
+        .max_correction = 5.f,
+        .dead_band = .1f,
+        .stall_error = 3.f,
+        .stall_progress = .5f,
+        .stall_time = 1.f,
+    };
+}
+
+void position_loop_init(position_loop_t *loop, const position_loop_config_t *config)
+{
+    memset(loop, 0, sizeof(*loop));
+    loop->config = *config;
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+        loop->axes[axis].anchor = NAN;
+}
+
+uint32_t position_loop_update(position_loop_t *loop, const float targets[MOTORS_AXES], const float measured[MOTORS_AXES],
+                              const bool valid[MOTORS_AXES], const bool settled[MOTORS_AXES], float dt, float commands[MOTORS_AXES])
+{
+    const position_loop_config_t *config = &loop->config;
+    uint32_t stalled = 0;
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        position_loop_axis_t *state = &loop->axes[axis];
+
+        if (valid[axis] && !state->stalled)
+        {
+            state->error = targets[axis] - measured[axis];
+
+            // Far from the target and not getting anywhere
+            if (fabsf(state->error) <= config->stall_error || !(fabsf(measured[axis] - state->anchor) < config->stall_progress))
+            {
+                state->anchor = measured[axis];
+                state->still_time = 0.f;
+            }
+            else if ((state->still_time += dt) >= config->stall_time)
+            {
+                state->stalled = true;
+                state->hold = measured[axis];
+                loop->stalls++;
+                stalled |= 1u << axis;
+            }
+
+            if (settled[axis] && !state->stalled && fabsf(state->error) > config->dead_band)
+            {
+                state->correction += config->ki * state->error * dt;
+                state->correction = fminf(fmaxf(state->correction, -config->max_correction), config->max_correction);
+            }
+        }
+
+        commands[axis] = state->stalled ? state->hold : targets[axis] + state->correction;
+    }
+
+    return stalled;
+}
+
+void position_loop_clear_stall(position_loop_t *loop, int axis)
+{
+    loop->axes[axis].stalled = false;
+    loop->axes[axis].anchor = NAN;
+    loop->axes[axis].still_time = 0.f;
+}
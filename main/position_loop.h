@@ -0,0 +1,58 @@
+#ifndef __POSITION_LOOP_H__
+#define __POSITION_LOOP_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "actuator.h"
+
+typedef struct position_loop_config_t
+{
+    // Integral gain (1/s) on the error of a settled axis, and the largest
+    // correction (degree) it may build up
+    float ki;
+    float max_correction;
+    // Errors (degree) left alone
+    float dead_band;
+    // An axis further than `stall_error` (degree) from its target that does
+    // not move by `stall_progress` (degree) within `stall_time` (s) is stalled
+    float stall_error;
+    float stall_progress;
+    float stall_time;
+} position_loop_config_t;
+
+typedef struct position_loop_axis_t
+{
+    // Added to the target to command the servo
+    float correction;
+    // Target minus measured angle, degree
+    float error;
+    // Where the axis was when it last made progress, and since when
+    float anchor;
+    float still_time;
+    // A stalled axis is held where it stopped instead of pushing on
+    bool stalled;
+    float hold;
+} position_loop_axis_t;
+
+typedef struct position_loop_t
+{
+    position_loop_config_t config;
+    position_loop_axis_t axes[MOTORS_AXES];
+    uint32_t stalls;
+} position_loop_t;
+
+position_loop_config_t position_loop_default_config();
+void position_loop_init(position_loop_t *loop, const position_loop_config_t *config);
+/**
+ * Corrects the commands of the next `dt` seconds from the measured angles.
+ * Only settled axes, done moving and energized, build up their correction.
+ * An axis without a valid measurement is commanded with its last correction.
+ * Returns the bits (1 << axis) of the axes that just stalled. They are
+ * commanded where they stopped until position_loop_clear_stall().
+ */
+uint32_t position_loop_update(position_loop_t *loop, const float targets[MOTORS_AXES], const float measured[MOTORS_AXES],
+                              const bool valid[MOTORS_AXES], const bool settled[MOTORS_AXES], float dt, float commands[MOTORS_AXES]);
+// Call on a new move
+void position_loop_clear_stall(position_loop_t *loop, int axis);
+
+#endif // __POSITION_LOOP_H__
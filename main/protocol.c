@@ -0,0 +1,1866 @@
+// Generated by tools/protocol_gen.py from protocol/schema.json, do not edit.
+#include <math.h>
+#include <string.h>
+#include "protocol.h"
+
+#define JSON_MAX_DEPTH 16
+#define JSON_KEY_IS(key, length, name) ((length) == sizeof(name) - 1 && memcmp(key, name, sizeof(name) - 1) == 0)
+// Mantissa digits kept when reading numbers, more only scale them
+#define JSON_MANTISSA_LIMIT 100000000000000000ULL
+
+typedef struct json_writer_t
+{
+    char *at;
+    char *end;
+    bool failed;
+} json_writer_t;
+
+typedef struct json_reader_t
+{
+    const char *at;
+    const char *end;
+    int depth;
+} json_reader_t;
+
+typedef struct binary_writer_t
+{
+    uint8_t *at;
+    uint8_t *end;
+    bool failed;
+} binary_writer_t;
+
+typedef struct binary_reader_t
+{
+    const uint8_t *at;
+    const uint8_t *end;
+} binary_reader_t;
+
+static void json_write(json_writer_t *writer, const char *text, size_t length);
+static void json_write_key(json_writer_t *writer, bool *first, const char *key, size_t length);
+static void json_write_string(json_writer_t *writer, const char *text);
+static void json_write_float(json_writer_t *writer, float value, int precision);
+static void json_write_integer(json_writer_t *writer, int64_t value);
+static void json_skip_space(json_reader_t *reader);
+static bool json_peek(json_reader_t *reader, char c);
+static bool json_expect(json_reader_t *reader, char c);
+static bool json_begin(json_reader_t *reader, char open, char close, bool *more);
+static bool json_next(json_reader_t *reader, char close, bool *more);
+static bool json_read_string(json_reader_t *reader, const char **text, size_t *length);
+static bool json_read_key(json_reader_t *reader, const char **key, size_t *length);
+static bool json_read_number(json_reader_t *reader, double *value);
+static bool json_read_float(json_reader_t *reader, float *value);
+static bool json_read_u32(json_reader_t *reader, uint32_t *value);
+static bool json_read_i32(json_reader_t *reader, int32_t *value);
+static bool json_read_i64(json_reader_t *reader, int64_t *value);
+static bool json_read_enum(json_reader_t *reader, const char *const *names, int count, int *value);
+static bool json_skip_value(json_reader_t *reader);
+static void binary_write(binary_writer_t *writer, uint64_t value, int size);
+static void binary_write_float(binary_writer_t *writer, float value);
+static bool binary_read(binary_reader_t *reader, int size, uint64_t *value);
+static bool binary_read_u8(binary_reader_t *reader, uint8_t *value);
+static bool binary_read_float(binary_reader_t *reader, float *value);
+static bool binary_read_u32(binary_reader_t *reader, uint32_t *value);
+static bool binary_read_i32(binary_reader_t *reader, int32_t *value);
+static bool binary_read_i64(binary_reader_t *reader, int64_t *value);
+static bool binary_read_enum(binary_reader_t *reader, int count, int *value);
+static bool json_read_app_event(json_reader_t *reader, protocol_app_event_t *value);
+static bool binary_read_app_event(binary_reader_t *reader, protocol_app_event_t *value);
+static bool json_read_control_mode(json_reader_t *reader, protocol_control_mode_t *value);
+static bool binary_read_control_mode(binary_reader_t *reader, protocol_control_mode_t *value);
+static bool json_read_ahrs_engine(json_reader_t *reader, protocol_ahrs_engine_t *value);
+static bool binary_read_ahrs_engine(binary_reader_t *reader, protocol_ahrs_engine_t *value);
+static void encode_json_quaternion(json_writer_t *writer, const quaternion_t *value);
+static bool decode_json_quaternion(json_reader_t *reader, quaternion_t *value);
+static void encode_binary_quaternion(binary_writer_t *writer, const quaternion_t *value);
+static bool decode_binary_quaternion(binary_reader_t *reader, quaternion_t *value);
+static void encode_json_orientation(json_writer_t *writer, const orientation_t *value);
+static bool decode_json_orientation(json_reader_t *reader, orientation_t *value);
+static void encode_binary_orientation(binary_writer_t *writer, const orientation_t *value);
+static bool decode_binary_orientation(binary_reader_t *reader, orientation_t *value);
+static void encode_json_servo_calibration_point(json_writer_t *writer, const servo_calibration_point_t *value);
+static bool decode_json_servo_calibration_point(json_reader_t *reader, servo_calibration_point_t *value);
+static void encode_binary_servo_calibration_point(binary_writer_t *writer, const servo_calibration_point_t *value);
+static bool decode_binary_servo_calibration_point(binary_reader_t *reader, servo_calibration_point_t *value);
+static void encode_json_servo_calibration(json_writer_t *writer, const protocol_servo_calibration_t *value);
+static bool decode_json_servo_calibration(json_reader_t *reader, protocol_servo_calibration_t *value);
+static void encode_binary_servo_calibration(binary_writer_t *writer, const protocol_servo_calibration_t *value);
+static bool decode_binary_servo_calibration(binary_reader_t *reader, protocol_servo_calibration_t *value);
+static void encode_json_control_config(json_writer_t *writer, const protocol_control_config_t *value);
+static bool decode_json_control_config(json_reader_t *reader, protocol_control_config_t *value);
+static void encode_binary_control_config(binary_writer_t *writer, const protocol_control_config_t *value);
+static bool decode_binary_control_config(binary_reader_t *reader, protocol_control_config_t *value);
+static void encode_json_tracking_policy(json_writer_t *writer, const protocol_tracking_policy_t *value);
+static bool decode_json_tracking_policy(json_reader_t *reader, protocol_tracking_policy_t *value);
+static void encode_binary_tracking_policy(binary_writer_t *writer, const protocol_tracking_policy_t *value);
+static bool decode_binary_tracking_policy(binary_reader_t *reader, protocol_tracking_policy_t *value);
+static void encode_json_telemetry_rate(json_writer_t *writer, const protocol_telemetry_rate_t *value);
+static bool decode_json_telemetry_rate(json_reader_t *reader, protocol_telemetry_rate_t *value);
+static void encode_binary_telemetry_rate(binary_writer_t *writer, const protocol_telemetry_rate_t *value);
+static bool decode_binary_telemetry_rate(binary_reader_t *reader, protocol_telemetry_rate_t *value);
+static void encode_json_system_state(json_writer_t *writer, const protocol_system_state_t *value);
+static bool decode_json_system_state(json_reader_t *reader, protocol_system_state_t *value);
+static void encode_binary_system_state(binary_writer_t *writer, const protocol_system_state_t *value);
+static bool decode_binary_system_state(binary_reader_t *reader, protocol_system_state_t *value);
+static void encode_json_viewers(json_writer_t *writer, const protocol_viewers_t *value);
+static bool decode_json_viewers(json_reader_t *reader, protocol_viewers_t *value);
+static void encode_binary_viewers(binary_writer_t *writer, const protocol_viewers_t *value);
+static bool decode_binary_viewers(binary_reader_t *reader, protocol_viewers_t *value);
+static void encode_json_delta_change(json_writer_t *writer, const protocol_delta_change_t *value);
+static bool decode_json_delta_change(json_reader_t *reader, protocol_delta_change_t *value);
+static void encode_binary_delta_change(binary_writer_t *writer, const protocol_delta_change_t *value);
+static bool decode_binary_delta_change(binary_reader_t *reader, protocol_delta_change_t *value);
+static void encode_json_system_delta(json_writer_t *writer, const protocol_system_delta_t *value);
+static bool decode_json_system_delta(json_reader_t *reader, protocol_system_delta_t *value);
+static void encode_binary_system_delta(binary_writer_t *writer, const protocol_system_delta_t *value);
+static bool decode_binary_system_delta(binary_reader_t *reader, protocol_system_delta_t *value);
+static void encode_json_keyframe_ack(json_writer_t *writer, const protocol_keyframe_ack_t *value);
+static bool decode_json_keyframe_ack(json_reader_t *reader, protocol_keyframe_ack_t *value);
+static void encode_binary_keyframe_ack(binary_writer_t *writer, const protocol_keyframe_ack_t *value);
+static bool decode_binary_keyframe_ack(binary_reader_t *reader, protocol_keyframe_ack_t *value);
+
+const char *const protocol_app_event_names[PROTOCOL_APP_EVENT_COUNT] = {
+    "UPDATE_CONFIG",
+    "UPDATE_STATE",
+    "UPDATE_VIEWERS",
+    "UPDATE_DELTA",
+    "ACK_KEYFRAME",
+};
+
+const char *const protocol_control_mode_names[PROTOCOL_CONTROL_MODE_COUNT] = {
+    "AUTOMATIC",
+    "MANUAL",
+};
+
+const char *const protocol_ahrs_engine_names[PROTOCOL_AHRS_ENGINE_COUNT] = {
+    "Mahony",
+    "Madgwick",
+    "EKF",
+};
+
+int protocol_encode_json(const protocol_message_t *message, char *buffer, size_t size)
+{
+    json_writer_t writer = {
+        .at = buffer,
+        .end = buffer + size - 1,
+    };
+
+    if (size == 0 || message->event >= PROTOCOL_APP_EVENT_COUNT)
+        return -1;
+
+    json_write(&writer, "{\"event\":", 9);
+    json_write_string(&writer, protocol_app_event_names[message->event]);
+    json_write(&writer, ",\"payload\":", 11);
+    switch (message->event)
+    {
+    case PROTOCOL_APP_EVENT_UPDATE_CONFIG:
+        encode_json_control_config(&writer, &message->control_config);
+        break;
+    case PROTOCOL_APP_EVENT_UPDATE_STATE:
+        encode_json_system_state(&writer, &message->system_state);
+        break;
+    case PROTOCOL_APP_EVENT_UPDATE_VIEWERS:
+        encode_json_viewers(&writer, &message->viewers);
+        break;
+    case PROTOCOL_APP_EVENT_UPDATE_DELTA:
+        encode_json_system_delta(&writer, &message->system_delta);
+        break;
+    case PROTOCOL_APP_EVENT_ACK_KEYFRAME:
+        encode_json_keyframe_ack(&writer, &message->keyframe_ack);
+        break;
+    default:
+        break;
+    }
+    json_write(&writer, "}", 1);
+
+    if (writer.failed)
+        return -1;
+
+    *writer.at = '\0';
+    return writer.at - buffer;
+}
+
+bool protocol_decode_json(const char *json, size_t length, protocol_message_t *message)
+{
+    json_reader_t reader = {
+        .at = json,
+        .end = json + length,
+    };
+    const char *key, *payload = NULL;
+    size_t key_length;
+    bool more, has_event = false;
+
+    if (!json_begin(&reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(&reader, &key, &key_length))
+            return false;
+        if (JSON_KEY_IS(key, key_length, "event"))
+        {
+            if (!json_read_app_event(&reader, &message->event))
+                return false;
+            has_event = true;
+        }
+        else if (JSON_KEY_IS(key, key_length, "payload"))
+        {
+            json_skip_space(&reader);
+            payload = reader.at;
+            if (!json_skip_value(&reader))
+                return false;
+        }
+        else if (!json_skip_value(&reader))
+        {
+            return false;
+        }
+        if (!json_next(&reader, '}', &more))
+            return false;
+    }
+    json_skip_space(&reader);
+    if (!has_event || payload == NULL || reader.at != reader.end)
+        return false;
+
+    // The payload again, now that the event tells its type
+    reader.at = payload;
+    switch (message->event)
+    {
+    case PROTOCOL_APP_EVENT_UPDATE_CONFIG:
+        return decode_json_control_config(&reader, &message->control_config);
+    case PROTOCOL_APP_EVENT_UPDATE_STATE:
+        return decode_json_system_state(&reader, &message->system_state);
+    case PROTOCOL_APP_EVENT_UPDATE_VIEWERS:
+        return decode_json_viewers(&reader, &message->viewers);
+    case PROTOCOL_APP_EVENT_UPDATE_DELTA:
+        return decode_json_system_delta(&reader, &message->system_delta);
+    case PROTOCOL_APP_EVENT_ACK_KEYFRAME:
+        return decode_json_keyframe_ack(&reader, &message->keyframe_ack);
+    default:
+        return false;
+    }
+}
+
+int protocol_encode_binary(const protocol_message_t *message, uint8_t *buffer, size_t size)
+{
+    binary_writer_t writer = {
+        .at = buffer,
+        .end = buffer + size,
+    };
+
+    if (message->event >= PROTOCOL_APP_EVENT_COUNT)
+        return -1;
+
+    binary_write(&writer, message->event, 1);
+    switch (message->event)
+    {
+    case PROTOCOL_APP_EVENT_UPDATE_CONFIG:
+        encode_binary_control_config(&writer, &message->control_config);
+        break;
+    case PROTOCOL_APP_EVENT_UPDATE_STATE:
+        encode_binary_system_state(&writer, &message->system_state);
+        break;
+    case PROTOCOL_APP_EVENT_UPDATE_VIEWERS:
+        encode_binary_viewers(&writer, &message->viewers);
+        break;
+    case PROTOCOL_APP_EVENT_UPDATE_DELTA:
+        encode_binary_system_delta(&writer, &message->system_delta);
+        break;
+    case PROTOCOL_APP_EVENT_ACK_KEYFRAME:
+        encode_binary_keyframe_ack(&writer, &message->keyframe_ack);
+        break;
+    default:
+        break;
+    }
+
+    return writer.failed ? -1 : writer.at - buffer;
+}
+
+bool protocol_decode_binary(const uint8_t *data, size_t length, protocol_message_t *message)
+{
+    binary_reader_t reader = {
+        .at = data,
+        .end = data + length,
+    };
+
+    if (!binary_read_app_event(&reader, &message->event))
+        return false;
+
+    switch (message->event)
+    {
+    case PROTOCOL_APP_EVENT_UPDATE_CONFIG:
+        return decode_binary_control_config(&reader, &message->control_config) && reader.at == reader.end;
+    case PROTOCOL_APP_EVENT_UPDATE_STATE:
+        return decode_binary_system_state(&reader, &message->system_state) && reader.at == reader.end;
+    case PROTOCOL_APP_EVENT_UPDATE_VIEWERS:
+        return decode_binary_viewers(&reader, &message->viewers) && reader.at == reader.end;
+    case PROTOCOL_APP_EVENT_UPDATE_DELTA:
+        return decode_binary_system_delta(&reader, &message->system_delta) && reader.at == reader.end;
+    case PROTOCOL_APP_EVENT_ACK_KEYFRAME:
+        return decode_binary_keyframe_ack(&reader, &message->keyframe_ack) && reader.at == reader.end;
+    default:
+        return false;
+    }
+}
+
+static bool json_read_app_event(json_reader_t *reader, protocol_app_event_t *value)
+{
+    int index;
+
+    if (!json_read_enum(reader, protocol_app_event_names, PROTOCOL_APP_EVENT_COUNT, &index))
+        return false;
+
+    *value = index;
+    return true;
+}
+
+static bool binary_read_app_event(binary_reader_t *reader, protocol_app_event_t *value)
+{
+    int index;
+
+    if (!binary_read_enum(reader, PROTOCOL_APP_EVENT_COUNT, &index))
+        return false;
+
+    *value = index;
+    return true;
+}
+
+static bool json_read_control_mode(json_reader_t *reader, protocol_control_mode_t *value)
+{
+    int index;
+
+    if (!json_read_enum(reader, protocol_control_mode_names, PROTOCOL_CONTROL_MODE_COUNT, &index))
+        return false;
+
+    *value = index;
+    return true;
+}
+
+static bool binary_read_control_mode(binary_reader_t *reader, protocol_control_mode_t *value)
+{
+    int index;
+
+    if (!binary_read_enum(reader, PROTOCOL_CONTROL_MODE_COUNT, &index))
+        return false;
+
+    *value = index;
+    return true;
+}
+
+static bool json_read_ahrs_engine(json_reader_t *reader, protocol_ahrs_engine_t *value)
+{
+    int index;
+
+    if (!json_read_enum(reader, protocol_ahrs_engine_names, PROTOCOL_AHRS_ENGINE_COUNT, &index))
+        return false;
+
+    *value = index;
+    return true;
+}
+
+static bool binary_read_ahrs_engine(binary_reader_t *reader, protocol_ahrs_engine_t *value)
+{
+    int index;
+
+    if (!binary_read_enum(reader, PROTOCOL_AHRS_ENGINE_COUNT, &index))
+        return false;
+
+    *value = index;
+    return true;
+}
+
+static void encode_json_quaternion(json_writer_t *writer, const quaternion_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"w\":", 4);
+    json_write_float(writer, value->w, 6);
+    json_write_key(writer, &first, "\"x\":", 4);
+    json_write_float(writer, value->x, 6);
+    json_write_key(writer, &first, "\"y\":", 4);
+    json_write_float(writer, value->y, 6);
+    json_write_key(writer, &first, "\"z\":", 4);
+    json_write_float(writer, value->z, 6);
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_quaternion(json_reader_t *reader, quaternion_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "w"))
+        {
+            if (!json_read_float(reader, &value->w))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (JSON_KEY_IS(key, length, "x"))
+        {
+            if (!json_read_float(reader, &value->x))
+                return false;
+            seen |= 1u << 1;
+        }
+        else if (JSON_KEY_IS(key, length, "y"))
+        {
+            if (!json_read_float(reader, &value->y))
+                return false;
+            seen |= 1u << 2;
+        }
+        else if (JSON_KEY_IS(key, length, "z"))
+        {
+            if (!json_read_float(reader, &value->z))
+                return false;
+            seen |= 1u << 3;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0xfu) == 0xfu;
+}
+
+static void encode_binary_quaternion(binary_writer_t *writer, const quaternion_t *value)
+{
+    binary_write_float(writer, value->w);
+    binary_write_float(writer, value->x);
+    binary_write_float(writer, value->y);
+    binary_write_float(writer, value->z);
+}
+
+static bool decode_binary_quaternion(binary_reader_t *reader, quaternion_t *value)
+{
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_float(reader, &value->w))
+        return false;
+    if (!binary_read_float(reader, &value->x))
+        return false;
+    if (!binary_read_float(reader, &value->y))
+        return false;
+    if (!binary_read_float(reader, &value->z))
+        return false;
+
+    return true;
+}
+
+static void encode_json_orientation(json_writer_t *writer, const orientation_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"azimuth\":", 10);
+    json_write_float(writer, value->azimuth, 6);
+    json_write_key(writer, &first, "\"inclination\":", 14);
+    json_write_float(writer, value->inclination, 6);
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_orientation(json_reader_t *reader, orientation_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "azimuth"))
+        {
+            if (!json_read_float(reader, &value->azimuth))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (JSON_KEY_IS(key, length, "inclination"))
+        {
+            if (!json_read_float(reader, &value->inclination))
+                return false;
+            seen |= 1u << 1;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0x3u) == 0x3u;
+}
+
+static void encode_binary_orientation(binary_writer_t *writer, const orientation_t *value)
+{
+    binary_write_float(writer, value->azimuth);
+    binary_write_float(writer, value->inclination);
+}
+
+static bool decode_binary_orientation(binary_reader_t *reader, orientation_t *value)
+{
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_float(reader, &value->azimuth))
+        return false;
+    if (!binary_read_float(reader, &value->inclination))
+        return false;
+
+    return true;
+}
+
+static void encode_json_servo_calibration_point(json_writer_t *writer, const servo_calibration_point_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"angle\":", 8);
+    json_write_float(writer, value->angle, 3);
+    json_write_key(writer, &first, "\"pulseWidth\":", 13);
+    json_write_float(writer, value->pulse_width, 1);
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_servo_calibration_point(json_reader_t *reader, servo_calibration_point_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "angle"))
+        {
+            if (!json_read_float(reader, &value->angle))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (JSON_KEY_IS(key, length, "pulseWidth"))
+        {
+            if (!json_read_float(reader, &value->pulse_width))
+                return false;
+            seen |= 1u << 1;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0x3u) == 0x3u;
+}
+
+static void encode_binary_servo_calibration_point(binary_writer_t *writer, const servo_calibration_point_t *value)
+{
+    binary_write_float(writer, value->angle);
+    binary_write_float(writer, value->pulse_width);
+}
+
+static bool decode_binary_servo_calibration_point(binary_reader_t *reader, servo_calibration_point_t *value)
+{
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_float(reader, &value->angle))
+        return false;
+    if (!binary_read_float(reader, &value->pulse_width))
+        return false;
+
+    return true;
+}
+
+static void encode_json_servo_calibration(json_writer_t *writer, const protocol_servo_calibration_t *value)
+{
+    bool first = true;
+
+    if (value->has_azimuth)
+    {
+        json_write_key(writer, &first, "\"azimuth\":", 10);
+        json_write(writer, "[", 1);
+        for (int i = 0; i < value->azimuth_count; i++)
+        {
+            if (i > 0)
+                json_write(writer, ",", 1);
+            encode_json_servo_calibration_point(writer, &value->azimuth[i]);
+        }
+        json_write(writer, "]", 1);
+    }
+    if (value->has_inclination)
+    {
+        json_write_key(writer, &first, "\"inclination\":", 14);
+        json_write(writer, "[", 1);
+        for (int i = 0; i < value->inclination_count; i++)
+        {
+            if (i > 0)
+                json_write(writer, ",", 1);
+            encode_json_servo_calibration_point(writer, &value->inclination[i]);
+        }
+        json_write(writer, "]", 1);
+    }
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_servo_calibration(json_reader_t *reader, protocol_servo_calibration_t *value)
+{
+    const char *key;
+    size_t length;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "azimuth"))
+        {
+            bool items;
+
+            if (!json_begin(reader, '[', ']', &items))
+                return false;
+            for (value->azimuth_count = 0; items; value->azimuth_count++)
+            {
+                if (value->azimuth_count >= 16 || !decode_json_servo_calibration_point(reader, &value->azimuth[value->azimuth_count]) ||
+                    !json_next(reader, ']', &items))
+                    return false;
+            }
+            value->has_azimuth = true;
+        }
+        else if (JSON_KEY_IS(key, length, "inclination"))
+        {
+            bool items;
+
+            if (!json_begin(reader, '[', ']', &items))
+                return false;
+            for (value->inclination_count = 0; items; value->inclination_count++)
+            {
+                if (value->inclination_count >= 16 || !decode_json_servo_calibration_point(reader, &value->inclination[value->inclination_count]) ||
+                    !json_next(reader, ']', &items))
+                    return false;
+            }
+            value->has_inclination = true;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return true;
+}
+
+static void encode_binary_servo_calibration(binary_writer_t *writer, const protocol_servo_calibration_t *value)
+{
+    binary_write(writer, value->has_azimuth << 0 | value->has_inclination << 1, 1);
+    if (value->has_azimuth)
+    {
+        binary_write(writer, value->azimuth_count, 1);
+        for (int i = 0; i < value->azimuth_count; i++)
+            encode_binary_servo_calibration_point(writer, &value->azimuth[i]);
+    }
+    if (value->has_inclination)
+    {
+        binary_write(writer, value->inclination_count, 1);
+        for (int i = 0; i < value->inclination_count; i++)
+            encode_binary_servo_calibration_point(writer, &value->inclination[i]);
+    }
+}
+
+static bool decode_binary_servo_calibration(binary_reader_t *reader, protocol_servo_calibration_t *value)
+{
+    uint8_t present, count;
+
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_u8(reader, &present) || present >> 2 != 0)
+        return false;
+    value->has_azimuth = present >> 0 & 1;
+    value->has_inclination = present >> 1 & 1;
+    if (value->has_azimuth)
+    {
+        if (!binary_read_u8(reader, &count) || count > 16)
+            return false;
+        for (value->azimuth_count = 0; value->azimuth_count < count; value->azimuth_count++)
+        {
+            if (!decode_binary_servo_calibration_point(reader, &value->azimuth[value->azimuth_count]))
+                return false;
+        }
+    }
+    if (value->has_inclination)
+    {
+        if (!binary_read_u8(reader, &count) || count > 16)
+            return false;
+        for (value->inclination_count = 0; value->inclination_count < count; value->inclination_count++)
+        {
+            if (!decode_binary_servo_calibration_point(reader, &value->inclination[value->inclination_count]))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static void encode_json_control_config(json_writer_t *writer, const protocol_control_config_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"controlMode\":", 14);
+    json_write_string(writer, protocol_control_mode_names[value->control_mode]);
+    json_write_key(writer, &first, "\"manualOrientation\":", 20);
+    encode_json_orientation(writer, &value->manual_orientation);
+    if (value->has_ahrs_engine)
+    {
+        json_write_key(writer, &first, "\"ahrsEngine\":", 13);
+        json_write_string(writer, protocol_ahrs_engine_names[value->ahrs_engine]);
+    }
+    if (value->has_servo_calibration)
+    {
+        json_write_key(writer, &first, "\"servoCalibration\":", 19);
+        encode_json_servo_calibration(writer, &value->servo_calibration);
+    }
+    if (value->has_tracking_threshold)
+    {
+        json_write_key(writer, &first, "\"trackingThreshold\":", 20);
+        json_write_float(writer, value->tracking_threshold, 3);
+    }
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_control_config(json_reader_t *reader, protocol_control_config_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "controlMode"))
+        {
+            if (!json_read_control_mode(reader, &value->control_mode))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (JSON_KEY_IS(key, length, "manualOrientation"))
+        {
+            if (!decode_json_orientation(reader, &value->manual_orientation))
+                return false;
+            seen |= 1u << 1;
+        }
+        else if (JSON_KEY_IS(key, length, "ahrsEngine"))
+        {
+            if (!json_read_ahrs_engine(reader, &value->ahrs_engine))
+                return false;
+            value->has_ahrs_engine = true;
+        }
+        else if (JSON_KEY_IS(key, length, "servoCalibration"))
+        {
+            if (!decode_json_servo_calibration(reader, &value->servo_calibration))
+                return false;
+            value->has_servo_calibration = true;
+        }
+        else if (JSON_KEY_IS(key, length, "trackingThreshold"))
+        {
+            if (!json_read_float(reader, &value->tracking_threshold))
+                return false;
+            value->has_tracking_threshold = true;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0x3u) == 0x3u;
+}
+
+static void encode_binary_control_config(binary_writer_t *writer, const protocol_control_config_t *value)
+{
+    binary_write(writer, value->has_ahrs_engine << 0 | value->has_servo_calibration << 1 | value->has_tracking_threshold << 2, 1);
+    binary_write(writer, value->control_mode, 1);
+    encode_binary_orientation(writer, &value->manual_orientation);
+    if (value->has_ahrs_engine)
+    {
+        binary_write(writer, value->ahrs_engine, 1);
+    }
+    if (value->has_servo_calibration)
+    {
+        encode_binary_servo_calibration(writer, &value->servo_calibration);
+    }
+    if (value->has_tracking_threshold)
+    {
+        binary_write_float(writer, value->tracking_threshold);
+    }
+}
+
+static bool decode_binary_control_config(binary_reader_t *reader, protocol_control_config_t *value)
+{
+    uint8_t present;
+
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_u8(reader, &present) || present >> 3 != 0)
+        return false;
+    value->has_ahrs_engine = present >> 0 & 1;
+    value->has_servo_calibration = present >> 1 & 1;
+    value->has_tracking_threshold = present >> 2 & 1;
+    if (!binary_read_control_mode(reader, &value->control_mode))
+        return false;
+    if (!decode_binary_orientation(reader, &value->manual_orientation))
+        return false;
+    if (value->has_ahrs_engine && !binary_read_ahrs_engine(reader, &value->ahrs_engine))
+        return false;
+    if (value->has_servo_calibration && !decode_binary_servo_calibration(reader, &value->servo_calibration))
+        return false;
+    if (value->has_tracking_threshold && !binary_read_float(reader, &value->tracking_threshold))
+        return false;
+
+    return true;
+}
+
+static void encode_json_tracking_policy(json_writer_t *writer, const protocol_tracking_policy_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"moves\":", 8);
+    json_write_integer(writer, value->moves);
+    json_write_key(writer, &first, "\"skipped\":", 10);
+    json_write_integer(writer, value->skipped);
+    json_write_key(writer, &first, "\"motorOnTime\":", 14);
+    json_write_float(writer, value->motor_on_time, 1);
+    json_write_key(writer, &first, "\"motorEnergy\":", 14);
+    json_write_float(writer, value->motor_energy, 4);
+    json_write_key(writer, &first, "\"yield\":", 8);
+    json_write_float(writer, value->yield, 4);
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_tracking_policy(json_reader_t *reader, protocol_tracking_policy_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "moves"))
+        {
+            if (!json_read_u32(reader, &value->moves))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (JSON_KEY_IS(key, length, "skipped"))
+        {
+            if (!json_read_u32(reader, &value->skipped))
+                return false;
+            seen |= 1u << 1;
+        }
+        else if (JSON_KEY_IS(key, length, "motorOnTime"))
+        {
+            if (!json_read_float(reader, &value->motor_on_time))
+                return false;
+            seen |= 1u << 2;
+        }
+        else if (JSON_KEY_IS(key, length, "motorEnergy"))
+        {
+            if (!json_read_float(reader, &value->motor_energy))
+                return false;
+            seen |= 1u << 3;
+        }
+        else if (JSON_KEY_IS(key, length, "yield"))
+        {
+            if (!json_read_float(reader, &value->yield))
+                return false;
+            seen |= 1u << 4;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0x1fu) == 0x1fu;
+}
+
+static void encode_binary_tracking_policy(binary_writer_t *writer, const protocol_tracking_policy_t *value)
+{
+    binary_write(writer, value->moves, 4);
+    binary_write(writer, value->skipped, 4);
+    binary_write_float(writer, value->motor_on_time);
+    binary_write_float(writer, value->motor_energy);
+    binary_write_float(writer, value->yield);
+}
+
+static bool decode_binary_tracking_policy(binary_reader_t *reader, protocol_tracking_policy_t *value)
+{
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_u32(reader, &value->moves))
+        return false;
+    if (!binary_read_u32(reader, &value->skipped))
+        return false;
+    if (!binary_read_float(reader, &value->motor_on_time))
+        return false;
+    if (!binary_read_float(reader, &value->motor_energy))
+        return false;
+    if (!binary_read_float(reader, &value->yield))
+        return false;
+
+    return true;
+}
+
+static void encode_json_telemetry_rate(json_writer_t *writer, const protocol_telemetry_rate_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"rate\":", 7);
+    json_write_float(writer, value->rate, 3);
+    json_write_key(writer, &first, "\"sent\":", 7);
+    json_write_integer(writer, value->sent);
+    json_write_key(writer, &first, "\"failed\":", 9);
+    json_write_integer(writer, value->failed);
+    json_write_key(writer, &first, "\"deferred\":", 11);
+    json_write_integer(writer, value->deferred);
+    json_write_key(writer, &first, "\"backoffs\":", 11);
+    json_write_integer(writer, value->backoffs);
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_telemetry_rate(json_reader_t *reader, protocol_telemetry_rate_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "rate"))
+        {
+            if (!json_read_float(reader, &value->rate))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (JSON_KEY_IS(key, length, "sent"))
+        {
+            if (!json_read_u32(reader, &value->sent))
+                return false;
+            seen |= 1u << 1;
+        }
+        else if (JSON_KEY_IS(key, length, "failed"))
+        {
+            if (!json_read_u32(reader, &value->failed))
+                return false;
+            seen |= 1u << 2;
+        }
+        else if (JSON_KEY_IS(key, length, "deferred"))
+        {
+            if (!json_read_u32(reader, &value->deferred))
+                return false;
+            seen |= 1u << 3;
+        }
+        else if (JSON_KEY_IS(key, length, "backoffs"))
+        {
+            if (!json_read_u32(reader, &value->backoffs))
+                return false;
+            seen |= 1u << 4;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0x1fu) == 0x1fu;
+}
+
+static void encode_binary_telemetry_rate(binary_writer_t *writer, const protocol_telemetry_rate_t *value)
+{
+    binary_write_float(writer, value->rate);
+    binary_write(writer, value->sent, 4);
+    binary_write(writer, value->failed, 4);
+    binary_write(writer, value->deferred, 4);
+    binary_write(writer, value->backoffs, 4);
+}
+
+static bool decode_binary_telemetry_rate(binary_reader_t *reader, protocol_telemetry_rate_t *value)
+{
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_float(reader, &value->rate))
+        return false;
+    if (!binary_read_u32(reader, &value->sent))
+        return false;
+    if (!binary_read_u32(reader, &value->failed))
+        return false;
+    if (!binary_read_u32(reader, &value->deferred))
+        return false;
+    if (!binary_read_u32(reader, &value->backoffs))
+        return false;
+
+    return true;
+}
+
+static void encode_json_system_state(json_writer_t *writer, const protocol_system_state_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"platformRotation\":", 19);
+    encode_json_quaternion(writer, &value->platform_rotation);
+    json_write_key(writer, &first, "\"panelOrientation\":", 19);
+    encode_json_orientation(writer, &value->panel_orientation);
+    json_write_key(writer, &first, "\"motorsRotation\":", 17);
+    encode_json_orientation(writer, &value->motors_rotation);
+    json_write_key(writer, &first, "\"motorsEnergized\":", 18);
+    encode_json_orientation(writer, &value->motors_energized);
+    json_write_key(writer, &first, "\"timestamp\":", 12);
+    json_write_integer(writer, value->timestamp);
+    if (value->has_motors_measured)
+    {
+        json_write_key(writer, &first, "\"motorsMeasured\":", 17);
+        encode_json_orientation(writer, &value->motors_measured);
+    }
+    if (value->has_tracking_policy)
+    {
+        json_write_key(writer, &first, "\"trackingPolicy\":", 17);
+        encode_json_tracking_policy(writer, &value->tracking_policy);
+    }
+    if (value->has_telemetry)
+    {
+        json_write_key(writer, &first, "\"telemetry\":", 12);
+        encode_json_telemetry_rate(writer, &value->telemetry);
+    }
+    if (value->has_keyframe)
+    {
+        json_write_key(writer, &first, "\"keyframe\":", 11);
+        json_write_integer(writer, value->keyframe);
+    }
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_system_state(json_reader_t *reader, protocol_system_state_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "platformRotation"))
+        {
+            if (!decode_json_quaternion(reader, &value->platform_rotation))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (JSON_KEY_IS(key, length, "panelOrientation"))
+        {
+            if (!decode_json_orientation(reader, &value->panel_orientation))
+                return false;
+            seen |= 1u << 1;
+        }
+        else if (JSON_KEY_IS(key, length, "motorsRotation"))
+        {
+            if (!decode_json_orientation(reader, &value->motors_rotation))
+                return false;
+            seen |= 1u << 2;
+        }
+        else if (JSON_KEY_IS(key, length, "motorsEnergized"))
+        {
+            if (!decode_json_orientation(reader, &value->motors_energized))
+                return false;
+            seen |= 1u << 3;
+        }
+        else if (JSON_KEY_IS(key, length, "timestamp"))
+        {
+            if (!json_read_i64(reader, &value->timestamp))
+                return false;
+            seen |= 1u << 4;
+        }
+        else if (JSON_KEY_IS(key, length, "motorsMeasured"))
+        {
+            if (!decode_json_orientation(reader, &value->motors_measured))
+                return false;
+            value->has_motors_measured = true;
+        }
+        else if (JSON_KEY_IS(key, length, "trackingPolicy"))
+        {
+            if (!decode_json_tracking_policy(reader, &value->tracking_policy))
+                return false;
+            value->has_tracking_policy = true;
+        }
+        else if (JSON_KEY_IS(key, length, "telemetry"))
+        {
+            if (!decode_json_telemetry_rate(reader, &value->telemetry))
+                return false;
+            value->has_telemetry = true;
+        }
+        else if (JSON_KEY_IS(key, length, "keyframe"))
+        {
+            if (!json_read_u32(reader, &value->keyframe))
+                return false;
+            value->has_keyframe = true;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0x1fu) == 0x1fu;
+}
+
+static void encode_binary_system_state(binary_writer_t *writer, const protocol_system_state_t *value)
+{
+    binary_write(writer, value->has_motors_measured << 0 | value->has_tracking_policy << 1 | value->has_telemetry << 2 | value->has_keyframe << 3, 1);
+    encode_binary_quaternion(writer, &value->platform_rotation);
+    encode_binary_orientation(writer, &value->panel_orientation);
+    encode_binary_orientation(writer, &value->motors_rotation);
+    encode_binary_orientation(writer, &value->motors_energized);
+    binary_write(writer, value->timestamp, 8);
+    if (value->has_motors_measured)
+    {
+        encode_binary_orientation(writer, &value->motors_measured);
+    }
+    if (value->has_tracking_policy)
+    {
+        encode_binary_tracking_policy(writer, &value->tracking_policy);
+    }
+    if (value->has_telemetry)
+    {
+        encode_binary_telemetry_rate(writer, &value->telemetry);
+    }
+    if (value->has_keyframe)
+    {
+        binary_write(writer, value->keyframe, 4);
+    }
+}
+
+static bool decode_binary_system_state(binary_reader_t *reader, protocol_system_state_t *value)
+{
+    uint8_t present;
+
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_u8(reader, &present) || present >> 4 != 0)
+        return false;
+    value->has_motors_measured = present >> 0 & 1;
+    value->has_tracking_policy = present >> 1 & 1;
+    value->has_telemetry = present >> 2 & 1;
+    value->has_keyframe = present >> 3 & 1;
+    if (!decode_binary_quaternion(reader, &value->platform_rotation))
+        return false;
+    if (!decode_binary_orientation(reader, &value->panel_orientation))
+        return false;
+    if (!decode_binary_orientation(reader, &value->motors_rotation))
+        return false;
+    if (!decode_binary_orientation(reader, &value->motors_energized))
+        return false;
+    if (!binary_read_i64(reader, &value->timestamp))
+        return false;
+    if (value->has_motors_measured && !decode_binary_orientation(reader, &value->motors_measured))
+        return false;
+    if (value->has_tracking_policy && !decode_binary_tracking_policy(reader, &value->tracking_policy))
+        return false;
+    if (value->has_telemetry && !decode_binary_telemetry_rate(reader, &value->telemetry))
+        return false;
+    if (value->has_keyframe && !binary_read_u32(reader, &value->keyframe))
+        return false;
+
+    return true;
+}
+
+static void encode_json_viewers(json_writer_t *writer, const protocol_viewers_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"viewers\":", 10);
+    json_write_integer(writer, value->viewers);
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_viewers(json_reader_t *reader, protocol_viewers_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "viewers"))
+        {
+            if (!json_read_u32(reader, &value->viewers))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0x1u) == 0x1u;
+}
+
+static void encode_binary_viewers(binary_writer_t *writer, const protocol_viewers_t *value)
+{
+    binary_write(writer, value->viewers, 4);
+}
+
+static bool decode_binary_viewers(binary_reader_t *reader, protocol_viewers_t *value)
+{
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_u32(reader, &value->viewers))
+        return false;
+
+    return true;
+}
+
+static void encode_json_delta_change(json_writer_t *writer, const protocol_delta_change_t *value)
+{
+    json_write(writer, "[", 1);
+    json_write_integer(writer, value->index);
+    json_write(writer, ",", 1);
+    json_write_integer(writer, value->steps);
+    json_write(writer, "]", 1);
+}
+
+static bool decode_json_delta_change(json_reader_t *reader, protocol_delta_change_t *value)
+{
+    bool more;
+
+    if (!json_begin(reader, '[', ']', &more))
+        return false;
+    if (!more || !json_read_u32(reader, &value->index) || !json_next(reader, ']', &more))
+        return false;
+    if (!more || !json_read_i32(reader, &value->steps) || !json_next(reader, ']', &more))
+        return false;
+
+    return !more;
+}
+
+static void encode_binary_delta_change(binary_writer_t *writer, const protocol_delta_change_t *value)
+{
+    binary_write(writer, value->index, 4);
+    binary_write(writer, value->steps, 4);
+}
+
+static bool decode_binary_delta_change(binary_reader_t *reader, protocol_delta_change_t *value)
+{
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_u32(reader, &value->index))
+        return false;
+    if (!binary_read_i32(reader, &value->steps))
+        return false;
+
+    return true;
+}
+
+static void encode_json_system_delta(json_writer_t *writer, const protocol_system_delta_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"base\":", 7);
+    json_write_integer(writer, value->base);
+    json_write_key(writer, &first, "\"timestamp\":", 12);
+    json_write_integer(writer, value->timestamp);
+    json_write_key(writer, &first, "\"changes\":", 10);
+    json_write(writer, "[", 1);
+    for (int i = 0; i < value->changes_count; i++)
+    {
+        if (i > 0)
+            json_write(writer, ",", 1);
+        encode_json_delta_change(writer, &value->changes[i]);
+    }
+    json_write(writer, "]", 1);
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_system_delta(json_reader_t *reader, protocol_system_delta_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "base"))
+        {
+            if (!json_read_u32(reader, &value->base))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (JSON_KEY_IS(key, length, "timestamp"))
+        {
+            if (!json_read_i64(reader, &value->timestamp))
+                return false;
+            seen |= 1u << 1;
+        }
+        else if (JSON_KEY_IS(key, length, "changes"))
+        {
+            bool items;
+
+            if (!json_begin(reader, '[', ']', &items))
+                return false;
+            for (value->changes_count = 0; items; value->changes_count++)
+            {
+                if (value->changes_count >= 10 || !decode_json_delta_change(reader, &value->changes[value->changes_count]) ||
+                    !json_next(reader, ']', &items))
+                    return false;
+            }
+            seen |= 1u << 2;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0x7u) == 0x7u;
+}
+
+static void encode_binary_system_delta(binary_writer_t *writer, const protocol_system_delta_t *value)
+{
+    binary_write(writer, value->base, 4);
+    binary_write(writer, value->timestamp, 8);
+    binary_write(writer, value->changes_count, 1);
+    for (int i = 0; i < value->changes_count; i++)
+        encode_binary_delta_change(writer, &value->changes[i]);
+}
+
+static bool decode_binary_system_delta(binary_reader_t *reader, protocol_system_delta_t *value)
+{
+    uint8_t count;
+
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_u32(reader, &value->base))
+        return false;
+    if (!binary_read_i64(reader, &value->timestamp))
+        return false;
+    if (!binary_read_u8(reader, &count) || count > 10)
+        return false;
+    for (value->changes_count = 0; value->changes_count < count; value->changes_count++)
+    {
+        if (!decode_binary_delta_change(reader, &value->changes[value->changes_count]))
+            return false;
+    }
+
+    return true;
+}
+
+static void encode_json_keyframe_ack(json_writer_t *writer, const protocol_keyframe_ack_t *value)
+{
+    bool first = true;
+
+    json_write_key(writer, &first, "\"keyframe\":", 11);
+    json_write_integer(writer, value->keyframe);
+    json_write(writer, first ? "{}" : "}", first ? 2 : 1);
+}
+
+static bool decode_json_keyframe_ack(json_reader_t *reader, protocol_keyframe_ack_t *value)
+{
+    const char *key;
+    size_t length;
+    uint32_t seen = 0;
+    bool more;
+
+    memset(value, 0, sizeof(*value));
+    if (!json_begin(reader, '{', '}', &more))
+        return false;
+    while (more)
+    {
+        if (!json_read_key(reader, &key, &length))
+            return false;
+        if (JSON_KEY_IS(key, length, "keyframe"))
+        {
+            if (!json_read_u32(reader, &value->keyframe))
+                return false;
+            seen |= 1u << 0;
+        }
+        else if (!json_skip_value(reader))
+        {
+            return false;
+        }
+        if (!json_next(reader, '}', &more))
+            return false;
+    }
+
+    return (seen & 0x1u) == 0x1u;
+}
+
+static void encode_binary_keyframe_ack(binary_writer_t *writer, const protocol_keyframe_ack_t *value)
+{
+    binary_write(writer, value->keyframe, 4);
+}
+
+static bool decode_binary_keyframe_ack(binary_reader_t *reader, protocol_keyframe_ack_t *value)
+{
+    memset(value, 0, sizeof(*value));
+    if (!binary_read_u32(reader, &value->keyframe))
+        return false;
+
+    return true;
+}
+
+static void json_write(json_writer_t *writer, const char *text, size_t length)
+{
+    if (writer->failed || (size_t)(writer->end - writer->at) < length)
+    {
+        writer->failed = true;
+        return;
+    }
+
+    memcpy(writer->at, text, length);
+    writer->at += length;
+}
+
+static void json_write_key(json_writer_t *writer, bool *first, const char *key, size_t length)
+{
+    json_write(writer, *first ? "{" : ",", 1);
+    json_write(writer, key, length);
+    *first = false;
+}
+
+static void json_write_string(json_writer_t *writer, const char *text)
+{
+    json_write(writer, "\"", 1);
+    json_write(writer, text, strlen(text));
+    json_write(writer, "\"", 1);
+}
+
+// Fixed point digits rather than printf, which allocates for floats in newlib
+static void json_write_float(json_writer_t *writer, float value, int precision)
+{
+    static const double scales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    double scaled = round(fabs((double)value) * scales[precision]);
+    char digits[24];
+    char *at = digits + sizeof(digits);
+
+    // NAN and values beyond 64 bits, JSON has neither
+    if (!(scaled < 9e18))
+    {
+        json_write(writer, "null", 4);
+        return;
+    }
+
+    uint64_t integer = scaled;
+    for (int i = 0; i < precision; i++, integer /= 10)
+        *--at = '0' + integer % 10;
+    if (precision > 0)
+        *--at = '.';
+    do
+        *--at = '0' + integer % 10;
+    while ((integer /= 10) > 0);
+    if (value < 0.f && scaled > 0.)
+        *--at = '-';
+
+    json_write(writer, at, digits + sizeof(digits) - at);
+}
+
+static void json_write_integer(json_writer_t *writer, int64_t value)
+{
+    uint64_t integer = value < 0 ? -(uint64_t)value : (uint64_t)value;
+    char digits[24];
+    char *at = digits + sizeof(digits);
+
+    do
+        *--at = '0' + integer % 10;
+    while ((integer /= 10) > 0);
+    if (value < 0)
+        *--at = '-';
+
+    json_write(writer, at, digits + sizeof(digits) - at);
+}
+
+static void json_skip_space(json_reader_t *reader)
+{
+    while (reader->at < reader->end && (*reader->at == ' ' || *reader->at == '\t' || *reader->at == '\n' || *reader->at == '\r'))
+        reader->at++;
+}
+
+static bool json_peek(json_reader_t *reader, char c)
+{
+    json_skip_space(reader);
+    return reader->at < reader->end && *reader->at == c;
+}
+
+static bool json_expect(json_reader_t *reader, char c)
+{
+    if (!json_peek(reader, c))
+        return false;
+
+    reader->at++;
+    return true;
+}
+
+// Opens an object or an array, `more` tells whether a member follows
+static bool json_begin(json_reader_t *reader, char open, char close, bool *more)
+{
+    if (!json_expect(reader, open) || reader->depth >= JSON_MAX_DEPTH)
+        return false;
+
+    *more = !json_expect(reader, close);
+    reader->depth += *more;
+    return true;
+}
+
+// After a member, `more` tells whether another one follows the comma
+static bool json_next(json_reader_t *reader, char close, bool *more)
+{
+    if (json_expect(reader, ','))
+    {
+        *more = true;
+        return true;
+    }
+    if (!json_expect(reader, close))
+        return false;
+
+    reader->depth--;
+    *more = false;
+    return true;
+}
+
+// Escapes are skipped, not decoded: names and keys never have any
+static bool json_read_string(json_reader_t *reader, const char **text, size_t *length)
+{
+    if (!json_expect(reader, '"'))
+        return false;
+
+    *text = reader->at;
+    while (reader->at < reader->end && *reader->at != '"')
+        reader->at += *reader->at == '\\' && reader->end - reader->at > 1 ? 2 : 1;
+    if (reader->at >= reader->end)
+        return false;
+
+    *length = reader->at++ - *text;
+    return true;
+}
+
+static bool json_read_key(json_reader_t *reader, const char **key, size_t *length)
+{
+    return json_read_string(reader, key, length) && json_expect(reader, ':');
+}
+
+// Null reads as NAN
+static bool json_read_number(json_reader_t *reader, double *value)
+{
+    uint64_t mantissa = 0;
+    int exponent = 0, digits = 0;
+    bool negative;
+
+    json_skip_space(reader);
+    if (reader->end - reader->at >= 4 && memcmp(reader->at, "null", 4) == 0)
+    {
+        reader->at += 4;
+        *value = NAN;
+        return true;
+    }
+
+    negative = reader->at < reader->end && *reader->at == '-';
+    reader->at += negative;
+    for (; reader->at < reader->end && *reader->at >= '0' && *reader->at <= '9'; reader->at++, digits++)
+    {
+        if (mantissa < JSON_MANTISSA_LIMIT)
+            mantissa = mantissa * 10 + (*reader->at - '0');
+        else
+            exponent++;
+    }
+    if (reader->at < reader->end && *reader->at == '.')
+    {
+        for (reader->at++; reader->at < reader->end && *reader->at >= '0' && *reader->at <= '9'; reader->at++, digits++)
+        {
+            if (mantissa < JSON_MANTISSA_LIMIT)
+            {
+                mantissa = mantissa * 10 + (*reader->at - '0');
+                exponent--;
+            }
+        }
+    }
+    if (digits == 0)
+        return false;
+
+    if (reader->at < reader->end && (*reader->at == 'e' || *reader->at == 'E'))
+    {
+        int power = 0, power_digits = 0;
+        bool negative_power;
+
+        reader->at++;
+        negative_power = reader->at < reader->end && *reader->at == '-';
+        reader->at += reader->at < reader->end && (*reader->at == '-' || *reader->at == '+');
+        for (; reader->at < reader->end && *reader->at >= '0' && *reader->at <= '9'; reader->at++, power_digits++)
+        {
+            if (power < 1000)
+                power = power * 10 + (*reader->at - '0');
+        }
+        if (power_digits == 0)
+            return false;
+        exponent += negative_power ? -power : power;
+    }
+
+    // Dividing keeps the exact powers of ten exact
+    *value = exponent < 0 ? mantissa / pow(10., -exponent) : mantissa * pow(10., exponent);
+    if (negative)
+        *value = -*value;
+    return true;
+}
+
+static bool json_read_float(json_reader_t *reader, float *value)
+{
+    double number;
+
+    if (!json_read_number(reader, &number))
+        return false;
+
+    *value = number;
+    return true;
+}
+
+static bool json_read_u32(json_reader_t *reader, uint32_t *value)
+{
+    double number;
+
+    if (!json_read_number(reader, &number) || !(number >= 0. && number <= UINT32_MAX && number == floor(number)))
+        return false;
+
+    *value = number;
+    return true;
+}
+
+static bool json_read_i32(json_reader_t *reader, int32_t *value)
+{
+    double number;
+
+    if (!json_read_number(reader, &number) || !(number >= INT32_MIN && number <= INT32_MAX && number == floor(number)))
+        return false;
+
+    *value = number;
+    return true;
+}
+
+static bool json_read_i64(json_reader_t *reader, int64_t *value)
+{
+    double number;
+
+    if (!json_read_number(reader, &number) || !(number >= -9e18 && number <= 9e18 && number == floor(number)))
+        return false;
+
+    *value = number;
+    return true;
+}
+
+static bool json_read_enum(json_reader_t *reader, const char *const *names, int count, int *value)
+{
+    const char *name;
+    size_t length;
+
+    if (!json_read_string(reader, &name, &length))
+        return false;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (strlen(names[i]) == length && memcmp(names[i], name, length) == 0)
+        {
+            *value = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool json_skip_value(json_reader_t *reader)
+{
+    const char *text;
+    size_t length;
+    double number;
+    bool more;
+
+    if (json_peek(reader, '"'))
+        return json_read_string(reader, &text, &length);
+
+    if (json_peek(reader, '{') || json_peek(reader, '['))
+    {
+        bool object = *reader->at == '{';
+        char close = object ? '}' : ']';
+
+        if (!json_begin(reader, *reader->at, close, &more))
+            return false;
+        while (more)
+        {
+            if ((object && !json_read_key(reader, &text, &length)) || !json_skip_value(reader) || !json_next(reader, close, &more))
+                return false;
+        }
+        return true;
+    }
+
+    if (reader->end - reader->at >= 4 && memcmp(reader->at, "true", 4) == 0)
+    {
+        reader->at += 4;
+        return true;
+    }
+    if (reader->end - reader->at >= 5 && memcmp(reader->at, "false", 5) == 0)
+    {
+        reader->at += 5;
+        return true;
+    }
+
+    return json_read_number(reader, &number);
+}
+
+static void binary_write(binary_writer_t *writer, uint64_t value, int size)
+{
+    if (writer->failed || writer->end - writer->at < size)
+    {
+        writer->failed = true;
+        return;
+    }
+
+    for (int i = 0; i < size; i++)
+        *writer->at++ = value >> 8 * i;
+}
+
+// Any NAN as the quiet one the server and the client write too
+static void binary_write_float(binary_writer_t *writer, float value)
+{
+    uint32_t bits = 0x7fc00000u;
+
+    if (!isnan(value))
+        memcpy(&bits, &value, sizeof(bits));
+    binary_write(writer, bits, sizeof(bits));
+}
+
+static bool binary_read(binary_reader_t *reader, int size, uint64_t *value)
+{
+    if (reader->end - reader->at < size)
+        return false;
+
+    *value = 0;
+    for (int i = 0; i < size; i++)
+        *value |= (uint64_t)*reader->at++ << 8 * i;
+    return true;
+}
+
+static bool binary_read_u8(binary_reader_t *reader, uint8_t *value)
+{
+    uint64_t bits;
+
+    if (!binary_read(reader, 1, &bits))
+        return false;
+
+    *value = bits;
+    return true;
+}
+
+static bool binary_read_float(binary_reader_t *reader, float *value)
+{
+    uint64_t bits;
+    uint32_t word;
+
+    if (!binary_read(reader, sizeof(word), &bits))
+        return false;
+
+    word = bits;
+    memcpy(value, &word, sizeof(word));
+    return true;
+}
+
+static bool binary_read_u32(binary_reader_t *reader, uint32_t *value)
+{
+    uint64_t bits;
+
+    if (!binary_read(reader, 4, &bits))
+        return false;
+
+    *value = bits;
+    return true;
+}
+
+static bool binary_read_i32(binary_reader_t *reader, int32_t *value)
+{
+    uint64_t bits;
+
+    if (!binary_read(reader, 4, &bits))
+        return false;
+
+    *value = (int32_t)(uint32_t)bits;
+    return true;
+}
+
+static bool binary_read_i64(binary_reader_t *reader, int64_t *value)
+{
+    uint64_t bits;
+
+    if (!binary_read(reader, 8, &bits))
+        return false;
+
+    *value = (int64_t)bits;
+    return true;
+}
+
+static bool binary_read_enum(binary_reader_t *reader, int count, int *value)
+{
+    uint8_t index;
+
+    if (!binary_read_u8(reader, &index) || index >= count)
+        return false;
+
+    *value = index;
+    return true;
+}
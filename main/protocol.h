@@ -0,0 +1,158 @@
+// Generated by tools/protocol_gen.py from protocol/schema.json, do not edit.
+#ifndef __PROTOCOL_H__
+#define __PROTOCOL_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "servo_calibration.h"
+#include "types.h"
+
+typedef enum protocol_app_event_t
+{
+    PROTOCOL_APP_EVENT_UPDATE_CONFIG,
+    PROTOCOL_APP_EVENT_UPDATE_STATE,
+    PROTOCOL_APP_EVENT_UPDATE_VIEWERS,
+    PROTOCOL_APP_EVENT_UPDATE_DELTA,
+    PROTOCOL_APP_EVENT_ACK_KEYFRAME,
+    PROTOCOL_APP_EVENT_COUNT,
+} protocol_app_event_t;
+
+typedef enum protocol_control_mode_t
+{
+    PROTOCOL_CONTROL_MODE_AUTOMATIC,
+    PROTOCOL_CONTROL_MODE_MANUAL,
+    PROTOCOL_CONTROL_MODE_COUNT,
+} protocol_control_mode_t;
+
+typedef enum protocol_ahrs_engine_t
+{
+    PROTOCOL_AHRS_ENGINE_MAHONY,
+    PROTOCOL_AHRS_ENGINE_MADGWICK,
+    PROTOCOL_AHRS_ENGINE_EKF,
+    PROTOCOL_AHRS_ENGINE_COUNT,
+} protocol_ahrs_engine_t;
+
+extern const char *const protocol_app_event_names[PROTOCOL_APP_EVENT_COUNT];
+extern const char *const protocol_control_mode_names[PROTOCOL_CONTROL_MODE_COUNT];
+extern const char *const protocol_ahrs_engine_names[PROTOCOL_AHRS_ENGINE_COUNT];
+
+typedef struct protocol_servo_calibration_t
+{
+    bool has_azimuth;
+    servo_calibration_point_t azimuth[16];
+    int azimuth_count;
+    bool has_inclination;
+    servo_calibration_point_t inclination[16];
+    int inclination_count;
+} protocol_servo_calibration_t;
+
+typedef struct protocol_control_config_t
+{
+    protocol_control_mode_t control_mode;
+    orientation_t manual_orientation;
+    bool has_ahrs_engine;
+    protocol_ahrs_engine_t ahrs_engine;
+    bool has_servo_calibration;
+    protocol_servo_calibration_t servo_calibration;
+    // Gain a tracking move needs, relative to the energy it costs
+    bool has_tracking_threshold;
+    float tracking_threshold;
+} protocol_control_config_t;
+
+// Energies in Wh, time in seconds
+typedef struct protocol_tracking_policy_t
+{
+    uint32_t moves;
+    uint32_t skipped;
+    float motor_on_time;
+    float motor_energy;
+    float yield;
+} protocol_tracking_policy_t;
+
+// Effective uploads per second, and upload counters since boot
+typedef struct protocol_telemetry_rate_t
+{
+    float rate;
+    uint32_t sent;
+    uint32_t failed;
+    uint32_t deferred;
+    uint32_t backoffs;
+} protocol_telemetry_rate_t;
+
+typedef struct protocol_system_state_t
+{
+    quaternion_t platform_rotation;
+    orientation_t panel_orientation;
+    orientation_t motors_rotation;
+    // Seconds each servo has been energized since boot
+    orientation_t motors_energized;
+    // Milliseconds since the Unix epoch
+    int64_t timestamp;
+    // Read from the servo potentiometers, when the firmware has them
+    bool has_motors_measured;
+    orientation_t motors_measured;
+    bool has_tracking_policy;
+    protocol_tracking_policy_t tracking_policy;
+    bool has_telemetry;
+    protocol_telemetry_rate_t telemetry;
+    // Number the tracker gave this state when it uploads deltas against it
+    bool has_keyframe;
+    uint32_t keyframe;
+} protocol_system_state_t;
+
+typedef struct protocol_viewers_t
+{
+    uint32_t viewers;
+} protocol_viewers_t;
+
+// Index in the delta fields of the firmware and value in quantization steps
+typedef struct protocol_delta_change_t
+{
+    uint32_t index;
+    int32_t steps;
+} protocol_delta_change_t;
+
+// Fields that changed since the keyframe `base`
+typedef struct protocol_system_delta_t
+{
+    uint32_t base;
+    int64_t timestamp;
+    protocol_delta_change_t changes[10];
+    int changes_count;
+} protocol_system_delta_t;
+
+typedef struct protocol_keyframe_ack_t
+{
+    uint32_t keyframe;
+} protocol_keyframe_ack_t;
+
+typedef struct protocol_message_t
+{
+    protocol_app_event_t event;
+    union
+    {
+        protocol_control_config_t control_config;
+        protocol_system_state_t system_state;
+        protocol_viewers_t viewers;
+        protocol_system_delta_t system_delta;
+        protocol_keyframe_ack_t keyframe_ack;
+    };
+} protocol_message_t;
+
+/**
+ * Writes `message` as JSON, null terminated, without allocating. Returns the
+ * length, or -1 when `size` is too short.
+ */
+int protocol_encode_json(const protocol_message_t *message, char *buffer, size_t size);
+/**
+ * Reads the JSON message of `length` characters, members in any order and
+ * unknown ones skipped. False when it is not valid, lacks a required field,
+ * or has an unknown event.
+ */
+bool protocol_decode_json(const char *json, size_t length, protocol_message_t *message);
+// The binary form, the length or -1 when `size` is too short
+int protocol_encode_binary(const protocol_message_t *message, uint8_t *buffer, size_t size);
+bool protocol_decode_binary(const uint8_t *data, size_t length, protocol_message_t *message);
+
+#endif // __PROTOCOL_H__
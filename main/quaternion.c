@@ -1,4 +1,5 @@
 #include <math.h>
+#include <stddef.h>
 #include "types.h"
 
 #define PI 3.14159265358979323846
@@ -41,6 +42,36 @@ quaternion_t quaternion_multiply(quaternion_t q1, quaternion_t q2)
     };
 }
 
+// Rotation by the rotation vector v (axis times angle)
+quaternion_t quaternion_exp(vector3_t v)
+{
+    float angle_squared = v.x * v.x + v.y * v.y + v.z * v.z;
+    float c, s;
+
+    if (angle_squared < .01f)
+    {
+        // Taylor series, exact in float below 0.1 rad and much cheaper than
+        // the trigonometric functions for per-sample gyro steps
+        float angle_fourth = angle_squared * angle_squared;
+        c = 1.f - angle_squared / 8.f + angle_fourth / 384.f;
+        s = .5f - angle_squared / 48.f + angle_fourth / 3840.f;
+    }
+    else
+    {
+        float angle = sqrtf(angle_squared);
+        c = cosf(angle * .5f);
+        s = sinf(angle * .5f) / angle;
+    }
+
+    return (quaternion_t){c, v.x * s, v.y * s, v.z * s};
+}
+
+quaternion_t quaternion_normalize(quaternion_t q)
+{
+    float norm = 1.f / sqrtf(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    return (quaternion_t){q.w * norm, q.x * norm, q.y * norm, q.z * norm};
+}
+
 vector3_t quaternion_rotate(quaternion_t q, vector3_t v)
 {
     quaternion_t qv = {0.f, v.x, v.y, v.z};
@@ -62,6 +93,11 @@ vector3_t quaternion_rotate(quaternion_t q, vector3_t v)
 // Similar to Madgwick scheme but uses proportional and integral filtering on
 // the error between estimated reference vectors and measured ones.
 void quaternion_mahony_update(quaternion_t *q, vector3_t *error, vector3_t accel, vector3_t gyro, vector3_t magnet, float dt)
+{
+    quaternion_mahony_update_gains(q, error, accel, gyro, magnet, Kp, Ki, dt);
+}
+
+void quaternion_mahony_update_gains(quaternion_t *q, vector3_t *error, vector3_t accel, vector3_t gyro, vector3_t magnet, float kp, float ki, float dt)
 {
     // short name local variable for readability
     float q1 = q->w, q2 = q->x, q3 = q->y, q4 = q->z;
@@ -124,9 +160,9 @@ void quaternion_mahony_update(quaternion_t *q, vector3_t *error, vector3_t accel
     ez = (ax * vy - ay * vx) + (mx * wy - my * wx);
 
     // Apply feedback terms
-    gx = gx + Kp * ex;
-    gy = gy + Kp * ey;
-    gz = gz + Kp * ez;
+    gx = gx + kp * ex;
+    gy = gy + kp * ey;
+    gz = gz + kp * ez;
     if (error != NULL)
     {
         // Accumulate integral error
@@ -135,9 +171,9 @@ void quaternion_mahony_update(quaternion_t *q, vector3_t *error, vector3_t accel
         error->z += ez;
 
         // Integral feedback
-        gx += Ki * error->x;
-        gy += Ki * error->y;
-        gz += Ki * error->z;
+        gx += ki * error->x;
+        gy += ki * error->y;
+        gz += ki * error->z;
     }
 
     // Integrate rate of change of quaternion
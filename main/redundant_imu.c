@@ -0,0 +1,291 @@
+#include <esp_log.h>
+#include <math.h>
+#include <string.h>
+#include "redundant_imu.h"
+
+// Weight of the newest sample in the averaged innovation
+#define INNOVATION_RATE .05f
+// Keeps a perfectly consistent channel from taking the whole blend
+#define INNOVATION_FLOOR .01f
+
+static const char *TAG = "Redundant IMU";
+
+static bool check_sample(const redundant_imu_t *imu, imu_channel_t *channel, const ahrs_sample_t *sample);
+static void drop(redundant_imu_t *imu, int index, imu_channel_state_t state);
+static void vote(redundant_imu_t *imu, int64_t now);
+static void blend(redundant_imu_t *imu);
+static float rotation_distance(quaternion_t a, quaternion_t b);
+
+redundant_imu_config_t redundant_imu_default_config()
+{
+    return (redundant_imu_config_t){
+        .max_read_failures = 5,
+        .max_repeated_samples = 25,
+        .recovery_samples = 50,
+        .disagreement_threshold = 5.f * (float)M_PI / 180.f,
+        .disagreement_time = 5.f,
+        .min_accel = .5f,
+        .max_accel = 2.f,
+    };
+}
+
+const char *imu_channel_state_name(imu_channel_state_t state)
+{
+    switch (state)
+    {
+    case IMU_CHANNEL_HEALTHY:
+        return "healthy";
+    case IMU_CHANNEL_FAILED:
+        return "failed";
+    case IMU_CHANNEL_STUCK:
+        return "stuck";
+    case IMU_CHANNEL_INCONSISTENT:
+        return "inconsistent";
+    default:
+        return "unknown";
+    }
+}
+
+void redundant_imu_init(redundant_imu_t *imu, const redundant_imu_config_t *config, const ahrs_config_t *ahrs_config, int channel_count)
+{
+    memset(imu, 0, sizeof(*imu));
+    imu->config = *config;
+    imu->channel_count = channel_count < REDUNDANT_IMU_MAX_CHANNELS ? channel_count : REDUNDANT_IMU_MAX_CHANNELS;
+    imu->rotation = QUATERNION_IDENTITY;
+
+    for (int i = 0; i < imu->channel_count; i++)
+    {
+        ahrs_init(&imu->channels[i].ahrs, ahrs_config);
+        imu->channels[i].state = IMU_CHANNEL_HEALTHY;
+        imu->channels[i].dead_reckoning = QUATERNION_IDENTITY;
+    }
+}
+
+void redundant_imu_set_ahrs_config(redundant_imu_t *imu, const ahrs_config_t *ahrs_config)
+{
+    for (int i = 0; i < imu->channel_count; i++)
+        ahrs_set_config(&imu->channels[i].ahrs, ahrs_config);
+}
+
+void redundant_imu_pause(redundant_imu_t *imu)
+{
+    for (int i = 0; i < imu->channel_count; i++)
+        ahrs_pause(&imu->channels[i].ahrs);
+}
+
+bool redundant_imu_update(redundant_imu_t *imu, const ahrs_sample_t samples[], const bool valid[])
+{
+    int64_t now = 0;
+
+    for (int i = 0; i < imu->channel_count; i++)
+    {
+        imu_channel_t *channel = &imu->channels[i];
+        int64_t previous_timestamp = channel->last_sample.timestamp;
+
+        if (!valid[i] || !check_sample(imu, channel, &samples[i]))
+        {
+            channel->good_samples = 0;
+            channel->stale = true;
+
+            if (++channel->read_failures >= imu->config.max_read_failures && channel->state == IMU_CHANNEL_HEALTHY)
+                drop(imu, i, IMU_CHANNEL_FAILED);
+
+            continue;
+        }
+
+        channel->read_failures = 0;
+        now = samples[i].timestamp;
+
+        if (channel->repeated_samples >= imu->config.max_repeated_samples)
+        {
+            if (channel->state == IMU_CHANNEL_HEALTHY)
+                drop(imu, i, IMU_CHANNEL_STUCK);
+
+            channel->good_samples = 0;
+            channel->stale = true;
+            continue;
+        }
+
+        if (channel->state != IMU_CHANNEL_HEALTHY && channel->stale)
+        {
+            // A silent or stuck channel comes back: restart its filter from
+            // the fused rotation
+            ahrs_reset(&channel->ahrs, imu->rotation);
+            channel->innovation = 0.f;
+        }
+        channel->stale = false;
+
+        ahrs_update_batch(&channel->ahrs, &samples[i], 1);
+
+        float dt = previous_timestamp != 0 ? (samples[i].timestamp - previous_timestamp) * 1e-6f : 0.f;
+        vector3_t angle = {samples[i].gyro.x * dt, samples[i].gyro.y * dt, samples[i].gyro.z * dt};
+        channel->dead_reckoning = quaternion_normalize(quaternion_multiply(channel->dead_reckoning, quaternion_exp(angle)));
+
+        vector3_t measured = vector3_normalize(samples[i].accel);
+        vector3_t estimated = quaternion_rotate(quaternion_inverse(channel->ahrs.rotation), VECTOR3_UP);
+        float innovation = acosf(fminf(fmaxf(vector3_dot(measured, estimated), -1.f), 1.f));
+        channel->innovation += INNOVATION_RATE * (innovation - channel->innovation);
+
+        if (channel->state == IMU_CHANNEL_HEALTHY)
+            continue;
+
+        // A dropped channel keeps filtering and is used again once it has
+        // agreed with the fused rotation for long enough
+        bool consistent = redundant_imu_healthy_count(imu) == 0 ||
+                          rotation_distance(channel->ahrs.rotation, imu->rotation) < imu->config.disagreement_threshold;
+        channel->good_samples = consistent ? channel->good_samples + 1 : 0;
+
+        if (channel->good_samples >= imu->config.recovery_samples)
+        {
+            channel->state = IMU_CHANNEL_HEALTHY;
+            ESP_LOGI(TAG, "Channel %d recovered.", i);
+        }
+    }
+
+    vote(imu, now);
+
+    if (redundant_imu_healthy_count(imu) == 0)
+        return false;
+
+    blend(imu);
+    return true;
+}
+
+int redundant_imu_healthy_count(const redundant_imu_t *imu)
+{
+    int count = 0;
+
+    for (int i = 0; i < imu->channel_count; i++)
+        count += imu->channels[i].state == IMU_CHANNEL_HEALTHY;
+
+    return count;
+}
+
+// Range checks the sample and tracks how long the raw output stayed identical.
+// Real sensor noise always moves the last bits, so a frozen output means a
+// hung device or a bus returning stale data.
+static bool check_sample(const redundant_imu_t *imu, imu_channel_t *channel, const ahrs_sample_t *sample)
+{
+    float accel = vector3_magnitude(sample->accel);
+
+    if (!(accel >= imu->config.min_accel && accel <= imu->config.max_accel) ||
+        !isfinite(vector3_magnitude(sample->gyro)) || !isfinite(vector3_magnitude(sample->magnet)))
+        return false;
+
+    bool repeated = memcmp(&sample->accel, &channel->last_sample.accel, sizeof(sample->accel)) == 0 &&
+                    memcmp(&sample->gyro, &channel->last_sample.gyro, sizeof(sample->gyro)) == 0 &&
+                    memcmp(&sample->magnet, &channel->last_sample.magnet, sizeof(sample->magnet)) == 0;
+
+    channel->repeated_samples = repeated ? channel->repeated_samples + 1 : 0;
+    channel->last_sample = *sample;
+
+    return true;
+}
+
+static void drop(redundant_imu_t *imu, int index, imu_channel_state_t state)
+{
+    imu->channels[index].state = state;
+    imu->channels[index].good_samples = 0;
+    imu->dropped++;
+
+    ESP_LOGW(TAG, "Channel %d dropped: %s, %d healthy left.", index, imu_channel_state_name(state), redundant_imu_healthy_count(imu));
+}
+
+// When the healthy channels disagree for too long, the one furthest from the
+// others and from its own dead reckoning is dropped. With two channels both
+// are equally far apart, so the dead reckoning decides.
+static void vote(redundant_imu_t *imu, int64_t now)
+{
+    float scores[REDUNDANT_IMU_MAX_CHANNELS] = {0};
+    float max_distance = 0.f;
+
+    for (int i = 0; i < imu->channel_count; i++)
+    {
+        if (imu->channels[i].state != IMU_CHANNEL_HEALTHY)
+            continue;
+
+        for (int j = i + 1; j < imu->channel_count; j++)
+        {
+            if (imu->channels[j].state != IMU_CHANNEL_HEALTHY)
+                continue;
+
+            float distance = rotation_distance(imu->channels[i].ahrs.rotation, imu->channels[j].ahrs.rotation);
+            scores[i] += distance;
+            scores[j] += distance;
+            max_distance = fmaxf(max_distance, distance);
+        }
+    }
+
+    // Re-anchor the dead reckoning while the channels clearly agree, before a
+    // slowly diverging channel has dragged the blend along
+    if (max_distance < .5f * imu->config.disagreement_threshold)
+    {
+        for (int i = 0; i < imu->channel_count; i++)
+            imu->channels[i].dead_reckoning = imu->channels[i].ahrs.rotation;
+    }
+
+    if (max_distance <= imu->config.disagreement_threshold)
+    {
+        imu->disagreeing_since = 0;
+        return;
+    }
+
+    if (imu->disagreeing_since == 0)
+        imu->disagreeing_since = now;
+
+    if ((now - imu->disagreeing_since) * 1e-6f < imu->config.disagreement_time)
+        return;
+
+    int worst = -1;
+
+    for (int i = 0; i < imu->channel_count; i++)
+    {
+        if (imu->channels[i].state != IMU_CHANNEL_HEALTHY)
+            continue;
+
+        scores[i] += rotation_distance(imu->channels[i].ahrs.rotation, imu->channels[i].dead_reckoning);
+
+        if (worst < 0 || scores[i] > scores[worst])
+            worst = i;
+    }
+
+    drop(imu, worst, IMU_CHANNEL_INCONSISTENT);
+    imu->disagreeing_since = 0;
+}
+
+// Weighted average of the healthy rotations. The channels are close to each
+// other, so the normalized sum is an accurate mean.
+static void blend(redundant_imu_t *imu)
+{
+    quaternion_t sum = {0.f, 0.f, 0.f, 0.f};
+    quaternion_t reference = imu->rotation;
+
+    for (int i = 0; i < imu->channel_count; i++)
+    {
+        const imu_channel_t *channel = &imu->channels[i];
+
+        if (channel->state != IMU_CHANNEL_HEALTHY)
+            continue;
+
+        quaternion_t q = channel->ahrs.rotation;
+        float weight = 1.f / (channel->innovation + INNOVATION_FLOOR);
+
+        // q and -q are the same rotation: add them on the same side
+        if (q.w * reference.w + q.x * reference.x + q.y * reference.y + q.z * reference.z < 0.f)
+            weight = -weight;
+
+        sum.w += weight * q.w;
+        sum.x += weight * q.x;
+        sum.y += weight * q.y;
+        sum.z += weight * q.z;
+    }
+
+    imu->rotation = quaternion_normalize(sum);
+}
+
+static float rotation_distance(quaternion_t a, quaternion_t b)
+{
+    float dot = fabsf(a.w * b.w + a.x * b.x + a.y * b.y + a.z * b.z);
+
+    return 2.f * acosf(fminf(dot, 1.f));
+}
@@ -0,0 +1,80 @@
+#ifndef __REDUNDANT_IMU_H__
+#define __REDUNDANT_IMU_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "ahrs.h"
+
+#define REDUNDANT_IMU_MAX_CHANNELS 2
+
+typedef enum imu_channel_state_t
+{
+    IMU_CHANNEL_HEALTHY,
+    // Too many consecutive reads failed or were out of range
+    IMU_CHANNEL_FAILED,
+    // The raw output did not change
+    IMU_CHANNEL_STUCK,
+    // Outvoted after disagreeing with the other channels
+    IMU_CHANNEL_INCONSISTENT,
+} imu_channel_state_t;
+
+typedef struct redundant_imu_config_t
+{
+    // Consecutive failed or implausible reads before a channel is dropped
+    uint32_t max_read_failures;
+    // Consecutive bit-identical samples before a channel is considered stuck
+    uint32_t max_repeated_samples;
+    // Consecutive good samples, consistent with the blended rotation, before a
+    // dropped channel is fused again
+    uint32_t recovery_samples;
+    // Angle (rad) between two channel rotations that counts as a disagreement,
+    // and how long (s) it may last before the least trusted channel is dropped
+    float disagreement_threshold;
+    float disagreement_time;
+    // Plausible accel norm range (g)
+    float min_accel;
+    float max_accel;
+} redundant_imu_config_t;
+
+typedef struct imu_channel_t
+{
+    ahrs_t ahrs;
+    imu_channel_state_t state;
+    uint32_t read_failures;
+    uint32_t repeated_samples;
+    uint32_t good_samples;
+    ahrs_sample_t last_sample;
+    // The filter missed samples
+    bool stale;
+    // Averaged angle (rad) between the measured and the estimated gravity,
+    // a channel with a smaller one is trusted more
+    float innovation;
+    // Gyro-only propagation of the rotation from when the channels last
+    // agreed. The channel pulled away from it by its own accel and magnet
+    // corrections is the faulty one.
+    quaternion_t dead_reckoning;
+} imu_channel_t;
+
+typedef struct redundant_imu_t
+{
+    redundant_imu_config_t config;
+    imu_channel_t channels[REDUNDANT_IMU_MAX_CHANNELS];
+    int channel_count;
+    // Blended rotation of the healthy channels
+    quaternion_t rotation;
+    int64_t disagreeing_since;
+    uint32_t dropped;
+} redundant_imu_t;
+
+redundant_imu_config_t redundant_imu_default_config();
+const char *imu_channel_state_name(imu_channel_state_t state);
+
+void redundant_imu_init(redundant_imu_t *imu, const redundant_imu_config_t *config, const ahrs_config_t *ahrs_config, int channel_count);
+void redundant_imu_set_ahrs_config(redundant_imu_t *imu, const ahrs_config_t *ahrs_config);
+void redundant_imu_pause(redundant_imu_t *imu);
+// samples[i] is only used when valid[i]. Returns false when no channel is
+// healthy, in which case the rotation is left as it was.
+bool redundant_imu_update(redundant_imu_t *imu, const ahrs_sample_t samples[], const bool valid[]);
+int redundant_imu_healthy_count(const redundant_imu_t *imu);
+
+#endif // __REDUNDANT_IMU_H__
@@ -20,6 +20,19 @@ calibration_t calibration = {
     .mag_scale = {.x = 0.015385f, .y = 0.014286f, .z = -0.015385f},
 };
 
+#ifdef CONFIG_DUAL_IMU
+bool secondary_initialized = false;
+// Uncalibrated until the secondary IMU goes through the calibration procedure
+calibration_t secondary_calibration = {
+    .accel_offset = {.x = 0.0f, .y = 0.0f, .z = 0.0f},
+    .accel_scale_lo = {.x = -1.0f, .y = -1.0f, .z = -1.0f},
+    .accel_scale_hi = {.x = 1.0f, .y = 1.0f, .z = 1.0f},
+    .gyro_bias_offset = {.x = 0.0f, .y = 0.0f, .z = 0.0f},
+    .mag_offset = {.x = 0.0f, .y = 0.0f, .z = 0.0f},
+    .mag_scale = {.x = 1.0f, .y = 1.0f, .z = 1.0f},
+};
+#endif
+
 void sensor_init()
 {
     ESP_LOGI("Sensor", "Initializing...");
@@ -30,6 +43,24 @@ void sensor_init()
     } else {
         ESP_LOGE("Sensor", "Error initializing.");
     }
+
+#ifdef CONFIG_DUAL_IMU
+    if (initialized && i2c_mpu9250_init_secondary(&secondary_calibration) == ESP_OK) {
+        secondary_initialized = true;
+        ESP_LOGI("Sensor", "Secondary IMU initialized.");
+    } else {
+        ESP_LOGE("Sensor", "Error initializing the secondary IMU, it will be reported as failed.");
+    }
+#endif
+}
+
+int sensor_count()
+{
+#ifdef CONFIG_DUAL_IMU
+    return 2;
+#else
+    return 1;
+#endif
 }
 
 void sensor_read(vector3_t *accel, vector3_t *gyro, vector3_t *magnet)
@@ -57,3 +88,49 @@ void sensor_read(vector3_t *accel, vector3_t *gyro, vector3_t *magnet)
     magnet->y = vm.x;
     magnet->z = vm.z;
 }
+
+static void copy_reading(vector_t va, vector_t vg, vector_t vm, vector3_t *accel, vector3_t *gyro, vector3_t *magnet)
+{
+    accel->x = va.x;
+    accel->y = va.y;
+    accel->z = va.z;
+    gyro->x = vg.x;
+    gyro->y = vg.y;
+    gyro->z = vg.z;
+    // Swap X and Y components because of alignment issue
+    magnet->x = vm.y;
+    magnet->y = vm.x;
+    magnet->z = vm.z;
+}
+
+void sensor_read_all(vector3_t accel[], vector3_t gyro[], vector3_t magnet[], bool valid[])
+{
+    valid[0] = false;
+#ifdef CONFIG_DUAL_IMU
+    valid[1] = false;
+#endif
+
+    if (!initialized) return;
+
+#ifdef CONFIG_DUAL_IMU
+    vector_t va[2], vg[2], vm[2];
+    esp_err_t results[2];
+
+    get_accel_gyro_mag_dual(va, vg, vm, results);
+
+    for (int i = 0; i < 2; i++)
+    {
+        valid[i] = results[i] == ESP_OK;
+
+        if (valid[i])
+            copy_reading(va[i], vg[i], vm[i], &accel[i], &gyro[i], &magnet[i]);
+    }
+#else
+    vector_t va, vg, vm;
+
+    valid[0] = get_accel_gyro_mag(&va, &vg, &vm) == ESP_OK;
+
+    if (valid[0])
+        copy_reading(va, vg, vm, &accel[0], &gyro[0], &magnet[0]);
+#endif
+}
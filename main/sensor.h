@@ -6,5 +6,9 @@
 
 void sensor_init();
 void sensor_read(vector3_t* accel, vector3_t *gyro, vector3_t *magnet);
+// Number of IMUs read by sensor_read_all
+int sensor_count();
+// Reads every IMU in one bus transaction, valid[i] tells whether IMU i answered
+void sensor_read_all(vector3_t accel[], vector3_t gyro[], vector3_t magnet[], bool valid[]);
 
 #endif // SENSOR_H
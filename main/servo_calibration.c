@@ -0,0 +1,69 @@
+#include <math.h>
+#include "servo_calibration.h"
+
+servo_calibration_t servo_calibration_linear(float min_angle, float min_pulse_width, float max_angle, float max_pulse_width)
+{
+    return (servo_calibration_t){
+        .points = {
+            {.angle = min_angle, .pulse_width = min_pulse_width},
+            {.angle = max_angle, .pulse_width = max_pulse_width},
+        },
+        .count = 2,
+    };
+}
+
+bool servo_calibration_is_valid(const servo_calibration_t *calibration)
+{
+    if (calibration->count < 2 || calibration->count > SERVO_CALIBRATION_MAX_POINTS)
+        return false;
+
+    const servo_calibration_point_t *points = calibration->points;
+    float direction = points[calibration->count - 1].pulse_width - points[0].pulse_width;
+
+    for (int i = 0; i < calibration->count; i++)
+    {
+        if (!isfinite(points[i].angle) ||
+            !(points[i].pulse_width >= SERVO_CALIBRATION_MIN_PULSE && points[i].pulse_width <= SERVO_CALIBRATION_MAX_PULSE))
+            return false;
+
+        // The servo must not turn back within the range, or an angle
+        // would have two pulse widths
+        if (i > 0 && (points[i].angle <= points[i - 1].angle || (points[i].pulse_width - points[i - 1].pulse_width) * direction <= 0.f))
+            return false;
+    }
+
+    return true;
+}
+
+float servo_calibration_pulse_width(const servo_calibration_t *calibration, float angle)
+{
+    const servo_calibration_point_t *points = calibration->points;
+    int last = calibration->count - 1;
+
+    if (angle <= points[0].angle)
+        return points[0].pulse_width;
+    if (angle >= points[last].angle)
+        return points[last].pulse_width;
+
+    // Bisection for the points around the angle
+    int low = 0, high = last;
+    while (high - low > 1)
+    {
+        int middle = (low + high) / 2;
+
+        if (points[middle].angle <= angle)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    float t = (angle - points[low].angle) / (points[high].angle - points[low].angle);
+    return points[low].pulse_width + t * (points[high].pulse_width - points[low].pulse_width);
+}
+
+uint32_t servo_calibration_duty(const servo_calibration_t *calibration, float angle, int resolution, int frequency)
+{
+    float period = 1e6f / frequency;
+
+    return lroundf(servo_calibration_pulse_width(calibration, angle) / period * (float)(1u << resolution));
+}
@@ -0,0 +1,37 @@
+#ifndef __SERVO_CALIBRATION_H__
+#define __SERVO_CALIBRATION_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define SERVO_CALIBRATION_MAX_POINTS 16
+// Pulse widths (us) a servo may be driven with
+#define SERVO_CALIBRATION_MIN_PULSE 300.f
+#define SERVO_CALIBRATION_MAX_PULSE 2700.f
+
+typedef struct servo_calibration_point_t
+{
+    // Degree
+    float angle;
+    // Microsecond
+    float pulse_width;
+} servo_calibration_point_t;
+
+// Measured angle to pulse width table of one servo, interpolated linearly
+// between points, which are sorted by increasing angle
+typedef struct servo_calibration_t
+{
+    servo_calibration_point_t points[SERVO_CALIBRATION_MAX_POINTS];
+    int count;
+} servo_calibration_t;
+
+// Two point table of an ideal, linear servo
+servo_calibration_t servo_calibration_linear(float min_angle, float min_pulse_width, float max_angle, float max_pulse_width);
+// At least two points, strictly increasing angles, monotonic pulse widths within the servo limits
+bool servo_calibration_is_valid(const servo_calibration_t *calibration);
+// Pulse width (us) of an angle, clamped to the table range
+float servo_calibration_pulse_width(const servo_calibration_t *calibration, float angle);
+// LEDC duty of an angle for a timer of `resolution` bits at `frequency` Hz
+uint32_t servo_calibration_duty(const servo_calibration_t *calibration, float angle, int resolution, int frequency);
+
+#endif // __SERVO_CALIBRATION_H__
@@ -0,0 +1,90 @@
+#include <math.h>
+#include <string.h>
+#include "servo_feedback.h"
+
+static float trimmed_mean(uint16_t *samples, int count, float trim);
+
+servo_feedback_config_t servo_feedback_default_config()
+{
+    // Taps spanning most of the 12 bit range over the servo travel, measure
+    // the actual ends before relying on the absolute angles
+    return (servo_feedback_config_t){
+        .channels = {6, 7},
+        .sample_rate = 20000,
+        .raw_min = {3700.f, 400.f},
+        .raw_max = {400.f, 3700.f},
+        .angle_min = {0.f, -90.f},
+        .angle_max = {180.f, 90.f},
+        .trim = .2f,
+    };
+}
+
+esp_err_t servo_feedback_init(servo_feedback_t *feedback, const servo_feedback_ops_t *ops, const servo_feedback_config_t *config, void *context)
+{
+    *feedback = (servo_feedback_t){
+        .ops = ops,
+        .config = *config,
+        .context = context,
+    };
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+        feedback->angles[axis] = NAN;
+
+    return ops->start(feedback);
+}
+
+void servo_feedback_update(servo_feedback_t *feedback, bool valid[MOTORS_AXES])
+{
+    static uint16_t samples[MOTORS_AXES][SERVO_FEEDBACK_MAX_BATCH];
+    int counts[MOTORS_AXES] = {0};
+
+    feedback->ops->read(feedback, samples, counts);
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        valid[axis] = counts[axis] > 0;
+        if (!valid[axis])
+            continue;
+
+        feedback->angles[axis] = servo_feedback_angle(&feedback->config, axis, trimmed_mean(samples[axis], counts[axis], feedback->config.trim));
+        feedback->conversions += counts[axis];
+    }
+}
+
+float servo_feedback_angle(const servo_feedback_config_t *config, int axis, float raw)
+{
+    float t = (raw - config->raw_min[axis]) / (config->raw_max[axis] - config->raw_min[axis]);
+
+    return config->angle_min[axis] + t * (config->angle_max[axis] - config->angle_min[axis]);
+}
+
+float servo_feedback_raw(const servo_feedback_config_t *config, int axis, float angle)
+{
+    float t = (angle - config->angle_min[axis]) / (config->angle_max[axis] - config->angle_min[axis]);
+
+    return config->raw_min[axis] + t * (config->raw_max[axis] - config->raw_min[axis]);
+}
+
+// Motor and PWM spikes land in the dropped tails, the mean of the rest
+// averages the noise down
+static float trimmed_mean(uint16_t *samples, int count, float trim)
+{
+    // Insertion sort, batches are small
+    for (int i = 1; i < count; i++)
+    {
+        uint16_t sample = samples[i];
+        int j = i;
+
+        for (; j > 0 && samples[j - 1] > sample; j--)
+            samples[j] = samples[j - 1];
+        samples[j] = sample;
+    }
+
+    int dropped = trim * count;
+    uint32_t sum = 0;
+
+    for (int i = dropped; i < count - dropped; i++)
+        sum += samples[i];
+
+    return (float)sum / (count - 2 * dropped);
+}
@@ -0,0 +1,73 @@
+#ifndef __SERVO_FEEDBACK_H__
+#define __SERVO_FEEDBACK_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "actuator.h"
+
+// Conversions per axis filtered together at most
+#define SERVO_FEEDBACK_MAX_BATCH 64
+
+typedef struct servo_feedback_t servo_feedback_t;
+
+/**
+ * Sources of potentiometer conversions. `read` hands over the raw
+ * conversions gathered since the previous call, at most
+ * SERVO_FEEDBACK_MAX_BATCH per axis, without blocking.
+ */
+typedef struct servo_feedback_ops_t
+{
+    const char *name;
+    esp_err_t (*start)(servo_feedback_t *feedback);
+    void (*read)(servo_feedback_t *feedback, uint16_t samples[MOTORS_AXES][SERVO_FEEDBACK_MAX_BATCH], int counts[MOTORS_AXES]);
+} servo_feedback_ops_t;
+
+typedef struct servo_feedback_config_t
+{
+    // ADC1 channel of each potentiometer tap
+    int channels[MOTORS_AXES];
+    // Conversions per second, shared by the axes
+    uint32_t sample_rate;
+    // Potentiometer map: raw readings measured at two angles (degree)
+    float raw_min[MOTORS_AXES];
+    float raw_max[MOTORS_AXES];
+    float angle_min[MOTORS_AXES];
+    float angle_max[MOTORS_AXES];
+    // Share of the lowest and of the highest conversions dropped from a batch
+    float trim;
+} servo_feedback_config_t;
+
+struct servo_feedback_t
+{
+    const servo_feedback_ops_t *ops;
+    servo_feedback_config_t config;
+    void *context;
+    // Filtered angle (degree) of each axis, from the last batch
+    float angles[MOTORS_AXES];
+    uint32_t conversions;
+};
+
+// Host stand-in source: conversions of a potentiometer at `angles`, with noise
+// and occasional spikes
+typedef struct servo_feedback_sim_t
+{
+    float angles[MOTORS_AXES];
+    // Raw count noise, spike probability per conversion, conversions per read
+    float noise;
+    float spike_rate;
+    int batch;
+    uint32_t seed;
+} servo_feedback_sim_t;
+
+extern const servo_feedback_ops_t servo_feedback_adc_ops;
+extern const servo_feedback_ops_t servo_feedback_sim_ops;
+
+servo_feedback_config_t servo_feedback_default_config();
+esp_err_t servo_feedback_init(servo_feedback_t *feedback, const servo_feedback_ops_t *ops, const servo_feedback_config_t *config, void *context);
+// Filters the conversions since the last call. valid[i] is false when axis i got none.
+void servo_feedback_update(servo_feedback_t *feedback, bool valid[MOTORS_AXES]);
+// Angle of a raw reading, and the other way around
+float servo_feedback_angle(const servo_feedback_config_t *config, int axis, float raw);
+float servo_feedback_raw(const servo_feedback_config_t *config, int axis, float angle);
+
+#endif // __SERVO_FEEDBACK_H__
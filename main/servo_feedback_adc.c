@@ -0,0 +1,75 @@
+#include <driver/adc.h>
+#include "servo_feedback.h"
+
+// DMA frame size, two bytes per conversion
+#define FRAME_BYTES 256
+#define POOL_BYTES 1024
+
+static esp_err_t servo_feedback_adc_start(servo_feedback_t *feedback)
+{
+    const servo_feedback_config_t *config = &feedback->config;
+    adc_digi_init_config_t init_config = {
+        .max_store_buf_size = POOL_BYTES,
+        .conv_num_each_intr = FRAME_BYTES,
+        .adc1_chan_mask = BIT(config->channels[MOTOR_AZIMUTH]) | BIT(config->channels[MOTOR_INCLINATION]),
+        .adc2_chan_mask = 0,
+    };
+    adc_digi_pattern_config_t patterns[MOTORS_AXES];
+    adc_digi_configuration_t digi_config = {
+        .conv_limit_en = true,
+        .conv_limit_num = 250,
+        .pattern_num = MOTORS_AXES,
+        .adc_pattern = patterns,
+        .sample_freq_hz = config->sample_rate,
+        .conv_mode = ADC_CONV_SINGLE_UNIT_1,
+        .format = ADC_DIGI_OUTPUT_FORMAT_TYPE1,
+    };
+    esp_err_t result;
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        patterns[axis] = (adc_digi_pattern_config_t){
+            .atten = ADC_ATTEN_DB_11,
+            .channel = config->channels[axis],
+            .unit = 0,
+            .bit_width = SOC_ADC_DIGI_MAX_BITWIDTH,
+        };
+    }
+
+    if ((result = adc_digi_initialize(&init_config)) != ESP_OK ||
+        (result = adc_digi_controller_configure(&digi_config)) != ESP_OK)
+        return result;
+
+    return adc_digi_start();
+}
+
+// Drains the DMA pool, the newest conversions of each axis are kept
+static void servo_feedback_adc_read(servo_feedback_t *feedback, uint16_t samples[MOTORS_AXES][SERVO_FEEDBACK_MAX_BATCH], int counts[MOTORS_AXES])
+{
+    static uint8_t frame[FRAME_BYTES];
+    uint32_t received[MOTORS_AXES] = {0};
+    uint32_t length = 0;
+
+    while (adc_digi_read_bytes(frame, sizeof(frame), &length, 0) == ESP_OK && length > 0)
+    {
+        for (uint32_t i = 0; i + sizeof(adc_digi_output_data_t) <= length; i += sizeof(adc_digi_output_data_t))
+        {
+            const adc_digi_output_data_t *conversion = (const adc_digi_output_data_t *)&frame[i];
+
+            for (int axis = 0; axis < MOTORS_AXES; axis++)
+            {
+                if (conversion->type1.channel == feedback->config.channels[axis])
+                    samples[axis][received[axis]++ % SERVO_FEEDBACK_MAX_BATCH] = conversion->type1.data;
+            }
+        }
+    }
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+        counts[axis] = received[axis] < SERVO_FEEDBACK_MAX_BATCH ? received[axis] : SERVO_FEEDBACK_MAX_BATCH;
+}
+
+const servo_feedback_ops_t servo_feedback_adc_ops = {
+    .name = "ADC continuous",
+    .start = servo_feedback_adc_start,
+    .read = servo_feedback_adc_read,
+};
@@ -0,0 +1,53 @@
+#include <math.h>
+#include <stddef.h>
+#include "servo_feedback.h"
+
+static float noise(uint32_t *seed);
+
+static esp_err_t servo_feedback_sim_start(servo_feedback_t *feedback)
+{
+    return feedback->context != NULL ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+static void servo_feedback_sim_read(servo_feedback_t *feedback, uint16_t samples[MOTORS_AXES][SERVO_FEEDBACK_MAX_BATCH], int counts[MOTORS_AXES])
+{
+    servo_feedback_sim_t *simulation = feedback->context;
+    int batch = simulation->batch < SERVO_FEEDBACK_MAX_BATCH ? simulation->batch : SERVO_FEEDBACK_MAX_BATCH;
+
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+    {
+        float raw = servo_feedback_raw(&feedback->config, axis, simulation->angles[axis]);
+
+        for (int i = 0; i < batch; i++)
+        {
+            simulation->seed = simulation->seed * 1664525u + 1013904223u;
+            float value = (simulation->seed >> 8) * (1.f / 16777216.f) < simulation->spike_rate
+                              ? (simulation->seed & 1 ? 4095.f : 0.f)
+                              : raw + simulation->noise * noise(&simulation->seed);
+
+            samples[axis][i] = fminf(fmaxf(roundf(value), 0.f), 4095.f);
+        }
+
+        counts[axis] = batch;
+    }
+}
+
+// Roughly normal, unit deviation
+static float noise(uint32_t *seed)
+{
+    float sum = 0.f;
+
+    for (int i = 0; i < 4; i++)
+    {
+        *seed = *seed * 1664525u + 1013904223u;
+        sum += (*seed >> 8) * (1.f / 16777216.f) - .5f;
+    }
+
+    return sum * sqrtf(3.f);
+}
+
+const servo_feedback_ops_t servo_feedback_sim_ops = {
+    .name = "simulation",
+    .start = servo_feedback_sim_start,
+    .read = servo_feedback_sim_read,
+};
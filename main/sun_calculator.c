@@ -1,10 +1,15 @@
+#include <math.h>
 #include <time.h>
 #include <sun_calc.h>
+#include "compensation.h"
 #include "sun_calculator.h"
 
 #define PI 3.14159265358979323846
 #define rad (PI / 180.f)
 
+// Half the span (s) of the central difference giving the sun rate
+#define SUN_RATE_SPAN 60
+
 orientation_t get_sun_orientation(time_t time, float latitude, float longitude)
 {
     sun_coords_t sun_coords = sunCalcGetPosition(time, latitude, longitude);
@@ -13,3 +18,18 @@ orientation_t get_sun_orientation(time_t time, float latitude, float longitude)
     orientation.inclination = 90.f - sun_coords.altitude / rad;
     return orientation;
 }
+
+float get_sun_angular_rate(time_t time, float latitude, float longitude)
+{
+    vector3_t before = compensation_direction(get_sun_orientation(time - SUN_RATE_SPAN, latitude, longitude));
+    vector3_t after = compensation_direction(get_sun_orientation(time + SUN_RATE_SPAN, latitude, longitude));
+
+    return acosf(fminf(fmaxf(vector3_dot(before, after), -1.f), 1.f)) / rad / (2 * SUN_RATE_SPAN);
+}
+
+float get_sun_lookahead(time_t time, float latitude, float longitude, float dead_band, float max_lookahead)
+{
+    float rate = get_sun_angular_rate(time, latitude, longitude);
+
+    return rate * max_lookahead > .5f * dead_band ? .5f * dead_band / rate : max_lookahead;
+}
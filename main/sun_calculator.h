@@ -1,8 +1,17 @@
 #ifndef SUN_CALCULATOR_H
 #define SUN_CALCULATOR_H
 
+#include <time.h>
 #include "types.h"
 
 orientation_t get_sun_orientation(time_t time, float latitude, float longitude);
+// Angular speed (degree per second) of the sun across the sky, from the ephemeris derivative
+float get_sun_angular_rate(time_t time, float latitude, float longitude);
+/**
+ * How far ahead (s) to aim so that the panel leads the sun by half a dead band
+ * (degree) after a move and trails it by half when the next one starts: the
+ * middle of the hold interval. At most `max_lookahead`.
+ */
+float get_sun_lookahead(time_t time, float latitude, float longitude, float dead_band, float max_lookahead);
 
 #endif // SUN_CALCULATOR_H
@@ -0,0 +1,100 @@
+#include <math.h>
+#include <string.h>
+#include "telemetry_delta.h"
+
+const telemetry_delta_field_t telemetry_delta_fields[TELEMETRY_DELTA_FIELDS] = {
+    {"platformRotation", "w", 1e-4f},
+    {"platformRotation", "x", 1e-4f},
+    {"platformRotation", "y", 1e-4f},
+    {"platformRotation", "z", 1e-4f},
+    {"panelOrientation", "azimuth", .01f},
+    {"panelOrientation", "inclination", .01f},
+    {"motorsRotation", "azimuth", .01f},
+    {"motorsRotation", "inclination", .01f},
+    {"motorsEnergized", "azimuth", .1f},
+    {"motorsEnergized", "inclination", .1f},
+};
+
+static void quantize(const float values[TELEMETRY_DELTA_FIELDS], int32_t steps[TELEMETRY_DELTA_FIELDS]);
+
+telemetry_delta_config_t telemetry_delta_default_config()
+{
+    return (telemetry_delta_config_t){
+        .keyframe_period = 10.f,
+        .ack_timeout = 2.f,
+    };
+}
+
+void telemetry_delta_init(telemetry_delta_t *delta, const telemetry_delta_config_t *config)
+{
+    *delta = (telemetry_delta_t){
+        .config = *config,
+        .next_keyframe = 1,
+    };
+}
+
+telemetry_delta_frame_t telemetry_delta_next(telemetry_delta_t *delta, const float values[TELEMETRY_DELTA_FIELDS], float dt, uint32_t *keyframe)
+{
+    int32_t steps[TELEMETRY_DELTA_FIELDS];
+    bool ack_overdue = delta->pending && (delta->pending_age += dt) >= delta->config.ack_timeout;
+
+    quantize(values, steps);
+    delta->since_keyframe += dt;
+
+    // A keyframe still in flight is given its time, unless it got lost
+    if ((!delta->pending || ack_overdue) && (!delta->acked || delta->since_keyframe >= delta->config.keyframe_period))
+    {
+        delta->pending = true;
+        delta->pending_keyframe = delta->next_keyframe++;
+        delta->pending_age = 0.f;
+        memcpy(delta->pending_values, steps, sizeof(steps));
+        memcpy(delta->sent_values, steps, sizeof(steps));
+        delta->since_keyframe = 0.f;
+        delta->stats.keyframes++;
+        *keyframe = delta->pending_keyframe;
+        return TELEMETRY_DELTA_KEYFRAME;
+    }
+
+    if (!delta->acked || memcmp(steps, delta->sent_values, sizeof(steps)) == 0)
+    {
+        delta->stats.unchanged++;
+        return TELEMETRY_DELTA_UNCHANGED;
+    }
+
+    memcpy(delta->sent_values, steps, sizeof(steps));
+    for (int i = 0; i < TELEMETRY_DELTA_FIELDS; i++)
+        delta->stats.changes += steps[i] != delta->acked_values[i];
+    delta->stats.deltas++;
+    *keyframe = delta->acked_keyframe;
+    return TELEMETRY_DELTA_DELTA;
+}
+
+void telemetry_delta_ack(telemetry_delta_t *delta, uint32_t keyframe)
+{
+    if (!delta->pending || keyframe != delta->pending_keyframe)
+        return;
+
+    delta->pending = false;
+    delta->acked = true;
+    delta->acked_keyframe = keyframe;
+    memcpy(delta->acked_values, delta->pending_values, sizeof(delta->acked_values));
+}
+
+int telemetry_delta_changes(const telemetry_delta_t *delta, protocol_delta_change_t changes[TELEMETRY_DELTA_FIELDS])
+{
+    int count = 0;
+
+    for (int i = 0; i < TELEMETRY_DELTA_FIELDS; i++)
+    {
+        if (delta->sent_values[i] != delta->acked_values[i])
+            changes[count++] = (protocol_delta_change_t){.index = i, .steps = delta->sent_values[i]};
+    }
+
+    return count;
+}
+
+static void quantize(const float values[TELEMETRY_DELTA_FIELDS], int32_t steps[TELEMETRY_DELTA_FIELDS])
+{
+    for (int i = 0; i < TELEMETRY_DELTA_FIELDS; i++)
+        steps[i] = lroundf(values[i] / telemetry_delta_fields[i].step);
+}
@@ -0,0 +1,82 @@
+#ifndef __TELEMETRY_DELTA_H__
+#define __TELEMETRY_DELTA_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "protocol.h"
+
+// The platform rotation, panel orientation, motors rotation and motors
+// energized time, in the order of telemetry_delta_fields
+#define TELEMETRY_DELTA_FIELDS 10
+
+typedef struct telemetry_delta_field_t
+{
+    // Object and member in the full state
+    const char *object;
+    const char *member;
+    // Quantization step, deltas carry the value in steps
+    float step;
+} telemetry_delta_field_t;
+
+extern const telemetry_delta_field_t telemetry_delta_fields[TELEMETRY_DELTA_FIELDS];
+
+typedef enum telemetry_delta_frame_t
+{
+    // Nothing changed by a step since the previous frame
+    TELEMETRY_DELTA_UNCHANGED,
+    TELEMETRY_DELTA_KEYFRAME,
+    TELEMETRY_DELTA_DELTA,
+} telemetry_delta_frame_t;
+
+typedef struct telemetry_delta_config_t
+{
+    // Time (s) between keyframes, for viewers joining late, and the time a
+    // keyframe waits for its acknowledgement before it is sent again
+    float keyframe_period;
+    float ack_timeout;
+} telemetry_delta_config_t;
+
+typedef struct telemetry_delta_stats_t
+{
+    uint32_t keyframes;
+    uint32_t deltas;
+    uint32_t unchanged;
+    // Fields carried by the deltas
+    uint32_t changes;
+} telemetry_delta_stats_t;
+
+typedef struct telemetry_delta_t
+{
+    telemetry_delta_config_t config;
+    // Keyframe the server acknowledged, the deltas are against it
+    bool acked;
+    uint32_t acked_keyframe;
+    int32_t acked_values[TELEMETRY_DELTA_FIELDS];
+    // Keyframe sent and waiting for its acknowledgement
+    bool pending;
+    uint32_t pending_keyframe;
+    int32_t pending_values[TELEMETRY_DELTA_FIELDS];
+    float pending_age;
+    uint32_t next_keyframe;
+    float since_keyframe;
+    // Values of the previous frame
+    int32_t sent_values[TELEMETRY_DELTA_FIELDS];
+    telemetry_delta_stats_t stats;
+} telemetry_delta_t;
+
+telemetry_delta_config_t telemetry_delta_default_config();
+void telemetry_delta_init(telemetry_delta_t *delta, const telemetry_delta_config_t *config);
+/**
+ * Chooses the frame for `values`, `dt` seconds after the previous call:
+ * a keyframe when one is due or the last one went unacknowledged, otherwise
+ * a delta against the acknowledged keyframe if anything moved by a step.
+ * `keyframe` gets the number of the keyframe sent, or the delta base.
+ */
+telemetry_delta_frame_t telemetry_delta_next(telemetry_delta_t *delta, const float values[TELEMETRY_DELTA_FIELDS], float dt, uint32_t *keyframe);
+// The server has the keyframe numbered `keyframe`
+void telemetry_delta_ack(telemetry_delta_t *delta, uint32_t keyframe);
+// Fields of the last delta that differ from the acknowledged keyframe, returns their count
+int telemetry_delta_changes(const telemetry_delta_t *delta, protocol_delta_change_t changes[TELEMETRY_DELTA_FIELDS]);
+
+#endif // __TELEMETRY_DELTA_H__
@@ -0,0 +1,74 @@
+#include <math.h>
+#include "telemetry_rate.h"
+
+telemetry_rate_config_t telemetry_rate_default_config()
+{
+    return (telemetry_rate_config_t){
+        .active_period = .2f,
+        .heartbeat_period = 5.f,
+        .max_period = 30.f,
+        .backoff_factor = 2.f,
+        .rssi_threshold = -80,
+        .send_time_threshold = .05f,
+    };
+}
+
+void telemetry_rate_init(telemetry_rate_t *rate, const telemetry_rate_config_t *config)
+{
+    *rate = (telemetry_rate_t){
+        .config = *config,
+        .backoff = 1.f,
+        .period = config->heartbeat_period,
+    };
+}
+
+bool telemetry_rate_should_send(telemetry_rate_t *rate, bool moving, int viewers, float dt)
+{
+    const telemetry_rate_config_t *config = &rate->config;
+    float unbacked = moving || viewers > 0 ? config->active_period : config->heartbeat_period;
+
+    rate->period = fminf(unbacked * rate->backoff, fmaxf(config->max_period, unbacked));
+    rate->elapsed += dt;
+    rate->elapsed_unbacked += dt;
+
+    if (rate->elapsed_unbacked >= unbacked)
+    {
+        rate->elapsed_unbacked = 0.f;
+        if (rate->elapsed < rate->period)
+            rate->stats.deferred++;
+    }
+
+    if (rate->elapsed < rate->period)
+        return false;
+
+    rate->elapsed = 0.f;
+    rate->elapsed_unbacked = 0.f;
+    return true;
+}
+
+void telemetry_rate_report(telemetry_rate_t *rate, bool sent, float send_time, int rssi)
+{
+    const telemetry_rate_config_t *config = &rate->config;
+    // Past the longest period the backoff has nothing left to stretch
+    float max_backoff = config->max_period / config->active_period;
+
+    if (sent)
+        rate->stats.sent++;
+    else
+        rate->stats.failed++;
+
+    if (!sent || send_time > config->send_time_threshold || rssi < config->rssi_threshold)
+    {
+        rate->backoff = fminf(rate->backoff * config->backoff_factor, max_backoff);
+        rate->stats.backoffs++;
+    }
+    else
+    {
+        rate->backoff = fmaxf(rate->backoff / config->backoff_factor, 1.f);
+    }
+}
+
+float telemetry_rate_effective(const telemetry_rate_t *rate)
+{
+    return 1.f / rate->period;
+}
@@ -0,0 +1,64 @@
+#ifndef __TELEMETRY_RATE_H__
+#define __TELEMETRY_RATE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct telemetry_rate_config_t
+{
+    // Upload period (s) while the panel moves or someone watches, and the
+    // heartbeat otherwise
+    float active_period;
+    float heartbeat_period;
+    // Longest period (s) the backoff stretches to
+    float max_period;
+    // Backoff factor of a congested upload, undone one factor per clean one
+    float backoff_factor;
+    // Signal (dBm) below which the link counts as congested
+    int rssi_threshold;
+    // A send blocking longer (s) means the WebSocket buffer is backed up
+    float send_time_threshold;
+} telemetry_rate_config_t;
+
+typedef struct telemetry_rate_stats_t
+{
+    uint32_t sent;
+    // Uploads that could not be sent in time, and uploads due at the
+    // unbacked period that the backoff held back
+    uint32_t failed;
+    uint32_t deferred;
+    // Congested uploads, each of which backed the rate off
+    uint32_t backoffs;
+} telemetry_rate_stats_t;
+
+typedef struct telemetry_rate_t
+{
+    telemetry_rate_config_t config;
+    // Multiplies the period, 1 on a clean link
+    float backoff;
+    // Time (s) since the last upload, and since the last one due without backoff
+    float elapsed;
+    float elapsed_unbacked;
+    // Effective period (s) of the last decision
+    float period;
+    telemetry_rate_stats_t stats;
+} telemetry_rate_t;
+
+telemetry_rate_config_t telemetry_rate_default_config();
+void telemetry_rate_init(telemetry_rate_t *rate, const telemetry_rate_config_t *config);
+/**
+ * Whether to upload `dt` seconds after the previous call: at the active
+ * period while `moving` or with `viewers` watching, at the heartbeat
+ * otherwise, both stretched by the backoff.
+ */
+bool telemetry_rate_should_send(telemetry_rate_t *rate, bool moving, int viewers, float dt);
+/**
+ * Outcome of an upload: whether it went out, how long (s) the send blocked,
+ * and the signal (dBm). A failed, slow or weak upload backs the rate off
+ * exponentially, a clean one recovers one step.
+ */
+void telemetry_rate_report(telemetry_rate_t *rate, bool sent, float send_time, int rssi);
+// Uploads per second at the current period
+float telemetry_rate_effective(const telemetry_rate_t *rate);
+
+#endif // __TELEMETRY_RATE_H__
@@ -0,0 +1,126 @@
+#include <esp_attr.h>
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <stdio.h>
+#include <freertos/task.h>
+#include "trace.h"
+
+// Records moved out of the rings at a time by the printing task
+#define TRACE_PRINT_BATCH 16
+// "T:", timestamp, format, core, count, the arguments and the new line
+#define TRACE_LINE_SIZE (2 + 8 + 4 + 2 + 2 + 8 * TRACE_MAX_ARGS + 2)
+
+static trace_ring_t rings[portNUM_PROCESSORS];
+
+static void print_records(void *params);
+
+void IRAM_ATTR trace_write(trace_format_t format, const uint32_t *args, int argc)
+{
+    int core = xPortGetCoreID();
+    trace_ring_t *ring = &rings[core];
+    unsigned int head = atomic_load(&ring->head);
+
+    // Reserve a slot, against the tasks and interrupts preempting this one
+    do
+    {
+        if (head - atomic_load(&ring->tail) >= TRACE_RING_SLOTS)
+        {
+            atomic_fetch_add(&ring->dropped, 1);
+            return;
+        }
+    } while (!atomic_compare_exchange_weak(&ring->head, &head, head + 1));
+
+    trace_slot_t *slot = &ring->slots[head % TRACE_RING_SLOTS];
+
+    if (argc > TRACE_MAX_ARGS)
+        argc = TRACE_MAX_ARGS;
+    slot->record.timestamp = esp_timer_get_time();
+    slot->record.format = format;
+    slot->record.core = core;
+    slot->record.argc = argc;
+    for (int i = 0; i < argc; i++)
+        slot->record.args[i] = args[i];
+
+    atomic_store_explicit(&slot->sequence, head + 1, memory_order_release);
+}
+
+size_t trace_read(trace_record_t *records, size_t count)
+{
+    size_t read = 0;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++)
+    {
+        trace_ring_t *ring = &rings[core];
+        unsigned int tail = atomic_load(&ring->tail);
+
+        while (read < count && tail != atomic_load(&ring->head))
+        {
+            trace_slot_t *slot = &ring->slots[tail % TRACE_RING_SLOTS];
+
+            // Reserved, but the writer did not finish it yet
+            if (atomic_load_explicit(&slot->sequence, memory_order_acquire) != tail + 1)
+                break;
+
+            records[read++] = slot->record;
+            tail++;
+        }
+
+        atomic_store(&ring->tail, tail);
+    }
+
+    return read;
+}
+
+uint32_t trace_dropped()
+{
+    uint32_t dropped = 0;
+
+    for (int core = 0; core < portNUM_PROCESSORS; core++)
+        dropped += atomic_load(&rings[core].dropped);
+
+    return dropped;
+}
+
+esp_err_t trace_start(uint32_t period_ms)
+{
+    if (xTaskCreate(print_records, "Trace", 3072, (void *)(uintptr_t)period_ms, tskIDLE_PRIORITY, NULL) != pdPASS)
+        return ESP_ERR_NO_MEM;
+
+    return ESP_OK;
+}
+
+static void print_records(void *params)
+{
+    uint32_t period_ms = (uintptr_t)params;
+    uint32_t dropped_reported = 0;
+    static trace_record_t records[TRACE_PRINT_BATCH];
+    char line[TRACE_LINE_SIZE + 1];
+
+    for (;;)
+    {
+        size_t count;
+
+        vTaskDelay(pdMS_TO_TICKS(period_ms));
+
+        while ((count = trace_read(records, TRACE_PRINT_BATCH)) > 0)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                const trace_record_t *record = &records[i];
+                int length = sprintf(line, "T:%08x%04x%02x%02x", record->timestamp, record->format, record->core, record->argc);
+
+                for (int arg = 0; arg < record->argc; arg++)
+                    length += sprintf(line + length, "%08x", record->args[arg]);
+                line[length++] = '\n';
+                fwrite(line, 1, length, stdout);
+            }
+        }
+
+        uint32_t dropped = trace_dropped();
+        if (dropped != dropped_reported)
+        {
+            ESP_LOGW("Trace", "%u events dropped on full rings.", dropped - dropped_reported);
+            dropped_reported = dropped;
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <esp_err.h>
+#include <freertos/FreeRTOS.h>
+#include <sdkconfig.h>
+
+#ifdef CONFIG_TRACE_RING_SLOTS
+#define TRACE_RING_SLOTS CONFIG_TRACE_RING_SLOTS
+#else
+#define TRACE_RING_SLOTS 256
+#endif
+#define TRACE_MAX_ARGS 5
+
+typedef enum trace_format_t
+{
+#define TRACE_FORMAT(id, tag, format) id,
+#include "trace_formats.h"
+#undef TRACE_FORMAT
+    TRACE_FORMATS,
+} trace_format_t;
+
+typedef struct trace_record_t
+{
+    // Time (us) of the event, the low bits of esp_timer_get_time()
+    uint32_t timestamp;
+    uint16_t format;
+    uint8_t core;
+    uint8_t argc;
+    uint32_t args[TRACE_MAX_ARGS];
+} trace_record_t;
+
+typedef struct trace_slot_t
+{
+    // Index the slot was last written for, plus one once it is complete
+    atomic_uint sequence;
+    trace_record_t record;
+} trace_slot_t;
+
+/**
+ * One ring per core, so that the cores do not contend. Tasks and interrupts
+ * of the same core reserve their slots with a compare and swap, and the
+ * reader only takes slots whose sequence says they are complete. Events
+ * that find the ring full are dropped.
+ */
+typedef struct trace_ring_t
+{
+    atomic_uint head;
+    atomic_uint tail;
+    atomic_uint dropped;
+    trace_slot_t slots[TRACE_RING_SLOTS];
+} trace_ring_t;
+
+// Arguments as raw 32 bit words, the floats by their bits
+static inline uint32_t trace_int_word(int32_t value)
+{
+    return (uint32_t)value;
+}
+
+static inline uint32_t trace_float_word(float value)
+{
+    uint32_t word;
+    memcpy(&word, &value, sizeof(word));
+    return word;
+}
+
+#define TRACE_WORD(x) _Generic((x), float: trace_float_word, double: trace_float_word, default: trace_int_word)(x)
+#define TRACE_WORDS_1(a) TRACE_WORD(a)
+#define TRACE_WORDS_2(a, ...) TRACE_WORD(a), TRACE_WORDS_1(__VA_ARGS__)
+#define TRACE_WORDS_3(a, ...) TRACE_WORD(a), TRACE_WORDS_2(__VA_ARGS__)
+#define TRACE_WORDS_4(a, ...) TRACE_WORD(a), TRACE_WORDS_3(__VA_ARGS__)
+#define TRACE_WORDS_5(a, ...) TRACE_WORD(a), TRACE_WORDS_4(__VA_ARGS__)
+#define TRACE_WORDS(_1, _2, _3, _4, _5, name, ...) name
+
+/**
+ * Records an event of `format` with up to TRACE_MAX_ARGS arguments, in well
+ * under a microsecond, from a task or an interrupt. Formatting is left to
+ * the host, see tools/trace_decode.py.
+ */
+#define TRACE(format, ...)                                                                                                     \
+    do                                                                                                                         \
+    {                                                                                                                          \
+        const uint32_t trace_args[] = {TRACE_WORDS(__VA_ARGS__, TRACE_WORDS_5, TRACE_WORDS_4, TRACE_WORDS_3, TRACE_WORDS_2, \
+                                                   TRACE_WORDS_1)(__VA_ARGS__)};                                               \
+        trace_write(format, trace_args, sizeof(trace_args) / sizeof(trace_args[0]));                                         \
+    } while (0)
+
+void trace_write(trace_format_t format, const uint32_t *args, int argc);
+/**
+ * Moves up to `count` complete records out of the rings, oldest first
+ * within each core. Single reader.
+ */
+size_t trace_read(trace_record_t *records, size_t count);
+// Events dropped on full rings since the start
+uint32_t trace_dropped();
+/**
+ * Starts a task of the lowest priority printing the records every `period_ms`
+ * as `T:` lines of hexadecimal, which tools/trace_decode.py turns back into
+ * log lines.
+ */
+esp_err_t trace_start(uint32_t period_ms);
+
+#endif // __TRACE_H__
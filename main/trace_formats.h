@@ -0,0 +1,9 @@
+// Every trace event: identifier, tag and format, without the trailing new
+// line. Arguments are 32 bits: integers, and floats for %f, %e and %g.
+// Strings and 64 bit integers cannot be traced. tools/trace_decode.py reads
+// this file to format the events, which are numbered in this order, so only
+// append to it.
+TRACE_FORMAT(TRACE_CLOUD_MESSAGE, "Cloud Client", "Server response: opcode %d, %d bytes")
+TRACE_FORMAT(TRACE_SNTP_SYNC, "SNTP", "Received time from server: %d")
+TRACE_FORMAT(TRACE_MOTORS_MOVE, "Motors", "Move to azimuth %.2f inclination %.2f in %.3f s")
+TRACE_FORMAT(TRACE_MOTORS_STALL, "Motors", "Axis %d stalled %.1f degree from its target, holding it there")
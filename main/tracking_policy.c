@@ -0,0 +1,73 @@
+#include <math.h>
+#include "compensation.h"
+#include "tracking_policy.h"
+
+#define PI 3.14159265358979323846
+#define rad (PI / 180.f)
+
+static float incidence(orientation_t panel, orientation_t sun);
+
+tracking_policy_config_t tracking_policy_default_config()
+{
+    return (tracking_policy_config_t){
+        .panel_power = 20.f,
+        .moving_power = 5.f,
+        .holding_power = 1.f,
+        .gating_time = 0.f,
+        .horizon = 300.f,
+        .threshold = 1.f,
+    };
+}
+
+void tracking_policy_init(tracking_policy_t *policy, const tracking_policy_config_t *config)
+{
+    *policy = (tracking_policy_t){
+        .config = *config,
+    };
+}
+
+// Meinel's direct irradiance attenuation over the Kasten-Young air mass,
+// relative to the sun at the zenith
+float tracking_policy_clear_sky_power(const tracking_policy_config_t *config, float zenith)
+{
+    if (zenith >= 90.f)
+        return 0.f;
+
+    float air_mass = 1.f / (cosf(zenith * rad) + .50572f * powf(96.07995f - zenith, -1.6364f));
+
+    return config->panel_power * powf(.7f, powf(air_mass, .678f) - 1.f);
+}
+
+float tracking_policy_move_cost(const tracking_policy_config_t *config, float duration)
+{
+    return config->moving_power * duration + config->holding_power * config->gating_time;
+}
+
+bool tracking_policy_should_move(tracking_policy_t *policy, orientation_t current, orientation_t target, orientation_t sun, float power, float duration)
+{
+    const tracking_policy_config_t *config = &policy->config;
+    float gain = power * (incidence(target, sun) - incidence(current, sun)) * config->horizon;
+    float cost = tracking_policy_move_cost(config, duration);
+
+    if (gain <= config->threshold * cost)
+    {
+        policy->stats.skipped++;
+        return false;
+    }
+
+    policy->stats.moves++;
+    policy->stats.motor_on_time += duration + config->gating_time;
+    policy->stats.motor_energy += cost;
+    return true;
+}
+
+void tracking_policy_account(tracking_policy_t *policy, orientation_t panel, orientation_t sun, float power, float dt)
+{
+    policy->stats.yield += power * incidence(panel, sun) * dt;
+}
+
+// Cosine of the angle of incidence, none from behind the panel
+static float incidence(orientation_t panel, orientation_t sun)
+{
+    return fmaxf(vector3_dot(compensation_direction(panel), compensation_direction(sun)), 0.f);
+}
@@ -0,0 +1,57 @@
+#ifndef __TRACKING_POLICY_H__
+#define __TRACKING_POLICY_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "types.h"
+
+typedef struct tracking_policy_config_t
+{
+    // Panel output (W) facing the sun at the zenith, under a clear sky
+    float panel_power;
+    // Servo draw (W) of a move, and of an energized servo holding still
+    float moving_power;
+    float holding_power;
+    // Energized time (s) power gating adds to each move: the settle time and
+    // the pre-pulse, 0 without gating
+    float gating_time;
+    // Time (s) a move keeps its gain, about the interval between moves
+    float horizon;
+    // A move has to gain `threshold` times what it costs
+    float threshold;
+} tracking_policy_config_t;
+
+typedef struct tracking_policy_stats_t
+{
+    uint32_t moves;
+    uint32_t skipped;
+    // Time (s) the servos were energized for moves, their energy and the
+    // estimated panel yield (J)
+    float motor_on_time;
+    float motor_energy;
+    float yield;
+} tracking_policy_stats_t;
+
+typedef struct tracking_policy_t
+{
+    tracking_policy_config_t config;
+    tracking_policy_stats_t stats;
+} tracking_policy_t;
+
+tracking_policy_config_t tracking_policy_default_config();
+void tracking_policy_init(tracking_policy_t *policy, const tracking_policy_config_t *config);
+// Clear sky panel output (W) at normal incidence, the sun `zenith` degrees from the zenith
+float tracking_policy_clear_sky_power(const tracking_policy_config_t *config, float zenith);
+// Energy (J) of a move lasting `duration` seconds
+float tracking_policy_move_cost(const tracking_policy_config_t *config, float duration);
+/**
+ * Whether turning the panel from `current` to `target` pays off: the yield
+ * gained over the horizon from a better incidence cosine on `sun`, at
+ * `power` (W) for normal incidence, against the cost of a move lasting
+ * `duration` seconds. Moves taken are counted in the stats.
+ */
+bool tracking_policy_should_move(tracking_policy_t *policy, orientation_t current, orientation_t target, orientation_t sun, float power, float duration);
+// Adds the yield of `dt` seconds with the panel pointing along `panel`
+void tracking_policy_account(tracking_policy_t *policy, orientation_t panel, orientation_t sun, float power, float dt);
+
+#endif // __TRACKING_POLICY_H__
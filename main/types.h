@@ -30,11 +30,15 @@ typedef struct vector3_t
 quaternion_t quaternion_from_orientation(orientation_t o);
 quaternion_t quaternion_inverse(quaternion_t q);
 quaternion_t quaternion_multiply(quaternion_t q1, quaternion_t q2);
+quaternion_t quaternion_exp(vector3_t v);
+quaternion_t quaternion_normalize(quaternion_t q);
 vector3_t quaternion_rotate(quaternion_t q, vector3_t v);
 void quaternion_mahony_update(quaternion_t *q, vector3_t *error, vector3_t accel, vector3_t gyro, vector3_t magnet, float dt);
+void quaternion_mahony_update_gains(quaternion_t *q, vector3_t *error, vector3_t accel, vector3_t gyro, vector3_t magnet, float kp, float ki, float dt);
 
 float vector3_dot(vector3_t a, vector3_t b);
 float vector3_magnitude(vector3_t v);
+vector3_t vector3_cross(vector3_t a, vector3_t b);
 vector3_t vector3_normalize(vector3_t v);
 
 #endif // __TYPES_H__
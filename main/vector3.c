@@ -11,6 +11,15 @@ float vector3_magnitude(vector3_t v)
     return sqrt(vector3_dot(v, v));
 }
 
+vector3_t vector3_cross(vector3_t a, vector3_t b)
+{
+    return (vector3_t){
+        a.y * b.z - a.z * b.y,
+        a.z * b.x - a.x * b.z,
+        a.x * b.y - a.y * b.x,
+    };
+}
+
 vector3_t vector3_normalize(vector3_t v)
 {
     float magnitude = vector3_magnitude(v);
@@ -4,6 +4,7 @@ import http, { IncomingMessage } from 'http';
 import { Socket } from 'net';
 import url from 'url';
 import WebSocket from 'ws';
+import { AppEvent, ControlConfig, ControlMode, decodeBinary, decodeJson, encodeJson, Message, SystemDelta, SystemState } from './protocol';
 
 const app = express();
 app.use(expressStaticGzip('public', {
@@ -13,52 +14,56 @@ app.use(expressStaticGzip('public', {
 const server = http.createServer(app);
 const wss = new WebSocket.Server({ noServer: true });
 
-enum AppEvent {
-    UpdateConfig = "UPDATE_CONFIG",
-    UpdateState = "UPDATE_STATE",
-}
-
-enum ControlMode {
-    Automatic = "AUTOMATIC",
-    Manual = "MANUAL",
-}
-
-interface ControlConfig {
-    controlMode?: ControlMode,
-    manualOrientation?: Orientation,
-}
-
-interface SystemState {
-    platformRotation: Quaternion,
-    panelOrientation: Orientation,
-    motorsRotation: Orientation,
-    timestamp: number,
-}
-
-interface Orientation {
-    azimuth: number,
-    inclination: number,
-}
-
-interface Quaternion {
-    w: number,
-    x: number,
-    y: number,
-    z: number,
-}
-
-let config = {
+let config: ControlConfig = {
     controlMode: ControlMode.Manual,
     manualOrientation: {
         azimuth: 0.0,
         inclination: 0.0,
-    } as Orientation
-} as ControlConfig;
+    },
+};
+
+// Clients that upload their state, every other one is a viewer
+const trackers = new WeakSet<WebSocket>();
+
+// Delta fields, in the order of telemetry_delta_fields in the firmware, and
+// their quantization step
+const deltaFields: [keyof SystemState, string, number][] = [
+    ['platformRotation', 'w', 1e-4],
+    ['platformRotation', 'x', 1e-4],
+    ['platformRotation', 'y', 1e-4],
+    ['platformRotation', 'z', 1e-4],
+    ['panelOrientation', 'azimuth', .01],
+    ['panelOrientation', 'inclination', .01],
+    ['motorsRotation', 'azimuth', .01],
+    ['motorsRotation', 'inclination', .01],
+    ['motorsEnergized', 'azimuth', .1],
+    ['motorsEnergized', 'inclination', .1],
+];
+// Latest keyframes of each tracker, a delta may still refer to the one
+// before the last while the last is being acknowledged
+const keyframes = new WeakMap<WebSocket, Map<number, SystemState>>();
+const keptKeyframes = 4;
+// Full state last fanned out, for the viewers that connect in between
+let lastState: SystemState | undefined;
 
 function throwException(message: string): never {
     throw new Error(message);
 }
 
+// Trackers upload faster while someone watches
+function sendViewers() {
+    const viewers = [...wss.clients].filter(client => !trackers.has(client)).length;
+
+    for (let client of wss.clients) {
+        if (!trackers.has(client)) continue;
+
+        client.send(encodeJson({
+            event: AppEvent.UpdateViewers,
+            payload: { viewers },
+        }));
+    }
+}
+
 server.on('upgrade', (request: IncomingMessage, socket: Socket, buffer: Buffer) => {
     const pathname = url.parse(request.url ?? throwException('Request does not have an URL!')).pathname;
 
@@ -74,41 +79,50 @@ wss.on('connection', (ws: WebSocket, request: IncomingMessage) => {
 
     console.log(`A client from ${address} connected.`);
 
-    ws.on('close', (code, reason) => console.log(`A client from ${address} disconnected with code ${code}, reason: ${reason}.`));
+    ws.on('close', (code, reason) => {
+        console.log(`A client from ${address} disconnected with code ${code}, reason: ${reason}.`);
+        sendViewers();
+    });
 
     ws.on('message', data => {
         try {
-            let request: {
-                event: AppEvent,
-                payload?: {} | []
-            } = JSON.parse(data as string);
+            // Text frames carry JSON, binary frames the compact form
+            const message: Message = typeof data == 'string' ? decodeJson(data) : decodeBinary(new Uint8Array(data as Buffer));
 
-            wss.emit(request.event, ws, request.payload);
+            wss.emit(message.event, ws, message.payload);
         } catch (e: any) {
-            console.log(`Error parsing JSON: ${e}\n---------\nJSON string:\n\t${data}`);
+            console.log(`Error parsing message: ${e}\n---------\nMessage:\n\t${data}`);
         }
     });
 
     ws.on(AppEvent.UpdateConfig, () => {
-        ws.send(JSON.stringify({
+        ws.send(encodeJson({
             event: AppEvent.UpdateConfig,
             payload: config,
         }));
     });
 
     ws.on(AppEvent.UpdateState, (new_state: SystemState) => {
-        ws.send(JSON.stringify({
+        ws.send(encodeJson({
             event: AppEvent.UpdateState,
             payload: new_state,
-        }))
+        }));
     });
 
     ws.emit(AppEvent.UpdateConfig);
+    if (lastState) ws.emit(AppEvent.UpdateState, lastState);
+    sendViewers();
 });
 
 wss.on(AppEvent.UpdateConfig, (ws: WebSocket, new_config: ControlConfig) => {
-    config.controlMode = new_config.controlMode ?? config.controlMode;
-    config.manualOrientation = new_config.manualOrientation ?? config.manualOrientation;
+    config.controlMode = new_config.controlMode;
+    config.manualOrientation = new_config.manualOrientation;
+    config.ahrsEngine = new_config.ahrsEngine ?? config.ahrsEngine;
+    config.servoCalibration = {
+        azimuth: new_config.servoCalibration?.azimuth ?? config.servoCalibration?.azimuth,
+        inclination: new_config.servoCalibration?.inclination ?? config.servoCalibration?.inclination,
+    };
+    config.trackingThreshold = new_config.trackingThreshold ?? config.trackingThreshold;
 
     for (let client of wss.clients) {
         if (new_config && client == ws) continue;
@@ -117,12 +131,56 @@ wss.on(AppEvent.UpdateConfig, (ws: WebSocket, new_config: ControlConfig) => {
     }
 });
 
-wss.on(AppEvent.UpdateState, (ws: WebSocket, new_state: SystemState) => {
+function sendState(ws: WebSocket, state: SystemState) {
+    if (!trackers.has(ws)) {
+        trackers.add(ws);
+        sendViewers();
+    }
+
+    lastState = state;
     for (let client of wss.clients) {
         if (client == ws) continue;
 
-        client.emit(AppEvent.UpdateState, new_state);
+        client.emit(AppEvent.UpdateState, state);
     }
+}
+
+wss.on(AppEvent.UpdateState, (ws: WebSocket, new_state: SystemState) => {
+    if (new_state.keyframe !== undefined) {
+        const kept = keyframes.get(ws) ?? new Map<number, SystemState>();
+
+        kept.set(new_state.keyframe, new_state);
+        for (let keyframe of kept.keys()) {
+            if (kept.size > keptKeyframes) kept.delete(keyframe);
+        }
+        keyframes.set(ws, kept);
+
+        ws.send(encodeJson({
+            event: AppEvent.AckKeyframe,
+            payload: { keyframe: new_state.keyframe },
+        }));
+    }
+
+    sendState(ws, new_state);
+});
+
+// Viewers get the full state, rebuilt on the keyframe the delta refers to.
+// Deltas on a keyframe this server never saw wait for the next keyframe.
+wss.on(AppEvent.UpdateDelta, (ws: WebSocket, delta: SystemDelta) => {
+    const base = keyframes.get(ws)?.get(delta.base);
+    if (!base) return;
+
+    const state: SystemState = JSON.parse(JSON.stringify(base));
+    for (let { index, steps } of delta.changes) {
+        const field = deltaFields[index];
+        if (!field) continue;
+
+        (state[field[0]] as any)[field[1]] = steps * field[2];
+    }
+    state.timestamp = delta.timestamp;
+    delete state.keyframe;
+
+    sendState(ws, state);
 });
 
 const port = parseInt(process.env['PORT'] ?? '8080');
@@ -0,0 +1,29 @@
+import { performance } from 'perf_hooks';
+import { decodeBinary, decodeJson, encodeBinary, encodeJson } from './protocol';
+import { readProtocolVectors } from './protocolVectors';
+
+// Passes over the firmware vectors
+const PASSES = 50;
+
+// Encoding and decoding time of both forms, per message
+const vectors = readProtocolVectors();
+const messages = vectors.map(vector => decodeJson(vector.json));
+const count = vectors.length * PASSES;
+
+// After a warm-up pass
+function time(name: string, run: (index: number) => void) {
+    vectors.forEach((vector, i) => run(i));
+
+    const start = performance.now();
+
+    for (let pass = 0; pass < PASSES; pass++)
+        for (let i = 0; i < vectors.length; i++)
+            run(i);
+    console.log(`${name}: ${Math.round((performance.now() - start) * 1e6 / count)} ns/message`);
+}
+
+console.log(`Protocol / ${vectors.length} messages, ${PASSES} passes`);
+time('Encoding JSON', i => encodeJson(messages[i]));
+time('Decoding JSON', i => decodeJson(vectors[i].json));
+time('Encoding binary', i => encodeBinary(messages[i]));
+time('Decoding binary', i => decodeBinary(vectors[i].binary));
@@ -0,0 +1,61 @@
+import assert from 'assert';
+import { decodeBinary, decodeJson, encodeBinary, encodeJson, Message } from './protocol';
+import { readProtocolVectors } from './protocolVectors';
+
+// Mutated copies of each vector fed to the decoders
+const MUTATIONS = 20;
+
+let seed = 7;
+
+// Same generator as test_random in the firmware tests
+function randomBelow(max: number): number {
+    seed = (Math.imul(seed, 1664525) + 1013904223) >>> 0;
+    return Math.floor(seed / 4294967296 * max);
+}
+
+// Decoders reject with an Error or a JSON SyntaxError, anything else is a crash
+function decodes(decode: () => Message): boolean {
+    try {
+        encodeJson(decode());
+        return true;
+    } catch (error) {
+        if (error instanceof SyntaxError || (error instanceof Error && error.constructor == Error)) return false;
+        throw error;
+    }
+}
+
+// The firmware vectors have to decode from both forms to the same message,
+// encode back to the same bytes, and survive a round trip through JSON.
+// Mutated and truncated copies must not crash the decoders, most have to be
+// rejected.
+const vectors = readProtocolVectors();
+let mutations = 0, accepted = 0;
+
+assert(vectors.length > 0, 'No protocol vectors');
+vectors.forEach(({ json, binary }, i) => {
+    const message = decodeJson(json);
+    const fromBinary = decodeBinary(binary);
+
+    assert.deepStrictEqual(JSON.parse(encodeJson(message)), JSON.parse(json), `Vector ${i} changes through JSON`);
+    assert.deepStrictEqual(JSON.parse(encodeJson(fromBinary)), JSON.parse(json), `Vector ${i} decodes differently from binary`);
+    assert.deepStrictEqual(encodeBinary(message), binary, `Vector ${i} encodes to other bytes`);
+    assert.deepStrictEqual(decodeJson(encodeJson(message)), message, `Vector ${i} is not stable through JSON`);
+
+    for (let j = 0; j < MUTATIONS; j++) {
+        const text = j % 2 == 0;
+        const mutated = text ? Buffer.from(json) : Buffer.from(binary);
+        const at = randomBelow(mutated.length);
+
+        // Alternately a byte replaced and the message cut short
+        if (j % 4 < 2)
+            mutated[at] = text ? '{}[],:"-.0e9 nul'.charCodeAt(randomBelow(16)) : randomBelow(256);
+        const length = j % 4 < 2 ? mutated.length : at;
+
+        mutations++;
+        if (decodes(() => text ? decodeJson(mutated.toString('latin1', 0, length)) : decodeBinary(new Uint8Array(mutated.subarray(0, length)))))
+            accepted++;
+    }
+});
+
+console.log(`${vectors.length} vectors decoded and encoded back, ${accepted} of ${mutations} mutations accepted`);
+assert(accepted < mutations / 2, `${accepted} of ${mutations} mutations accepted`);
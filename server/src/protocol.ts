@@ -0,0 +1,805 @@
+// Generated by tools/protocol_gen.py from protocol/schema.json, do not edit.
+
+export enum AppEvent {
+    UpdateConfig = "UPDATE_CONFIG",
+    UpdateState = "UPDATE_STATE",
+    UpdateViewers = "UPDATE_VIEWERS",
+    UpdateDelta = "UPDATE_DELTA",
+    AckKeyframe = "ACK_KEYFRAME",
+}
+
+export enum ControlMode {
+    Automatic = "AUTOMATIC",
+    Manual = "MANUAL",
+}
+
+export enum AhrsEngine {
+    Mahony = "Mahony",
+    Madgwick = "Madgwick",
+    Ekf = "EKF",
+}
+
+export interface Quaternion {
+    w: number,
+    x: number,
+    y: number,
+    z: number,
+}
+
+// Degrees
+export interface Orientation {
+    azimuth: number,
+    inclination: number,
+}
+
+// Measured pulse width (us) per angle (degree), sorted by angle
+export interface ServoCalibrationPoint {
+    angle: number,
+    pulseWidth: number,
+}
+
+export interface ServoCalibration {
+    azimuth?: ServoCalibrationPoint[],
+    inclination?: ServoCalibrationPoint[],
+}
+
+export interface ControlConfig {
+    controlMode: ControlMode,
+    manualOrientation: Orientation,
+    ahrsEngine?: AhrsEngine,
+    servoCalibration?: ServoCalibration,
+    // Gain a tracking move needs, relative to the energy it costs
+    trackingThreshold?: number,
+}
+
+// Energies in Wh, time in seconds
+export interface TrackingPolicy {
+    moves: number,
+    skipped: number,
+    motorOnTime: number,
+    motorEnergy: number,
+    yield: number,
+}
+
+// Effective uploads per second, and upload counters since boot
+export interface TelemetryRate {
+    rate: number,
+    sent: number,
+    failed: number,
+    deferred: number,
+    backoffs: number,
+}
+
+export interface SystemState {
+    platformRotation: Quaternion,
+    panelOrientation: Orientation,
+    motorsRotation: Orientation,
+    // Seconds each servo has been energized since boot
+    motorsEnergized: Orientation,
+    // Milliseconds since the Unix epoch
+    timestamp: number,
+    // Read from the servo potentiometers, when the firmware has them
+    motorsMeasured?: Orientation,
+    trackingPolicy?: TrackingPolicy,
+    telemetry?: TelemetryRate,
+    // Number the tracker gave this state when it uploads deltas against it
+    keyframe?: number,
+}
+
+export interface Viewers {
+    viewers: number,
+}
+
+// Index in the delta fields of the firmware and value in quantization steps
+export interface DeltaChange {
+    index: number,
+    steps: number,
+}
+
+// Fields that changed since the keyframe `base`
+export interface SystemDelta {
+    base: number,
+    timestamp: number,
+    changes: DeltaChange[],
+}
+
+export interface KeyframeAck {
+    keyframe: number,
+}
+
+export type Message =
+    | { event: AppEvent.UpdateConfig, payload: ControlConfig }
+    | { event: AppEvent.UpdateState, payload: SystemState }
+    | { event: AppEvent.UpdateViewers, payload: Viewers }
+    | { event: AppEvent.UpdateDelta, payload: SystemDelta }
+    | { event: AppEvent.AckKeyframe, payload: KeyframeAck };
+
+function fail(message: string): never {
+    throw new Error(message);
+}
+
+function readObject(value: any, name: string): { [key: string]: any } {
+    return typeof value == 'object' && value !== null && !Array.isArray(value) ? value : fail(`${name} is not an object`);
+}
+
+function readArray(value: any, name: string, max: number): any[] {
+    return Array.isArray(value) && value.length <= max ? value : fail(`${name} is not an array of at most ${max} items`);
+}
+
+// Rounded to the decimals the firmware writes, null for the values JSON cannot hold
+function writeFloat(value: number, precision: number): number | null {
+    return isFinite(value) ? Number(value.toFixed(precision)) : null;
+}
+
+// Null stands for the values JSON cannot hold
+function readFloat(value: any, name: string): number {
+    return value === null ? NaN : typeof value == 'number' ? value : fail(`${name} is not a number`);
+}
+
+function readInteger(value: any, name: string, min: number, max: number): number {
+    return Number.isInteger(value) && value >= min && value <= max ? value : fail(`${name} is not an integer from ${min} to ${max}`);
+}
+
+function readEnum<T>(value: any, name: string, values: readonly T[]): T {
+    return values.indexOf(value) >= 0 ? value : fail(`${name} is not one of ${values.join(', ')}`);
+}
+
+class BinaryWriter {
+    private buffer = new ArrayBuffer(256);
+    private view = new DataView(this.buffer);
+    private length = 0;
+
+    u8(value: number) {
+        this.view.setUint8(this.reserve(1), value);
+    }
+
+    u32(value: number) {
+        this.view.setUint32(this.reserve(4), value, true);
+    }
+
+    i32(value: number) {
+        this.view.setInt32(this.reserve(4), value, true);
+    }
+
+    i64(value: number) {
+        const high = Math.floor(value / 4294967296);
+
+        this.u32(value - high * 4294967296);
+        this.i32(high);
+    }
+
+    f32(value: number) {
+        this.view.setFloat32(this.reserve(4), value, true);
+    }
+
+    bytes(): Uint8Array {
+        return new Uint8Array(this.buffer, 0, this.length);
+    }
+
+    private reserve(size: number): number {
+        if (this.length + size > this.buffer.byteLength) {
+            const buffer = new ArrayBuffer(this.buffer.byteLength * 2);
+
+            new Uint8Array(buffer).set(new Uint8Array(this.buffer));
+            this.buffer = buffer;
+            this.view = new DataView(buffer);
+        }
+
+        this.length += size;
+        return this.length - size;
+    }
+}
+
+class BinaryReader {
+    private view: DataView;
+    private offset = 0;
+
+    constructor(data: Uint8Array) {
+        this.view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+    }
+
+    u8(): number {
+        return this.view.getUint8(this.take(1));
+    }
+
+    u32(): number {
+        return this.view.getUint32(this.take(4), true);
+    }
+
+    i32(): number {
+        return this.view.getInt32(this.take(4), true);
+    }
+
+    i64(): number {
+        const low = this.u32();
+
+        return this.i32() * 4294967296 + low;
+    }
+
+    f32(): number {
+        return this.view.getFloat32(this.take(4), true);
+    }
+
+    count(max: number): number {
+        const count = this.u8();
+
+        return count <= max ? count : fail(`${count} items, at most ${max}`);
+    }
+
+    enum<T>(values: readonly T[]): T {
+        const index = this.u8();
+
+        return index < values.length ? values[index] : fail(`Enum index ${index} out of range`);
+    }
+
+    get done(): boolean {
+        return this.offset == this.view.byteLength;
+    }
+
+    private take(size: number): number {
+        if (this.offset + size > this.view.byteLength) fail('Binary message is truncated');
+
+        this.offset += size;
+        return this.offset - size;
+    }
+}
+
+const appEventValues: readonly AppEvent[] = [AppEvent.UpdateConfig, AppEvent.UpdateState, AppEvent.UpdateViewers, AppEvent.UpdateDelta, AppEvent.AckKeyframe];
+
+const controlModeValues: readonly ControlMode[] = [ControlMode.Automatic, ControlMode.Manual];
+
+const ahrsEngineValues: readonly AhrsEngine[] = [AhrsEngine.Mahony, AhrsEngine.Madgwick, AhrsEngine.Ekf];
+
+export function encodeJson(message: Message): string {
+    switch (message.event) {
+        case AppEvent.UpdateConfig:
+            return JSON.stringify({ event: message.event, payload: writeControlConfig(message.payload) });
+        case AppEvent.UpdateState:
+            return JSON.stringify({ event: message.event, payload: writeSystemState(message.payload) });
+        case AppEvent.UpdateViewers:
+            return JSON.stringify({ event: message.event, payload: writeViewers(message.payload) });
+        case AppEvent.UpdateDelta:
+            return JSON.stringify({ event: message.event, payload: writeSystemDelta(message.payload) });
+        case AppEvent.AckKeyframe:
+            return JSON.stringify({ event: message.event, payload: writeKeyframeAck(message.payload) });
+    }
+}
+
+// Throws when the message is not valid
+export function decodeJson(text: string): Message {
+    const root = readObject(JSON.parse(text), 'message');
+
+    switch (readEnum(root.event, 'event', appEventValues)) {
+        case AppEvent.UpdateConfig:
+            return { event: AppEvent.UpdateConfig, payload: readControlConfig(root.payload, 'payload') };
+        case AppEvent.UpdateState:
+            return { event: AppEvent.UpdateState, payload: readSystemState(root.payload, 'payload') };
+        case AppEvent.UpdateViewers:
+            return { event: AppEvent.UpdateViewers, payload: readViewers(root.payload, 'payload') };
+        case AppEvent.UpdateDelta:
+            return { event: AppEvent.UpdateDelta, payload: readSystemDelta(root.payload, 'payload') };
+        case AppEvent.AckKeyframe:
+            return { event: AppEvent.AckKeyframe, payload: readKeyframeAck(root.payload, 'payload') };
+    }
+}
+
+export function encodeBinary(message: Message): Uint8Array {
+    const writer = new BinaryWriter();
+
+    writer.u8(appEventValues.indexOf(message.event));
+    switch (message.event) {
+        case AppEvent.UpdateConfig:
+            encodeBinaryControlConfig(writer, message.payload);
+            break;
+        case AppEvent.UpdateState:
+            encodeBinarySystemState(writer, message.payload);
+            break;
+        case AppEvent.UpdateViewers:
+            encodeBinaryViewers(writer, message.payload);
+            break;
+        case AppEvent.UpdateDelta:
+            encodeBinarySystemDelta(writer, message.payload);
+            break;
+        case AppEvent.AckKeyframe:
+            encodeBinaryKeyframeAck(writer, message.payload);
+            break;
+    }
+
+    return writer.bytes();
+}
+
+export function decodeBinary(data: Uint8Array): Message {
+    const reader = new BinaryReader(data);
+    let message: Message;
+
+    switch (reader.enum(appEventValues)) {
+        case AppEvent.UpdateConfig:
+            message = { event: AppEvent.UpdateConfig, payload: decodeBinaryControlConfig(reader) };
+            break;
+        case AppEvent.UpdateState:
+            message = { event: AppEvent.UpdateState, payload: decodeBinarySystemState(reader) };
+            break;
+        case AppEvent.UpdateViewers:
+            message = { event: AppEvent.UpdateViewers, payload: decodeBinaryViewers(reader) };
+            break;
+        case AppEvent.UpdateDelta:
+            message = { event: AppEvent.UpdateDelta, payload: decodeBinarySystemDelta(reader) };
+            break;
+        case AppEvent.AckKeyframe:
+            message = { event: AppEvent.AckKeyframe, payload: decodeBinaryKeyframeAck(reader) };
+            break;
+    }
+
+    return reader.done ? message : fail('Binary message is too long');
+}
+
+function writeQuaternion(value: Quaternion): any {
+    const result: any = {
+        w: writeFloat(value.w, 6),
+        x: writeFloat(value.x, 6),
+        y: writeFloat(value.y, 6),
+        z: writeFloat(value.z, 6),
+    };
+
+    return result;
+}
+
+function readQuaternion(value: any, name: string): Quaternion {
+    const object = readObject(value, name);
+    const result: Quaternion = {
+        w: readFloat(object.w, `${name}.w`),
+        x: readFloat(object.x, `${name}.x`),
+        y: readFloat(object.y, `${name}.y`),
+        z: readFloat(object.z, `${name}.z`),
+    };
+
+    return result;
+}
+
+function encodeBinaryQuaternion(writer: BinaryWriter, value: Quaternion) {
+    writer.f32(value.w);
+    writer.f32(value.x);
+    writer.f32(value.y);
+    writer.f32(value.z);
+}
+
+function decodeBinaryQuaternion(reader: BinaryReader): Quaternion {
+    return {
+        w: reader.f32(),
+        x: reader.f32(),
+        y: reader.f32(),
+        z: reader.f32(),
+    };
+}
+
+function writeOrientation(value: Orientation): any {
+    const result: any = {
+        azimuth: writeFloat(value.azimuth, 6),
+        inclination: writeFloat(value.inclination, 6),
+    };
+
+    return result;
+}
+
+function readOrientation(value: any, name: string): Orientation {
+    const object = readObject(value, name);
+    const result: Orientation = {
+        azimuth: readFloat(object.azimuth, `${name}.azimuth`),
+        inclination: readFloat(object.inclination, `${name}.inclination`),
+    };
+
+    return result;
+}
+
+function encodeBinaryOrientation(writer: BinaryWriter, value: Orientation) {
+    writer.f32(value.azimuth);
+    writer.f32(value.inclination);
+}
+
+function decodeBinaryOrientation(reader: BinaryReader): Orientation {
+    return {
+        azimuth: reader.f32(),
+        inclination: reader.f32(),
+    };
+}
+
+function writeServoCalibrationPoint(value: ServoCalibrationPoint): any {
+    const result: any = {
+        angle: writeFloat(value.angle, 3),
+        pulseWidth: writeFloat(value.pulseWidth, 1),
+    };
+
+    return result;
+}
+
+function readServoCalibrationPoint(value: any, name: string): ServoCalibrationPoint {
+    const object = readObject(value, name);
+    const result: ServoCalibrationPoint = {
+        angle: readFloat(object.angle, `${name}.angle`),
+        pulseWidth: readFloat(object.pulseWidth, `${name}.pulseWidth`),
+    };
+
+    return result;
+}
+
+function encodeBinaryServoCalibrationPoint(writer: BinaryWriter, value: ServoCalibrationPoint) {
+    writer.f32(value.angle);
+    writer.f32(value.pulseWidth);
+}
+
+function decodeBinaryServoCalibrationPoint(reader: BinaryReader): ServoCalibrationPoint {
+    return {
+        angle: reader.f32(),
+        pulseWidth: reader.f32(),
+    };
+}
+
+function writeServoCalibration(value: ServoCalibration): any {
+    const result: any = {
+    };
+
+    if (value.azimuth !== undefined) result.azimuth = value.azimuth.map(writeServoCalibrationPoint);
+    if (value.inclination !== undefined) result.inclination = value.inclination.map(writeServoCalibrationPoint);
+    return result;
+}
+
+function readServoCalibration(value: any, name: string): ServoCalibration {
+    const object = readObject(value, name);
+    const result: ServoCalibration = {
+    };
+
+    if (object.azimuth !== undefined) result.azimuth = readArray(object.azimuth, `${name}.azimuth`, 16).map((item, i) => readServoCalibrationPoint(item, `${name}.azimuth[${i}]`));
+    if (object.inclination !== undefined) result.inclination = readArray(object.inclination, `${name}.inclination`, 16).map((item, i) => readServoCalibrationPoint(item, `${name}.inclination[${i}]`));
+    return result;
+}
+
+function encodeBinaryServoCalibration(writer: BinaryWriter, value: ServoCalibration) {
+    writer.u8((value.azimuth !== undefined ? 1 : 0) | (value.inclination !== undefined ? 2 : 0));
+    if (value.azimuth !== undefined) {
+        writer.u8(value.azimuth.length);
+        for (let item of value.azimuth) encodeBinaryServoCalibrationPoint(writer, item);
+    }
+    if (value.inclination !== undefined) {
+        writer.u8(value.inclination.length);
+        for (let item of value.inclination) encodeBinaryServoCalibrationPoint(writer, item);
+    }
+}
+
+function decodeBinaryServoCalibration(reader: BinaryReader): ServoCalibration {
+    const present = reader.u8();
+
+    if (present >> 2) fail('Unknown optional fields');
+    const result = {} as ServoCalibration;
+
+    if (present & 1) result.azimuth = Array.from({ length: reader.count(16) }, () => decodeBinaryServoCalibrationPoint(reader));
+    if (present & 2) result.inclination = Array.from({ length: reader.count(16) }, () => decodeBinaryServoCalibrationPoint(reader));
+    return result;
+}
+
+function writeControlConfig(value: ControlConfig): any {
+    const result: any = {
+        controlMode: value.controlMode,
+        manualOrientation: writeOrientation(value.manualOrientation),
+    };
+
+    if (value.ahrsEngine !== undefined) result.ahrsEngine = value.ahrsEngine;
+    if (value.servoCalibration !== undefined) result.servoCalibration = writeServoCalibration(value.servoCalibration);
+    if (value.trackingThreshold !== undefined) result.trackingThreshold = writeFloat(value.trackingThreshold, 3);
+    return result;
+}
+
+function readControlConfig(value: any, name: string): ControlConfig {
+    const object = readObject(value, name);
+    const result: ControlConfig = {
+        controlMode: readEnum(object.controlMode, `${name}.controlMode`, controlModeValues),
+        manualOrientation: readOrientation(object.manualOrientation, `${name}.manualOrientation`),
+    };
+
+    if (object.ahrsEngine !== undefined) result.ahrsEngine = readEnum(object.ahrsEngine, `${name}.ahrsEngine`, ahrsEngineValues);
+    if (object.servoCalibration !== undefined) result.servoCalibration = readServoCalibration(object.servoCalibration, `${name}.servoCalibration`);
+    if (object.trackingThreshold !== undefined) result.trackingThreshold = readFloat(object.trackingThreshold, `${name}.trackingThreshold`);
+    return result;
+}
+
+function encodeBinaryControlConfig(writer: BinaryWriter, value: ControlConfig) {
+    writer.u8((value.ahrsEngine !== undefined ? 1 : 0) | (value.servoCalibration !== undefined ? 2 : 0) | (value.trackingThreshold !== undefined ? 4 : 0));
+    writer.u8(controlModeValues.indexOf(value.controlMode));
+    encodeBinaryOrientation(writer, value.manualOrientation);
+    if (value.ahrsEngine !== undefined) {
+        writer.u8(ahrsEngineValues.indexOf(value.ahrsEngine));
+    }
+    if (value.servoCalibration !== undefined) {
+        encodeBinaryServoCalibration(writer, value.servoCalibration);
+    }
+    if (value.trackingThreshold !== undefined) {
+        writer.f32(value.trackingThreshold);
+    }
+}
+
+function decodeBinaryControlConfig(reader: BinaryReader): ControlConfig {
+    const present = reader.u8();
+
+    if (present >> 3) fail('Unknown optional fields');
+    const result = {} as ControlConfig;
+
+    result.controlMode = reader.enum(controlModeValues);
+    result.manualOrientation = decodeBinaryOrientation(reader);
+    if (present & 1) result.ahrsEngine = reader.enum(ahrsEngineValues);
+    if (present & 2) result.servoCalibration = decodeBinaryServoCalibration(reader);
+    if (present & 4) result.trackingThreshold = reader.f32();
+    return result;
+}
+
+function writeTrackingPolicy(value: TrackingPolicy): any {
+    const result: any = {
+        moves: value.moves,
+        skipped: value.skipped,
+        motorOnTime: writeFloat(value.motorOnTime, 1),
+        motorEnergy: writeFloat(value.motorEnergy, 4),
+        yield: writeFloat(value.yield, 4),
+    };
+
+    return result;
+}
+
+function readTrackingPolicy(value: any, name: string): TrackingPolicy {
+    const object = readObject(value, name);
+    const result: TrackingPolicy = {
+        moves: readInteger(object.moves, `${name}.moves`, 0, 4294967295),
+        skipped: readInteger(object.skipped, `${name}.skipped`, 0, 4294967295),
+        motorOnTime: readFloat(object.motorOnTime, `${name}.motorOnTime`),
+        motorEnergy: readFloat(object.motorEnergy, `${name}.motorEnergy`),
+        yield: readFloat(object.yield, `${name}.yield`),
+    };
+
+    return result;
+}
+
+function encodeBinaryTrackingPolicy(writer: BinaryWriter, value: TrackingPolicy) {
+    writer.u32(value.moves);
+    writer.u32(value.skipped);
+    writer.f32(value.motorOnTime);
+    writer.f32(value.motorEnergy);
+    writer.f32(value.yield);
+}
+
+function decodeBinaryTrackingPolicy(reader: BinaryReader): TrackingPolicy {
+    return {
+        moves: reader.u32(),
+        skipped: reader.u32(),
+        motorOnTime: reader.f32(),
+        motorEnergy: reader.f32(),
+        yield: reader.f32(),
+    };
+}
+
+function writeTelemetryRate(value: TelemetryRate): any {
+    const result: any = {
+        rate: writeFloat(value.rate, 3),
+        sent: value.sent,
+        failed: value.failed,
+        deferred: value.deferred,
+        backoffs: value.backoffs,
+    };
+
+    return result;
+}
+
+function readTelemetryRate(value: any, name: string): TelemetryRate {
+    const object = readObject(value, name);
+    const result: TelemetryRate = {
+        rate: readFloat(object.rate, `${name}.rate`),
+        sent: readInteger(object.sent, `${name}.sent`, 0, 4294967295),
+        failed: readInteger(object.failed, `${name}.failed`, 0, 4294967295),
+        deferred: readInteger(object.deferred, `${name}.deferred`, 0, 4294967295),
+        backoffs: readInteger(object.backoffs, `${name}.backoffs`, 0, 4294967295),
+    };
+
+    return result;
+}
+
+function encodeBinaryTelemetryRate(writer: BinaryWriter, value: TelemetryRate) {
+    writer.f32(value.rate);
+    writer.u32(value.sent);
+    writer.u32(value.failed);
+    writer.u32(value.deferred);
+    writer.u32(value.backoffs);
+}
+
+function decodeBinaryTelemetryRate(reader: BinaryReader): TelemetryRate {
+    return {
+        rate: reader.f32(),
+        sent: reader.u32(),
+        failed: reader.u32(),
+        deferred: reader.u32(),
+        backoffs: reader.u32(),
+    };
+}
+
+function writeSystemState(value: SystemState): any {
+    const result: any = {
+        platformRotation: writeQuaternion(value.platformRotation),
+        panelOrientation: writeOrientation(value.panelOrientation),
+        motorsRotation: writeOrientation(value.motorsRotation),
+        motorsEnergized: writeOrientation(value.motorsEnergized),
+        timestamp: value.timestamp,
+    };
+
+    if (value.motorsMeasured !== undefined) result.motorsMeasured = writeOrientation(value.motorsMeasured);
+    if (value.trackingPolicy !== undefined) result.trackingPolicy = writeTrackingPolicy(value.trackingPolicy);
+    if (value.telemetry !== undefined) result.telemetry = writeTelemetryRate(value.telemetry);
+    if (value.keyframe !== undefined) result.keyframe = value.keyframe;
+    return result;
+}
+
+function readSystemState(value: any, name: string): SystemState {
+    const object = readObject(value, name);
+    const result: SystemState = {
+        platformRotation: readQuaternion(object.platformRotation, `${name}.platformRotation`),
+        panelOrientation: readOrientation(object.panelOrientation, `${name}.panelOrientation`),
+        motorsRotation: readOrientation(object.motorsRotation, `${name}.motorsRotation`),
+        motorsEnergized: readOrientation(object.motorsEnergized, `${name}.motorsEnergized`),
+        timestamp: readInteger(object.timestamp, `${name}.timestamp`, -Number.MAX_SAFE_INTEGER, Number.MAX_SAFE_INTEGER),
+    };
+
+    if (object.motorsMeasured !== undefined) result.motorsMeasured = readOrientation(object.motorsMeasured, `${name}.motorsMeasured`);
+    if (object.trackingPolicy !== undefined) result.trackingPolicy = readTrackingPolicy(object.trackingPolicy, `${name}.trackingPolicy`);
+    if (object.telemetry !== undefined) result.telemetry = readTelemetryRate(object.telemetry, `${name}.telemetry`);
+    if (object.keyframe !== undefined) result.keyframe = readInteger(object.keyframe, `${name}.keyframe`, 0, 4294967295);
+    return result;
+}
+
+function encodeBinarySystemState(writer: BinaryWriter, value: SystemState) {
+    writer.u8((value.motorsMeasured !== undefined ? 1 : 0) | (value.trackingPolicy !== undefined ? 2 : 0) | (value.telemetry !== undefined ? 4 : 0) | (value.keyframe !== undefined ? 8 : 0));
+    encodeBinaryQuaternion(writer, value.platformRotation);
+    encodeBinaryOrientation(writer, value.panelOrientation);
+    encodeBinaryOrientation(writer, value.motorsRotation);
+    encodeBinaryOrientation(writer, value.motorsEnergized);
+    writer.i64(value.timestamp);
+    if (value.motorsMeasured !== undefined) {
+        encodeBinaryOrientation(writer, value.motorsMeasured);
+    }
+    if (value.trackingPolicy !== undefined) {
+        encodeBinaryTrackingPolicy(writer, value.trackingPolicy);
+    }
+    if (value.telemetry !== undefined) {
+        encodeBinaryTelemetryRate(writer, value.telemetry);
+    }
+    if (value.keyframe !== undefined) {
+        writer.u32(value.keyframe);
+    }
+}
+
+function decodeBinarySystemState(reader: BinaryReader): SystemState {
+    const present = reader.u8();
+
+    if (present >> 4) fail('Unknown optional fields');
+    const result = {} as SystemState;
+
+    result.platformRotation = decodeBinaryQuaternion(reader);
+    result.panelOrientation = decodeBinaryOrientation(reader);
+    result.motorsRotation = decodeBinaryOrientation(reader);
+    result.motorsEnergized = decodeBinaryOrientation(reader);
+    result.timestamp = reader.i64();
+    if (present & 1) result.motorsMeasured = decodeBinaryOrientation(reader);
+    if (present & 2) result.trackingPolicy = decodeBinaryTrackingPolicy(reader);
+    if (present & 4) result.telemetry = decodeBinaryTelemetryRate(reader);
+    if (present & 8) result.keyframe = reader.u32();
+    return result;
+}
+
+function writeViewers(value: Viewers): any {
+    const result: any = {
+        viewers: value.viewers,
+    };
+
+    return result;
+}
+
+function readViewers(value: any, name: string): Viewers {
+    const object = readObject(value, name);
+    const result: Viewers = {
+        viewers: readInteger(object.viewers, `${name}.viewers`, 0, 4294967295),
+    };
+
+    return result;
+}
+
+function encodeBinaryViewers(writer: BinaryWriter, value: Viewers) {
+    writer.u32(value.viewers);
+}
+
+function decodeBinaryViewers(reader: BinaryReader): Viewers {
+    return {
+        viewers: reader.u32(),
+    };
+}
+
+function writeDeltaChange(value: DeltaChange): any {
+    return [value.index, value.steps];
+}
+
+function readDeltaChange(value: any, name: string): DeltaChange {
+    const items = readArray(value, name, 2);
+
+    if (items.length != 2) fail(`${name} does not have 2 items`);
+    return {
+        index: readInteger(items[0], `${name}[0]`, 0, 4294967295),
+        steps: readInteger(items[1], `${name}[1]`, -2147483648, 2147483647),
+    };
+}
+
+function encodeBinaryDeltaChange(writer: BinaryWriter, value: DeltaChange) {
+    writer.u32(value.index);
+    writer.i32(value.steps);
+}
+
+function decodeBinaryDeltaChange(reader: BinaryReader): DeltaChange {
+    return {
+        index: reader.u32(),
+        steps: reader.i32(),
+    };
+}
+
+function writeSystemDelta(value: SystemDelta): any {
+    const result: any = {
+        base: value.base,
+        timestamp: value.timestamp,
+        changes: value.changes.map(writeDeltaChange),
+    };
+
+    return result;
+}
+
+function readSystemDelta(value: any, name: string): SystemDelta {
+    const object = readObject(value, name);
+    const result: SystemDelta = {
+        base: readInteger(object.base, `${name}.base`, 0, 4294967295),
+        timestamp: readInteger(object.timestamp, `${name}.timestamp`, -Number.MAX_SAFE_INTEGER, Number.MAX_SAFE_INTEGER),
+        changes: readArray(object.changes, `${name}.changes`, 10).map((item, i) => readDeltaChange(item, `${name}.changes[${i}]`)),
+    };
+
+    return result;
+}
+
+function encodeBinarySystemDelta(writer: BinaryWriter, value: SystemDelta) {
+    writer.u32(value.base);
+    writer.i64(value.timestamp);
+    writer.u8(value.changes.length);
+    for (let item of value.changes) encodeBinaryDeltaChange(writer, item);
+}
+
+function decodeBinarySystemDelta(reader: BinaryReader): SystemDelta {
+    return {
+        base: reader.u32(),
+        timestamp: reader.i64(),
+        changes: Array.from({ length: reader.count(10) }, () => decodeBinaryDeltaChange(reader)),
+    };
+}
+
+function writeKeyframeAck(value: KeyframeAck): any {
+    const result: any = {
+        keyframe: value.keyframe,
+    };
+
+    return result;
+}
+
+function readKeyframeAck(value: any, name: string): KeyframeAck {
+    const object = readObject(value, name);
+    const result: KeyframeAck = {
+        keyframe: readInteger(object.keyframe, `${name}.keyframe`, 0, 4294967295),
+    };
+
+    return result;
+}
+
+function encodeBinaryKeyframeAck(writer: BinaryWriter, value: KeyframeAck) {
+    writer.u32(value.keyframe);
+}
+
+function decodeBinaryKeyframeAck(reader: BinaryReader): KeyframeAck {
+    return {
+        keyframe: reader.u32(),
+    };
+}
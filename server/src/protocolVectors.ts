@@ -0,0 +1,22 @@
+import fs from 'fs';
+import path from 'path';
+
+export interface ProtocolVector {
+    json: string,
+    binary: Uint8Array,
+}
+
+// Messages encoded by the firmware codec, written by test/test_protocol.c: one
+// per line, the binary form in hex, a space, then the JSON text
+export function readProtocolVectors(): ProtocolVector[] {
+    const text = fs.readFileSync(path.join(__dirname, '..', '..', 'protocol', 'vectors.txt'), 'utf8');
+
+    return text.split('\n').filter(line => line.length > 0).map(line => {
+        const space = line.indexOf(' ');
+
+        return {
+            json: line.slice(space + 1),
+            binary: new Uint8Array(Buffer.from(line.slice(0, space), 'hex')),
+        };
+    });
+}
@@ -0,0 +1,15 @@
+#ifndef __DRIVER_GPIO_H__
+#define __DRIVER_GPIO_H__
+
+#include <stdint.h>
+
+typedef int gpio_num_t;
+
+#define GPIO_NUM_21 21
+#define GPIO_NUM_22 22
+
+#define BIT(n) (1u << (n))
+#define BIT0 BIT(0)
+#define BIT1 BIT(1)
+
+#endif // __DRIVER_GPIO_H__
@@ -0,0 +1,67 @@
+#ifndef __DRIVER_I2C_H__
+#define __DRIVER_I2C_H__
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_intr_alloc.h>
+#include <driver/gpio.h>
+
+// No I2C peripheral on the host: the drivers run against a simulated bus
+// attached with i2c_bus_attach(), installing the driver always fails
+typedef int i2c_port_t;
+
+#define I2C_NUM_0 0
+#define I2C_NUM_1 1
+#define I2C_NUM_MAX 2
+
+typedef enum
+{
+    I2C_MODE_SLAVE,
+    I2C_MODE_MASTER,
+} i2c_mode_t;
+
+enum
+{
+    I2C_MASTER_WRITE = 0,
+    I2C_MASTER_READ = 1,
+};
+
+typedef enum
+{
+    I2C_MASTER_ACK,
+    I2C_MASTER_NACK,
+    I2C_MASTER_LAST_NACK,
+} i2c_ack_type_t;
+
+typedef struct i2c_config_t
+{
+    i2c_mode_t mode;
+    int sda_io_num;
+    int scl_io_num;
+    bool sda_pullup_en;
+    bool scl_pullup_en;
+    struct
+    {
+        uint32_t clk_speed;
+    } master;
+} i2c_config_t;
+
+typedef void *i2c_cmd_handle_t;
+
+static inline esp_err_t i2c_param_config(i2c_port_t port, const i2c_config_t *config) { return ESP_ERR_NOT_SUPPORTED; }
+static inline esp_err_t i2c_driver_install(i2c_port_t port, i2c_mode_t mode, size_t slave_rx, size_t slave_tx, int flags) { return ESP_ERR_NOT_SUPPORTED; }
+static inline esp_err_t i2c_driver_delete(i2c_port_t port) { return ESP_OK; }
+static inline esp_err_t i2c_get_timeout(i2c_port_t port, int *timeout) { return ESP_ERR_NOT_SUPPORTED; }
+static inline esp_err_t i2c_set_timeout(i2c_port_t port, int timeout) { return ESP_ERR_NOT_SUPPORTED; }
+static inline i2c_cmd_handle_t i2c_cmd_link_create(void) { return NULL; }
+static inline void i2c_cmd_link_delete(i2c_cmd_handle_t cmd) {}
+static inline esp_err_t i2c_master_start(i2c_cmd_handle_t cmd) { return ESP_OK; }
+static inline esp_err_t i2c_master_stop(i2c_cmd_handle_t cmd) { return ESP_OK; }
+static inline esp_err_t i2c_master_write_byte(i2c_cmd_handle_t cmd, uint8_t data, bool ack) { return ESP_OK; }
+static inline esp_err_t i2c_master_write(i2c_cmd_handle_t cmd, uint8_t *data, size_t size, bool ack) { return ESP_OK; }
+static inline esp_err_t i2c_master_read(i2c_cmd_handle_t cmd, uint8_t *data, size_t size, i2c_ack_type_t ack) { return ESP_OK; }
+static inline esp_err_t i2c_master_cmd_begin(i2c_port_t port, i2c_cmd_handle_t cmd, uint32_t ticks) { return ESP_ERR_NOT_SUPPORTED; }
+
+#endif // __DRIVER_I2C_H__
@@ -0,0 +1,48 @@
+#ifndef __DRIVER_TIMER_H__
+#define __DRIVER_TIMER_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_intr_alloc.h>
+
+// No hardware timer on the host: the motion queue is ticked by the tests
+typedef enum
+{
+    TIMER_GROUP_0,
+} timer_group_t;
+
+typedef enum
+{
+    TIMER_0,
+} timer_idx_t;
+
+enum
+{
+    TIMER_PAUSE = 0,
+    TIMER_INTR_LEVEL = 0,
+    TIMER_ALARM_EN = 1,
+    TIMER_COUNT_UP = 1,
+    TIMER_AUTORELOAD_EN = 1,
+};
+
+typedef struct timer_config_t
+{
+    int alarm_en;
+    int counter_en;
+    int intr_type;
+    int counter_dir;
+    int auto_reload;
+    int divider;
+} timer_config_t;
+
+static inline esp_err_t timer_init(timer_group_t group, timer_idx_t timer, const timer_config_t *config) { return ESP_ERR_NOT_SUPPORTED; }
+static inline esp_err_t timer_set_counter_value(timer_group_t group, timer_idx_t timer, uint64_t value) { return ESP_OK; }
+static inline esp_err_t timer_set_alarm_value(timer_group_t group, timer_idx_t timer, uint64_t value) { return ESP_OK; }
+static inline esp_err_t timer_isr_callback_add(timer_group_t group, timer_idx_t timer, bool (*callback)(void *), void *arg, int flags) { return ESP_OK; }
+static inline esp_err_t timer_start(timer_group_t group, timer_idx_t timer) { return ESP_OK; }
+static inline esp_err_t timer_pause(timer_group_t group, timer_idx_t timer) { return ESP_OK; }
+static inline esp_err_t timer_isr_callback_remove(timer_group_t group, timer_idx_t timer) { return ESP_OK; }
+static inline esp_err_t timer_deinit(timer_group_t group, timer_idx_t timer) { return ESP_OK; }
+
+#endif // __DRIVER_TIMER_H__
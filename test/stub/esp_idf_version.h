@@ -0,0 +1,7 @@
+#ifndef __ESP_IDF_VERSION_H__
+#define __ESP_IDF_VERSION_H__
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) ((major << 16) | (minor << 8) | (patch))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(4, 4, 0)
+
+#endif // __ESP_IDF_VERSION_H__
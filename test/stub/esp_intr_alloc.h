@@ -0,0 +1,6 @@
+#ifndef __ESP_INTR_ALLOC_H__
+#define __ESP_INTR_ALLOC_H__
+
+#define ESP_INTR_FLAG_IRAM 0
+
+#endif // __ESP_INTR_ALLOC_H__
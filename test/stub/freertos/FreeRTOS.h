@@ -0,0 +1,29 @@
+#ifndef __FREERTOS_H__
+#define __FREERTOS_H__
+
+#include <stdint.h>
+#include "sdkconfig.h"
+
+typedef void *TaskHandle_t;
+typedef int BaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define configMAX_PRIORITIES 25
+#define configTICK_RATE_HZ 1000
+#define portNUM_PROCESSORS 2
+#define portMAX_DELAY 0xffffffff
+#define portTICK_RATE_MS 1
+#define tskIDLE_PRIORITY 0
+#define pdMS_TO_TICKS(ms) (ms)
+
+// Single threaded on the host, critical sections have nothing to exclude
+typedef int portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+#endif // __FREERTOS_H__
@@ -0,0 +1,6 @@
+#ifndef __FREERTOS_QUEUE_H__
+#define __FREERTOS_QUEUE_H__
+
+#include "FreeRTOS.h"
+
+#endif // __FREERTOS_QUEUE_H__
@@ -0,0 +1,14 @@
+#ifndef __FREERTOS_SEMPHR_H__
+#define __FREERTOS_SEMPHR_H__
+
+#include "FreeRTOS.h"
+
+// Tasks never run concurrently on the host, so a mutex is always free
+typedef void *SemaphoreHandle_t;
+
+static inline SemaphoreHandle_t xSemaphoreCreateMutex(void) { return (SemaphoreHandle_t)1; }
+static inline void vSemaphoreDelete(SemaphoreHandle_t semaphore) {}
+static inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) { return pdTRUE; }
+static inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) { return pdTRUE; }
+
+#endif // __FREERTOS_SEMPHR_H__
@@ -0,0 +1,16 @@
+#ifndef __FREERTOS_TASK_H__
+#define __FREERTOS_TASK_H__
+
+#include "FreeRTOS.h"
+
+// Tasks are never started on the host
+static inline BaseType_t xTaskCreatePinnedToCore(void (*task)(void *), const char *name, uint32_t stack, void *params,
+                                                 BaseType_t priority, TaskHandle_t *handle, BaseType_t core) { return pdFALSE; }
+static inline void vTaskDelete(TaskHandle_t task) {}
+static inline void vTaskDelay(TickType_t ticks) {}
+// Delays do not wait, so no time passes between ticks either
+static inline TickType_t xTaskGetTickCount(void) { return 0; }
+static inline uint32_t ulTaskNotifyTake(BaseType_t clear, TickType_t ticks) { return 0; }
+static inline void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken) {}
+
+#endif // __FREERTOS_TASK_H__
@@ -0,0 +1,11 @@
+#ifndef __SDKCONFIG_H__
+#define __SDKCONFIG_H__
+
+// The simulated servos; the I2C drivers run against i2c_bus_sim
+#define CONFIG_ACTUATOR_BACKEND_SIM 1
+
+#define CONFIG_IDF_TARGET_ESP32 1
+#define CONFIG_I2C_BUS_LOCK_TIMEOUT 1000
+#define CONFIG_I2CDEV_TIMEOUT 1000
+
+#endif // __SDKCONFIG_H__
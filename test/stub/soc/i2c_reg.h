@@ -0,0 +1,6 @@
+#ifndef __SOC_I2C_REG_H__
+#define __SOC_I2C_REG_H__
+
+// i2cdev falls back to its own maximum stretch time
+
+#endif // __SOC_I2C_REG_H__
@@ -0,0 +1,52 @@
+#ifndef __TEST_H__
+#define __TEST_H__
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Sun path simulations: a year from 2023-01-01 UTC at the tracker location
+#define TEST_YEAR_START 1672531200
+#define TEST_YEAR_DAYS 365
+#define TEST_LATITUDE 10.75f
+#define TEST_LONGITUDE 106.75f
+
+static int test_failures;
+
+// Reports a failed check and carries on, the test fails once it returns
+#define TEST_CHECK(condition, format, ...)                                              \
+    do                                                                                  \
+    {                                                                                   \
+        if (!(condition))                                                               \
+        {                                                                               \
+            printf("FAIL %s:%d: " format "\n", __FILE__, __LINE__, ##__VA_ARGS__);      \
+            test_failures++;                                                            \
+        }                                                                               \
+    } while (0)
+
+#define TEST_RESULT() (test_failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS)
+
+static inline uint32_t test_random(uint32_t *seed)
+{
+    *seed = *seed * 1664525u + 1013904223u;
+    return *seed;
+}
+
+static inline uint32_t test_random_below(uint32_t *seed, uint32_t count)
+{
+    return ((uint64_t)test_random(seed) * count) >> 32;
+}
+
+// Deterministic gaussian noise: a sum of uniforms, close enough to a normal distribution
+static inline float test_noise(uint32_t *seed, float sigma)
+{
+    float sum = 0.f;
+
+    for (int i = 0; i < 4; i++)
+        sum += (test_random(seed) >> 8) * (1.f / 16777216.f);
+
+    return (sum - 2.f) * sqrtf(3.f) * sigma;
+}
+
+#endif // __TEST_H__
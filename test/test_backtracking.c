@@ -0,0 +1,139 @@
+#include <math.h>
+#include <stdio.h>
+#include "backtracking.h"
+#include "compensation.h"
+#include "sun_calculator.h"
+#include "test.h"
+#include "tracking_policy.h"
+
+#define PI 3.14159265358979323846
+#define rad (PI / 180.f)
+
+// Sun directions every 5 minutes, in chunks of daylight ones
+#define STEP 300
+#define CHUNK 256
+
+static float row_shade(const backtracking_config_t *config, float rotation, float sun_rotation);
+
+// A year of sun directions against several row layouts: the row shading of
+// facing the sun against the incidence backtracking gives up, both weighted
+// by the clear sky output. The backtracked rows must be free of shade and
+// yield at least as much. Rows run north-south, the pitch is in panel widths.
+int main()
+{
+    const struct
+    {
+        float row_pitch;
+        float slope;
+    } layouts[] = {
+        {3.33f, 0.f},
+        {2.5f, 0.f},
+        {2.f, 0.f},
+        {2.5f, 5.f},
+        {2.5f, 10.f},
+    };
+    const int layout_count = sizeof(layouts) / sizeof(layouts[0]);
+    const tracking_policy_config_t power_config = tracking_policy_default_config();
+    static float sun_x[CHUNK], sun_y[CHUNK], sun_z[CHUNK];
+    static float rotations[CHUNK], incidences[CHUNK];
+    static float sun_rotations[CHUNK], powers[CHUNK];
+    backtracking_t backtracking[layout_count];
+    double facing[layout_count], backtracked[layout_count];
+    float shade_max[layout_count];
+    int backtracking_count[layout_count];
+    double ideal = 0.;
+    int samples = 0;
+
+    for (int l = 0; l < layout_count; l++)
+    {
+        backtracking_config_t config = backtracking_default_config();
+        config.row_pitch = layouts[l].row_pitch;
+        config.slope = layouts[l].slope;
+        backtracking_init(&backtracking[l], &config);
+        facing[l] = backtracked[l] = 0.;
+        shade_max[l] = 0.f;
+        backtracking_count[l] = 0;
+    }
+
+    time_t t = TEST_YEAR_START;
+    while (t < TEST_YEAR_START + TEST_YEAR_DAYS * 86400)
+    {
+        int count = 0;
+
+        for (; count < CHUNK && t < TEST_YEAR_START + TEST_YEAR_DAYS * 86400; t += STEP)
+        {
+            orientation_t sun = get_sun_orientation(t, TEST_LATITUDE, TEST_LONGITUDE);
+            vector3_t direction = compensation_direction(sun);
+
+            // Daylight only
+            if (sun.inclination >= 90.f)
+                continue;
+
+            sun_x[count] = direction.x;
+            sun_y[count] = direction.y;
+            sun_z[count] = direction.z;
+            powers[count] = tracking_policy_clear_sky_power(&power_config, sun.inclination);
+            ideal += powers[count];
+            count++;
+        }
+        samples += count;
+
+        for (int l = 0; l < layout_count; l++)
+        {
+            backtracking_evaluate(&backtracking[l], sun_x, sun_y, sun_z, count, rotations, incidences);
+
+            for (int i = 0; i < count; i++)
+            {
+                vector3_t direction = {sun_x[i], sun_y[i], sun_z[i]};
+                float across = vector3_dot(direction, backtracking[l].across);
+
+                sun_rotations[i] = atan2f(across, sun_z[i]);
+            }
+
+            for (int i = 0; i < count; i++)
+            {
+                // Facing the sun loses the shaded part of the panel, the
+                // backtracked panel has to be free of shade
+                float shade = row_shade(&backtracking[l].config, rotations[i], sun_rotations[i]);
+
+                facing[l] += powers[i] * (1.f - row_shade(&backtracking[l].config, sun_rotations[i], sun_rotations[i]));
+                backtracked[l] += powers[i] * incidences[i] * (1.f - shade);
+                shade_max[l] = fmaxf(shade_max[l], shade);
+                if (fabsf(rotations[i] - sun_rotations[i]) > 1e-4f)
+                    backtracking_count[l]++;
+            }
+        }
+    }
+
+    for (int l = 0; l < layout_count; l++)
+    {
+        printf("Pitch %.2f, slope %.0f degree: backtracking %.1f%% of %d samples, yield facing the sun %.2f%% backtracked %.2f%%, "
+               "shade left %.5f\n",
+               layouts[l].row_pitch, layouts[l].slope, 100.f * backtracking_count[l] / samples, samples,
+               100. * facing[l] / ideal, 100. * backtracked[l] / ideal, shade_max[l]);
+        TEST_CHECK(shade_max[l] <= 1e-3f, "pitch %.2f, slope %.0f: %.5f of the panel left shaded",
+                   layouts[l].row_pitch, layouts[l].slope, shade_max[l]);
+        TEST_CHECK(backtracked[l] >= facing[l], "pitch %.2f, slope %.0f: backtracking yields %.2f%%, facing the sun %.2f%%",
+                   layouts[l].row_pitch, layouts[l].slope, 100. * backtracked[l] / ideal, 100. * facing[l] / ideal);
+    }
+
+    return TEST_RESULT();
+}
+
+// Shaded part of a panel at `rotation` (radian) by the next row toward a sun
+// at `sun_rotation`, in the plane across the rows: the edges of both panels
+// are projected on the axis across the sun rays and their overlap measured.
+static float row_shade(const backtracking_config_t *config, float rotation, float sun_rotation)
+{
+    float half_width = .5f * config->panel_width;
+    float next_x = copysignf(config->row_pitch, sun_rotation);
+    float next_z = next_x * tanf(config->slope * rad);
+    // Across the sun rays, and along the panel surface
+    float ux = cosf(sun_rotation), uz = -sinf(sun_rotation);
+    float tx = cosf(rotation), tz = -sinf(rotation);
+    float edge = fabsf(half_width * (tx * ux + tz * uz));
+    float next = next_x * ux + next_z * uz;
+    float overlap = fminf(edge, next + edge) - fmaxf(-edge, next - edge);
+
+    return edge > 0.f ? fmaxf(overlap, 0.f) / (2.f * edge) : 0.f;
+}
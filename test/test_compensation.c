@@ -0,0 +1,144 @@
+#include <esp_timer.h>
+#include <math.h>
+#include <stdio.h>
+#include "compensation.h"
+#include "test.h"
+
+#define PI 3.14159265358979323846
+#define rad (PI / 180.f)
+
+// Orientations and timed passes over them
+#define INPUTS 64
+#define PASSES 500
+// Platform rotations the outputs are compared on
+#define ROTATIONS 100
+
+static orientation_t compensate_quaternion_chain(quaternion_t platform_rotation, orientation_t orientation, float fallback_azimuth);
+static float largest_difference(quaternion_t platform_rotation);
+static void report(const char *stage, int64_t elapsed, int calls);
+
+static orientation_t inputs[INPUTS];
+static vector3_t directions[INPUTS];
+static vector3_t local[INPUTS];
+static orientation_t outputs[INPUTS];
+
+// Times every stage of the cached matrix compensation against the quaternion
+// chain it replaced, then checks both agree on a range of platform tilts
+int main()
+{
+    const quaternion_t platform_rotation = quaternion_normalize((quaternion_t){.98f, .08f, -.12f, .1f});
+    const int calls = INPUTS * PASSES;
+    compensation_t compensation;
+    int64_t start;
+
+    for (int i = 0; i < INPUTS; i++)
+        inputs[i] = (orientation_t){.azimuth = i * 360.f / INPUTS, .inclination = (i % 9) * 10.f};
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < PASSES; pass++)
+        for (int i = 0; i < INPUTS; i++)
+            outputs[i] = compensate_quaternion_chain(platform_rotation, inputs[i], 0.f);
+    report("quaternion chain", esp_timer_get_time() - start, calls);
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < calls; pass++)
+    {
+        compensation_init(&compensation, 0.f);
+        compensation_set_platform_rotation(&compensation, platform_rotation);
+    }
+    report("matrix rebuild", esp_timer_get_time() - start, calls);
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < calls; pass++)
+        compensation_set_platform_rotation(&compensation, platform_rotation);
+    report("unchanged rotation check", esp_timer_get_time() - start, calls);
+    TEST_CHECK(compensation.rebuilds == 1, "%u rebuilds for an unchanged rotation", compensation.rebuilds);
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < PASSES; pass++)
+        for (int i = 0; i < INPUTS; i++)
+            directions[i] = compensation_direction(inputs[i]);
+    report("direction from azimuth and inclination", esp_timer_get_time() - start, calls);
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < PASSES; pass++)
+        for (int i = 0; i < INPUTS; i++)
+            local[i] = compensation_to_platform(&compensation, directions[i]);
+    report("matrix-vector product", esp_timer_get_time() - start, calls);
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < PASSES; pass++)
+        for (int i = 0; i < INPUTS; i++)
+            compensation_orientation(local[i], &outputs[i]);
+    report("direction to orientation", esp_timer_get_time() - start, calls);
+
+    start = esp_timer_get_time();
+    for (int pass = 0; pass < PASSES; pass++)
+        for (int i = 0; i < INPUTS; i++)
+            outputs[i] = compensation_apply(&compensation, inputs[i], 0.f);
+    report("cached matrix, total", esp_timer_get_time() - start, calls);
+
+    // Platform tilts up to 20 degrees around random axes
+    float error_max = largest_difference(platform_rotation);
+    uint32_t seed = 32;
+
+    for (int rotation = 0; rotation < ROTATIONS; rotation++)
+    {
+        vector3_t axis = vector3_normalize((vector3_t){test_noise(&seed, 1.f), test_noise(&seed, 1.f), test_noise(&seed, 1.f)});
+        float angle = test_random_below(&seed, 2000) * .01f * rad;
+        quaternion_t tilt = quaternion_exp((vector3_t){axis.x * angle, axis.y * angle, axis.z * angle});
+
+        error_max = fmaxf(error_max, largest_difference(tilt));
+    }
+
+    printf("Largest difference with the quaternion chain: %.5f deg\n", error_max);
+    TEST_CHECK(error_max < 1e-3f, "%.5f deg from the quaternion chain", error_max);
+
+    return TEST_RESULT();
+}
+
+// The compensation as it was done before the cached matrix
+static orientation_t compensate_quaternion_chain(quaternion_t platform_rotation, orientation_t orientation, float fallback_azimuth)
+{
+    vector3_t world_direction = quaternion_rotate(
+        quaternion_from_orientation(orientation),
+        VECTOR3_UP);
+    vector3_t local_direction = quaternion_rotate(
+        quaternion_inverse(platform_rotation),
+        world_direction);
+
+    local_direction = vector3_normalize(local_direction);
+
+    if (fabs(local_direction.x) < .1f && fabs(local_direction.y) < .1f)
+        return (orientation_t){.azimuth = fallback_azimuth, .inclination = 0.f};
+
+    return (orientation_t){
+        .azimuth = -atan2(local_direction.y, local_direction.x) / rad + (local_direction.y >= 0.f ? 360.f : 0.f),
+        .inclination = acos(local_direction.z) / rad,
+    };
+}
+
+static float largest_difference(quaternion_t platform_rotation)
+{
+    compensation_t compensation;
+    float error_max = 0.f;
+
+    compensation_init(&compensation, 0.f);
+    compensation_set_platform_rotation(&compensation, platform_rotation);
+
+    for (int i = 0; i < INPUTS; i++)
+    {
+        orientation_t expected = compensate_quaternion_chain(platform_rotation, inputs[i], 0.f);
+        orientation_t output = compensation_apply(&compensation, inputs[i], 0.f);
+        float azimuth_error = fabsf(remainderf(output.azimuth - expected.azimuth, 360.f));
+
+        error_max = fmaxf(error_max, fmaxf(azimuth_error, fabsf(output.inclination - expected.inclination)));
+    }
+
+    return error_max;
+}
+
+static void report(const char *stage, int64_t elapsed, int calls)
+{
+    printf("%s: %lld ns/call\n", stage, (long long)(elapsed * 1000 / calls));
+}
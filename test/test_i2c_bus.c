@@ -0,0 +1,135 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "i2c_bus_sim.h"
+#include "mpu9250.h"
+#include "ak8963.h"
+#include "ds3231.h"
+#include "test.h"
+
+#define CLK_SPEED 400000
+
+static uint32_t read_time_ns(size_t data_size)
+{
+    return i2c_bus_transfer_time_ns(CLK_SPEED, 1, data_size, true);
+}
+
+static bool vector_equal(const vector_t *v, float x, float y, float z)
+{
+    return fabsf(v->x - x) < 1e-4f && fabsf(v->y - y) < 1e-4f && fabsf(v->z - z) < 1e-4f;
+}
+
+// Transfers the secondary IMU still acknowledges before it drops off the bus
+static int secondary_answers = 1;
+
+static bool secondary_is_present(const i2c_sim_device_t *device)
+{
+    return secondary_answers-- > 0;
+}
+
+// The MPU9250, its AK8963 and the DS3231 on simulated buses, read through
+// their drivers: a sample has to come back in one batch of two reads, taking
+// less wire time than reading the sensors one after the other. A secondary
+// IMU failing halfway through its initialization leaves the primary running.
+int main()
+{
+    static i2c_bus_sim_t sim, rtc_sim;
+    i2c_bus_t bus, rtc_bus;
+    i2c_sim_device_t *magnetometer;
+    calibration_t cal = {
+        .mag_scale = {1.f, 1.f, 1.f},
+        .accel_scale_lo = {1.f, 1.f, 1.f},
+        .accel_scale_hi = {1.f, 1.f, 1.f},
+    };
+
+    i2c_bus_sim_init(&bus, &sim, I2C_NUM_0, CLK_SPEED);
+    i2c_sim_device_t *mpu9250 = i2c_bus_sim_add_mpu9250(&sim, MPU9250_I2C_ADDR, &magnetometer);
+    i2c_sim_device_t *secondary = i2c_bus_sim_add_mpu9250(&sim, MPU9250_I2C_ADDR_SECONDARY, NULL);
+    i2c_bus_attach(&bus);
+
+    // The secondary IMU takes the DS3231 address, the RTC has a bus of its own
+    i2c_bus_sim_init(&rtc_bus, &rtc_sim, I2C_NUM_1, CLK_SPEED);
+    i2c_sim_device_t *ds3231 = i2c_bus_sim_add_ds3231(&rtc_sim, DS3231_ADDR);
+    i2c_bus_attach(&rtc_bus);
+
+    TEST_CHECK(i2c_mpu9250_init(&cal) == ESP_OK, "MPU9250 initialization failed");
+
+    // Answers WHO_AM_I, then stops acknowledging
+    secondary->is_present = secondary_is_present;
+    TEST_CHECK(i2c_mpu9250_init_secondary(&cal) == ESP_FAIL, "Secondary MPU9250 initialization did not fail");
+
+    // 1 g on z at ±4 g, 1 and -2 deg/s at ±250 deg/s
+    const int16_t accel[3] = {0, 0, 8192};
+    const int16_t gyro[3] = {131, -262, 0};
+    const int16_t magnet[3] = {100, -200, 300};
+    vector_t va, vg, vm;
+    vector_t dual_va[2], dual_vg[2], dual_vm[2];
+    esp_err_t results[2];
+
+    i2c_bus_sim_set_mpu9250_sample(mpu9250, accel, gyro, 0);
+    i2c_bus_sim_set_ak8963_sample(magnetometer, magnet);
+    i2c_bus_reset_stats(&bus);
+
+    // Without the secondary IMU, the dual read is the primary sample read
+    TEST_CHECK(get_accel_gyro_mag_dual(dual_va, dual_vg, dual_vm, results) == ESP_OK, "Dual sample read failed");
+    TEST_CHECK(results[0] == ESP_OK && results[1] == ESP_ERR_INVALID_STATE, "Dual sample results %d, %d", results[0], results[1]);
+    va = dual_va[0];
+    vg = dual_vg[0];
+    vm = dual_vm[0];
+    TEST_CHECK(vector_equal(&va, 0.f, 0.f, 1.f), "Accel (%.4f, %.4f, %.4f)", va.x, va.y, va.z);
+    TEST_CHECK(vector_equal(&vg, 1.f, -2.f, 0.f), "Gyro (%.4f, %.4f, %.4f)", vg.x, vg.y, vg.z);
+    TEST_CHECK(vector_equal(&vm, 100.f, -200.f, 300.f), "Magnet (%.4f, %.4f, %.4f)", vm.x, vm.y, vm.z);
+
+    // Accel, temperature and gyro, then the magnetometer through ST2
+    i2c_bus_stats_t batched = bus.stats;
+    uint64_t batched_time = read_time_ns(14) + read_time_ns(AK8963_ST2 - AK8963_XOUT_L + 1);
+
+    printf("Batched sample: %u transactions, %u bytes written, %u read, %.1f us\n",
+           batched.transactions, batched.bytes_written, batched.bytes_read, batched.bus_time_ns * 1e-3f);
+    TEST_CHECK(batched.transactions == 2 && batched.errors == 0, "%u transactions, %u errors", batched.transactions, batched.errors);
+    TEST_CHECK(batched.bytes_written == 2, "%u bytes written", batched.bytes_written);
+    TEST_CHECK(batched.bytes_read == 21, "%u bytes read", batched.bytes_read);
+    TEST_CHECK(batched.bus_time_ns == batched_time, "%llu ns on the bus, %llu expected",
+               (unsigned long long)batched.bus_time_ns, (unsigned long long)batched_time);
+
+    // The same sample one sensor at a time, ending the magnetometer cycle with a read of ST2
+    i2c_bus_sim_set_ak8963_sample(magnetometer, magnet);
+    i2c_bus_reset_stats(&bus);
+
+    TEST_CHECK(get_accel(&va) == ESP_OK && get_gyro(&vg) == ESP_OK && get_mag(&vm) == ESP_OK, "Separate reads failed");
+    TEST_CHECK(vector_equal(&vm, 100.f, -200.f, 300.f), "Magnet (%.4f, %.4f, %.4f)", vm.x, vm.y, vm.z);
+
+    i2c_bus_stats_t separate = bus.stats;
+
+    printf("Separate reads: %u transactions, %u bytes written, %u read, %.1f us\n",
+           separate.transactions, separate.bytes_written, separate.bytes_read, separate.bus_time_ns * 1e-3f);
+    TEST_CHECK(separate.transactions == 4, "%u transactions", separate.transactions);
+    TEST_CHECK(batched.bus_time_ns < separate.bus_time_ns, "%llu ns on the bus batched, %llu separately",
+               (unsigned long long)batched.bus_time_ns, (unsigned long long)separate.bus_time_ns);
+
+    // The RTC goes through i2cdev, which shares the bus manager with the MPU9250 driver
+    struct tm now = {.tm_sec = 56, .tm_min = 34, .tm_hour = 12, .tm_mday = 21, .tm_mon = 5, .tm_year = 123, .tm_wday = 3};
+    struct tm time;
+    i2c_dev_t rtc;
+
+    memset(&rtc, 0, sizeof(rtc));
+    i2c_bus_sim_set_ds3231_time(ds3231, &now);
+    TEST_CHECK(ds3231_init_desc(&rtc, I2C_NUM_1, GPIO_NUM_21, GPIO_NUM_22) == ESP_OK, "DS3231 initialization failed");
+
+    TEST_CHECK(ds3231_get_time(&rtc, &time) == ESP_OK, "Time read failed");
+    TEST_CHECK(time.tm_year == now.tm_year && time.tm_mon == now.tm_mon && time.tm_mday == now.tm_mday &&
+                   time.tm_hour == now.tm_hour && time.tm_min == now.tm_min && time.tm_sec == now.tm_sec,
+               "Time %04d-%02d-%02d %02d:%02d:%02d", time.tm_year + 1900, time.tm_mon + 1, time.tm_mday,
+               time.tm_hour, time.tm_min, time.tm_sec);
+
+    i2c_bus_stats_t *stats = &rtc_bus.stats;
+
+    printf("Time read: %u transactions, %u bytes written, %u read, %.1f us\n",
+           stats->transactions, stats->bytes_written, stats->bytes_read, stats->bus_time_ns * 1e-3f);
+    TEST_CHECK(stats->transactions == 1 && stats->bytes_written == 1 && stats->bytes_read == 7,
+               "%u transactions, %u bytes written, %u read", stats->transactions, stats->bytes_written, stats->bytes_read);
+    TEST_CHECK(stats->bus_time_ns == read_time_ns(7), "%llu ns on the bus", (unsigned long long)stats->bus_time_ns);
+
+    return TEST_RESULT();
+}
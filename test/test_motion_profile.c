@@ -0,0 +1,116 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "motion_profile.h"
+#include "test.h"
+
+// Sampling step of the checks
+#define STEP 1e-3f
+// Shortest LEDC fade ramp, one PWM frame, and its allowed deviation (degree)
+#define FADE_SPACING .02f
+#define FADE_TOLERANCE .25f
+
+// Plans moves with both profile types and samples them finely, checking the
+// peak velocity, acceleration and jerk against the limits, the arrival on
+// target, that both axes arrive together, and that the LEDC fade ramps
+// between breakpoints stay close to the profile
+int main()
+{
+    const motion_limits_t limits[MOTION_PROFILE_AXES] = {
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+        {.velocity = 120.f, .acceleration = 240.f, .jerk = 1500.f},
+    };
+    const struct
+    {
+        const char *name;
+        axis_state_t start[MOTION_PROFILE_AXES];
+        float target[MOTION_PROFILE_AXES];
+    } moves[] = {
+        {"long move", {{0.f, 0.f, 0.f}, {0.f, 0.f, 0.f}}, {170.f, -60.f}},
+        {"short move", {{10.f, 0.f, 0.f}, {10.f, 0.f, 0.f}}, {12.f, 10.5f}},
+        {"retarget ahead", {{50.f, 100.f, -100.f}, {20.f, -30.f, 50.f}}, {120.f, -10.f}},
+        {"retarget behind", {{50.f, 150.f, 200.f}, {0.f, 60.f, 0.f}}, {20.f, 5.f}},
+    };
+    const motion_profile_type_t types[] = {MOTION_PROFILE_TRAPEZOIDAL, MOTION_PROFILE_S_CURVE};
+
+    for (int t = 0; t < sizeof(types) / sizeof(types[0]); t++)
+    {
+        for (int m = 0; m < sizeof(moves) / sizeof(moves[0]); m++)
+        {
+            static motion_profile_t profile;
+            axis_state_t states[MOTION_PROFILE_AXES], previous[MOTION_PROFILE_AXES];
+            float velocity = 0.f, acceleration = 0.f, jerk = 0.f, jump = 0.f, arrival = 0.f;
+
+            motion_profile_plan(&profile, types[t], limits, moves[m].start, moves[m].target);
+            memcpy(previous, moves[m].start, sizeof(previous));
+
+            for (float time = STEP; time < profile.duration + STEP; time += STEP)
+            {
+                motion_profile_sample(&profile, time, states);
+
+                for (int a = 0; a < MOTION_PROFILE_AXES; a++)
+                {
+                    // Peaks relative to the limits, 1 means at the limit
+                    velocity = fmaxf(velocity, fabsf(states[a].velocity) / limits[a].velocity);
+                    acceleration = fmaxf(acceleration, fabsf(states[a].acceleration) / limits[a].acceleration);
+                    if (types[t] == MOTION_PROFILE_S_CURVE)
+                        jerk = fmaxf(jerk, fabsf(states[a].acceleration - previous[a].acceleration) / STEP / limits[a].jerk);
+                    // Position steps beyond what the velocity limit allows
+                    jump = fmaxf(jump, fabsf(states[a].position - previous[a].position) - limits[a].velocity * STEP);
+                    previous[a] = states[a];
+                }
+            }
+
+            for (int a = 0; a < MOTION_PROFILE_AXES; a++)
+            {
+                // Where the axis is just before the end, against the target
+                axis_state_t before[MOTION_PROFILE_AXES];
+                motion_profile_sample(&profile, profile.duration - STEP, before);
+                arrival = fmaxf(arrival, fabsf(before[a].position - moves[m].target[a]) - limits[a].velocity * STEP);
+            }
+
+            float skew = fabsf(profile.axes[0].duration - profile.axes[1].duration);
+
+            printf("%s, %s: %.3f s, arrival skew %.4f s, peak velocity %.3f, acceleration %.3f, jerk %.3f of limits\n",
+                   motion_profile_type_name(types[t]), moves[m].name, profile.duration, skew, velocity, acceleration, jerk);
+            TEST_CHECK(velocity <= 1.001f && acceleration <= 1.001f && jerk <= 1.01f, "%s, %s: limits exceeded",
+                       motion_profile_type_name(types[t]), moves[m].name);
+            TEST_CHECK(jump <= 1e-3f, "%s, %s: position jumps %.4f degree", motion_profile_type_name(types[t]), moves[m].name, jump);
+            TEST_CHECK(arrival <= 1e-2f, "%s, %s: %.4f degree off target", motion_profile_type_name(types[t]), moves[m].name, arrival);
+            TEST_CHECK(skew <= 1e-3f, "%s, %s: axes arrive %.4f s apart", motion_profile_type_name(types[t]), moves[m].name, skew);
+
+            // The same move as linear LEDC fade ramps between breakpoints
+            int ramps = 0;
+            float ramp_error = 0.f;
+
+            for (float from = 0.f; from < profile.duration; ramps++)
+            {
+                float to = motion_profile_next_breakpoint(&profile, from, FADE_SPACING, FADE_TOLERANCE);
+                axis_state_t ends[2][MOTION_PROFILE_AXES];
+
+                motion_profile_sample(&profile, from, ends[0]);
+                motion_profile_sample(&profile, to, ends[1]);
+
+                for (float time = from; time < to; time += STEP)
+                {
+                    motion_profile_sample(&profile, time, states);
+
+                    for (int a = 0; a < MOTION_PROFILE_AXES; a++)
+                    {
+                        float ramp = ends[0][a].position + (ends[1][a].position - ends[0][a].position) * (time - from) / (to - from);
+                        ramp_error = fmaxf(ramp_error, fabsf(ramp - states[a].position));
+                    }
+                }
+
+                from = to;
+            }
+
+            printf("%s, %s: %d fade ramps instead of %d duty updates, max deviation from the profile %.3f degree\n",
+                   motion_profile_type_name(types[t]), moves[m].name, ramps, (int)ceilf(profile.duration / FADE_SPACING), ramp_error);
+            TEST_CHECK(ramp_error <= FADE_TOLERANCE * 1.01f, "%s, %s: fade ramps %.3f degree off the profile",
+                       motion_profile_type_name(types[t]), moves[m].name, ramp_error);
+        }
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,94 @@
+#include <math.h>
+#include <stdio.h>
+#include "motion_profile.h"
+#include "motion_queue.h"
+#include "test.h"
+
+// Executor period (us), queued horizon (s) and tolerance (degree), and the
+// refill period (ticks)
+#define PERIOD 20000
+#define HORIZON .3f
+#define TOLERANCE .05f
+#define REFILL 5
+
+static void count_output(const float angles[MOTORS_AXES], uint32_t energize, void *context);
+
+// A planned move executed from the queue, refilled like the motors task does,
+// against the motion profile, then retargeted halfway. The executor is ticked
+// here, its timing is left to the on-device benchmark.
+int main()
+{
+    const motion_limits_t limits[MOTION_PROFILE_AXES] = {
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+    };
+    const axis_state_t start[MOTION_PROFILE_AXES] = {{.position = 30.f}, {.position = 0.f}};
+    const float target[MOTION_PROFILE_AXES] = {150.f, 60.f};
+    const float retarget[MOTION_PROFILE_AXES] = {20.f, -30.f};
+    const float period = PERIOD * 1e-6f;
+    static motion_queue_t queue;
+    static motion_profile_t profile;
+    float position[MOTORS_AXES] = {start[0].position, start[1].position};
+    float previous[MOTORS_AXES] = {start[0].position, start[1].position};
+    float deviation = 0.f, step = 0.f, queued_until = 0.f, planned_at = 0.f;
+    uint32_t segments = 0, ticks = 0, outputs = 0;
+    bool retargeted = false;
+
+    motion_queue_init(&queue, position, PERIOD, count_output, &outputs);
+    motion_profile_plan(&profile, MOTION_PROFILE_S_CURVE, limits, start, target);
+
+    for (uint32_t tick = 0; !retargeted || tick * period - planned_at < profile.duration + HORIZON; tick++)
+    {
+        float elapsed = tick * period - planned_at;
+        axis_state_t states[MOTION_PROFILE_AXES];
+
+        if (!retargeted && elapsed >= .5f * profile.duration)
+        {
+            // From where the profile says the motors are, as the motors task does
+            motion_profile_sample(&profile, elapsed, states);
+            motion_profile_plan(&profile, MOTION_PROFILE_S_CURVE, limits, states, retarget);
+            motion_queue_flush(&queue);
+            queued_until = 0.f;
+            planned_at = tick * period;
+            elapsed = 0.f;
+            retargeted = true;
+        }
+
+        if (tick % REFILL == 0 || elapsed == 0.f)
+        {
+            uint32_t before = motion_queue_length(&queue);
+            queued_until = motion_queue_push_profile(&queue, &profile, queued_until, elapsed + HORIZON, TOLERANCE);
+            segments += motion_queue_length(&queue) - before;
+        }
+
+        motion_queue_tick(&queue, (int64_t)tick * PERIOD);
+        ticks++;
+        motion_profile_sample(&profile, elapsed + period, states);
+
+        for (int axis = 0; axis < MOTORS_AXES; axis++)
+        {
+            deviation = fmaxf(deviation, fabsf(queue.position[axis] - states[axis].position));
+            step = fmaxf(step, fabsf(queue.position[axis] - previous[axis]) / period / limits[axis].velocity);
+            previous[axis] = queue.position[axis];
+        }
+    }
+
+    printf("%u ticks from %u segments, deviation from the profile %.3f degree, peak step %.2f of the velocity limit, "
+           "%u underruns, ends at %.2f %.2f\n",
+           ticks, segments, deviation, step, queue.stats.underruns, queue.position[0], queue.position[1]);
+    TEST_CHECK(outputs == ticks, "%u outputs for %u ticks", outputs, ticks);
+    // Segments end on executor ticks, which can shift them by a fraction of a tick
+    TEST_CHECK(deviation <= 2.f * TOLERANCE, "%.3f degree off the profile", deviation);
+    TEST_CHECK(step <= 1.01f, "steps at %.2f of the velocity limit", step);
+    TEST_CHECK(queue.stats.underruns == 0, "%u underruns", queue.stats.underruns);
+    for (int axis = 0; axis < MOTORS_AXES; axis++)
+        TEST_CHECK(fabsf(queue.position[axis] - retarget[axis]) <= 1e-3f, "axis %d ends at %.3f instead of %.3f",
+                   axis, queue.position[axis], retarget[axis]);
+
+    return TEST_RESULT();
+}
+
+static void count_output(const float angles[MOTORS_AXES], uint32_t energize, void *context)
+{
+    (*(uint32_t *)context)++;
+}
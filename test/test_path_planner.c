@@ -0,0 +1,222 @@
+#include <math.h>
+#include <stdio.h>
+#include "motion_profile.h"
+#include "path_planner.h"
+#include "sun_calculator.h"
+#include "test.h"
+
+// Tracking every 2 minutes over the year
+#define STEP 120
+// Sun feed-forward: days spread over the year, tracked every 10 s, and the
+// longest lookahead (s)
+#define FEED_FORWARD_DAYS 12
+#define FEED_FORWARD_STEP 10
+#define FEED_FORWARD_MAX_LOOKAHEAD 600.f
+
+static const motion_limits_t limits[MOTION_PROFILE_AXES] = {
+    {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+    {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+};
+
+static void test_sun_path();
+static void test_sun_feed_forward();
+static void test_motors_ticks();
+static bool is_in_fold_dead_zone(orientation_t orientation);
+
+int main()
+{
+    test_sun_path();
+    test_sun_feed_forward();
+    test_motors_ticks();
+
+    return TEST_RESULT();
+}
+
+// A year of sun paths tracked by the former fold and dead zones, then by the
+// path planner, which has to move less often and for less time, and stay
+// within its pointing tolerance of the sun
+static void test_sun_path()
+{
+    static path_planner_t planner;
+    static motion_profile_t profile;
+    int move_counts[2];
+    float moving_times[2];
+
+    for (int run = 0; run < 2; run++)
+    {
+        bool planned = run == 1;
+        path_planner_config_t config = path_planner_default_config(MOTION_PROFILE_S_CURVE, limits);
+        orientation_t motors = {0.f, 0.f};
+        float azimuth_travel = 0.f, inclination_travel = 0.f, moving_time = 0.f;
+        float error_sum = 0.f, error_max = 0.f;
+        int moves = 0, sweeps = 0, steps = 0;
+
+        path_planner_init(&planner, &config);
+
+        for (time_t t = TEST_YEAR_START; t < TEST_YEAR_START + TEST_YEAR_DAYS * 86400; t += STEP)
+        {
+            orientation_t sun = get_sun_orientation(t, TEST_LATITUDE, TEST_LONGITUDE);
+            orientation_t desired = sun;
+            bool move;
+
+            // Daylight only
+            if (sun.inclination >= 90.f)
+                continue;
+
+            if (planned)
+            {
+                axis_state_t current[MOTION_PROFILE_AXES] = {{.position = motors.azimuth}, {.position = motors.inclination}};
+                move = path_planner_plan(&planner, sun, current, &desired);
+            }
+            else
+            {
+                if (desired.azimuth > 180.f)
+                {
+                    desired.azimuth -= 180.f;
+                    desired.inclination = -desired.inclination;
+                }
+                desired.inclination = fminf(fmaxf(desired.inclination, -90.f), 90.f);
+                move = !(is_in_fold_dead_zone(desired) && is_in_fold_dead_zone(motors));
+            }
+            steps++;
+
+            if (move && (desired.azimuth != motors.azimuth || desired.inclination != motors.inclination))
+            {
+                axis_state_t current[MOTION_PROFILE_AXES] = {{.position = motors.azimuth}, {.position = motors.inclination}};
+                float target[MOTION_PROFILE_AXES] = {desired.azimuth, desired.inclination};
+                motion_profile_plan(&profile, MOTION_PROFILE_S_CURVE, limits, current, target);
+
+                azimuth_travel += fabsf(desired.azimuth - motors.azimuth);
+                inclination_travel += fabsf(desired.inclination - motors.inclination);
+                moving_time += profile.duration;
+                sweeps += fabsf(desired.azimuth - motors.azimuth) > 90.f;
+                moves++;
+                motors = desired;
+            }
+
+            float error = path_planner_pointing_error(motors, sun);
+            error_sum += error;
+            error_max = fmaxf(error_max, error);
+        }
+
+        move_counts[run] = moves;
+        moving_times[run] = moving_time;
+        printf("Sun path / %s: %d moves, %d azimuth sweeps, travel azimuth %.0f deg, inclination %.0f deg, "
+               "moving %.0f s, pointing error mean %.3f deg, max %.3f deg\n",
+               planned ? "path planner" : "fold and dead zones", moves, sweeps, azimuth_travel, inclination_travel,
+               moving_time, error_sum / steps, error_max);
+        if (planned)
+        {
+            printf("Sun path / path planner: solutions timed on %u of %d steps\n", planner.evaluations, steps);
+            TEST_CHECK(error_max <= config.pointing_tolerance + 1e-3f, "path planner %.3f degree off the sun", error_max);
+            TEST_CHECK(planner.evaluations < (uint32_t)steps, "solutions timed on all %d steps", steps);
+        }
+    }
+
+    TEST_CHECK(move_counts[1] < move_counts[0], "path planner moves %d times, the fold %d", move_counts[1], move_counts[0]);
+    TEST_CHECK(moving_times[1] < moving_times[0], "path planner moves for %.0f s, the fold %.0f", moving_times[1], moving_times[0]);
+}
+
+// Days spread over a year, tracked every 10 s behind the path planner dead
+// band: aiming ahead of the sun has to point closer to it on average than
+// aiming at it. Pointing errors are against where the sun actually is.
+static void test_sun_feed_forward()
+{
+    static path_planner_t planner;
+    float error_means[2], error_maxes[2];
+
+    for (int run = 0; run < 2; run++)
+    {
+        bool ahead = run == 1;
+        path_planner_config_t config = path_planner_default_config(MOTION_PROFILE_S_CURVE, limits);
+        orientation_t motors = {90.f, 0.f};
+        float error_sum = 0.f, error_max = 0.f;
+        int moves = 0, steps = 0;
+
+        path_planner_init(&planner, &config);
+
+        for (int day = 0; day < FEED_FORWARD_DAYS; day++)
+        {
+            time_t start = TEST_YEAR_START + day * (TEST_YEAR_DAYS / FEED_FORWARD_DAYS) * 86400;
+
+            for (time_t t = start; t < start + 86400; t += FEED_FORWARD_STEP)
+            {
+                orientation_t sun = get_sun_orientation(t, TEST_LATITUDE, TEST_LONGITUDE);
+                orientation_t aim = sun, desired;
+
+                // Daylight only
+                if (sun.inclination >= 90.f)
+                    continue;
+
+                if (ahead)
+                {
+                    float lookahead = get_sun_lookahead(t, TEST_LATITUDE, TEST_LONGITUDE, config.dead_band, FEED_FORWARD_MAX_LOOKAHEAD);
+                    aim = get_sun_orientation(t + lroundf(lookahead), TEST_LATITUDE, TEST_LONGITUDE);
+                }
+
+                axis_state_t current[MOTION_PROFILE_AXES] = {{.position = motors.azimuth}, {.position = motors.inclination}};
+                if (path_planner_plan(&planner, aim, current, &desired) &&
+                    (desired.azimuth != motors.azimuth || desired.inclination != motors.inclination))
+                {
+                    motors = desired;
+                    moves++;
+                }
+
+                float error = path_planner_pointing_error(motors, sun);
+                error_sum += error;
+                error_max = fmaxf(error_max, error);
+                steps++;
+            }
+        }
+
+        error_means[run] = error_sum / steps;
+        error_maxes[run] = error_max;
+        printf("Sun feed-forward / %s: %d moves, pointing error mean %.3f max %.3f degree\n",
+               ahead ? "aiming ahead" : "aiming at the sun", moves, error_means[run], error_max);
+    }
+
+    TEST_CHECK(error_means[1] < error_means[0], "aiming ahead %.3f degree off on average, at the sun %.3f",
+               error_means[1], error_means[0]);
+    TEST_CHECK(error_maxes[1] <= error_maxes[0] * 1.01f, "aiming ahead up to %.3f degree off, at the sun %.3f",
+               error_maxes[1], error_maxes[0]);
+}
+
+// The motors task plans every tick along the move: the solutions are timed
+// again only once the setpoint moved past the retarget threshold
+static void test_motors_ticks()
+{
+    static path_planner_t planner;
+    static motion_profile_t profile;
+    path_planner_config_t config = path_planner_default_config(MOTION_PROFILE_S_CURVE, limits);
+    axis_state_t current[MOTION_PROFILE_AXES] = {{.position = 10.f}, {.position = 20.f}};
+    orientation_t setpoint = {.azimuth = 120.f, .inclination = 40.f};
+    orientation_t desired, planned;
+
+    path_planner_init(&planner, &config);
+    TEST_CHECK(path_planner_plan(&planner, setpoint, current, &planned), "No move from rest");
+
+    float target[MOTION_PROFILE_AXES] = {planned.azimuth, planned.inclination};
+    motion_profile_plan(&profile, MOTION_PROFILE_S_CURVE, limits, current, target);
+
+    for (float t = 0.f; t < profile.duration; t += .01f)
+    {
+        motion_profile_sample(&profile, t, current);
+        setpoint.azimuth += .001f;
+        TEST_CHECK(path_planner_plan(&planner, setpoint, current, &desired), "No move at %.2f s", t);
+        TEST_CHECK(fabsf(desired.azimuth - planned.azimuth) < .2f && desired.inclination == planned.inclination,
+                   "Moved to (%.2f, %.2f) at %.2f s", desired.azimuth, desired.inclination, t);
+    }
+    TEST_CHECK(planner.evaluations == 1, "Solutions timed %u times along the move", planner.evaluations);
+
+    setpoint.azimuth += 1.f;
+    path_planner_plan(&planner, setpoint, current, &desired);
+    TEST_CHECK(planner.evaluations == 2, "Solutions timed %u times past the retarget threshold", planner.evaluations);
+}
+
+// The dead zones the motors task used before the path planner
+static bool is_in_fold_dead_zone(orientation_t orientation)
+{
+    return (-5.f < orientation.azimuth && orientation.azimuth < 5.f) ||
+           (175.f < orientation.azimuth && orientation.azimuth < 185.f) ||
+           (355.f < orientation.azimuth && orientation.azimuth < 365.f);
+}
@@ -0,0 +1,103 @@
+#include <math.h>
+#include <stdio.h>
+#include "position_loop.h"
+#include "servo_feedback.h"
+#include "test.h"
+
+// Control period (s), servo lag (s), offsets the load leaves the servos at
+// (degree), run time and settling time before the error is measured (s), and
+// the angle a jammed azimuth servo stops at
+#define TICK .02f
+#define LAG .1f
+#define AZIMUTH_OFFSET .8f
+#define INCLINATION_OFFSET -1.5f
+#define RUN_TIME 30.f
+#define SETTLE_TIME 15.f
+#define JAM_ANGLE 70.f
+
+// Servos that lag their command and settle off it under load, read through
+// the noisy stand-in ADC. The position loop has to remove most of the
+// steady-state error and find a jammed servo within a few seconds.
+int main()
+{
+    const float start[MOTORS_AXES] = {30.f, 0.f};
+    const float targets[MOTORS_AXES] = {120.f, 40.f};
+    const float offsets[MOTORS_AXES] = {AZIMUTH_OFFSET, INCLINATION_OFFSET};
+    static servo_feedback_t feedback;
+    static servo_feedback_sim_t simulation;
+    static position_loop_t loop;
+    servo_feedback_config_t feedback_config = servo_feedback_default_config();
+    position_loop_config_t loop_config = position_loop_default_config();
+    float open_error[MOTORS_AXES];
+
+    for (int run = 0; run < 3; run++)
+    {
+        bool closed = run > 0, jammed = run == 2;
+        float positions[MOTORS_AXES] = {start[0], start[1]};
+        float error_sum[MOTORS_AXES] = {0.f}, error_max[MOTORS_AXES] = {0.f};
+        float detected = NAN;
+        int samples = 0;
+
+        simulation = (servo_feedback_sim_t){.noise = 4.f, .spike_rate = .01f, .batch = 20, .seed = 1};
+        servo_feedback_init(&feedback, &servo_feedback_sim_ops, &feedback_config, &simulation);
+        position_loop_init(&loop, &loop_config);
+
+        for (float t = 0.f; t < RUN_TIME; t += TICK)
+        {
+            bool valid[MOTORS_AXES], settled[MOTORS_AXES];
+            float measured[MOTORS_AXES], commands[MOTORS_AXES];
+
+            simulation.angles[0] = positions[0];
+            simulation.angles[1] = positions[1];
+            servo_feedback_update(&feedback, valid);
+
+            for (int axis = 0; axis < MOTORS_AXES; axis++)
+            {
+                measured[axis] = feedback.angles[axis];
+                settled[axis] = t > 1.f;
+                commands[axis] = targets[axis];
+            }
+
+            if (closed && position_loop_update(&loop, targets, measured, valid, settled, TICK, commands) && isnan(detected))
+                detected = t;
+
+            for (int axis = 0; axis < MOTORS_AXES; axis++)
+            {
+                positions[axis] += (commands[axis] + offsets[axis] - positions[axis]) * TICK / LAG;
+                if (jammed && axis == MOTOR_AZIMUTH)
+                    positions[axis] = fminf(positions[axis], JAM_ANGLE);
+
+                if (t >= SETTLE_TIME)
+                {
+                    error_sum[axis] += fabsf(targets[axis] - positions[axis]);
+                    error_max[axis] = fmaxf(error_max[axis], fabsf(targets[axis] - positions[axis]));
+                }
+            }
+            samples += t >= SETTLE_TIME;
+        }
+
+        if (jammed)
+        {
+            printf("Jammed azimuth: %s after %.2f s of the move, held %.1f degree from its target\n",
+                   isnan(detected) ? "not detected" : "stall detected", detected, error_sum[MOTOR_AZIMUTH] / samples);
+            TEST_CHECK(!isnan(detected) && detected <= 5.f, "jammed servo found after %.2f s", detected);
+            continue;
+        }
+
+        printf("%s loop: steady-state error azimuth mean %.3f max %.3f, inclination mean %.3f max %.3f degree\n",
+               closed ? "Closed" : "Open", error_sum[0] / samples, error_max[0], error_sum[1] / samples, error_max[1]);
+
+        for (int axis = 0; axis < MOTORS_AXES; axis++)
+        {
+            if (!closed)
+                open_error[axis] = error_sum[axis] / samples;
+            else
+                TEST_CHECK(error_sum[axis] / samples <= .5f * open_error[axis], "axis %d: closed loop error %.3f, open %.3f degree",
+                           axis, error_sum[axis] / samples, open_error[axis]);
+        }
+        if (closed)
+            TEST_CHECK(isnan(detected), "healthy servo reported stalled after %.2f s", detected);
+    }
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,194 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "protocol.h"
+#include "telemetry_delta.h"
+#include "test.h"
+
+// Random messages encoded and decoded, and the mutated copies of each fed to
+// the decoders
+#define MESSAGES 1000
+#define MUTATIONS 20
+// Leading messages kept in PROTOCOL_VECTORS for the server and client tests
+#define VECTORS 200
+
+static void random_message(uint32_t *seed, protocol_message_t *message);
+static bool check_vector(FILE *vectors, bool update, const char *json, int length, const uint8_t *binary, int size);
+
+// The generated codecs on random messages of every event. Each message goes
+// through JSON twice, after which the text has to be stable and the binary
+// form has to give it back exactly. Mutated and truncated copies are decoded
+// for robustness, most have to be rejected. The leading messages have to
+// match the vectors the other codecs are tested on, `--update` rewrites them.
+int main(int argc, char **argv)
+{
+    static protocol_message_t message, decoded, again;
+    static char json[2048], json_again[2048], mutated[2048];
+    static uint8_t binary[512];
+    int failed = 0, unstable = 0, inexact = 0, mutations = 0, accepted = 0, mismatched = 0;
+    uint32_t seed = 7;
+    bool update = argc > 1 && strcmp(argv[1], "--update") == 0;
+    FILE *vectors = fopen(PROTOCOL_VECTORS, update ? "w" : "r");
+
+    TEST_CHECK(vectors != NULL, "Cannot open %s", PROTOCOL_VECTORS);
+    if (vectors == NULL)
+        return TEST_RESULT();
+
+    for (int i = 0; i < MESSAGES; i++)
+    {
+        random_message(&seed, &message);
+
+        int length = protocol_encode_json(&message, json, sizeof(json));
+        if (length <= 0 || !protocol_decode_json(json, length, &decoded))
+        {
+            failed++;
+            continue;
+        }
+
+        // Floats are only stable once rounded to their decimals
+        length = protocol_encode_json(&decoded, json, sizeof(json));
+        if (length <= 0 || !protocol_decode_json(json, length, &again) || protocol_encode_json(&again, json_again, sizeof(json_again)) != length ||
+            memcmp(json, json_again, length) != 0)
+            unstable++;
+
+        int size = protocol_encode_binary(&decoded, binary, sizeof(binary));
+        if (size <= 0 || !protocol_decode_binary(binary, size, &again) ||
+            protocol_encode_json(&again, json_again, sizeof(json_again)) != length || memcmp(json, json_again, length) != 0)
+            inexact++;
+        if (i < VECTORS && !check_vector(vectors, update, json, length, binary, size))
+            mismatched++;
+
+        for (int j = 0; j < MUTATIONS; j++)
+        {
+            bool text = j % 2 == 0;
+            int mutated_length = text ? length : size;
+            uint32_t at = test_random_below(&seed, mutated_length);
+
+            memcpy(mutated, text ? (const void *)json : (const void *)binary, mutated_length);
+            // Alternately a byte replaced and the message cut short
+            if (j % 4 < 2)
+                mutated[at] = text ? "{}[],:\"-.0e9 nul"[test_random_below(&seed, 16)] : test_random_below(&seed, 256);
+            else
+                mutated_length = at;
+
+            mutations++;
+            accepted += text ? protocol_decode_json(mutated, mutated_length, &again)
+                             : protocol_decode_binary((const uint8_t *)mutated, mutated_length, &again);
+        }
+    }
+
+    // Nothing past the vectors written
+    char line[4];
+    if (!update && fgets(line, sizeof(line), vectors) != NULL)
+        mismatched++;
+    fclose(vectors);
+
+    printf("%d messages: %d failed, %d unstable, %d inexact; %d of %d mutations accepted; %d of %d vectors %s\n",
+           MESSAGES, failed, unstable, inexact, accepted, mutations, update ? VECTORS - mismatched : mismatched, VECTORS,
+           update ? "written" : "mismatched");
+    TEST_CHECK(failed == 0, "%d messages not decoded", failed);
+    TEST_CHECK(unstable == 0, "%d messages change through JSON", unstable);
+    TEST_CHECK(inexact == 0, "%d messages change through the binary form", inexact);
+    TEST_CHECK(accepted < mutations / 2, "%d of %d mutations accepted", accepted, mutations);
+    TEST_CHECK(mismatched == 0, "%d vectors differ from %s, regenerate them with --update", mismatched, PROTOCOL_VECTORS);
+
+    return TEST_RESULT();
+}
+
+// One line per message: the binary form in hex, a space, then the JSON text
+static bool check_vector(FILE *vectors, bool update, const char *json, int length, const uint8_t *binary, int size)
+{
+    static char line[4096], expected[4096];
+    int at = 0;
+
+    for (int i = 0; i < size; i++)
+        at += sprintf(line + at, "%02x", binary[i]);
+    at += sprintf(line + at, " %.*s\n", length, json);
+
+    if (update)
+        return fputs(line, vectors) >= 0;
+    return fgets(expected, sizeof(expected), vectors) != NULL && strcmp(line, expected) == 0;
+}
+
+// Every optional field and array length, with values over the full range of their type
+static void random_message(uint32_t *seed, protocol_message_t *message)
+{
+    memset(message, 0, sizeof(*message));
+    message->event = test_random_below(seed, PROTOCOL_APP_EVENT_COUNT);
+
+    switch (message->event)
+    {
+    case PROTOCOL_APP_EVENT_UPDATE_CONFIG:
+    {
+        protocol_control_config_t *config = &message->control_config;
+        protocol_servo_calibration_t *calibration = &config->servo_calibration;
+
+        config->control_mode = test_random_below(seed, PROTOCOL_CONTROL_MODE_COUNT);
+        config->manual_orientation = (orientation_t){test_noise(seed, 180.f), test_noise(seed, 45.f)};
+        config->has_ahrs_engine = test_random_below(seed, 2);
+        config->ahrs_engine = test_random_below(seed, PROTOCOL_AHRS_ENGINE_COUNT);
+        config->has_servo_calibration = test_random_below(seed, 2);
+        calibration->has_azimuth = test_random_below(seed, 2);
+        calibration->azimuth_count = test_random_below(seed, SERVO_CALIBRATION_MAX_POINTS + 1);
+        calibration->has_inclination = test_random_below(seed, 2);
+        calibration->inclination_count = test_random_below(seed, SERVO_CALIBRATION_MAX_POINTS + 1);
+        for (int i = 0; i < SERVO_CALIBRATION_MAX_POINTS; i++)
+        {
+            calibration->azimuth[i] = (servo_calibration_point_t){i * 12.f + test_noise(seed, 1.f), 500.f + i * 130.f + test_noise(seed, 5.f)};
+            calibration->inclination[i] = (servo_calibration_point_t){i * 6.f + test_noise(seed, 1.f), 500.f + i * 130.f + test_noise(seed, 5.f)};
+        }
+        config->has_tracking_threshold = test_random_below(seed, 2);
+        config->tracking_threshold = fabsf(test_noise(seed, 2.f));
+        break;
+    }
+    case PROTOCOL_APP_EVENT_UPDATE_STATE:
+    {
+        protocol_system_state_t *state = &message->system_state;
+
+        state->platform_rotation = quaternion_normalize((quaternion_t){1.f, test_noise(seed, .1f), test_noise(seed, .1f), test_noise(seed, .1f)});
+        state->panel_orientation = (orientation_t){test_noise(seed, 180.f), test_noise(seed, 45.f)};
+        state->motors_rotation = (orientation_t){test_noise(seed, 90.f), test_noise(seed, 45.f)};
+        state->motors_energized = (orientation_t){fabsf(test_noise(seed, 1e4f)), fabsf(test_noise(seed, 1e4f))};
+        state->timestamp = 1700000000000LL + test_random_below(seed, UINT32_MAX);
+        state->has_motors_measured = test_random_below(seed, 2);
+        state->motors_measured = (orientation_t){test_noise(seed, 90.f), test_noise(seed, 45.f)};
+        state->has_tracking_policy = test_random_below(seed, 2);
+        state->tracking_policy = (protocol_tracking_policy_t){
+            .moves = test_random_below(seed, UINT32_MAX),
+            .skipped = test_random_below(seed, 100000),
+            .motor_on_time = fabsf(test_noise(seed, 1e3f)),
+            .motor_energy = fabsf(test_noise(seed, 10.f)),
+            .yield = fabsf(test_noise(seed, 1e3f)),
+        };
+        state->has_telemetry = test_random_below(seed, 2);
+        state->telemetry = (protocol_telemetry_rate_t){
+            .rate = fabsf(test_noise(seed, 2.f)),
+            .sent = test_random_below(seed, UINT32_MAX),
+            .failed = test_random_below(seed, 1000),
+            .deferred = test_random_below(seed, 1000),
+            .backoffs = test_random_below(seed, 100),
+        };
+        state->has_keyframe = test_random_below(seed, 2);
+        state->keyframe = test_random_below(seed, UINT32_MAX);
+        break;
+    }
+    case PROTOCOL_APP_EVENT_UPDATE_VIEWERS:
+        message->viewers.viewers = test_random_below(seed, 100);
+        break;
+    case PROTOCOL_APP_EVENT_UPDATE_DELTA:
+        message->system_delta.base = test_random_below(seed, UINT32_MAX);
+        message->system_delta.timestamp = 1700000000000LL + test_random_below(seed, UINT32_MAX);
+        message->system_delta.changes_count = test_random_below(seed, TELEMETRY_DELTA_FIELDS + 1);
+        for (int i = 0; i < message->system_delta.changes_count; i++)
+            message->system_delta.changes[i] = (protocol_delta_change_t){
+                .index = i,
+                .steps = (int32_t)(test_random_below(seed, UINT32_MAX) - INT32_MAX),
+            };
+        break;
+    case PROTOCOL_APP_EVENT_ACK_KEYFRAME:
+        message->keyframe_ack.keyframe = test_random_below(seed, UINT32_MAX);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,105 @@
+#include <math.h>
+#include <stdio.h>
+#include "servo_calibration.h"
+#include "test.h"
+
+#define PI 3.14159265358979323846
+
+// Servo PWM: the former 10 bit timer and the current 16 bit one, at 50 Hz
+#define FREQUENCY 50
+#define LEGACY_RESOLUTION 10
+#define RESOLUTION 16
+// Calibration points measured on the simulated servo, and angles checked
+#define CALIBRATION_POINTS 9
+#define CHECKS 3601
+
+static float servo_pulse_width(float angle);
+static float servo_angle(float pulse_width);
+
+// Angles commanded to a simulated nonlinear servo, through the former linear
+// 10 bit mapping then through a calibration table on the 16 bit timer. The
+// calibrated mapping has to reach the angles within a quarter of a degree.
+int main()
+{
+    servo_calibration_t linear = servo_calibration_linear(-90.f, 400.f, 90.f, 2400.f);
+    servo_calibration_t measured = {.count = CALIBRATION_POINTS};
+
+    for (int i = 0; i < CALIBRATION_POINTS; i++)
+    {
+        float angle = -90.f + 180.f * i / (CALIBRATION_POINTS - 1);
+        measured.points[i] = (servo_calibration_point_t){.angle = angle, .pulse_width = servo_pulse_width(angle)};
+    }
+
+    const struct
+    {
+        const char *name;
+        const servo_calibration_t *calibration;
+        int resolution;
+    } mappings[] = {
+        {"linear, 10 bit", &linear, LEGACY_RESOLUTION},
+        {"linear, 16 bit", &linear, RESOLUTION},
+        {"calibrated, 16 bit", &measured, RESOLUTION},
+    };
+    float max_errors[sizeof(mappings) / sizeof(mappings[0])];
+
+    TEST_CHECK(servo_calibration_is_valid(&linear) && servo_calibration_is_valid(&measured), "valid tables rejected");
+
+    for (int m = 0; m < sizeof(mappings) / sizeof(mappings[0]); m++)
+    {
+        float period = 1e6f / FREQUENCY;
+        float max_error = 0.f, total_error = 0.f;
+        uint32_t first = servo_calibration_duty(mappings[m].calibration, -90.f, mappings[m].resolution, FREQUENCY);
+        uint32_t last = servo_calibration_duty(mappings[m].calibration, 90.f, mappings[m].resolution, FREQUENCY);
+
+        for (int i = 0; i < CHECKS; i++)
+        {
+            float angle = -90.f + 180.f * i / (CHECKS - 1);
+            uint32_t duty = servo_calibration_duty(mappings[m].calibration, angle, mappings[m].resolution, FREQUENCY);
+            float error = fabsf(servo_angle(duty * period / (float)(1u << mappings[m].resolution)) - angle);
+
+            max_error = fmaxf(max_error, error);
+            total_error += error;
+        }
+
+        max_errors[m] = max_error;
+        printf("%s: %u counts, %.4f degree per count, reached angle error mean %.3f, max %.3f degree\n",
+               mappings[m].name, (unsigned)(last - first), 180.f / (last - first), total_error / CHECKS, max_error);
+    }
+
+    TEST_CHECK(max_errors[2] <= .25f, "calibrated servo up to %.3f degree off", max_errors[2]);
+    TEST_CHECK(max_errors[2] < max_errors[1] && max_errors[1] <= max_errors[0], "errors do not shrink: %.3f, %.3f, %.3f degree",
+               max_errors[0], max_errors[1], max_errors[2]);
+
+    return TEST_RESULT();
+}
+
+// A servo with a 30 us dead zone offset and a bowed response, as measured on
+// cheap analog servos
+static float servo_pulse_width(float angle)
+{
+    float t = (angle + 90.f) / 180.f;
+
+    return 430.f + 2000.f * t - 90.f * sinf(PI * t);
+}
+
+static float servo_angle(float pulse_width)
+{
+    float low = -90.f, high = 90.f;
+
+    if (pulse_width <= servo_pulse_width(low))
+        return low;
+    if (pulse_width >= servo_pulse_width(high))
+        return high;
+
+    for (int i = 0; i < 30; i++)
+    {
+        float middle = .5f * (low + high);
+
+        if (servo_pulse_width(middle) < pulse_width)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    return .5f * (low + high);
+}
@@ -0,0 +1,118 @@
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include "protocol.h"
+#include "telemetry_delta.h"
+#include "test.h"
+
+// Uploads every 200 ms for an hour, the acknowledgements lost from 10 to 11
+// minutes, and the keyframes the check server keeps
+#define DURATION 3600.f
+#define PERIOD .2f
+#define ACK_LOSS 600.f
+#define KEPT 8
+
+// An hour of uploads, as full states and as deltas against keyframes: the
+// platform jitters below the quantization, the sun moves the panel
+// orientation a little every minute, and the motors move 20 s every 5
+// minutes. A server rebuilds each state from the delta message and its
+// keyframe, within a quantization step, and the deltas have to take far
+// fewer bytes than the full states.
+int main()
+{
+    static protocol_message_t message, received;
+    telemetry_delta_config_t config = telemetry_delta_default_config();
+    telemetry_delta_t delta;
+    // Keyframes the server received, by number modulo the kept count
+    float kept[KEPT][TELEMETRY_DELTA_FIELDS];
+    uint32_t kept_numbers[KEPT] = {0};
+    uint32_t ack = 0, frames = 0, rebuilt = 0, missed = 0;
+    uint64_t full_bytes = 0, delta_bytes = 0;
+    float error_max = 0.f;
+    uint32_t seed = 1;
+    char buffer[2048];
+
+    telemetry_delta_init(&delta, &config);
+
+    for (float t = 0.f; t < DURATION; t += PERIOD)
+    {
+        float cycle = fmodf(t, 300.f);
+        float moves = floorf(t / 300.f) + fminf(cycle / 20.f, 1.f);
+        float sun = floorf(t / 60.f) * .25f;
+        float values[TELEMETRY_DELTA_FIELDS] = {
+            .9999f, .01f, -.005f, .002f,
+            120.f + sun, 30.f + sun * .3f,
+            120.f + moves * 1.25f, 30.f + moves * .4f,
+            moves * 20.f * .1f, moves * 20.f * .1f,
+        };
+        uint32_t keyframe;
+        int64_t timestamp = t * 1000.f;
+
+        for (int i = 0; i < 4; i++)
+            values[i] += ((test_random(&seed) >> 8) / 16777216.f - .5f) * 4e-5f;
+        message.event = PROTOCOL_APP_EVENT_UPDATE_STATE;
+        message.system_state = (protocol_system_state_t){
+            .platform_rotation = {values[0], values[1], values[2], values[3]},
+            .panel_orientation = {values[4], values[5]},
+            .motors_rotation = {values[6], values[7]},
+            .motors_energized = {values[8], values[9]},
+            .timestamp = timestamp,
+        };
+        frames++;
+        full_bytes += protocol_encode_json(&message, buffer, sizeof(buffer));
+
+        telemetry_delta_ack(&delta, ack);
+        telemetry_delta_frame_t frame = telemetry_delta_next(&delta, values, PERIOD, &keyframe);
+        if (frame == TELEMETRY_DELTA_UNCHANGED)
+            continue;
+
+        if (frame == TELEMETRY_DELTA_KEYFRAME)
+        {
+            message.system_state.has_keyframe = true;
+            message.system_state.keyframe = keyframe;
+            delta_bytes += protocol_encode_json(&message, buffer, sizeof(buffer));
+            memcpy(kept[keyframe % KEPT], values, sizeof(values));
+            kept_numbers[keyframe % KEPT] = keyframe;
+            if (t < ACK_LOSS || t >= ACK_LOSS + 60.f)
+                ack = keyframe;
+            continue;
+        }
+
+        message.event = PROTOCOL_APP_EVENT_UPDATE_DELTA;
+        message.system_delta.base = keyframe;
+        message.system_delta.timestamp = timestamp;
+        message.system_delta.changes_count = telemetry_delta_changes(&delta, message.system_delta.changes);
+        int length = protocol_encode_json(&message, buffer, sizeof(buffer));
+        delta_bytes += length;
+
+        if (kept_numbers[keyframe % KEPT] != keyframe || !protocol_decode_json(buffer, length, &received))
+        {
+            missed++;
+            continue;
+        }
+
+        float state[TELEMETRY_DELTA_FIELDS];
+
+        memcpy(state, kept[keyframe % KEPT], sizeof(state));
+        for (int i = 0; i < received.system_delta.changes_count; i++)
+        {
+            const protocol_delta_change_t *change = &received.system_delta.changes[i];
+            state[change->index] = change->steps * telemetry_delta_fields[change->index].step;
+        }
+        for (int i = 0; i < TELEMETRY_DELTA_FIELDS; i++)
+            error_max = fmaxf(error_max, fabsf(state[i] - values[i]) / telemetry_delta_fields[i].step);
+        rebuilt++;
+    }
+
+    printf("%u frames: full %llu bytes, delta %llu bytes (%.1f%%), %u keyframes, %u deltas of %.1f fields, %u unchanged\n",
+           frames, (unsigned long long)full_bytes, (unsigned long long)delta_bytes, 100.f * delta_bytes / full_bytes,
+           delta.stats.keyframes, delta.stats.deltas, (float)delta.stats.changes / delta.stats.deltas, delta.stats.unchanged);
+    printf("Rebuilt %u states, %u on unknown keyframes, error up to %.2f steps\n", rebuilt, missed, error_max);
+    TEST_CHECK(rebuilt > 0 && missed == 0, "%u states on unknown keyframes", missed);
+    // Fields left out of a delta are on the same step as in the keyframe
+    TEST_CHECK(error_max < 1.f, "rebuilt states up to %.2f steps off", error_max);
+    TEST_CHECK(delta_bytes < full_bytes / 2, "deltas take %llu bytes, full states %llu",
+               (unsigned long long)delta_bytes, (unsigned long long)full_bytes);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,73 @@
+#include <math.h>
+#include <stdio.h>
+#include "telemetry_rate.h"
+#include "test.h"
+
+// Simulation length (s) and decision interval (ms)
+#define DURATION 3600
+#define TICK_MS 100
+
+// An hour of telemetry decisions: the panel moves 20 s every 5 minutes, a
+// viewer watches for 10 minutes, then the WebSocket backs up for 5 minutes
+// and the signal fades for 5 more. The fixed 200 ms upload keeps trying
+// through the congestion, the controller has to back off and save the idle
+// uploads without slowing down while someone is watching.
+int main()
+{
+    uint32_t congested[2], failed[2];
+    float active_rates[2], idle_rates[2];
+
+    for (int run = 0; run < 2; run++)
+    {
+        bool adaptive = run == 1;
+        telemetry_rate_config_t config = telemetry_rate_default_config();
+        telemetry_rate_t rate;
+        uint32_t attempts = 0, active_uploads = 0, idle_uploads = 0;
+        float active_time = 0.f, idle_time = 0.f;
+        float dt = TICK_MS * 1e-3f;
+
+        congested[run] = failed[run] = 0;
+        telemetry_rate_init(&rate, &config);
+
+        for (int tick = 0; tick < DURATION * 1000 / TICK_MS; tick++)
+        {
+            float t = tick * dt;
+            bool moving = fmodf(t, 300.f) < 20.f;
+            int viewers = t >= 1200.f && t < 1800.f;
+            bool backed_up = t >= 2400.f && t < 2700.f;
+            int rssi = t >= 2700.f && t < 3000.f ? -85 : -60;
+            bool clear = !backed_up && rssi >= config.rssi_threshold;
+            bool send = adaptive ? telemetry_rate_should_send(&rate, moving, viewers, dt)
+                                 : tick % (200 / TICK_MS) == 0;
+
+            if (clear)
+            {
+                *(moving || viewers ? &active_time : &idle_time) += dt;
+                if (send)
+                    (*(moving || viewers ? &active_uploads : &idle_uploads))++;
+            }
+            if (!send)
+                continue;
+
+            attempts++;
+            congested[run] += !clear;
+            failed[run] += backed_up;
+            // A backed up buffer times the send out, a weak signal slows it down
+            if (adaptive)
+                telemetry_rate_report(&rate, !backed_up, backed_up ? .1f : clear ? .005f : .08f, rssi);
+        }
+
+        active_rates[run] = active_uploads / active_time;
+        idle_rates[run] = idle_uploads / idle_time;
+        printf("%s: %u uploads, %u into congestion, %u failed, %.2f per s active, %.2f per s idle, %u deferred, %u backoffs\n",
+               adaptive ? "Adaptive" : "Fixed 200 ms", attempts, congested[run], failed[run], active_rates[run], idle_rates[run],
+               rate.stats.deferred, rate.stats.backoffs);
+    }
+
+    TEST_CHECK(congested[1] < congested[0] / 4, "%u uploads into congestion, %u at a fixed rate", congested[1], congested[0]);
+    TEST_CHECK(failed[1] < failed[0] / 4, "%u failed uploads, %u at a fixed rate", failed[1], failed[0]);
+    TEST_CHECK(idle_rates[1] < idle_rates[0], "%.2f uploads per s idle, %.2f at a fixed rate", idle_rates[1], idle_rates[0]);
+    TEST_CHECK(active_rates[1] >= .9f * active_rates[0], "%.2f uploads per s active, %.2f at a fixed rate", active_rates[1], active_rates[0]);
+
+    return TEST_RESULT();
+}
@@ -0,0 +1,113 @@
+#include <math.h>
+#include <stdio.h>
+#include "motion_profile.h"
+#include "path_planner.h"
+#include "sun_calculator.h"
+#include "test.h"
+#include "tracking_policy.h"
+
+// A day from local midnight at the tracker location (2023-03-20, UTC+7),
+// decisions every 10 s, and the energized time (s) power gating adds to each move
+#define DAY 1679245200
+#define STEP 10
+#define GATING_TIME 3.06f
+
+// A clear day tracked on every change, behind the path planner dead band,
+// then by the tracking policy at several thresholds. The policy has to move
+// less and net more energy than following every change.
+int main()
+{
+    const motion_limits_t limits[MOTION_PROFILE_AXES] = {
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+        {.velocity = 180.f, .acceleration = 360.f, .jerk = 2000.f},
+    };
+    const struct
+    {
+        const char *name;
+        float dead_band;
+        float threshold;
+    } runs[] = {
+        {"every 0.01 degree", .01f, NAN},
+        {"planner dead band", -1.f, NAN},
+        {"policy, threshold 0.5", 0.f, .5f},
+        {"policy, threshold 1", 0.f, 1.f},
+        {"policy, threshold 2", 0.f, 2.f},
+        {"policy, threshold 4", 0.f, 4.f},
+    };
+    static path_planner_t planner;
+    static motion_profile_t profile;
+    uint32_t every_moves = 0;
+    float every_net = 0.f;
+
+    for (int r = 0; r < sizeof(runs) / sizeof(runs[0]); r++)
+    {
+        path_planner_config_t planner_config = path_planner_default_config(MOTION_PROFILE_S_CURVE, limits);
+        tracking_policy_config_t policy_config = tracking_policy_default_config();
+        tracking_policy_t policy;
+        orientation_t motors = {90.f, 0.f};
+        float error_sum = 0.f, error_max = 0.f;
+        int daylight = 0;
+
+        if (runs[r].dead_band >= 0.f)
+            planner_config.dead_band = runs[r].dead_band;
+        path_planner_init(&planner, &planner_config);
+        policy_config.gating_time = GATING_TIME;
+        policy_config.threshold = runs[r].threshold;
+        tracking_policy_init(&policy, &policy_config);
+
+        for (time_t t = DAY; t < DAY + 86400; t += STEP)
+        {
+            orientation_t sun = get_sun_orientation(t, TEST_LATITUDE, TEST_LONGITUDE);
+            float power = tracking_policy_clear_sky_power(&policy_config, sun.inclination);
+            axis_state_t current[MOTION_PROFILE_AXES] = {{.position = motors.azimuth}, {.position = motors.inclination}};
+            orientation_t desired;
+
+            if (power <= 0.f)
+                continue;
+
+            if (path_planner_plan(&planner, sun, current, &desired) &&
+                (desired.azimuth != motors.azimuth || desired.inclination != motors.inclination))
+            {
+                float target[MOTION_PROFILE_AXES] = {desired.azimuth, desired.inclination};
+                motion_profile_plan(&profile, MOTION_PROFILE_S_CURVE, limits, current, target);
+
+                if (isnan(runs[r].threshold))
+                {
+                    policy.stats.moves++;
+                    policy.stats.motor_on_time += profile.duration + policy_config.gating_time;
+                    policy.stats.motor_energy += tracking_policy_move_cost(&policy_config, profile.duration);
+                    motors = desired;
+                }
+                else if (tracking_policy_should_move(&policy, motors, desired, sun, power, profile.duration))
+                {
+                    motors = desired;
+                }
+            }
+
+            tracking_policy_account(&policy, motors, sun, power, STEP);
+            float error = path_planner_pointing_error(motors, sun);
+            error_sum += error;
+            error_max = fmaxf(error_max, error);
+            daylight++;
+        }
+
+        float net = (policy.stats.yield - policy.stats.motor_energy) / 3600.f;
+
+        printf("%s: %u moves, motors on %.0f s using %.3f Wh, yield %.3f Wh, net %.3f Wh, pointing error mean %.2f max %.2f degree\n",
+               runs[r].name, policy.stats.moves, policy.stats.motor_on_time, policy.stats.motor_energy / 3600.f,
+               policy.stats.yield / 3600.f, net, error_sum / daylight, error_max);
+
+        if (r == 0)
+        {
+            every_moves = policy.stats.moves;
+            every_net = net;
+        }
+        else if (!isnan(runs[r].threshold))
+        {
+            TEST_CHECK(policy.stats.moves < every_moves, "%s: %u moves, %u on every change", runs[r].name, policy.stats.moves, every_moves);
+            TEST_CHECK(net > every_net, "%s: net %.3f Wh, %.3f on every change", runs[r].name, net, every_net);
+        }
+    }
+
+    return TEST_RESULT();
+}
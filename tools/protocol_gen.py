@@ -0,0 +1,1567 @@
+#!/usr/bin/env python3
+"""Generates the message codecs of the firmware, the server and the client.
+
+Reads protocol/schema.json and writes the C, TypeScript and C# codecs of its
+messages, each with the JSON form sent over the WebSocket and a compact binary
+form. Run it after changing the schema and commit the generated files with it.
+
+    tools/protocol_gen.py
+    tools/protocol_gen.py --check
+
+The server (`npm test`) and client (Unity Test Runner) tests decode
+protocol/vectors.txt, messages encoded by the C codec. Rewrite them with
+`test_protocol --update` from the host build under test/ when its output
+changes.
+
+Field types are f32, u32, i32, i64, an enum, a struct, or an array of them
+written `Type[]` with its `max` length. JSON floats are written with
+`precision` decimals, 6 by default, and null when not finite. The binary form
+is little endian: floats and 32 bit integers on 4 bytes, i64 on 8, enums and
+array lengths on 1, and a byte of presence bits before the fields of a struct
+with optional ones. A message is its event followed by its payload.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+SCHEMA = os.path.join(ROOT, "protocol", "schema.json")
+OUTPUTS = {
+    "c_header": os.path.join(ROOT, "main", "protocol.h"),
+    "c_source": os.path.join(ROOT, "main", "protocol.c"),
+    "ts": os.path.join(ROOT, "server", "src", "protocol.ts"),
+    "cs": os.path.join(ROOT, "client", "Assets", "Scripts", "Protocol", "Protocol.cs"),
+}
+HEADER = "Generated by tools/protocol_gen.py from protocol/schema.json, do not edit."
+SCALARS = ("f32", "u32", "i32", "i64")
+EVENT_ENUM = "AppEvent"
+MAX_PRECISION = 9
+
+
+class Field:
+    def __init__(self, name, spec):
+        if isinstance(spec, str):
+            spec = {"type": spec}
+        self.name = name
+        self.array = spec["type"].endswith("[]")
+        self.type = spec["type"][:-2] if self.array else spec["type"]
+        self.max = spec.get("max")
+        self.optional = spec.get("optional", False)
+        self.precision = spec.get("precision", 6)
+        self.doc = spec.get("doc")
+
+
+class Struct:
+    def __init__(self, name, spec):
+        self.name = name
+        self.doc = spec.get("doc")
+        self.c = spec.get("c")
+        self.c_include = spec.get("c_include")
+        self.cs = spec.get("cs")
+        self.tuple = spec.get("tuple", False)
+        self.fields = [Field(field, value) for field, value in spec["fields"].items()]
+
+    @property
+    def optionals(self):
+        return [field for field in self.fields if field.optional]
+
+
+class Schema:
+    def __init__(self, spec):
+        self.messages = list(spec["messages"].items())
+        self.enums = {EVENT_ENUM: [event for event, _ in self.messages]}
+        self.enums.update(spec["enums"])
+        self.structs = {}
+        for name, value in spec["structs"].items():
+            struct = Struct(name, value)
+            self.check(struct)
+            self.structs[name] = struct
+        for event, payload in self.messages:
+            if payload not in self.structs:
+                sys.exit(f"{event}: unknown payload {payload}")
+
+    def check(self, struct):
+        if len(struct.fields) > 32 or len(struct.optionals) > 8:
+            sys.exit(f"{struct.name}: at most 32 fields, 8 of them optional")
+        if (struct.c or struct.tuple) and any(field.optional or field.array for field in struct.fields):
+            sys.exit(f"{struct.name}: mapped and tuple structs have neither optional nor array fields")
+        for field in struct.fields:
+            where = f"{struct.name}.{field.name}"
+            if field.type not in SCALARS and field.type not in self.enums and field.type not in self.structs:
+                sys.exit(f"{where}: unknown type {field.type}, structs are declared before use")
+            if field.array and not 0 < (field.max or 0) <= 255:
+                sys.exit(f"{where}: arrays need a max from 1 to 255")
+            if not 0 <= field.precision <= MAX_PRECISION:
+                sys.exit(f"{where}: precision from 0 to {MAX_PRECISION}")
+
+    def kind(self, type):
+        return "scalar" if type in SCALARS else "enum" if type in self.enums else "struct"
+
+
+def snake(name):
+    return re.sub(r"(?<=[a-z0-9])(?=[A-Z])", "_", name).lower()
+
+
+def pascal(value):
+    return "".join(word.capitalize() for word in value.split("_"))
+
+
+def camel(name):
+    return name[0].lower() + name[1:]
+
+
+def indent(lines, level):
+    return ["    " * level + line if line else line for line in lines]
+
+
+# C
+
+
+C_TYPES = {"f32": "float", "u32": "uint32_t", "i32": "int32_t", "i64": "int64_t"}
+
+C_RUNTIME = r"""
+#define JSON_MAX_DEPTH 16
+#define JSON_KEY_IS(key, length, name) ((length) == sizeof(name) - 1 && memcmp(key, name, sizeof(name) - 1) == 0)
+// Mantissa digits kept when reading numbers, more only scale them
+#define JSON_MANTISSA_LIMIT 100000000000000000ULL
+
+typedef struct json_writer_t
+{
+    char *at;
+    char *end;
+    bool failed;
+} json_writer_t;
+
+typedef struct json_reader_t
+{
+    const char *at;
+    const char *end;
+    int depth;
+} json_reader_t;
+
+typedef struct binary_writer_t
+{
+    uint8_t *at;
+    uint8_t *end;
+    bool failed;
+} binary_writer_t;
+
+typedef struct binary_reader_t
+{
+    const uint8_t *at;
+    const uint8_t *end;
+} binary_reader_t;
+
+static void json_write(json_writer_t *writer, const char *text, size_t length);
+static void json_write_key(json_writer_t *writer, bool *first, const char *key, size_t length);
+static void json_write_string(json_writer_t *writer, const char *text);
+static void json_write_float(json_writer_t *writer, float value, int precision);
+static void json_write_integer(json_writer_t *writer, int64_t value);
+static void json_skip_space(json_reader_t *reader);
+static bool json_peek(json_reader_t *reader, char c);
+static bool json_expect(json_reader_t *reader, char c);
+static bool json_begin(json_reader_t *reader, char open, char close, bool *more);
+static bool json_next(json_reader_t *reader, char close, bool *more);
+static bool json_read_string(json_reader_t *reader, const char **text, size_t *length);
+static bool json_read_key(json_reader_t *reader, const char **key, size_t *length);
+static bool json_read_number(json_reader_t *reader, double *value);
+static bool json_read_float(json_reader_t *reader, float *value);
+static bool json_read_u32(json_reader_t *reader, uint32_t *value);
+static bool json_read_i32(json_reader_t *reader, int32_t *value);
+static bool json_read_i64(json_reader_t *reader, int64_t *value);
+static bool json_read_enum(json_reader_t *reader, const char *const *names, int count, int *value);
+static bool json_skip_value(json_reader_t *reader);
+static void binary_write(binary_writer_t *writer, uint64_t value, int size);
+static void binary_write_float(binary_writer_t *writer, float value);
+static bool binary_read(binary_reader_t *reader, int size, uint64_t *value);
+static bool binary_read_u8(binary_reader_t *reader, uint8_t *value);
+static bool binary_read_float(binary_reader_t *reader, float *value);
+static bool binary_read_u32(binary_reader_t *reader, uint32_t *value);
+static bool binary_read_i32(binary_reader_t *reader, int32_t *value);
+static bool binary_read_i64(binary_reader_t *reader, int64_t *value);
+static bool binary_read_enum(binary_reader_t *reader, int count, int *value);
+"""
+
+C_RUNTIME_DEFINITIONS = r"""
+static void json_write(json_writer_t *writer, const char *text, size_t length)
+{
+    if (writer->failed || (size_t)(writer->end - writer->at) < length)
+    {
+        writer->failed = true;
+        return;
+    }
+
+    memcpy(writer->at, text, length);
+    writer->at += length;
+}
+
+static void json_write_key(json_writer_t *writer, bool *first, const char *key, size_t length)
+{
+    json_write(writer, *first ? "{" : ",", 1);
+    json_write(writer, key, length);
+    *first = false;
+}
+
+static void json_write_string(json_writer_t *writer, const char *text)
+{
+    json_write(writer, "\"", 1);
+    json_write(writer, text, strlen(text));
+    json_write(writer, "\"", 1);
+}
+
+// Fixed point digits rather than printf, which allocates for floats in newlib
+static void json_write_float(json_writer_t *writer, float value, int precision)
+{
+    static const double scales[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    double scaled = round(fabs((double)value) * scales[precision]);
+    char digits[24];
+    char *at = digits + sizeof(digits);
+
+    // NAN and values beyond 64 bits, JSON has neither
+    if (!(scaled < 9e18))
+    {
+        json_write(writer, "null", 4);
+        return;
+    }
+
+    uint64_t integer = scaled;
+    for (int i = 0; i < precision; i++, integer /= 10)
+        *--at = '0' + integer % 10;
+    if (precision > 0)
+        *--at = '.';
+    do
+        *--at = '0' + integer % 10;
+    while ((integer /= 10) > 0);
+    if (value < 0.f && scaled > 0.)
+        *--at = '-';
+
+    json_write(writer, at, digits + sizeof(digits) - at);
+}
+
+static void json_write_integer(json_writer_t *writer, int64_t value)
+{
+    uint64_t integer = value < 0 ? -(uint64_t)value : (uint64_t)value;
+    char digits[24];
+    char *at = digits + sizeof(digits);
+
+    do
+        *--at = '0' + integer % 10;
+    while ((integer /= 10) > 0);
+    if (value < 0)
+        *--at = '-';
+
+    json_write(writer, at, digits + sizeof(digits) - at);
+}
+
+static void json_skip_space(json_reader_t *reader)
+{
+    while (reader->at < reader->end && (*reader->at == ' ' || *reader->at == '\t' || *reader->at == '\n' || *reader->at == '\r'))
+        reader->at++;
+}
+
+static bool json_peek(json_reader_t *reader, char c)
+{
+    json_skip_space(reader);
+    return reader->at < reader->end && *reader->at == c;
+}
+
+static bool json_expect(json_reader_t *reader, char c)
+{
+    if (!json_peek(reader, c))
+        return false;
+
+    reader->at++;
+    return true;
+}
+
+// Opens an object or an array, `more` tells whether a member follows
+static bool json_begin(json_reader_t *reader, char open, char close, bool *more)
+{
+    if (!json_expect(reader, open) || reader->depth >= JSON_MAX_DEPTH)
+        return false;
+
+    *more = !json_expect(reader, close);
+    reader->depth += *more;
+    return true;
+}
+
+// After a member, `more` tells whether another one follows the comma
+static bool json_next(json_reader_t *reader, char close, bool *more)
+{
+    if (json_expect(reader, ','))
+    {
+        *more = true;
+        return true;
+    }
+    if (!json_expect(reader, close))
+        return false;
+
+    reader->depth--;
+    *more = false;
+    return true;
+}
+
+// Escapes are skipped, not decoded: names and keys never have any
+static bool json_read_string(json_reader_t *reader, const char **text, size_t *length)
+{
+    if (!json_expect(reader, '"'))
+        return false;
+
+    *text = reader->at;
+    while (reader->at < reader->end && *reader->at != '"')
+        reader->at += *reader->at == '\\' && reader->end - reader->at > 1 ? 2 : 1;
+    if (reader->at >= reader->end)
+        return false;
+
+    *length = reader->at++ - *text;
+    return true;
+}
+
+static bool json_read_key(json_reader_t *reader, const char **key, size_t *length)
+{
+    return json_read_string(reader, key, length) && json_expect(reader, ':');
+}
+
+// Null reads as NAN
+static bool json_read_number(json_reader_t *reader, double *value)
+{
+    uint64_t mantissa = 0;
+    int exponent = 0, digits = 0;
+    bool negative;
+
+    json_skip_space(reader);
+    if (reader->end - reader->at >= 4 && memcmp(reader->at, "null", 4) == 0)
+    {
+        reader->at += 4;
+        *value = NAN;
+        return true;
+    }
+
+    negative = reader->at < reader->end && *reader->at == '-';
+    reader->at += negative;
+    for (; reader->at < reader->end && *reader->at >= '0' && *reader->at <= '9'; reader->at++, digits++)
+    {
+        if (mantissa < JSON_MANTISSA_LIMIT)
+            mantissa = mantissa * 10 + (*reader->at - '0');
+        else
+            exponent++;
+    }
+    if (reader->at < reader->end && *reader->at == '.')
+    {
+        for (reader->at++; reader->at < reader->end && *reader->at >= '0' && *reader->at <= '9'; reader->at++, digits++)
+        {
+            if (mantissa < JSON_MANTISSA_LIMIT)
+            {
+                mantissa = mantissa * 10 + (*reader->at - '0');
+                exponent--;
+            }
+        }
+    }
+    if (digits == 0)
+        return false;
+
+    if (reader->at < reader->end && (*reader->at == 'e' || *reader->at == 'E'))
+    {
+        int power = 0, power_digits = 0;
+        bool negative_power;
+
+        reader->at++;
+        negative_power = reader->at < reader->end && *reader->at == '-';
+        reader->at += reader->at < reader->end && (*reader->at == '-' || *reader->at == '+');
+        for (; reader->at < reader->end && *reader->at >= '0' && *reader->at <= '9'; reader->at++, power_digits++)
+        {
+            if (power < 1000)
+                power = power * 10 + (*reader->at - '0');
+        }
+        if (power_digits == 0)
+            return false;
+        exponent += negative_power ? -power : power;
+    }
+
+    // Dividing keeps the exact powers of ten exact
+    *value = exponent < 0 ? mantissa / pow(10., -exponent) : mantissa * pow(10., exponent);
+    if (negative)
+        *value = -*value;
+    return true;
+}
+
+static bool json_read_float(json_reader_t *reader, float *value)
+{
+    double number;
+
+    if (!json_read_number(reader, &number))
+        return false;
+
+    *value = number;
+    return true;
+}
+
+static bool json_read_u32(json_reader_t *reader, uint32_t *value)
+{
+    double number;
+
+    if (!json_read_number(reader, &number) || !(number >= 0. && number <= UINT32_MAX && number == floor(number)))
+        return false;
+
+    *value = number;
+    return true;
+}
+
+static bool json_read_i32(json_reader_t *reader, int32_t *value)
+{
+    double number;
+
+    if (!json_read_number(reader, &number) || !(number >= INT32_MIN && number <= INT32_MAX && number == floor(number)))
+        return false;
+
+    *value = number;
+    return true;
+}
+
+static bool json_read_i64(json_reader_t *reader, int64_t *value)
+{
+    double number;
+
+    if (!json_read_number(reader, &number) || !(number >= -9e18 && number <= 9e18 && number == floor(number)))
+        return false;
+
+    *value = number;
+    return true;
+}
+
+static bool json_read_enum(json_reader_t *reader, const char *const *names, int count, int *value)
+{
+    const char *name;
+    size_t length;
+
+    if (!json_read_string(reader, &name, &length))
+        return false;
+
+    for (int i = 0; i < count; i++)
+    {
+        if (strlen(names[i]) == length && memcmp(names[i], name, length) == 0)
+        {
+            *value = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool json_skip_value(json_reader_t *reader)
+{
+    const char *text;
+    size_t length;
+    double number;
+    bool more;
+
+    if (json_peek(reader, '"'))
+        return json_read_string(reader, &text, &length);
+
+    if (json_peek(reader, '{') || json_peek(reader, '['))
+    {
+        bool object = *reader->at == '{';
+        char close = object ? '}' : ']';
+
+        if (!json_begin(reader, *reader->at, close, &more))
+            return false;
+        while (more)
+        {
+            if ((object && !json_read_key(reader, &text, &length)) || !json_skip_value(reader) || !json_next(reader, close, &more))
+                return false;
+        }
+        return true;
+    }
+
+    if (reader->end - reader->at >= 4 && memcmp(reader->at, "true", 4) == 0)
+    {
+        reader->at += 4;
+        return true;
+    }
+    if (reader->end - reader->at >= 5 && memcmp(reader->at, "false", 5) == 0)
+    {
+        reader->at += 5;
+        return true;
+    }
+
+    return json_read_number(reader, &number);
+}
+
+static void binary_write(binary_writer_t *writer, uint64_t value, int size)
+{
+    if (writer->failed || writer->end - writer->at < size)
+    {
+        writer->failed = true;
+        return;
+    }
+
+    for (int i = 0; i < size; i++)
+        *writer->at++ = value >> 8 * i;
+}
+
+// Any NAN as the quiet one the server and the client write too
+static void binary_write_float(binary_writer_t *writer, float value)
+{
+    uint32_t bits = 0x7fc00000u;
+
+    if (!isnan(value))
+        memcpy(&bits, &value, sizeof(bits));
+    binary_write(writer, bits, sizeof(bits));
+}
+
+static bool binary_read(binary_reader_t *reader, int size, uint64_t *value)
+{
+    if (reader->end - reader->at < size)
+        return false;
+
+    *value = 0;
+    for (int i = 0; i < size; i++)
+        *value |= (uint64_t)*reader->at++ << 8 * i;
+    return true;
+}
+
+static bool binary_read_u8(binary_reader_t *reader, uint8_t *value)
+{
+    uint64_t bits;
+
+    if (!binary_read(reader, 1, &bits))
+        return false;
+
+    *value = bits;
+    return true;
+}
+
+static bool binary_read_float(binary_reader_t *reader, float *value)
+{
+    uint64_t bits;
+    uint32_t word;
+
+    if (!binary_read(reader, sizeof(word), &bits))
+        return false;
+
+    word = bits;
+    memcpy(value, &word, sizeof(word));
+    return true;
+}
+
+static bool binary_read_u32(binary_reader_t *reader, uint32_t *value)
+{
+    uint64_t bits;
+
+    if (!binary_read(reader, 4, &bits))
+        return false;
+
+    *value = bits;
+    return true;
+}
+
+static bool binary_read_i32(binary_reader_t *reader, int32_t *value)
+{
+    uint64_t bits;
+
+    if (!binary_read(reader, 4, &bits))
+        return false;
+
+    *value = (int32_t)(uint32_t)bits;
+    return true;
+}
+
+static bool binary_read_i64(binary_reader_t *reader, int64_t *value)
+{
+    uint64_t bits;
+
+    if (!binary_read(reader, 8, &bits))
+        return false;
+
+    *value = (int64_t)bits;
+    return true;
+}
+
+static bool binary_read_enum(binary_reader_t *reader, int count, int *value)
+{
+    uint8_t index;
+
+    if (!binary_read_u8(reader, &index) || index >= count)
+        return false;
+
+    *value = index;
+    return true;
+}
+"""
+
+
+class CGenerator:
+    def __init__(self, schema):
+        self.schema = schema
+
+    def type(self, type):
+        kind = self.schema.kind(type)
+        if kind == "scalar":
+            return C_TYPES[type]
+        if kind == "enum":
+            return f"protocol_{snake(type)}_t"
+        return self.schema.structs[type].c or f"protocol_{snake(type)}_t"
+
+    def enum_constant(self, enum, value):
+        return f"PROTOCOL_{snake(enum).upper()}_{value.upper()}"
+
+    def header(self):
+        schema = self.schema
+        includes = sorted({struct.c_include for struct in schema.structs.values() if struct.c_include} | {"types.h"})
+        lines = [f"// {HEADER}", "#ifndef __PROTOCOL_H__", "#define __PROTOCOL_H__", ""]
+        lines += ["#include <stdbool.h>", "#include <stddef.h>", "#include <stdint.h>"]
+        lines += [f'#include "{include}"' for include in includes]
+
+        for enum, values in schema.enums.items():
+            name = self.type(enum)
+            lines += ["", f"typedef enum {name}", "{"]
+            lines += [f"    {self.enum_constant(enum, value)}," for value in values]
+            lines += [f"    {self.enum_constant(enum, 'count')},", f"}} {name};"]
+        lines += [""]
+        for enum in schema.enums:
+            lines += [f"extern const char *const protocol_{snake(enum)}_names[{self.enum_constant(enum, 'count')}];"]
+
+        for struct in schema.structs.values():
+            if struct.c:
+                continue
+            name = self.type(struct.name)
+            lines += [""]
+            if struct.doc:
+                lines += [f"// {struct.doc}"]
+            lines += [f"typedef struct {name}", "{"]
+            for field in struct.fields:
+                member = snake(field.name)
+                if field.doc:
+                    lines += [f"    // {field.doc}"]
+                if field.optional:
+                    lines += [f"    bool has_{member};"]
+                if field.array:
+                    lines += [f"    {self.type(field.type)} {member}[{field.max}];", f"    int {member}_count;"]
+                else:
+                    lines += [f"    {self.type(field.type)} {member};"]
+            lines += [f"}} {name};"]
+
+        lines += ["", "typedef struct protocol_message_t", "{", f"    {self.type(EVENT_ENUM)} event;", "    union", "    {"]
+        lines += [f"        {self.type(payload)} {snake(payload)};" for _, payload in schema.messages]
+        lines += ["    };", "} protocol_message_t;", ""]
+        lines += [
+            "/**",
+            " * Writes `message` as JSON, null terminated, without allocating. Returns the",
+            " * length, or -1 when `size` is too short.",
+            " */",
+            "int protocol_encode_json(const protocol_message_t *message, char *buffer, size_t size);",
+            "/**",
+            " * Reads the JSON message of `length` characters, members in any order and",
+            " * unknown ones skipped. False when it is not valid, lacks a required field,",
+            " * or has an unknown event.",
+            " */",
+            "bool protocol_decode_json(const char *json, size_t length, protocol_message_t *message);",
+            "// The binary form, the length or -1 when `size` is too short",
+            "int protocol_encode_binary(const protocol_message_t *message, uint8_t *buffer, size_t size);",
+            "bool protocol_decode_binary(const uint8_t *data, size_t length, protocol_message_t *message);",
+            "",
+            "#endif // __PROTOCOL_H__",
+        ]
+        return "\n".join(lines) + "\n"
+
+    def source(self):
+        schema = self.schema
+        lines = [f"// {HEADER}", "#include <math.h>", "#include <string.h>", '#include "protocol.h"']
+        lines += C_RUNTIME.rstrip("\n").split("\n")
+        for enum in schema.enums:
+            name = self.type(enum)
+            lines += [f"static bool json_read_{snake(enum)}(json_reader_t *reader, {name} *value);"]
+            lines += [f"static bool binary_read_{snake(enum)}(binary_reader_t *reader, {name} *value);"]
+        for struct in schema.structs.values():
+            name = self.type(struct.name)
+            lines += [f"static void encode_json_{snake(struct.name)}(json_writer_t *writer, const {name} *value);"]
+            lines += [f"static bool decode_json_{snake(struct.name)}(json_reader_t *reader, {name} *value);"]
+            lines += [f"static void encode_binary_{snake(struct.name)}(binary_writer_t *writer, const {name} *value);"]
+            lines += [f"static bool decode_binary_{snake(struct.name)}(binary_reader_t *reader, {name} *value);"]
+
+        for enum, values in schema.enums.items():
+            lines += ["", f"const char *const protocol_{snake(enum)}_names[{self.enum_constant(enum, 'count')}] = {{"]
+            lines += [f'    "{value}",' for value in values]
+            lines += ["};"]
+
+        lines += self.messages()
+        for enum in schema.enums:
+            lines += self.enum_readers(enum)
+        for struct in schema.structs.values():
+            lines += self.encode_json(struct)
+            lines += self.decode_json(struct)
+            lines += self.encode_binary(struct)
+            lines += self.decode_binary(struct)
+        lines += C_RUNTIME_DEFINITIONS.rstrip("\n").split("\n")
+        return "\n".join(lines) + "\n"
+
+    def messages(self):
+        event = self.type(EVENT_ENUM)
+        count = self.enum_constant(EVENT_ENUM, "count")
+
+        def cases(call):
+            lines = []
+            for name, payload in self.schema.messages:
+                lines += [f"    case {self.enum_constant(EVENT_ENUM, name)}:"]
+                lines += indent(call(snake(payload)), 2)
+            return lines
+
+        lines = ["", "int protocol_encode_json(const protocol_message_t *message, char *buffer, size_t size)", "{"]
+        lines += ["    json_writer_t writer = {", "        .at = buffer,", "        .end = buffer + size - 1,", "    };", ""]
+        lines += [f"    if (size == 0 || message->event >= {count})", "        return -1;", ""]
+        lines += ['    json_write(&writer, "{\\"event\\":", 9);']
+        lines += [f"    json_write_string(&writer, protocol_{snake(EVENT_ENUM)}_names[message->event]);"]
+        lines += ['    json_write(&writer, ",\\"payload\\":", 11);', "    switch (message->event)", "    {"]
+        lines += cases(lambda payload: [f"encode_json_{payload}(&writer, &message->{payload});", "break;"])
+        lines += ["    default:", "        break;", "    }", '    json_write(&writer, "}", 1);', ""]
+        lines += ["    if (writer.failed)", "        return -1;", "", "    *writer.at = '\\0';", "    return writer.at - buffer;", "}"]
+
+        lines += ["", "bool protocol_decode_json(const char *json, size_t length, protocol_message_t *message)", "{"]
+        lines += ["    json_reader_t reader = {", "        .at = json,", "        .end = json + length,", "    };"]
+        lines += ["    const char *key, *payload = NULL;", "    size_t key_length;", "    bool more, has_event = false;", ""]
+        lines += ["    if (!json_begin(&reader, '{', '}', &more))", "        return false;", "    while (more)", "    {"]
+        lines += ["        if (!json_read_key(&reader, &key, &key_length))", "            return false;"]
+        lines += ['        if (JSON_KEY_IS(key, key_length, "event"))', "        {"]
+        lines += [f"            if (!json_read_{snake(EVENT_ENUM)}(&reader, &message->event))", "                return false;"]
+        lines += ["            has_event = true;", "        }"]
+        lines += ['        else if (JSON_KEY_IS(key, key_length, "payload"))', "        {"]
+        lines += ["            json_skip_space(&reader);", "            payload = reader.at;"]
+        lines += ["            if (!json_skip_value(&reader))", "                return false;", "        }"]
+        lines += ["        else if (!json_skip_value(&reader))", "        {", "            return false;", "        }"]
+        lines += ["        if (!json_next(&reader, '}', &more))", "            return false;", "    }"]
+        lines += ["    json_skip_space(&reader);", "    if (!has_event || payload == NULL || reader.at != reader.end)", "        return false;", ""]
+        lines += ["    // The payload again, now that the event tells its type", "    reader.at = payload;", "    switch (message->event)", "    {"]
+        lines += cases(lambda payload: [f"return decode_json_{payload}(&reader, &message->{payload});"])
+        lines += ["    default:", "        return false;", "    }", "}"]
+
+        lines += ["", "int protocol_encode_binary(const protocol_message_t *message, uint8_t *buffer, size_t size)", "{"]
+        lines += ["    binary_writer_t writer = {", "        .at = buffer,", "        .end = buffer + size,", "    };", ""]
+        lines += [f"    if (message->event >= {count})", "        return -1;", ""]
+        lines += ["    binary_write(&writer, message->event, 1);", "    switch (message->event)", "    {"]
+        lines += cases(lambda payload: [f"encode_binary_{payload}(&writer, &message->{payload});", "break;"])
+        lines += ["    default:", "        break;", "    }", "", "    return writer.failed ? -1 : writer.at - buffer;", "}"]
+
+        lines += ["", "bool protocol_decode_binary(const uint8_t *data, size_t length, protocol_message_t *message)", "{"]
+        lines += ["    binary_reader_t reader = {", "        .at = data,", "        .end = data + length,", "    };", ""]
+        lines += [f"    if (!binary_read_{snake(EVENT_ENUM)}(&reader, &message->event))", "        return false;", ""]
+        lines += ["    switch (message->event)", "    {"]
+        lines += cases(lambda payload: [f"return decode_binary_{payload}(&reader, &message->{payload}) && reader.at == reader.end;"])
+        lines += ["    default:", "        return false;", "    }", "}"]
+        return lines
+
+    def enum_readers(self, enum):
+        name = self.type(enum)
+        count = self.enum_constant(enum, "count")
+        lines = []
+        for form, reader, call in (
+            ("json", "json_reader_t", f"json_read_enum(reader, protocol_{snake(enum)}_names, {count}, &index)"),
+            ("binary", "binary_reader_t", f"binary_read_enum(reader, {count}, &index)"),
+        ):
+            lines += ["", f"static bool {form}_read_{snake(enum)}({reader} *reader, {name} *value)", "{", "    int index;", ""]
+            lines += [f"    if (!{call})", "        return false;", "", "    *value = index;", "    return true;", "}"]
+        return lines
+
+    def json_write(self, field, value):
+        kind = self.schema.kind(field.type)
+        if field.type == "f32":
+            return f"json_write_float(writer, {value}, {field.precision});"
+        if kind == "scalar":
+            return f"json_write_integer(writer, {value});"
+        if kind == "enum":
+            return f"json_write_string(writer, protocol_{snake(field.type)}_names[{value}]);"
+        return f"encode_json_{snake(field.type)}(writer, &{value});"
+
+    def json_read(self, field, value):
+        kind = self.schema.kind(field.type)
+        if kind == "scalar":
+            return f"json_read_{'float' if field.type == 'f32' else field.type}(reader, &{value})"
+        if kind == "enum":
+            return f"json_read_{snake(field.type)}(reader, &{value})"
+        return f"decode_json_{snake(field.type)}(reader, &{value})"
+
+    def binary_write(self, field, value):
+        kind = self.schema.kind(field.type)
+        if field.type == "f32":
+            return f"binary_write_float(writer, {value});"
+        if kind == "scalar":
+            return f"binary_write(writer, {value}, {8 if field.type == 'i64' else 4});"
+        if kind == "enum":
+            return f"binary_write(writer, {value}, 1);"
+        return f"encode_binary_{snake(field.type)}(writer, &{value});"
+
+    def binary_read(self, field, value):
+        kind = self.schema.kind(field.type)
+        if kind == "scalar":
+            return f"binary_read_{'float' if field.type == 'f32' else field.type}(reader, &{value})"
+        if kind == "enum":
+            return f"binary_read_{snake(field.type)}(reader, &{value})"
+        return f"decode_binary_{snake(field.type)}(reader, &{value})"
+
+    def signature(self, struct, form, encode):
+        name = self.type(struct.name)
+        if encode:
+            return f"static void encode_{form}_{snake(struct.name)}({form}_writer_t *writer, const {name} *value)"
+        return f"static bool decode_{form}_{snake(struct.name)}({form}_reader_t *reader, {name} *value)"
+
+    def encode_json(self, struct):
+        lines = ["", self.signature(struct, "json", True), "{"]
+        if struct.tuple:
+            for i, field in enumerate(struct.fields):
+                lines += [f'    json_write(writer, "{"[" if i == 0 else ","}", 1);']
+                lines += [f"    {self.json_write(field, 'value->' + snake(field.name))}"]
+            return lines + ['    json_write(writer, "]", 1);', "}"]
+
+        lines += ["    bool first = true;", ""]
+        for field in struct.fields:
+            member = "value->" + snake(field.name)
+            key = f'"\\"{field.name}\\":", {len(field.name) + 3}'
+            body = [f"json_write_key(writer, &first, {key});"]
+            if field.array:
+                body += ['json_write(writer, "[", 1);', f"for (int i = 0; i < {member}_count; i++)", "{"]
+                body += ["    if (i > 0)", '        json_write(writer, ",", 1);', f"    {self.json_write(field, member + '[i]')}", "}"]
+                body += ['json_write(writer, "]", 1);']
+            else:
+                body += [self.json_write(field, member)]
+            if field.optional:
+                lines += [f"    if (value->has_{snake(field.name)})", "    {"] + indent(body, 2) + ["    }"]
+            else:
+                lines += indent(body, 1)
+        return lines + ['    json_write(writer, first ? "{}" : "}", first ? 2 : 1);', "}"]
+
+    def decode_json(self, struct):
+        lines = ["", self.signature(struct, "json", False), "{"]
+        if struct.tuple:
+            lines += ["    bool more;", "", "    if (!json_begin(reader, '[', ']', &more))", "        return false;"]
+            for field in struct.fields:
+                lines += [f"    if (!more || !{self.json_read(field, 'value->' + snake(field.name))} || !json_next(reader, ']', &more))"]
+                lines += ["        return false;"]
+            return lines + ["", "    return !more;", "}"]
+
+        required = sum(1 << i for i, field in enumerate(struct.fields) if not field.optional)
+        lines += ["    const char *key;", "    size_t length;"] + (["    uint32_t seen = 0;"] if required else []) + ["    bool more;", ""]
+        lines += ["    memset(value, 0, sizeof(*value));", "    if (!json_begin(reader, '{', '}', &more))", "        return false;"]
+        lines += ["    while (more)", "    {", "        if (!json_read_key(reader, &key, &length))", "            return false;"]
+        for i, field in enumerate(struct.fields):
+            member = "value->" + snake(field.name)
+            lines += [f'        {"if" if i == 0 else "else if"} (JSON_KEY_IS(key, length, "{field.name}"))', "        {"]
+            if field.array:
+                lines += ["            bool items;", ""]
+                lines += ["            if (!json_begin(reader, '[', ']', &items))", "                return false;"]
+                lines += [f"            for ({member}_count = 0; items; {member}_count++)", "            {"]
+                lines += [f"                if ({member}_count >= {field.max} || !{self.json_read(field, member + '[' + member + '_count]')} ||"]
+                lines += ["                    !json_next(reader, ']', &items))", "                    return false;", "            }"]
+            else:
+                lines += [f"            if (!{self.json_read(field, member)})", "                return false;"]
+            if field.optional:
+                lines += [f"            value->has_{snake(field.name)} = true;"]
+            else:
+                lines += [f"            seen |= 1u << {i};"]
+            lines += ["        }"]
+        lines += ["        else if (!json_skip_value(reader))", "        {", "            return false;", "        }"]
+        lines += ["        if (!json_next(reader, '}', &more))", "            return false;", "    }", ""]
+        if not required:
+            return lines + ["    return true;", "}"]
+        return lines + [f"    return (seen & {required:#x}u) == {required:#x}u;", "}"]
+
+    def encode_binary(self, struct):
+        lines = ["", self.signature(struct, "binary", True), "{"]
+        optionals = struct.optionals
+        if optionals:
+            bits = " | ".join(f"value->has_{snake(field.name)} << {i}" for i, field in enumerate(optionals))
+            lines += [f"    binary_write(writer, {bits}, 1);"]
+        for field in struct.fields:
+            member = "value->" + snake(field.name)
+            if field.array:
+                body = [f"binary_write(writer, {member}_count, 1);", f"for (int i = 0; i < {member}_count; i++)"]
+                body += [f"    {self.binary_write(field, member + '[i]')}"]
+            else:
+                body = [self.binary_write(field, member)]
+            if field.optional:
+                lines += [f"    if (value->has_{snake(field.name)})", "    {"] + indent(body, 2) + ["    }"]
+            else:
+                lines += indent(body, 1)
+        return lines + ["}"]
+
+    def decode_binary(self, struct):
+        lines = ["", self.signature(struct, "binary", False), "{"]
+        optionals = struct.optionals
+        locals = (["present"] if optionals else []) + (["count"] if any(field.array for field in struct.fields) else [])
+        if locals:
+            lines += [f"    uint8_t {', '.join(locals)};", ""]
+        lines += ["    memset(value, 0, sizeof(*value));"]
+        if optionals:
+            lines += [f"    if (!binary_read_u8(reader, &present) || present >> {len(optionals)} != 0)", "        return false;"]
+            lines += [f"    value->has_{snake(field.name)} = present >> {i} & 1;" for i, field in enumerate(optionals)]
+        for field in struct.fields:
+            member = "value->" + snake(field.name)
+            if not field.array:
+                condition = f"value->has_{snake(field.name)} && " if field.optional else ""
+                lines += [f"    if ({condition}!{self.binary_read(field, member)})", "        return false;"]
+                continue
+            body = [f"if (!binary_read_u8(reader, &count) || count > {field.max})", "    return false;"]
+            body += [f"for ({member}_count = 0; {member}_count < count; {member}_count++)", "{"]
+            body += [f"    if (!{self.binary_read(field, member + '[' + member + '_count]')})", "        return false;", "}"]
+            if field.optional:
+                lines += [f"    if (value->has_{snake(field.name)})", "    {"] + indent(body, 2) + ["    }"]
+            else:
+                lines += indent(body, 1)
+        return lines + ["", "    return true;", "}"]
+
+
+# TypeScript
+
+
+TS_RUNTIME = r"""
+function fail(message: string): never {
+    throw new Error(message);
+}
+
+function readObject(value: any, name: string): { [key: string]: any } {
+    return typeof value == 'object' && value !== null && !Array.isArray(value) ? value : fail(`${name} is not an object`);
+}
+
+function readArray(value: any, name: string, max: number): any[] {
+    return Array.isArray(value) && value.length <= max ? value : fail(`${name} is not an array of at most ${max} items`);
+}
+
+// Rounded to the decimals the firmware writes, null for the values JSON cannot hold
+function writeFloat(value: number, precision: number): number | null {
+    return isFinite(value) ? Number(value.toFixed(precision)) : null;
+}
+
+// Null stands for the values JSON cannot hold
+function readFloat(value: any, name: string): number {
+    return value === null ? NaN : typeof value == 'number' ? value : fail(`${name} is not a number`);
+}
+
+function readInteger(value: any, name: string, min: number, max: number): number {
+    return Number.isInteger(value) && value >= min && value <= max ? value : fail(`${name} is not an integer from ${min} to ${max}`);
+}
+
+function readEnum<T>(value: any, name: string, values: readonly T[]): T {
+    return values.indexOf(value) >= 0 ? value : fail(`${name} is not one of ${values.join(', ')}`);
+}
+
+class BinaryWriter {
+    private buffer = new ArrayBuffer(256);
+    private view = new DataView(this.buffer);
+    private length = 0;
+
+    u8(value: number) {
+        this.view.setUint8(this.reserve(1), value);
+    }
+
+    u32(value: number) {
+        this.view.setUint32(this.reserve(4), value, true);
+    }
+
+    i32(value: number) {
+        this.view.setInt32(this.reserve(4), value, true);
+    }
+
+    i64(value: number) {
+        const high = Math.floor(value / 4294967296);
+
+        this.u32(value - high * 4294967296);
+        this.i32(high);
+    }
+
+    f32(value: number) {
+        this.view.setFloat32(this.reserve(4), value, true);
+    }
+
+    bytes(): Uint8Array {
+        return new Uint8Array(this.buffer, 0, this.length);
+    }
+
+    private reserve(size: number): number {
+        if (this.length + size > this.buffer.byteLength) {
+            const buffer = new ArrayBuffer(this.buffer.byteLength * 2);
+
+            new Uint8Array(buffer).set(new Uint8Array(this.buffer));
+            this.buffer = buffer;
+            this.view = new DataView(buffer);
+        }
+
+        this.length += size;
+        return this.length - size;
+    }
+}
+
+class BinaryReader {
+    private view: DataView;
+    private offset = 0;
+
+    constructor(data: Uint8Array) {
+        this.view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+    }
+
+    u8(): number {
+        return this.view.getUint8(this.take(1));
+    }
+
+    u32(): number {
+        return this.view.getUint32(this.take(4), true);
+    }
+
+    i32(): number {
+        return this.view.getInt32(this.take(4), true);
+    }
+
+    i64(): number {
+        const low = this.u32();
+
+        return this.i32() * 4294967296 + low;
+    }
+
+    f32(): number {
+        return this.view.getFloat32(this.take(4), true);
+    }
+
+    count(max: number): number {
+        const count = this.u8();
+
+        return count <= max ? count : fail(`${count} items, at most ${max}`);
+    }
+
+    enum<T>(values: readonly T[]): T {
+        const index = this.u8();
+
+        return index < values.length ? values[index] : fail(`Enum index ${index} out of range`);
+    }
+
+    get done(): boolean {
+        return this.offset == this.view.byteLength;
+    }
+
+    private take(size: number): number {
+        if (this.offset + size > this.view.byteLength) fail('Binary message is truncated');
+
+        this.offset += size;
+        return this.offset - size;
+    }
+}
+"""
+
+TS_RANGES = {"u32": ("0", "4294967295"), "i32": ("-2147483648", "2147483647"), "i64": ("-Number.MAX_SAFE_INTEGER", "Number.MAX_SAFE_INTEGER")}
+
+
+class TsGenerator:
+    def __init__(self, schema):
+        self.schema = schema
+
+    def type(self, field):
+        kind = self.schema.kind(field.type)
+        type = "number" if kind == "scalar" else field.type
+        return type + "[]" if field.array else type
+
+    def source(self):
+        schema = self.schema
+        lines = [f"// {HEADER}"]
+        for enum, values in schema.enums.items():
+            lines += ["", f"export enum {enum} {{"]
+            lines += [f'    {pascal(value)} = "{value}",' for value in values]
+            lines += ["}"]
+        for struct in schema.structs.values():
+            lines += [""]
+            if struct.doc:
+                lines += [f"// {struct.doc}"]
+            lines += [f"export interface {struct.name} {{"]
+            for field in struct.fields:
+                if field.doc:
+                    lines += [f"    // {field.doc}"]
+                lines += [f"    {field.name}{'?' if field.optional else ''}: {self.type(field)},"]
+            lines += ["}"]
+        lines += ["", "export type Message ="]
+        lines += [f"    | {{ event: {EVENT_ENUM}.{pascal(event)}, payload: {payload} }}" for event, payload in schema.messages]
+        lines[-1] += ";"
+        lines += TS_RUNTIME.rstrip("\n").split("\n")
+        for enum, values in schema.enums.items():
+            lines += ["", f"const {camel(enum)}Values: readonly {enum}[] = [{', '.join(f'{enum}.{pascal(value)}' for value in values)}];"]
+
+        lines += self.messages()
+        for struct in schema.structs.values():
+            lines += self.write_json(struct) + self.read_json(struct) + self.write_binary(struct) + self.read_binary(struct)
+        return "\n".join(lines) + "\n"
+
+    def messages(self):
+        def cases(call):
+            lines = []
+            for event, payload in self.schema.messages:
+                lines += [f"        case {EVENT_ENUM}.{pascal(event)}:"] + indent(call(event, payload), 3)
+            return lines
+
+        lines = ["", "export function encodeJson(message: Message): string {", "    switch (message.event) {"]
+        lines += cases(lambda event, payload: [f"return JSON.stringify({{ event: message.event, payload: write{payload}(message.payload) }});"])
+        lines += ["    }", "}"]
+        lines += ["", "// Throws when the message is not valid", "export function decodeJson(text: string): Message {"]
+        lines += ["    const root = readObject(JSON.parse(text), 'message');", ""]
+        lines += [f"    switch (readEnum(root.event, 'event', {camel(EVENT_ENUM)}Values)) {{"]
+        lines += cases(lambda event, payload: [f"return {{ event: {EVENT_ENUM}.{pascal(event)}, payload: read{payload}(root.payload, 'payload') }};"])
+        lines += ["    }", "}"]
+        lines += ["", "export function encodeBinary(message: Message): Uint8Array {", "    const writer = new BinaryWriter();", ""]
+        lines += [f"    writer.u8({camel(EVENT_ENUM)}Values.indexOf(message.event));", "    switch (message.event) {"]
+        lines += cases(lambda event, payload: [f"encodeBinary{payload}(writer, message.payload);", "break;"])
+        lines += ["    }", "", "    return writer.bytes();", "}"]
+        lines += ["", "export function decodeBinary(data: Uint8Array): Message {", "    const reader = new BinaryReader(data);", "    let message: Message;", ""]
+        lines += [f"    switch (reader.enum({camel(EVENT_ENUM)}Values)) {{"]
+        lines += cases(lambda event, payload: [f"message = {{ event: {EVENT_ENUM}.{pascal(event)}, payload: decodeBinary{payload}(reader) }};", "break;"])
+        lines += ["    }", "", "    return reader.done ? message : fail('Binary message is too long');", "}"]
+        return lines
+
+    def read_value(self, field, value, name):
+        kind = self.schema.kind(field.type)
+        if field.type == "f32":
+            return f"readFloat({value}, {name})"
+        if kind == "scalar":
+            return f"readInteger({value}, {name}, {', '.join(TS_RANGES[field.type])})"
+        if kind == "enum":
+            return f"readEnum({value}, {name}, {camel(field.type)}Values)"
+        return f"read{field.type}({value}, {name})"
+
+    def read_field(self, field, value, name):
+        if field.array:
+            return f"readArray({value}, {name}, {field.max}).map((item, i) => {self.read_value(field, 'item', f'`{name[1:-1]}[${{i}}]`')})"
+        return self.read_value(field, value, name)
+
+    def write_value(self, field, value):
+        if field.type == "f32" and field.array:
+            return f"{value}.map(item => writeFloat(item, {field.precision}))"
+        if field.type == "f32":
+            return f"writeFloat({value}, {field.precision})"
+        if self.schema.kind(field.type) != "struct":
+            return value
+        if field.array:
+            return f"{value}.map(write{field.type})"
+        return f"write{field.type}({value})"
+
+    def write_json(self, struct):
+        lines = ["", f"function write{struct.name}(value: {struct.name}): any {{"]
+        if struct.tuple:
+            return lines + [f"    return [{', '.join(self.write_value(field, 'value.' + field.name) for field in struct.fields)}];", "}"]
+        required = [field for field in struct.fields if not field.optional]
+        lines += ["    const result: any = {"]
+        lines += [f"        {field.name}: {self.write_value(field, 'value.' + field.name)}," for field in required]
+        lines += ["    };", ""]
+        for field in struct.optionals:
+            lines += [f"    if (value.{field.name} !== undefined) result.{field.name} = {self.write_value(field, 'value.' + field.name)};"]
+        return lines + ["    return result;", "}"]
+
+    def read_json(self, struct):
+        lines = ["", f"function read{struct.name}(value: any, name: string): {struct.name} {{"]
+        if struct.tuple:
+            lines += [f"    const items = readArray(value, name, {len(struct.fields)});", ""]
+            lines += [f"    if (items.length != {len(struct.fields)}) fail(`${{name}} does not have {len(struct.fields)} items`);", "    return {"]
+            lines += [f"        {field.name}: {self.read_field(field, f'items[{i}]', f'`${{name}}[{i}]`')}," for i, field in enumerate(struct.fields)]
+            return lines + ["    };", "}"]
+        lines += ["    const object = readObject(value, name);", f"    const result: {struct.name} = {{"]
+        for field in struct.fields:
+            if not field.optional:
+                lines += [f"        {field.name}: {self.read_field(field, 'object.' + field.name, f'`${{name}}.{field.name}`')},"]
+        lines += ["    };", ""]
+        for field in struct.optionals:
+            read = self.read_field(field, "object." + field.name, f"`${{name}}.{field.name}`")
+            lines += [f"    if (object.{field.name} !== undefined) result.{field.name} = {read};"]
+        return lines + ["    return result;", "}"]
+
+    def encode_value(self, field, value):
+        kind = self.schema.kind(field.type)
+        if kind == "scalar":
+            return f"writer.{field.type}({value});"
+        if kind == "enum":
+            return f"writer.u8({camel(field.type)}Values.indexOf({value}));"
+        return f"encodeBinary{field.type}(writer, {value});"
+
+    def decode_value(self, field):
+        kind = self.schema.kind(field.type)
+        if kind == "scalar":
+            return f"reader.{field.type}()"
+        if kind == "enum":
+            return f"reader.enum({camel(field.type)}Values)"
+        return f"decodeBinary{field.type}(reader)"
+
+    def write_binary(self, struct):
+        lines = ["", f"function encodeBinary{struct.name}(writer: BinaryWriter, value: {struct.name}) {{"]
+        if struct.optionals:
+            bits = " | ".join(f"(value.{field.name} !== undefined ? {1 << i} : 0)" for i, field in enumerate(struct.optionals))
+            lines += [f"    writer.u8({bits});"]
+        for field in struct.fields:
+            value = f"value.{field.name}"
+            if field.array:
+                body = [f"writer.u8({value}.length);", f"for (let item of {value}) {self.encode_value(field, 'item')}"]
+            else:
+                body = [self.encode_value(field, value)]
+            if field.optional:
+                lines += [f"    if ({value} !== undefined) {{"] + indent(body, 2) + ["    }"]
+            else:
+                lines += indent(body, 1)
+        return lines + ["}"]
+
+    def read_binary(self, struct):
+        lines = ["", f"function decodeBinary{struct.name}(reader: BinaryReader): {struct.name} {{"]
+        if struct.optionals:
+            lines += ["    const present = reader.u8();", ""]
+            lines += [f"    if (present >> {len(struct.optionals)}) fail('Unknown optional fields');"]
+
+        def decode(field):
+            if field.array:
+                return f"Array.from({{ length: reader.count({field.max}) }}, () => {self.decode_value(field)})"
+            return self.decode_value(field)
+
+        if not struct.optionals:
+            lines += ["    return {"] + [f"        {field.name}: {decode(field)}," for field in struct.fields]
+            return lines + ["    };", "}"]
+
+        # Assigned one by one, the fields are read in the order they were written
+        lines += [f"    const result = {{}} as {struct.name};", ""]
+        bits = {field.name: 1 << i for i, field in enumerate(struct.optionals)}
+        for field in struct.fields:
+            if field.optional:
+                lines += [f"    if (present & {bits[field.name]}) result.{field.name} = {decode(field)};"]
+            else:
+                lines += [f"    result.{field.name} = {decode(field)};"]
+        return lines + ["    return result;", "}"]
+
+
+# C#
+
+
+# Field names that have to be escaped as C# members
+CS_KEYWORDS = {
+    "abstract", "as", "base", "bool", "break", "byte", "case", "catch", "char", "checked", "class", "const", "continue",
+    "decimal", "default", "delegate", "do", "double", "else", "enum", "event", "explicit", "extern", "false", "finally",
+    "fixed", "float", "for", "foreach", "goto", "if", "implicit", "in", "int", "interface", "internal", "is", "lock",
+    "long", "namespace", "new", "null", "object", "operator", "out", "override", "params", "private", "protected",
+    "public", "readonly", "ref", "return", "sbyte", "sealed", "short", "sizeof", "stackalloc", "static", "string",
+    "struct", "switch", "this", "throw", "true", "try", "typeof", "uint", "ulong", "unchecked", "unsafe", "ushort",
+    "using", "virtual", "void", "volatile", "while",
+}
+CS_TYPES = {"f32": "float", "u32": "uint", "i32": "int", "i64": "long"}
+CS_READERS = {"f32": "ReadSingle", "u32": "ReadUInt32", "i32": "ReadInt32", "i64": "ReadInt64"}
+CS_JSON_RUNTIME = r"""
+    // Rounded to the decimals the firmware writes
+    static void WriteFloat(JsonWriter writer, float value, int precision)
+    {
+        if (float.IsNaN(value) || float.IsInfinity(value)) writer.WriteNull();
+        else writer.WriteValue(Math.Round((double)value, precision, MidpointRounding.AwayFromZero));
+    }
+
+    static JToken Required(JToken token, string name)
+    {
+        return token[name] ?? throw new FormatException($"{name} is missing.");
+    }
+
+    static bool Optional(JToken token, string name, out JToken value)
+    {
+        value = token[name];
+        return value != null;
+    }
+
+    static float ReadFloat(JToken token)
+    {
+        if (token.Type == JTokenType.Null) return float.NaN;
+        if (token.Type != JTokenType.Float && token.Type != JTokenType.Integer) throw new FormatException($"{token.Path} is not a number.");
+
+        return token.Value<float>();
+    }
+
+    static T ReadInteger<T>(JToken token)
+    {
+        if (token.Type != JTokenType.Integer) throw new FormatException($"{token.Path} is not an integer.");
+
+        try
+        {
+            return token.Value<T>();
+        }
+        catch (Exception e) when (e is OverflowException || e is InvalidCastException)
+        {
+            throw new FormatException($"{token.Path} is out of range.");
+        }
+    }
+
+    static int ReadEnum(JToken token, string[] names)
+    {
+        var index = token.Type == JTokenType.String ? Array.IndexOf(names, token.Value<string>()) : -1;
+        if (index < 0) throw new FormatException($"{token.Path} is not one of {string.Join(", ", names)}.");
+
+        return index;
+    }
+
+    static JArray ReadArray(JToken token, int max)
+    {
+        if (!(token is JArray array) || array.Count > max) throw new FormatException($"{token.Path} is not an array of at most {max} items.");
+
+        return array;
+    }
+
+    static JObject ReadObject(JToken token)
+    {
+        return token as JObject ?? throw new FormatException($"{token.Path} is not an object.");
+    }
+"""
+
+
+class CsGenerator:
+    def __init__(self, schema):
+        self.schema = schema
+
+    def type(self, type):
+        kind = self.schema.kind(type)
+        if kind == "scalar":
+            return CS_TYPES[type]
+        if kind == "struct":
+            return self.schema.structs[type].cs or type
+        return type
+
+    def field_type(self, field):
+        return self.type(field.type) + ("[]" if field.array else "")
+
+    def source(self):
+        schema = self.schema
+        lines = [f"// {HEADER}", "using System;", "using System.Globalization;", "using System.IO;", "using System.Linq;", "using Newtonsoft.Json;", "using Newtonsoft.Json.Linq;"]
+        for enum, values in schema.enums.items():
+            lines += ["", f"public enum {enum}", "{"] + [f"    {value}," for value in values] + ["}"]
+        for struct in schema.structs.values():
+            if struct.cs:
+                continue
+            lines += [""]
+            if struct.doc:
+                lines += [f"// {struct.doc}"]
+            lines += ["[Serializable]", f"public struct {struct.name}", "{"]
+            for field in struct.fields:
+                if field.doc:
+                    lines += [f"    // {field.doc}"]
+                if field.optional:
+                    lines += [f"    public bool has{field.name[0].upper()}{field.name[1:]};"]
+                lines += [f"    public {self.field_type(field)} {self.member(field)};"]
+            lines += ["}"]
+
+        lines += ["", "// The payload of the event, the other ones are left empty", "public struct Message", "{", f"    public {EVENT_ENUM} @event;"]
+        lines += [f"    public {payload} {camel(payload)};" for _, payload in schema.messages]
+        lines += ["}"]
+        lines += self.json()
+        lines += self.binary()
+        # Unity writes its scripts with a byte order mark
+        return "\ufeff" + "\n".join(lines) + "\n"
+
+    def has(self, field):
+        return f"has{field.name[0].upper()}{field.name[1:]}"
+
+    def member(self, field):
+        return "@" + field.name if field.name in CS_KEYWORDS else field.name
+
+    def names(self, enum):
+        return f"{enum}Names"
+
+    def json(self):
+        schema = self.schema
+        lines = ["", "public static class ProtocolJson", "{"]
+        for enum, values in schema.enums.items():
+            lines += [f"    static readonly string[] {self.names(enum)} = {{ {', '.join(f'{chr(34)}{value}{chr(34)}' for value in values)} }};"]
+        lines += ["", "    public static string Encode(Message message)", "    {", "        var text = new StringWriter(CultureInfo.InvariantCulture);", ""]
+        lines += ["        using (var writer = new JsonTextWriter(text))", "        {", "            writer.WriteStartObject();"]
+        lines += ['            writer.WritePropertyName("event");', f"            writer.WriteValue({self.names(EVENT_ENUM)}[(int)message.@event]);"]
+        lines += ['            writer.WritePropertyName("payload");', "            switch (message.@event)", "            {"]
+        for event, payload in schema.messages:
+            lines += [f"                case {EVENT_ENUM}.{event}:", f"                    Write(writer, message.{camel(payload)});", "                    break;"]
+        lines += ["            }", "            writer.WriteEndObject();", "        }", "", "        return text.ToString();", "    }"]
+        lines += ["", "    // Throws a FormatException when the message is not valid", "    public static Message Decode(string json)", "    {"]
+        lines += ["        var root = ReadObject(JToken.Parse(json));"]
+        lines += [f'        var message = new Message {{ @event = ({EVENT_ENUM})ReadEnum(Required(root, "event"), {self.names(EVENT_ENUM)}) }};']
+        lines += ['        var payload = Required(root, "payload");', "", "        switch (message.@event)", "        {"]
+        for event, payload in schema.messages:
+            lines += [f"            case {EVENT_ENUM}.{event}:", f"                message.{camel(payload)} = Read{payload}(payload);", "                break;"]
+        lines += ["        }", "", "        return message;", "    }"]
+        for struct in schema.structs.values():
+            lines += self.write_json(struct) + self.read_json(struct)
+        lines += CS_JSON_RUNTIME.rstrip("\n").split("\n")
+        return lines + ["}"]
+
+    def write_value(self, field, value):
+        kind = self.schema.kind(field.type)
+        if field.type == "f32":
+            return f"WriteFloat(writer, {value}, {field.precision});"
+        if kind == "scalar":
+            return f"writer.WriteValue({value});"
+        if kind == "enum":
+            return f"writer.WriteValue({self.names(field.type)}[(int){value}]);"
+        return f"Write(writer, {value});"
+
+    def read_value(self, field, token):
+        kind = self.schema.kind(field.type)
+        if field.type == "f32":
+            return f"ReadFloat({token})"
+        if kind == "scalar":
+            return f"ReadInteger<{CS_TYPES[field.type]}>({token})"
+        if kind == "enum":
+            return f"({field.type})ReadEnum({token}, {self.names(field.type)})"
+        return f"Read{field.type}({token})"
+
+    def read_field(self, field, token):
+        if field.array:
+            return f"ReadArray({token}, {field.max}).Select(item => {self.read_value(field, 'item')}).ToArray()"
+        return self.read_value(field, token)
+
+    def write_json(self, struct):
+        lines = ["", f"    static void Write(JsonWriter writer, {self.type(struct.name)} value)", "    {"]
+        lines += ["        writer.WriteStartArray();" if struct.tuple else "        writer.WriteStartObject();"]
+        for field in struct.fields:
+            body = [] if struct.tuple else [f'writer.WritePropertyName("{field.name}");']
+            if field.array:
+                body += ["writer.WriteStartArray();", f"foreach (var item in value.{self.member(field)}) {self.write_value(field, 'item')}", "writer.WriteEndArray();"]
+            else:
+                body += [self.write_value(field, f"value.{self.member(field)}")]
+            if field.optional:
+                lines += [f"        if (value.{self.has(field)})", "        {"] + indent(body, 3) + ["        }"]
+            else:
+                lines += indent(body, 2)
+        lines += ["        writer.WriteEndArray();" if struct.tuple else "        writer.WriteEndObject();"]
+        return lines + ["    }"]
+
+    def read_json(self, struct):
+        name = self.type(struct.name)
+        lines = ["", f"    static {name} Read{struct.name}(JToken token)", "    {"]
+        if struct.tuple:
+            count = len(struct.fields)
+            lines += [f"        var items = ReadArray(token, {count});"]
+            lines += [f'        if (items.Count != {count}) throw new FormatException($"{{token.Path}} does not have {count} items.");', ""]
+            lines += [f"        return new {name}", "        {"]
+            lines += [f"            {self.member(field)} = {self.read_field(field, f'items[{i}]')}," for i, field in enumerate(struct.fields)]
+            return lines + ["        };", "    }"]
+        lines += ["        var value = new " + name + "();", "", "        ReadObject(token);"]
+        for field in struct.fields:
+            if field.optional:
+                lines += [f'        value.{self.has(field)} = Optional(token, "{field.name}", out var {field.name}Token);']
+                lines += [f"        if (value.{self.has(field)}) value.{self.member(field)} = {self.read_field(field, field.name + 'Token')};"]
+            else:
+                lines += [f'        value.{self.member(field)} = {self.read_field(field, f"Required(token, {chr(34)}{field.name}{chr(34)})")};']
+        return lines + ["", "        return value;", "    }"]
+
+    def binary(self):
+        schema = self.schema
+        lines = ["", "// Little endian, as BinaryWriter writes", "public static class ProtocolBinary", "{"]
+        lines += ["    public static byte[] Encode(Message message)", "    {", "        using (var stream = new MemoryStream())"]
+        lines += ["        using (var writer = new BinaryWriter(stream))", "        {", "            writer.Write((byte)message.@event);"]
+        lines += ["            switch (message.@event)", "            {"]
+        for event, payload in schema.messages:
+            lines += [f"                case {EVENT_ENUM}.{event}:", f"                    Write(writer, message.{camel(payload)});", "                    break;"]
+        lines += ["            }", "", "            return stream.ToArray();", "        }", "    }"]
+        lines += ["", "    // Throws a FormatException when the message is not valid, an", "    // EndOfStreamException when it is truncated"]
+        lines += ["    public static Message Decode(byte[] data)", "    {", "        using (var reader = new BinaryReader(new MemoryStream(data)))", "        {"]
+        lines += [f"            var message = new Message {{ @event = ({EVENT_ENUM})ReadEnum(reader, {len(schema.enums[EVENT_ENUM])}) }};", ""]
+        lines += ["            switch (message.@event)", "            {"]
+        for event, payload in schema.messages:
+            lines += [f"                case {EVENT_ENUM}.{event}:", f"                    message.{camel(payload)} = Read{payload}(reader);", "                    break;"]
+        lines += ["            }", "            if (reader.BaseStream.Position != data.Length) throw new FormatException(\"Binary message is too long.\");", ""]
+        lines += ["            return message;", "        }", "    }"]
+        for struct in schema.structs.values():
+            lines += self.write_binary(struct) + self.read_binary(struct)
+        lines += ["", "    // The NaN of the firmware and the server, float.NaN has its sign bit set", "    static void WriteFloat(BinaryWriter writer, float value)", "    {"]
+        lines += ["        if (float.IsNaN(value)) writer.Write(0x7fc00000u);", "        else writer.Write(value);", "    }"]
+        lines += ["", "    static int ReadEnum(BinaryReader reader, int count)", "    {", "        var index = reader.ReadByte();"]
+        lines += ['        if (index >= count) throw new FormatException($"Enum index {index} out of range.");', "", "        return index;", "    }"]
+        lines += ["", "    static int ReadCount(BinaryReader reader, int max)", "    {", "        var count = reader.ReadByte();"]
+        lines += ['        if (count > max) throw new FormatException($"{count} items, at most {max}.");', "", "        return count;", "    }"]
+        return lines + ["}"]
+
+    def encode_value(self, field, value):
+        kind = self.schema.kind(field.type)
+        if field.type == "f32":
+            return f"WriteFloat(writer, {value});"
+        if kind == "scalar":
+            return f"writer.Write({value});"
+        if kind == "enum":
+            return f"writer.Write((byte){value});"
+        return f"Write(writer, {value});"
+
+    def decode_value(self, field):
+        kind = self.schema.kind(field.type)
+        if kind == "scalar":
+            return f"reader.{CS_READERS[field.type]}()"
+        if kind == "enum":
+            return f"({field.type})ReadEnum(reader, {len(self.schema.enums[field.type])})"
+        return f"Read{field.type}(reader)"
+
+    def write_binary(self, struct):
+        lines = ["", f"    static void Write(BinaryWriter writer, {self.type(struct.name)} value)", "    {"]
+        if struct.optionals:
+            bits = " | ".join(f"(value.{self.has(field)} ? {1 << i} : 0)" for i, field in enumerate(struct.optionals))
+            lines += [f"        writer.Write((byte)({bits}));"]
+        for field in struct.fields:
+            value = f"value.{self.member(field)}"
+            if field.array:
+                body = [f"writer.Write((byte){value}.Length);", f"foreach (var item in {value}) {self.encode_value(field, 'item')}"]
+            else:
+                body = [self.encode_value(field, value)]
+            if field.optional:
+                lines += [f"        if (value.{self.has(field)})", "        {"] + indent(body, 3) + ["        }"]
+            else:
+                lines += indent(body, 2)
+        return lines + ["    }"]
+
+    def read_binary(self, struct):
+        name = self.type(struct.name)
+        lines = ["", f"    static {name} Read{struct.name}(BinaryReader reader)", "    {", f"        var value = new {name}();"]
+        if struct.optionals:
+            lines += ["        var present = reader.ReadByte();", ""]
+            lines += [f'        if (present >> {len(struct.optionals)} != 0) throw new FormatException("Unknown optional fields.");']
+            lines += [f"        value.{self.has(field)} = (present & {1 << i}) != 0;" for i, field in enumerate(struct.optionals)]
+        else:
+            lines += [""]
+        for field in struct.fields:
+            if field.array:
+                read = f"new {self.type(field.type)}[ReadCount(reader, {field.max})]"
+                body = [f"value.{self.member(field)} = {read};", f"for (var i = 0; i < value.{self.member(field)}.Length; i++) value.{self.member(field)}[i] = {self.decode_value(field)};"]
+            else:
+                body = [f"value.{self.member(field)} = {self.decode_value(field)};"]
+            if field.optional:
+                lines += [f"        if (value.{self.has(field)})", "        {"] + indent(body, 3) + ["        }"]
+            else:
+                lines += indent(body, 2)
+        return lines + ["", "        return value;", "    }"]
+
+
+def generate(schema):
+    c = CGenerator(schema)
+    return {
+        "c_header": c.header(),
+        "c_source": c.source(),
+        "ts": TsGenerator(schema).source(),
+        "cs": CsGenerator(schema).source(),
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    parser.add_argument("--check", action="store_true", help="only tell whether the generated files are up to date")
+    args = parser.parse_args()
+
+    with open(SCHEMA) as file:
+        schema = Schema(json.load(file))
+
+    stale = []
+    for output, text in generate(schema).items():
+        path = OUTPUTS[output]
+        try:
+            with open(path, newline="") as file:
+                current = file.read()
+        except FileNotFoundError:
+            current = None
+        if current == text:
+            continue
+        stale.append(os.path.relpath(path, ROOT))
+        if not args.check:
+            with open(path, "w", newline="") as file:
+                file.write(text)
+
+    for path in stale:
+        print(f"{'Out of date' if args.check else 'Generated'}: {path}")
+    return 1 if args.check and stale else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
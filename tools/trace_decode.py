@@ -0,0 +1,97 @@
+#!/usr/bin/env python3
+"""Turns the T: lines of the firmware trace back into log lines.
+
+Reads the monitor output from the files given, or the standard input, and
+prints every other line unchanged. The formats come from main/trace_formats.h,
+so decode with the one the firmware was built with.
+
+    idf.py monitor | tools/trace_decode.py
+    tools/trace_decode.py capture.log
+"""
+
+import argparse
+import fileinput
+import os
+import re
+import struct
+import sys
+
+FORMATS = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "main", "trace_formats.h")
+FORMAT_LINE = re.compile(r'^TRACE_FORMAT\(\s*(\w+)\s*,\s*"((?:[^"\\]|\\.)*)"\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)')
+CONVERSION = re.compile(r"%([-+ #0]*)(\d+|\*)?(?:\.(\d+|\*))?(hh|h|ll|l|z|j|t)?([diouxXcfFeEgG%])")
+RECORD = re.compile(r"T:([0-9a-f]{8})([0-9a-f]{4})([0-9a-f]{2})([0-9a-f]{2})((?:[0-9a-f]{8})*)$")
+
+
+def load_formats(path):
+    formats = []
+    with open(path) as file:
+        for line in file:
+            match = FORMAT_LINE.match(line.strip())
+            if match:
+                formats.append((match.group(1), match.group(2), match.group(3)))
+    return formats
+
+
+def convert(format, words):
+    """Python % formatting of the C format, each word read as its conversion says."""
+    values = []
+    words = iter(words)
+
+    def strip(match):
+        flags, width, precision, _, conversion = match.groups()
+        if conversion == "%":
+            return "%%"
+        word = next(words, 0)
+        if conversion in "di":
+            values.append(struct.unpack("<i", struct.pack("<I", word))[0])
+        elif conversion in "fFeEgG":
+            values.append(struct.unpack("<f", struct.pack("<I", word))[0])
+        elif conversion == "c":
+            values.append(chr(word & 0xFF))
+        else:
+            values.append(word)
+        return "%" + flags + (width or "") + ("." + precision if precision else "") + ("d" if conversion == "u" else conversion)
+
+    return CONVERSION.sub(strip, format) % tuple(values)
+
+
+def decode(line, formats, epoch):
+    match = RECORD.match(line)
+    if not match:
+        return None
+
+    timestamp, format, core, argc = (int(group, 16) for group in match.groups()[:4])
+    args = match.group(5)
+    words = [int(args[i:i + 8], 16) for i in range(0, 8 * argc, 8)]
+
+    # Timestamps are the low 32 bits of the microseconds since boot
+    if epoch["last"] is not None and timestamp < epoch["last"] and epoch["last"] - timestamp > 1 << 31:
+        epoch["wraps"] += 1
+    epoch["last"] = timestamp
+    milliseconds = ((epoch["wraps"] << 32) + timestamp) // 1000
+
+    if format >= len(formats):
+        return "T (%d) trace: unknown format %d on core %d, arguments %s" % (milliseconds, format, core, words)
+
+    _, tag, text = formats[format]
+    return "T (%d) %s: %s" % (milliseconds, tag, convert(text, words))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--formats", default=FORMATS, help="trace_formats.h the firmware was built with")
+    parser.add_argument("files", nargs="*", help="monitor output, the standard input by default")
+    arguments = parser.parse_args()
+
+    formats = load_formats(arguments.formats)
+    epoch = {"last": None, "wraps": 0}
+
+    for line in fileinput.input(arguments.files):
+        line = line.rstrip("\r\n")
+        decoded = decode(line.strip(), formats, epoch)
+        print(decoded if decoded is not None else line)
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()